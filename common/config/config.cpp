@@ -7,6 +7,7 @@
 #include "config.hpp"
 
 #include <boost/algorithm/string.hpp>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
 
@@ -24,6 +25,33 @@ namespace config
       exit(0);
    }
 
+   void KeyNotFoundError(const String & path, UInt64 index)
+   {
+      if (index == UINT64_MAX)
+         config::Error("Configuration value %s not found.", path.c_str());
+      else
+         config::Error("Configuration value %s[%i] not found.", path.c_str(), index);
+   }
+
+    size_t PathHash::operator()(const String & path) const
+    {
+        // FNV-1a
+        size_t hash = 14695981039346656037ULL;
+        for(String::const_iterator c = path.begin(); c != path.end(); c++)
+        {
+            hash ^= case_sensitive ? (unsigned char)*c : std::tolower((unsigned char)*c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    bool PathEqual::operator()(const String & a, const String & b) const
+    {
+        if (case_sensitive)
+            return a == b;
+        return a.size() == b.size() && boost::iequals(a, b);
+    }
+
     bool Config::isLeaf(const String & path)
     {
         return !boost::find_first(path, "/");
@@ -71,65 +99,65 @@ namespace config
     {
         m_path = path;
         loadConfig();
+        rebuildFlatKeys();
     }
 
     void Config::clear()
     {
         m_root.clear();
+        rebuildFlatKeys();
     }
 
-    bool Config::hasKey(const String & path, UInt64 index)
+    void Config::rebuildFlatKeys()
     {
-        //Handle the base case
-        if(isLeaf(path))
+        m_flat_keys.clear();
+        addFlatKeys(m_root, "");
+    }
+
+    void Config::addFlatKeys(const Section & section, const String & prefix)
+    {
+        KeyList const & keys = section.getKeys();
+        for(KeyList::const_iterator i = keys.begin(); i != keys.end(); i++)
+            m_flat_keys[prefix + i->first].value = i->second;
+
+        KeyArrayList const & array_keys = section.getArrayKeys();
+        for(KeyArrayList::const_iterator i = array_keys.begin(); i != array_keys.end(); i++)
         {
-            if(m_root.hasKey(path, index))
-                return true;
-            else
-                return false;
+            FlatKey & flat_key = m_flat_keys[prefix + i->first];
+            flat_key.overrides.assign(i->second.begin(), i->second.end());
         }
 
-        //Disect the path
-        PathPair path_pair = Config::splitPath(path);
-        Section & section = getSection_unsafe(path_pair.first);
+        SectionList const & subsections = section.getSubsections();
+        for(SectionList::const_iterator i = subsections.begin(); i != subsections.end(); i++)
+            addFlatKeys(*(i->second), prefix + i->first + "/");
+    }
 
-        if(section.hasKey(path_pair.second, index))
-            return true;
-        else
+    const FlatKey & Config::getFlatKey(const String & path)
+    {
+        FlatKeyTable::const_iterator found = m_flat_keys.find(path);
+        if (found == m_flat_keys.end())
+            KeyNotFoundError(path, UINT64_MAX);
+        return found->second;
+    }
+
+    bool Config::hasKey(const String & path, UInt64 index)
+    {
+        FlatKeyTable::const_iterator found = m_flat_keys.find(path);
+        if (found == m_flat_keys.end())
             return false;
+        //Without an index, a key that only has overrides exists too
+        if (index == UINT64_MAX)
+            return found->second.value != NULL || !found->second.overrides.empty();
+        return found->second.get(index) != NULL;
     }
 
     const Key & Config::getKey(const String & path, UInt64 index)
     {
-        //Handle the base case
-        if(isLeaf(path))
-        {
-            if(!m_root.hasKey(path, index))
-            {
-                if (index == UINT64_MAX)
-                    config::Error("Configuration value %s not found.", path.c_str());
-                else
-                    config::Error("Configuration value %s[%i] not found.", path.c_str(), index);
-            }
-            else
-            {
-                return m_root.getKey(path, index);
-            }
-        }
-
-        //Disect the path
-        PathPair path_pair = Config::splitPath(path);
-        Section & section = getSection_unsafe(path_pair.first);
-
-        if(!section.hasKey(path_pair.second, index))
-        {
-            if (index == UINT64_MAX)
-                config::Error("Configuration value %s not found.", path.c_str());
-            else
-                config::Error("Configuration value %s[%i] not found.", path.c_str(), index);
-        }
-
-        return section.getKey(path_pair.second, index);
+        FlatKeyTable::const_iterator found = m_flat_keys.find(path);
+        const Key * key = found != m_flat_keys.end() ? found->second.get(index) : NULL;
+        if (!key)
+            KeyNotFoundError(path, index);
+        return *key;
     }
 
     const Section & Config::addSection(const String & path)
@@ -166,13 +194,31 @@ namespace config
     template <class V>
     const Key & Config::addKeyInternal(const String & path, const V & value, UInt64 index)
     {
+        const Key * key;
         //Handle the base case
         if(isLeaf(path))
-            return m_root.addKey(path, value, index);
+            key = &m_root.addKey(path, value, index);
+        else
+        {
+            PathPair path_pair = Config::splitPath(path);
+            Section &parent = getSection_unsafe(path_pair.first);
+            key = &parent.addKey(path_pair.second, value, index);
+        }
 
-        PathPair path_pair = Config::splitPath(path);
-        Section &parent = getSection_unsafe(path_pair.first);
-        return parent.addKey(path_pair.second, value, index);
+        //Mirror Section::addKey(): a new default value replaces all overrides
+        FlatKey & flat_key = m_flat_keys[path];
+        if (index == UINT64_MAX)
+        {
+            flat_key.value = key;
+            flat_key.overrides.clear();
+        }
+        else
+        {
+            if (flat_key.overrides.size() < index + 1)
+                flat_key.overrides.resize(index + 1);
+            flat_key.overrides[index] = key;
+        }
+        return *key;
     }
 
     //Convert the in-memory representation into a string
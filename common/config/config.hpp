@@ -19,6 +19,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <iostream>
 
 namespace config
@@ -30,6 +31,62 @@ namespace config
     typedef std::vector < String > PathElementList;
     typedef std::pair<String,String> PathPair;
 
+    /*! \brief FlatKey: all values of one key, as stored in the flat key table of a Config.
+     * Resolves an index (usually a core id) to its override, or else to the default value.
+     */
+    struct FlatKey
+    {
+        const Key * value;                      //!< Default value, NULL if the key only has overrides
+        std::vector<const Key *> overrides;     //!< Per-index values, NULL where the index has no override
+
+        FlatKey() : value(NULL) {}
+        const Key * get(UInt64 index) const
+        {
+            return index < overrides.size() && overrides[index] ? overrides[index] : value;
+        }
+    };
+
+    //! Hashing and comparison of key paths, ignoring case unless the configuration is case sensitive
+    struct PathHash
+    {
+        bool case_sensitive;
+        size_t operator()(const String & path) const;
+    };
+    struct PathEqual
+    {
+        bool case_sensitive;
+        bool operator()(const String & a, const String & b) const;
+    };
+    typedef std::unordered_map<String, FlatKey, PathHash, PathEqual> FlatKeyTable;
+
+    __attribute__ ((__noreturn__)) void KeyNotFoundError(const String & path, UInt64 index);
+
+    /*! \brief Handle: a typed reference to one key of the flat key table, for reading a key for many indices.
+     * The handle sees later changes made through Config::set(), and remains valid until the configuration
+     * is cleared or reloaded.
+     */
+    template <class V>
+    class Handle
+    {
+        public:
+            Handle(const String & path, const FlatKey & key): m_path(path), m_key(&key) {}
+
+            V get(UInt64 index = UINT64_MAX) const
+            {
+                const Key * key = m_key->get(index);
+                if (!key)
+                    KeyNotFoundError(m_path, index);
+                V value;
+                key->getValue(value);
+                return value;
+            }
+            V operator[](UInt64 index) const { return get(index); }
+
+        private:
+            String m_path;
+            const FlatKey * m_key;
+    };
+
     /*! \brief Config: A class for managing the interface to persistent configuration entries defined at runtime.
      * This class is used to manage a configuration interface.
      * It is the base class for which different back ends will derive from.
@@ -37,8 +94,8 @@ namespace config
     class Config
     {
         public:
-            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive){}
-            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive){}
+            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive), m_flat_keys(0, PathHash{case_sensitive}, PathEqual{case_sensitive}){}
+            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive), m_flat_keys(0, PathHash{case_sensitive}, PathEqual{case_sensitive}){ rebuildFlatKeys(); }
             virtual ~Config(){}
 
             /*! \brief A function for saving the entire configuration
@@ -139,6 +196,14 @@ namespace config
             double getFloat(const String & path) { return getFloatArray(path, UINT64_MAX); }
             double getFloatArray(const String & path, UInt64 index);
 
+            /*! \brief Look up the key at the given path once, and return a handle that reads its value
+             * for any index, with the same fallback to the default value as the get*Array() functions.
+             * \param path - Path for key to look up
+             * \exception KeyNotFound is thrown if the specified path doesn't exist.
+             */
+            template <class V>
+            Handle<V> getHandle(const String & path) { return Handle<V>(path, getFlatKey(path)); }
+
             /*! \brief Returns a string representation of the tree starting at the specified section
              * \param current The root of the tree for which we are creating a string representation.
              */
@@ -170,6 +235,9 @@ namespace config
             Section & getRoot_unsafe() { return m_root; };
             Key & getKey_unsafe(String const& path);
 
+            //! Rebuild the flat key table from the tree, needed after keys were added to sections directly
+            void rebuildFlatKeys();
+
         private:
             template <class V>
             const Key & addKeyInternal(const String & path, const V & new_key, UInt64 index);
@@ -178,6 +246,14 @@ namespace config
             template <class V>
             const Key & getKey(const String & path, const V &default_val, UInt64 index);
 
+            /*! Every key of the tree by its full path, so getters need a single hash lookup instead of splitting
+             * the path and walking the sections. Kept up to date by addKey(), built when constructing from a Section and
+             * rebuilt by load() and clear().
+             */
+            FlatKeyTable m_flat_keys;
+            const FlatKey & getFlatKey(const String & path);
+            void addFlatKeys(const Section & section, const String & prefix);
+
             //Utility function used to break the last word past the last /
             //from the base path
             static PathPair splitPath(const String & path);
@@ -30,6 +30,7 @@ namespace config
         :
             Config(root, case_sensitive)
     {
+        // Config(root) has already built the flat key table
     }
 
     //load a given filename into a string, taken from boost regexp replace example
@@ -69,6 +70,7 @@ namespace config
     void ConfigFile::loadConfigFromString(const String & cfg)
     {
         parse(cfg, m_root);
+        rebuildFlatKeys();
     }
 
 
@@ -1,6 +1,7 @@
 #include "simulator.h"
 #include "cache.h"
 #include "log.h"
+#include "checkpoint_manager.h"
 
 // Cache class
 // constructors/destructors
@@ -22,6 +23,7 @@ Cache::Cache(
    m_num_accesses(0),
    m_num_hits(0),
    m_cache_type(cache_type),
+   m_core_id(core_id),
    m_fault_injector(fault_injector)
 {
    m_set_info = CacheSet::createCacheSetInfo(name, cfgname, core_id, replacement_policy, m_associativity);
@@ -36,10 +38,14 @@ Cache::Cache(
    for (UInt32 i = 0; i < m_num_sets; i++)
       m_set_usage_hist[i] = 0;
    #endif
+
+   Sim()->getCheckpointManager()->registerObject(m_name, m_core_id, this);
 }
 
 Cache::~Cache()
 {
+   Sim()->getCheckpointManager()->unregisterObject(m_name, m_core_id);
+
    #ifdef ENABLE_SET_USAGE_HIST
    printf("Cache %s set usage:", m_name.c_str());
    for (SInt32 i = 0; i < (SInt32) m_num_sets; i++)
@@ -184,3 +190,26 @@ Cache::updateHits(Core::mem_op_t mem_op_type, UInt64 hits)
       m_num_hits += hits;
    }
 }
+
+void
+Cache::saveState(CheckpointWriter &writer)
+{
+   writer.write(m_num_sets);
+   writer.write(m_associativity);
+   writer.write(m_blocksize);
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i]->saveState(writer);
+}
+
+void
+Cache::loadState(CheckpointReader::Section &section)
+{
+   UInt32 num_sets = section.read<UInt32>();
+   UInt32 associativity = section.read<UInt32>();
+   UInt32 blocksize = section.read<UInt32>();
+   LOG_ASSERT_ERROR(num_sets == m_num_sets && associativity == m_associativity && blocksize == m_blocksize,
+      "Cache %s: checkpoint has %d sets, %d ways and %d-byte blocks, but the cache has %d sets, %d ways and %d-byte blocks",
+      m_name.c_str(), num_sets, associativity, blocksize, m_num_sets, m_associativity, m_blocksize);
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i]->loadState(section);
+}
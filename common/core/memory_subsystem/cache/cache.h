@@ -11,11 +11,12 @@
 #include "log.h"
 #include "core.h"
 #include "fault_injection.h"
+#include "checkpoint.h"
 
 // Define to enable the set usage histogram
 //#define ENABLE_SET_USAGE_HIST
 
-class Cache : public CacheBase
+class Cache : public CacheBase, public Checkpointable
 {
    private:
       bool m_enabled;
@@ -26,6 +27,7 @@ class Cache : public CacheBase
 
       // Generic Cache Info
       cache_t m_cache_type;
+      core_id_t m_core_id;
       CacheSet** m_sets;
       CacheSetInfo* m_set_info;
 
@@ -68,6 +70,9 @@ class Cache : public CacheBase
 
       void enable() { m_enabled = true; }
       void disable() { m_enabled = false; }
+
+      void saveState(CheckpointWriter &writer);
+      void loadState(CheckpointReader::Section &section);
 };
 
 template <class T>
@@ -23,14 +23,40 @@ const char* CacheBlockInfo::getOptionName(option_t option)
 
 
 CacheBlockInfo::CacheBlockInfo(IntPtr tag, CacheState::cstate_t cstate, UInt64 options, SubsecondTime slme_available):
-   m_tag(tag),
-   m_cstate(cstate),
+   m_tag(&m_own_tag),
+   m_cstate(&m_own_cstate),
+   m_own_tag(tag),
+   m_own_cstate(cstate),
    m_owner(0),
    m_used(0),
    m_options(options),
    m_slme_available(slme_available)
 {}
 
+CacheBlockInfo::CacheBlockInfo(const CacheBlockInfo &other):
+   m_tag(&m_own_tag),
+   m_cstate(&m_own_cstate),
+   m_own_tag(other.getTag()),
+   m_own_cstate(other.getCState()),
+   m_owner(other.m_owner),
+   m_used(other.m_used),
+   m_options(other.m_options),
+   m_slme_available(other.m_slme_available)
+{}
+
+CacheBlockInfo&
+CacheBlockInfo::operator=(const CacheBlockInfo &other)
+{
+   // Copy the values, not where they are stored
+   *m_tag = other.getTag();
+   *m_cstate = other.getCState();
+   m_owner = other.m_owner;
+   m_used = other.m_used;
+   m_options = other.m_options;
+   m_slme_available = other.m_slme_available;
+   return *this;
+}
+
 CacheBlockInfo::~CacheBlockInfo()
 {}
 
@@ -54,19 +80,28 @@ CacheBlockInfo::create(CacheBase::cache_t cache_type)
    }
 }
 
+void
+CacheBlockInfo::bind(IntPtr *tag, CacheState::cstate_t *cstate)
+{
+   *tag = *m_tag;
+   *cstate = *m_cstate;
+   m_tag = tag;
+   m_cstate = cstate;
+}
+
 void
 CacheBlockInfo::invalidate()
 {
-   m_tag = ~0;
-   m_cstate = CacheState::INVALID;
+   *m_tag = ~0;
+   *m_cstate = CacheState::INVALID;
    m_slme_available = SubsecondTime::MaxTime();
 }
 
 void
 CacheBlockInfo::clone(CacheBlockInfo* cache_block_info)
 {
-   m_tag = cache_block_info->getTag();
-   m_cstate = cache_block_info->getCState();
+   *m_tag = cache_block_info->getTag();
+   *m_cstate = cache_block_info->getCState();
    m_owner = cache_block_info->m_owner;
    m_used = cache_block_info->m_used;
    m_options = cache_block_info->m_options;
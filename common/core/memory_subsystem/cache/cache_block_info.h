@@ -23,8 +23,12 @@ class CacheBlockInfo
    // This can be extended later to include other information
    // for different cache coherence protocols
    private:
-      IntPtr m_tag;
-      CacheState::cstate_t m_cstate;
+      // Tag and state are kept in the owning CacheSet's per-set arrays, so it can match all ways at once,
+      // this object is a view on them. Blocks that are not part of a set point to their own copy.
+      IntPtr *m_tag;
+      CacheState::cstate_t *m_cstate;
+      IntPtr m_own_tag;
+      CacheState::cstate_t m_own_cstate;
       UInt64 m_owner;
       BitsUsedType m_used;
       UInt8 m_options;  // large enough to hold a bitfield for all available option_t's
@@ -32,10 +36,15 @@ class CacheBlockInfo
 
       static const char* option_names[];
 
+      void bind(IntPtr *tag, CacheState::cstate_t *cstate);
+      friend class CacheSet;
+
    public:
       CacheBlockInfo(IntPtr tag = ~0,
             CacheState::cstate_t cstate = CacheState::INVALID,
             UInt64 options = 0, SubsecondTime slme_available = SubsecondTime::MaxTime());
+      CacheBlockInfo(const CacheBlockInfo &other);
+      CacheBlockInfo& operator=(const CacheBlockInfo &other);
       virtual ~CacheBlockInfo();
 
       static CacheBlockInfo* create(CacheBase::cache_t cache_type);
@@ -43,13 +52,13 @@ class CacheBlockInfo
       virtual void invalidate(void);
       virtual void clone(CacheBlockInfo* cache_block_info);
 
-      bool isValid() const { return (m_tag != ((IntPtr) ~0)); }
+      bool isValid() const { return (*m_tag != ((IntPtr) ~0)); }
 
-      IntPtr getTag() const { return m_tag; }
-      CacheState::cstate_t getCState() const { return m_cstate; }
+      IntPtr getTag() const { return *m_tag; }
+      CacheState::cstate_t getCState() const { return *m_cstate; }
 
-      void setTag(IntPtr tag) { m_tag = tag; }
-      void setCState(CacheState::cstate_t cstate) { m_cstate = cstate; }
+      void setTag(IntPtr tag) { *m_tag = tag; }
+      void setCState(CacheState::cstate_t cstate) { *m_cstate = cstate; }
 
       UInt64 getOwner() const { return m_owner; }
       void setOwner(UInt64 owner) { m_owner = owner; }
@@ -13,14 +13,30 @@
 #include "config.h"
 #include "config.hpp"
 
+#if defined(__x86_64__) && defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__x86_64__) && defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
 CacheSet::CacheSet(CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize):
       m_associativity(associativity), m_blocksize(blocksize)
 {
+   UInt32 num_tags = (m_associativity + TAG_GROUP - 1) / TAG_GROUP * TAG_GROUP;
+   __attribute__((unused)) int rc = posix_memalign((void**)&m_tags, 64, num_tags * sizeof(IntPtr) + m_associativity * sizeof(CacheState::cstate_t));
+   LOG_ASSERT_ERROR (rc == 0, "posix_memalign failed to allocate memory");
+   m_cstates = (CacheState::cstate_t*)(m_tags + num_tags);
+   // Padding ways are never valid, and are masked out of matches anyway
+   for (UInt32 i = 0; i < num_tags; i++)
+      m_tags[i] = ~0;
+   m_last_group_mask = (1 << (m_associativity - (num_tags - TAG_GROUP))) - 1;
+
    m_cache_block_info_array = new CacheBlockInfo*[m_associativity];
    for (UInt32 i = 0; i < m_associativity; i++)
    {
       m_cache_block_info_array[i] = CacheBlockInfo::create(cache_type);
+      m_cache_block_info_array[i]->bind(&m_tags[i], &m_cstates[i]);
    }
 
    if (Sim()->getFaultinjectionManager())
@@ -38,6 +54,64 @@ CacheSet::~CacheSet()
       delete m_cache_block_info_array[i];
    delete [] m_cache_block_info_array;
    delete [] m_blocks;
+   free(m_tags);
+}
+
+// Bitmask of the ways in [base, base + TAG_GROUP) that hold tag
+inline UInt32
+CacheSet::matchGroup(UInt32 base, IntPtr tag) const
+{
+#if defined(__x86_64__) && defined(__AVX2__)
+   __m256i needle = _mm256_set1_epi64x(tag);
+   __m256i tags = _mm256_load_si256((const __m256i*)&m_tags[base]);
+   return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(tags, needle)));
+#elif defined(__x86_64__) && defined(__SSE2__)
+   // SSE2 has no 64-bit compare: compare 32-bit halves, a way matches when both its halves do
+   __m128i needle = _mm_set1_epi64x(tag);
+   __m128i lo = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)&m_tags[base]), needle);
+   __m128i hi = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)&m_tags[base + 2]), needle);
+   lo = _mm_and_si128(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+   hi = _mm_and_si128(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+   return _mm_movemask_pd(_mm_castsi128_pd(lo)) | (_mm_movemask_pd(_mm_castsi128_pd(hi)) << 2);
+#else
+   UInt32 mask = 0;
+   for (UInt32 i = 0; i < TAG_GROUP; i++)
+      if (m_tags[base + i] == tag)
+         mask |= 1 << i;
+   return mask;
+#endif
+}
+
+SInt32
+CacheSet::findWay(IntPtr tag) const
+{
+   SInt32 last = (m_associativity - 1) / TAG_GROUP * TAG_GROUP;
+   UInt32 mask = matchGroup(last, tag) & m_last_group_mask;
+   if (mask)
+      return last + 31 - __builtin_clz(mask);
+   for (SInt32 base = last - TAG_GROUP; base >= 0; base -= TAG_GROUP)
+   {
+      mask = matchGroup(base, tag);
+      if (mask)
+         return base + 31 - __builtin_clz(mask);
+   }
+   return -1;
+}
+
+SInt32
+CacheSet::findInvalid() const
+{
+   SInt32 last = (m_associativity - 1) / TAG_GROUP * TAG_GROUP;
+   for (SInt32 base = 0; base < last; base += TAG_GROUP)
+   {
+      UInt32 mask = matchGroup(base, ~0);
+      if (mask)
+         return base + __builtin_ctz(mask);
+   }
+   UInt32 mask = matchGroup(last, ~0) & m_last_group_mask;
+   if (mask)
+      return last + __builtin_ctz(mask);
+   return -1;
 }
 
 void
@@ -69,14 +143,12 @@ CacheSet::write_line(UInt32 line_index, UInt32 offset, Byte *in_buff, UInt32 byt
 CacheBlockInfo*
 CacheSet::find(IntPtr tag, UInt32* line_index)
 {
-   for (SInt32 index = m_associativity-1; index >= 0; index--)
+   SInt32 index = findWay(tag);
+   if (index >= 0)
    {
-      if (m_cache_block_info_array[index]->getTag() == tag)
-      {
-         if (line_index != NULL)
-            *line_index = index;
-         return (m_cache_block_info_array[index]);
-      }
+      if (line_index != NULL)
+         *line_index = index;
+      return (m_cache_block_info_array[index]);
    }
    return NULL;
 }
@@ -84,13 +156,11 @@ CacheSet::find(IntPtr tag, UInt32* line_index)
 bool
 CacheSet::invalidate(IntPtr& tag)
 {
-   for (SInt32 index = m_associativity-1; index >= 0; index--)
+   SInt32 index = findWay(tag);
+   if (index >= 0)
    {
-      if (m_cache_block_info_array[index]->getTag() == tag)
-      {
-         m_cache_block_info_array[index]->invalidate();
-         return true;
-      }
+      m_cache_block_info_array[index]->invalidate();
+      return true;
    }
    return false;
 }
@@ -105,7 +175,7 @@ CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* evicti
 
    assert(eviction != NULL);
 
-   if (m_cache_block_info_array[index]->isValid())
+   if (m_tags[index] != ((IntPtr) ~0))
    {
       *eviction = true;
       // FIXME: This is a hack. I dont know if this is the best way to do
@@ -131,6 +201,34 @@ CacheSet::getDataPtr(UInt32 line_index, UInt32 offset)
    return &m_blocks[line_index * m_blocksize + offset];
 }
 
+void
+CacheSet::saveState(CheckpointWriter &writer)
+{
+   writer.write(m_tags, m_associativity * sizeof(IntPtr));
+   writer.write(m_cstates, m_associativity * sizeof(CacheState::cstate_t));
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      writer.write(m_cache_block_info_array[i]->m_owner);
+      writer.write(m_cache_block_info_array[i]->m_used);
+      writer.write(m_cache_block_info_array[i]->m_options);
+   }
+   saveReplacementState(writer);
+}
+
+void
+CacheSet::loadState(CheckpointReader::Section &section)
+{
+   section.read(m_tags, m_associativity * sizeof(IntPtr));
+   section.read(m_cstates, m_associativity * sizeof(CacheState::cstate_t));
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      m_cache_block_info_array[i]->m_owner = section.read<UInt64>();
+      m_cache_block_info_array[i]->m_used = section.read<CacheBlockInfo::BitsUsedType>();
+      m_cache_block_info_array[i]->m_options = section.read<UInt8>();
+   }
+   loadReplacementState(section);
+}
+
 CacheSet*
 CacheSet::createCacheSet(String cfgname, core_id_t core_id,
       String replacement_policy,
@@ -233,7 +331,7 @@ CacheSet::parsePolicyType(String policy)
 
 bool CacheSet::isValidReplacement(UInt32 index)
 {
-   if (m_cache_block_info_array[index]->getCState() == CacheState::SHARED_UPGRADING)
+   if (m_cstates[index] == CacheState::SHARED_UPGRADING)
    {
       return false;
    }
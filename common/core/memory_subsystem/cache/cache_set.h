@@ -7,6 +7,7 @@
 #include "lock.h"
 #include "random.h"
 #include "log.h"
+#include "checkpoint.h"
 
 #include <cstring>
 
@@ -28,8 +29,18 @@ class CacheSet
       static CacheBase::ReplacementPolicy parsePolicyType(String policy);
       static UInt8 getNumQBSAttempts(CacheBase::ReplacementPolicy, String cfgname, core_id_t core_id);
 
+   private:
+      static const UInt32 TAG_GROUP = 4;  //< Ways compared at once, the tag array is padded to a multiple of this
+
+      UInt32 matchGroup(UInt32 base, IntPtr tag) const;
+
    protected:
       CacheBlockInfo** m_cache_block_info_array;
+      // Tags and states of all ways, stored contiguously so find() can match all ways with a few SIMD compares.
+      // The CacheBlockInfo objects in m_cache_block_info_array are views on these.
+      IntPtr* m_tags;
+      CacheState::cstate_t* m_cstates;
+      UInt32 m_last_group_mask;
       char* m_blocks;
       UInt32 m_associativity;
       UInt32 m_blocksize;
@@ -60,6 +71,18 @@ class CacheSet
       virtual void updateReplacementIndex(UInt32) = 0;
 
       bool isValidReplacement(UInt32 index);
+
+      // Checkpointing: tags and states of all ways, followed by the replacement policy's state
+      void saveState(CheckpointWriter &writer);
+      void loadState(CheckpointReader::Section &section);
+      // Policies without replacement state (random) need not override these
+      virtual void saveReplacementState(CheckpointWriter &writer) {}
+      virtual void loadReplacementState(CheckpointReader::Section &section) {}
+
+      // Highest way holding tag, or -1
+      SInt32 findWay(IntPtr tag) const;
+      // Lowest way that holds no valid line, or -1
+      SInt32 findInvalid() const;
 };
 
 #endif /* CACHE_SET_H */
@@ -25,14 +25,12 @@ UInt32
 CacheSetLRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // First try to find an invalid block
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         // Mark our newly-inserted line as most-recently used
-         moveToMRU(i);
-         return i;
-      }
+      // Mark our newly-inserted line as most-recently used
+      moveToMRU(invalid);
+      return invalid;
    }
 
    // Make m_num_attemps attempts at evicting the block at LRU position
@@ -123,3 +121,15 @@ CacheSetInfoLRU::~CacheSetInfoLRU()
    if (m_attempts)
       delete [] m_attempts;
 }
+
+void
+CacheSetLRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+}
+
+void
+CacheSetLRU::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(m_lru_bits, m_associativity);
+}
@@ -36,6 +36,9 @@ class CacheSetLRU : public CacheSet
       virtual UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader::Section &section);
+
    protected:
       const UInt8 m_num_attempts;
       UInt8* m_lru_bits;
@@ -23,13 +23,11 @@ CacheSetMRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         updateReplacementIndex(i);
-         return i;
-      }
+      updateReplacementIndex(invalid);
+      return invalid;
    }
 
    UInt32 target = 0;
@@ -59,3 +57,15 @@ CacheSetMRU::updateReplacementIndex(UInt32 accessed_index)
    }
    m_lru_bits[accessed_index] = 0;
 }
+
+void
+CacheSetMRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+}
+
+void
+CacheSetMRU::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(m_lru_bits, m_associativity);
+}
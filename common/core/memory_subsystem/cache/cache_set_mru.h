@@ -13,6 +13,9 @@ class CacheSetMRU : public CacheSet
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader::Section &section);
+
    private:
       UInt8* m_lru_bits;
 };
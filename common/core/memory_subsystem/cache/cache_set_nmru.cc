@@ -25,13 +25,11 @@ CacheSetNMRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         updateReplacementIndex(i);
-         return i;
-      }
+      updateReplacementIndex(invalid);
+      return invalid;
    }
 
    for (UInt32 i = 0; i < m_associativity; i++)
@@ -61,3 +59,17 @@ CacheSetNMRU::updateReplacementIndex(UInt32 accessed_index)
    }
    m_lru_bits[accessed_index] = 0;
 }
+
+void
+CacheSetNMRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetNMRU::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(m_lru_bits, m_associativity);
+   m_replacement_pointer = section.read<UInt8>();
+}
@@ -83,3 +83,19 @@ CacheSetNRU::updateReplacementIndex(UInt32 accessed_index)
       }
    }
 }
+
+void
+CacheSetNRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_lru_bits, m_associativity);
+   writer.write(m_num_bits_set);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetNRU::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(m_lru_bits, m_associativity);
+   m_num_bits_set = section.read<UInt8>();
+   m_replacement_pointer = section.read<UInt8>();
+}
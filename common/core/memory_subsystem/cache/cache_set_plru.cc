@@ -23,13 +23,11 @@ CacheSetPLRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         updateReplacementIndex(i);
-         return i;
-      }
+      updateReplacementIndex(invalid);
+      return invalid;
    }
 
    UInt32 retValue = -1;
@@ -113,3 +111,15 @@ CacheSetPLRU::updateReplacementIndex(UInt32 accessed_index)
       LOG_PRINT_ERROR("PLRU doesn't support associativity %d", m_associativity);
    }
 }
+
+void
+CacheSetPLRU::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(b, sizeof(b));
+}
+
+void
+CacheSetPLRU::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(b, sizeof(b));
+}
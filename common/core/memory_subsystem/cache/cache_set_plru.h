@@ -13,6 +13,9 @@ class CacheSetPLRU : public CacheSet
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader::Section &section);
+
    private:
       UInt8 b[8];
 };
@@ -22,11 +22,9 @@ CacheSetRandom::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
-   {
-       if (!m_cache_block_info_array[i]->isValid())
-          return i;   // if there is an invalid line, use that line
-   }
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
+      return invalid;   // if there is an invalid line, use that line
 
    UInt32 index = (m_rand.next() % m_associativity);
    if (isValidReplacement(index))
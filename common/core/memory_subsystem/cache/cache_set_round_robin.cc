@@ -28,3 +28,15 @@ CacheSetRoundRobin::updateReplacementIndex(UInt32 accessed_index)
 {
    return;
 }
+
+void
+CacheSetRoundRobin::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_replacement_index);
+}
+
+void
+CacheSetRoundRobin::loadReplacementState(CheckpointReader::Section &section)
+{
+   m_replacement_index = section.read<UInt32>();
+}
@@ -13,6 +13,9 @@ class CacheSetRoundRobin : public CacheSet
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader::Section &section);
+
    private:
       UInt32 m_replacement_index;
 };
@@ -30,15 +30,13 @@ CacheSetSRRIP::~CacheSetSRRIP()
 UInt32
 CacheSetSRRIP::getReplacementIndex(CacheCntlr *cntlr)
 {
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalid();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
-         // Prepare way for a new line: set prediction to 'long'
-         m_rrip_bits[i] = m_rrip_insert;
-         return i;
-      }
+      // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
+      // Prepare way for a new line: set prediction to 'long'
+      m_rrip_bits[invalid] = m_rrip_insert;
+      return invalid;
    }
 
    UInt8 attempt = 0;
@@ -103,3 +101,17 @@ CacheSetSRRIP::updateReplacementIndex(UInt32 accessed_index)
    if (m_rrip_bits[accessed_index] > 0)
       m_rrip_bits[accessed_index]--;
 }
+
+void
+CacheSetSRRIP::saveReplacementState(CheckpointWriter &writer)
+{
+   writer.write(m_rrip_bits, m_associativity);
+   writer.write(m_replacement_pointer);
+}
+
+void
+CacheSetSRRIP::loadReplacementState(CheckpointReader::Section &section)
+{
+   section.read(m_rrip_bits, m_associativity);
+   m_replacement_pointer = section.read<UInt8>();
+}
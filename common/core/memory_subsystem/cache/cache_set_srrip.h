@@ -15,6 +15,9 @@ class CacheSetSRRIP : public CacheSet
       UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      void saveReplacementState(CheckpointWriter &writer);
+      void loadReplacementState(CheckpointReader::Section &section);
+
    private:
       const UInt8 m_rrip_numbits;
       const UInt8 m_rrip_max;
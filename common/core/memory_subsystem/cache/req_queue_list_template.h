@@ -1,25 +1,68 @@
 #pragma once
 
-#include <map>
-#include <queue>
+#include <vector>
 
+#include "fixed_types.h"
 #include "log.h"
+#include "utils.h"
 
 
-// Define to use the alternate, fixed-length queue implementation
-//#define ENABLE_CIRCULAR_QUEUE
+/* Per-address FIFOs of outstanding requests, as used by the directories to serialize requests to the same line.
 
+   The addresses that have requests queued are kept in a flat, open-addressed (linear probing) table, which is
+   doubled when it becomes half full and never shrinks. Each slot stores its FIFO inline as a small ring buffer,
+   which moves to the heap only when more than INLINE_SIZE requests are waiting for the same address. So in the
+   common case of a single outstanding request per line, enqueue and dequeue do not allocate. */
 
-#ifndef ENABLE_CIRCULAR_QUEUE
+struct ReqQueueListStats
+{
+   UInt64 addresses;       // Addresses that currently have requests queued
+   UInt64 addresses_max;
+   UInt64 lookups;
+   UInt64 probes;          // Slots visited by all lookups, probes / lookups is the average probe length
+   UInt64 probes_max;
+   UInt64 overflows;       // Queues that outgrew their inline storage
+};
 
 template <class T_Req> class ReqQueueListTemplate
 {
    private:
-      std::map<IntPtr, std::queue<T_Req*>* > m_req_queue_list;
+      static const UInt32 INLINE_SIZE = 4;      // Power of two
+      static const UInt32 INITIAL_SLOTS = 16;   // Power of two
+
+      struct Slot
+      {
+         IntPtr address;
+         UInt32 head;
+         UInt32 count;                          // Zero if the slot is free
+         UInt32 capacity;                       // INLINE_SIZE, or the size of the overflow array
+         union
+         {
+            T_Req* inline_reqs[INLINE_SIZE];
+            T_Req** overflow;
+         };
+
+         // Slots move when the table grows or on erase, so never keep a pointer to inline_reqs
+         T_Req** reqs() { return capacity == INLINE_SIZE ? inline_reqs : overflow; }
+      };
+
+      std::vector<Slot> m_slots;
+      UInt32 m_shift;                           // 64 - log2(number of slots)
+      UInt32 m_size;                            // Used slots
+      ReqQueueListStats* m_stats;
+
+      // Multiplicative hashing, the upper bits have the entropy of the (cache-line aligned) address
+      UInt32 home(IntPtr address) const { return (address * 0x9e3779b97f4a7c15ULL) >> m_shift; }
+      UInt32 mask() const { return m_slots.size() - 1; }
+
+      Slot* find(IntPtr address);
+      Slot* insert(IntPtr address);
+      void erase(Slot* slot);
+      void grow();
 
    public:
-      ReqQueueListTemplate() {};
-      ~ReqQueueListTemplate() {};
+      ReqQueueListTemplate(ReqQueueListStats* stats = NULL);
+      ~ReqQueueListTemplate();
 
       void enqueue(IntPtr address, T_Req* shmem_req);
       T_Req* dequeue(IntPtr address);
@@ -30,112 +73,157 @@ template <class T_Req> class ReqQueueListTemplate
 };
 
 template <class T_Req>
-void
-ReqQueueListTemplate<T_Req>::enqueue(IntPtr address, T_Req* shmem_req)
+ReqQueueListTemplate<T_Req>::ReqQueueListTemplate(ReqQueueListStats* stats)
+   : m_slots(INITIAL_SLOTS)
+   , m_shift(64 - floorLog2(INITIAL_SLOTS))
+   , m_size(0)
+   , m_stats(stats)
 {
-   if (m_req_queue_list.count(address) == 0)
-   {
-      m_req_queue_list[address] = new std::queue<T_Req*>();
-   }
-   m_req_queue_list[address]->push(shmem_req);
+   for(UInt32 s = 0; s < m_slots.size(); ++s)
+      m_slots[s].count = 0;
 }
 
 template <class T_Req>
-T_Req*
-ReqQueueListTemplate<T_Req>::dequeue(IntPtr address)
+ReqQueueListTemplate<T_Req>::~ReqQueueListTemplate()
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
-         "Could not find a request with address(0x%x)", address);
-
-   T_Req* shmem_req = m_req_queue_list[address]->front();
-   m_req_queue_list[address]->pop();
-   if (m_req_queue_list[address]->empty())
-   {
-      delete m_req_queue_list[address];
-      m_req_queue_list.erase(address);
-   }
-   return shmem_req;
+   for(UInt32 s = 0; s < m_slots.size(); ++s)
+      if (m_slots[s].count && m_slots[s].capacity != INLINE_SIZE)
+         delete [] m_slots[s].overflow;
+   if (m_stats)
+      m_stats->addresses -= m_size;
 }
 
 template <class T_Req>
-T_Req*
-ReqQueueListTemplate<T_Req>::front(IntPtr address)
+typename ReqQueueListTemplate<T_Req>::Slot*
+ReqQueueListTemplate<T_Req>::find(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
-         "Could not find a request with address(0x%x)", address);
+   UInt32 s = home(address), probes = 1;
+   while (m_slots[s].count && m_slots[s].address != address)
+   {
+      s = (s + 1) & mask();
+      ++probes;
+   }
 
-   return m_req_queue_list[address]->front();
+   if (m_stats)
+   {
+      ++m_stats->lookups;
+      m_stats->probes += probes;
+      if (probes > m_stats->probes_max)
+         m_stats->probes_max = probes;
+   }
+   return &m_slots[s];
 }
 
 template <class T_Req>
-T_Req*
-ReqQueueListTemplate<T_Req>::back(IntPtr address)
+typename ReqQueueListTemplate<T_Req>::Slot*
+ReqQueueListTemplate<T_Req>::insert(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
-         "Could not find a request with address(0x%x)", address);
-
-   return m_req_queue_list[address]->back();
+   Slot* slot = find(address);
+   if (slot->count == 0)
+   {
+      if (2 * (m_size + 1) > m_slots.size())
+      {
+         grow();
+         slot = find(address);
+      }
+      slot->address = address;
+      slot->head = 0;
+      slot->capacity = INLINE_SIZE;
+      ++m_size;
+      if (m_stats)
+      {
+         ++m_stats->addresses;
+         if (m_stats->addresses > m_stats->addresses_max)
+            m_stats->addresses_max = m_stats->addresses;
+      }
+   }
+   return slot;
 }
 
+// Backward-shift deletion, keeps probe sequences intact without tombstones
 template <class T_Req>
-UInt32
-ReqQueueListTemplate<T_Req>::size(IntPtr address)
+void
+ReqQueueListTemplate<T_Req>::erase(Slot* slot)
 {
-   if (m_req_queue_list.count(address) == 0)
-      return 0;
-   else
-      return m_req_queue_list[address]->size();
+   UInt32 hole = slot - &m_slots[0];
+   for(UInt32 s = (hole + 1) & mask(); m_slots[s].count; s = (s + 1) & mask())
+   {
+      // An entry can move into the hole only if its home slot is not cyclically in (hole, s]
+      UInt32 h = home(m_slots[s].address);
+      bool stays = hole <= s ? (h > hole && h <= s) : (h > hole || h <= s);
+      if (stays)
+         continue;
+      m_slots[hole] = m_slots[s];
+      hole = s;
+   }
+   m_slots[hole].count = 0;
+   --m_size;
+   if (m_stats)
+      --m_stats->addresses;
 }
 
 template <class T_Req>
-bool
-ReqQueueListTemplate<T_Req>::empty(IntPtr address)
-{
-   if (m_req_queue_list.count(address) == 0)
-      return true;
-   else
-      return false;
-}
-
-
-#else // ENABLE_CIRCULAR_QUEUE
-
-
-#include "circular_queue.h"
-
-template <class T_Req> class ReqQueueListTemplate
+void
+ReqQueueListTemplate<T_Req>::grow()
 {
-   private:
-      std::map<IntPtr, CircularQueue<T_Req*> > m_req_queue_list;
+   std::vector<Slot> slots(2 * m_slots.size());
+   for(UInt32 s = 0; s < slots.size(); ++s)
+      slots[s].count = 0;
+   m_slots.swap(slots);
+   --m_shift;
 
-   public:
-      ReqQueueListTemplate() {};
-      ~ReqQueueListTemplate() {};
-
-      void enqueue(IntPtr address, T_Req* shmem_req);
-      T_Req* dequeue(IntPtr address);
-      T_Req* front(IntPtr address);
-      UInt32 size(IntPtr address);
-      bool empty(IntPtr address);
-};
+   for(UInt32 s = 0; s < slots.size(); ++s)
+   {
+      if (slots[s].count)
+      {
+         UInt32 t = home(slots[s].address);
+         while (m_slots[t].count)
+            t = (t + 1) & mask();
+         m_slots[t] = slots[s];
+      }
+   }
+}
 
 template <class T_Req>
 void
 ReqQueueListTemplate<T_Req>::enqueue(IntPtr address, T_Req* shmem_req)
 {
-   m_req_queue_list[address].push(shmem_req);
+   Slot* slot = insert(address);
+   if (slot->count == slot->capacity)
+   {
+      // Full: move to a heap array twice the size, oldest request first
+      T_Req** reqs = new T_Req*[2 * slot->capacity];
+      for(UInt32 i = 0; i < slot->count; ++i)
+         reqs[i] = slot->reqs()[(slot->head + i) & (slot->capacity - 1)];
+      if (slot->capacity != INLINE_SIZE)
+         delete [] slot->overflow;
+      else if (m_stats)
+         ++m_stats->overflows;
+      slot->overflow = reqs;
+      slot->capacity *= 2;
+      slot->head = 0;
+   }
+   slot->reqs()[(slot->head + slot->count) & (slot->capacity - 1)] = shmem_req;
+   ++slot->count;
 }
 
 template <class T_Req>
 T_Req*
 ReqQueueListTemplate<T_Req>::dequeue(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) && ! m_req_queue_list[address].empty(),
+   Slot* slot = find(address);
+   LOG_ASSERT_ERROR(slot->count != 0,
          "Could not find a request with address(0x%x)", address);
 
-   T_Req* shmem_req = m_req_queue_list[address].pop();
-   if (m_req_queue_list[address].empty())
-      m_req_queue_list.erase(address);
+   T_Req* shmem_req = slot->reqs()[slot->head];
+   slot->head = (slot->head + 1) & (slot->capacity - 1);
+   --slot->count;
+   if (slot->count == 0)
+   {
+      if (slot->capacity != INLINE_SIZE)
+         delete [] slot->overflow;
+      erase(slot);
+   }
    return shmem_req;
 }
 
@@ -143,31 +231,34 @@ template <class T_Req>
 T_Req*
 ReqQueueListTemplate<T_Req>::front(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) && ! m_req_queue_list[address].empty(),
+   Slot* slot = find(address);
+   LOG_ASSERT_ERROR(slot->count != 0,
          "Could not find a request with address(0x%x)", address);
 
-   return m_req_queue_list[address].front();
+   return slot->reqs()[slot->head];
+}
+
+template <class T_Req>
+T_Req*
+ReqQueueListTemplate<T_Req>::back(IntPtr address)
+{
+   Slot* slot = find(address);
+   LOG_ASSERT_ERROR(slot->count != 0,
+         "Could not find a request with address(0x%x)", address);
+
+   return slot->reqs()[(slot->head + slot->count - 1) & (slot->capacity - 1)];
 }
 
 template <class T_Req>
 UInt32
 ReqQueueListTemplate<T_Req>::size(IntPtr address)
 {
-   if (m_req_queue_list.count(address) == 0)
-      return 0;
-   else
-      return m_req_queue_list[address].size();
+   return find(address)->count;
 }
 
 template <class T_Req>
 bool
 ReqQueueListTemplate<T_Req>::empty(IntPtr address)
 {
-   if (m_req_queue_list.count(address) == 0 || m_req_queue_list[address].empty())
-      return true;
-   else
-      return false;
+   return find(address)->count == 0;
 }
-
-
-#endif // ENABLE_CIRCULAR_QUEUE
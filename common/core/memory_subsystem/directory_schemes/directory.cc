@@ -7,22 +7,27 @@
 #include "log.h"
 #include "config.hpp"
 
+#include <new>
+#include <cstdlib>
+
 Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_entries, UInt32 max_hw_sharers, UInt32 max_num_sharers):
    m_num_entries(num_entries),
    m_num_entries_allocated(0),
    m_max_hw_sharers(max_hw_sharers),
    m_use_max_hw_sharers(max_hw_sharers), // Value to pass through to DirectoryEntry::addSharer
    m_max_num_sharers(max_num_sharers),
-   m_limitless_software_trap_penalty(SubsecondTime::Zero())
+   m_limitless_software_trap_penalty(SubsecondTime::Zero()),
+   m_entry_valid(num_entries, false)
 {
    // Look at the type of directory and create
-   m_directory_entry_list = new DirectoryEntry*[m_num_entries];
-
    m_directory_type = parseDirectoryType(directory_type_str);
-   for (UInt32 i = 0; i < m_num_entries; i++)
-   {
-      m_directory_entry_list[i] = NULL;
-   }
+
+   if (m_directory_type == FULL_MAP)
+      m_use_max_hw_sharers = m_max_num_sharers;
+
+   m_entry_size = getEntrySize();
+   m_entries = (Byte*)calloc(m_num_entries, m_entry_size);
+   LOG_ASSERT_ERROR(m_entries, "Could not allocate %u directory entries of %u bytes", m_num_entries, m_entry_size);
 
    if (m_directory_type == LIMITLESS)
    {
@@ -43,10 +48,10 @@ Directory::~Directory()
 {
    for (UInt32 i = 0; i < m_num_entries; i++)
    {
-      if (m_directory_entry_list[i])
-         delete m_directory_entry_list[i];
+      if (m_entry_valid[i])
+         getSlot(i)->~DirectoryEntry();
    }
-   delete [] m_directory_entry_list;
+   free(m_entries);
 }
 
 DirectoryEntry*
@@ -54,18 +59,25 @@ Directory::getDirectoryEntry(UInt32 entry_num)
 {
    LOG_ASSERT_ERROR(entry_num < m_num_entries, "Invalid entry_num(%d) >= num_entries(%d)", entry_num, m_num_entries);
 
-   if (m_directory_entry_list[entry_num] == NULL)
+   if (!m_entry_valid[entry_num])
    {
-      m_directory_entry_list[entry_num] = createDirectoryEntry();
+      createDirectoryEntry(getSlot(entry_num));
+      m_entry_valid[entry_num] = true;
       ++m_num_entries_allocated;
    }
-   return m_directory_entry_list[entry_num];
+   return getSlot(entry_num);
 }
 
-void
-Directory::setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry)
+DirectoryEntry*
+Directory::evictDirectoryEntry(UInt32 entry_num)
 {
-   m_directory_entry_list[entry_num] = directory_entry;
+   DirectoryEntry* directory_entry = getDirectoryEntry(entry_num);
+   DirectoryEntry* evicted_entry = directory_entry->clone();
+
+   directory_entry->~DirectoryEntry();
+   createDirectoryEntry(directory_entry);
+
+   return evicted_entry;
 }
 
 Directory::DirectoryType
@@ -84,38 +96,71 @@ Directory::parseDirectoryType(String directory_type_str)
    }
 }
 
-DirectoryEntry*
-Directory::createDirectoryEntry()
+UInt32
+Directory::getEntrySize()
 {
-   // Specify the storage class to use for counting the directory sharers.
+   // Specify the storage class to use for counting the directory sharers, this must match createDirectoryEntry.
    // Due to alignment issues, the minimum size can already hold up to 64 nodes.
    if (m_max_num_sharers <= 64)
-      return createDirectoryEntrySized<DirectorySharersBitset<64> >();
+      return getEntrySizeSized<DirectorySharersBitset<64> >();
+   else if (m_max_num_sharers <= 128)
+      return getEntrySizeSized<DirectorySharersBitset<128> >();
+   else if (m_max_num_sharers <= 256)
+      return getEntrySizeSized<DirectorySharersBitset<256> >();
+   else if (m_max_num_sharers <= 1024)
+      return getEntrySizeSized<DirectorySharersBitset<1024> >();
+   else
+      return getEntrySizeSized<DirectorySharersVector>();
+}
+
+template <class DirectorySharers>
+UInt32
+Directory::getEntrySizeSized()
+{
+   switch (m_directory_type)
+   {
+      case FULL_MAP:
+      case LIMITED_NO_BROADCAST:
+         return sizeof(DirectoryEntryLimitedNoBroadcast<DirectorySharers>);
+
+      case LIMITLESS:
+         return sizeof(DirectoryEntryLimitless<DirectorySharers>);
+
+      default:
+         LOG_PRINT_ERROR("Unrecognized Directory Type: %u", m_directory_type);
+         return 0;
+   }
+}
+
+DirectoryEntry*
+Directory::createDirectoryEntry(void *ptr)
+{
+   if (m_max_num_sharers <= 64)
+      return createDirectoryEntrySized<DirectorySharersBitset<64> >(ptr);
    else if (m_max_num_sharers <= 128)
-      return createDirectoryEntrySized<DirectorySharersBitset<128> >();
+      return createDirectoryEntrySized<DirectorySharersBitset<128> >(ptr);
    else if (m_max_num_sharers <= 256)
-      return createDirectoryEntrySized<DirectorySharersBitset<256> >();
+      return createDirectoryEntrySized<DirectorySharersBitset<256> >(ptr);
    else if (m_max_num_sharers <= 1024)
-      return createDirectoryEntrySized<DirectorySharersBitset<1024> >();
+      return createDirectoryEntrySized<DirectorySharersBitset<1024> >(ptr);
    else
-      return createDirectoryEntrySized<DirectorySharersVector>();
+      return createDirectoryEntrySized<DirectorySharersVector>(ptr);
 }
 
 template <class DirectorySharers>
 DirectoryEntry*
-Directory::createDirectoryEntrySized()
+Directory::createDirectoryEntrySized(void *ptr)
 {
    switch (m_directory_type)
    {
       case FULL_MAP:
-         m_use_max_hw_sharers = m_max_num_sharers;
-         return new DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_num_sharers, m_max_num_sharers);
+         return new (ptr) DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_num_sharers, m_max_num_sharers);
 
       case LIMITED_NO_BROADCAST:
-         return new DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers);
+         return new (ptr) DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers);
 
       case LIMITLESS:
-         return new DirectoryEntryLimitless<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers, m_limitless_software_trap_penalty);
+         return new (ptr) DirectoryEntryLimitless<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers, m_limitless_software_trap_penalty);
 
       default:
          LOG_PRINT_ERROR("Unrecognized Directory Type: %u", m_directory_type);
@@ -5,6 +5,8 @@
 #include "fixed_types.h"
 #include "subsecond_time.h"
 
+#include <vector>
+
 class Directory
 {
    public:
@@ -27,16 +29,27 @@ class Directory
       // FIXME: Hack: Get me out of here
       SubsecondTime m_limitless_software_trap_penalty;
 
-      DirectoryEntry** m_directory_entry_list;
+      // All entries live in one block of m_num_entries * m_entry_size bytes, and are constructed in place on first use.
+      // The block is zero-filled on allocation, so pages holding entries that are never used are never touched.
+      Byte* m_entries;
+      UInt32 m_entry_size;
+      std::vector<bool> m_entry_valid;
+
+      DirectoryEntry* getSlot(UInt32 entry_num) const { return (DirectoryEntry*)(m_entries + UInt64(entry_num) * m_entry_size); }
+      UInt32 getEntrySize();
+      template <class DirectorySharers> UInt32 getEntrySizeSized();
+      DirectoryEntry* createDirectoryEntry(void *ptr);
+      template <class DirectorySharers> DirectoryEntry* createDirectoryEntrySized(void *ptr);
 
    public:
       Directory(core_id_t core_id, String directory_type_str, UInt32 num_entries, UInt32 max_hw_sharers, UInt32 max_num_sharers);
       ~Directory();
 
       DirectoryEntry* getDirectoryEntry(UInt32 entry_num);
-      void setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry);
-      DirectoryEntry* createDirectoryEntry();
-      template <class DirectorySharers> DirectoryEntry* createDirectoryEntrySized();
+      // Like getDirectoryEntry, but returns NULL instead of allocating entries that were never used
+      DirectoryEntry* peekDirectoryEntry(UInt32 entry_num) const { return m_entry_valid[entry_num] ? getSlot(entry_num) : NULL; }
+      // Moves an entry out to a separate allocation, owned by the caller, and resets entry_num to an unused entry
+      DirectoryEntry* evictDirectoryEntry(UInt32 entry_num);
 
       UInt32 getMaxHwSharers() const { return m_use_max_hw_sharers; }
 
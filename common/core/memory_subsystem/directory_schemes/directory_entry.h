@@ -6,31 +6,72 @@
 #include "subsecond_time.h"
 
 #include <vector>
-#include <bitset>
 #include <cassert>
 
-template <long Size>
-class DirectorySharersBitset : public std::bitset<Size>
+// Sharer sets are bit masks of 64-bit words: counting uses popcount and iteration skips to the next set bit
+// with count-trailing-zeros, so both take one step per word (or per sharer) instead of one per core.
+
+inline UInt32 countSharers(const UInt64 *words, UInt32 num_words)
+{
+   UInt32 num_sharers = 0;
+   for(UInt32 w = 0; w < num_words; ++w)
+      num_sharers += __builtin_popcountll(words[w]);
+   return num_sharers;
+}
+
+// Returns the first sharer >= sharer_id, or num_words * 64 if there is none
+inline UInt32 findNextSharer(const UInt64 *words, UInt32 num_words, UInt32 sharer_id)
 {
+   UInt32 w = sharer_id / 64;
+   if (w >= num_words)
+      return num_words * 64;
+   UInt64 word = words[w] & (~UInt64(0) << (sharer_id % 64));
+   while (word == 0)
+   {
+      if (++w == num_words)
+         return num_words * 64;
+      word = words[w];
+   }
+   return w * 64 + __builtin_ctzll(word);
+}
+
+// Sharer set with a compile-time capacity, stored inline in the directory entry
+template <UInt32 Size>
+class DirectorySharersBitset
+{
+   private:
+      static_assert(Size % 64 == 0, "Size must be a multiple of 64");
+      static const UInt32 NUM_WORDS = Size / 64;
+      UInt64 m_words[NUM_WORDS];
+
    public:
-      DirectorySharersBitset(UInt32 max_num_sharers) : std::bitset<Size>()
+      DirectorySharersBitset(UInt32 max_num_sharers) : m_words()
       { assert(max_num_sharers <= Size); }
+
+      UInt32 size() const { return Size; }
+      bool test(UInt32 sharer_id) const { return (m_words[sharer_id / 64] >> (sharer_id % 64)) & 1; }
+      void set(UInt32 sharer_id) { m_words[sharer_id / 64] |= UInt64(1) << (sharer_id % 64); }
+      void reset(UInt32 sharer_id) { m_words[sharer_id / 64] &= ~(UInt64(1) << (sharer_id % 64)); }
+      UInt32 count() const { return countSharers(m_words, NUM_WORDS); }
+      UInt32 findNext(UInt32 sharer_id) const { return findNextSharer(m_words, NUM_WORDS, sharer_id); }
 };
 
-class DirectorySharersVector : public std::vector<bool>
+// Sharer set for more cores than the largest DirectorySharersBitset
+class DirectorySharersVector
 {
+   private:
+      UInt32 m_size;
+      std::vector<UInt64> m_words;
+
    public:
-      DirectorySharersVector(UInt32 max_num_sharers) : std::vector<bool>(max_num_sharers, false) {}
-      UInt32 count(void) const
-      {
-         UInt32 num_sharers = 0;
-         for(UInt32 j = 0; j < this->size(); ++j) {
-            if ((*this)[j]) {
-               num_sharers ++;
-            }
-         }
-         return num_sharers;
-      }
+      DirectorySharersVector(UInt32 max_num_sharers) : m_size(max_num_sharers), m_words((max_num_sharers + 63) / 64, 0) {}
+
+      UInt32 size() const { return m_size; }
+      bool test(UInt32 sharer_id) const { return (m_words[sharer_id / 64] >> (sharer_id % 64)) & 1; }
+      void set(UInt32 sharer_id) { m_words[sharer_id / 64] |= UInt64(1) << (sharer_id % 64); }
+      void reset(UInt32 sharer_id) { m_words[sharer_id / 64] &= ~(UInt64(1) << (sharer_id % 64)); }
+      UInt32 count() const { return countSharers(m_words.data(), m_words.size()); }
+      UInt32 findNext(UInt32 sharer_id) const { return findNextSharer(m_words.data(), m_words.size(), sharer_id); }
 };
 
 class DirectoryEntry
@@ -76,6 +117,14 @@ class DirectoryEntry
       virtual core_id_t getOneSharer() = 0;
       virtual std::pair<bool, std::vector<core_id_t> > getSharersList() = 0;
 
+      // Iterate over the sharers without building a list:
+      //    for (core_id_t sharer_id = entry->getFirstSharer(); sharer_id != INVALID_CORE_ID; sharer_id = entry->getNextSharer(sharer_id))
+      core_id_t getFirstSharer() { return getNextSharer(INVALID_CORE_ID); }
+      virtual core_id_t getNextSharer(core_id_t sharer_id) = 0;
+
+      // Separately allocated copy, for entries that leave the directory's storage while they still have requests outstanding
+      virtual DirectoryEntry* clone() = 0;
+
       virtual SubsecondTime getLatency() = 0;
 };
 
@@ -97,20 +146,18 @@ class DirectoryEntrySized : public DirectoryEntry
       {
          std::pair<bool, std::vector<core_id_t> > sharers_list;
          sharers_list.first = false;
-         sharers_list.second.resize(getNumSharers());
-
-         SInt32 i = 0;
-         for(UInt32 j = 0; j < m_sharers.size(); ++j) {
-            if (m_sharers[j]) {
-               core_id_t new_sharer = j;
-               sharers_list.second[i] = new_sharer;
-               i++;
-               assert (i <= (core_id_t) m_sharers.size());
-            }
-         }
+         sharers_list.second.reserve(getNumSharers());
+
+         for(core_id_t sharer_id = getFirstSharer(); sharer_id != INVALID_CORE_ID; sharer_id = getNextSharer(sharer_id))
+            sharers_list.second.push_back(sharer_id);
 
          return sharers_list;
       }
+      virtual core_id_t getNextSharer(core_id_t sharer_id)
+      {
+         UInt32 next = m_sharers.findNext(sharer_id + 1);
+         return next < m_sharers.size() ? core_id_t(next) : INVALID_CORE_ID;
+      }
 };
 
 #endif /* __DIRECTORY_ENTRY_H__ */
@@ -21,6 +21,8 @@ class DirectoryEntryLimitedNoBroadcast : public DirectoryEntrySized<DirectorySha
 
       core_id_t getOneSharer();
 
+      DirectoryEntry* clone() { return new DirectoryEntryLimitedNoBroadcast(*this); }
+
       SubsecondTime getLatency();
 
    private:
@@ -42,7 +44,7 @@ template <class DirectorySharers>
 bool
 DirectoryEntryLimitedNoBroadcast<DirectorySharers>::hasSharer(core_id_t sharer_id)
 {
-   return this->m_sharers[sharer_id];
+   return this->m_sharers.test(sharer_id);
 }
 
 // Return value says whether the sharer was successfully added
@@ -52,14 +54,14 @@ template <class DirectorySharers>
 bool
 DirectoryEntryLimitedNoBroadcast<DirectorySharers>::addSharer(core_id_t sharer_id, UInt32 max_hw_sharers)
 {
-   assert(! this->m_sharers[sharer_id]);
+   assert(! this->m_sharers.test(sharer_id));
 
    if (this->getNumSharers() >= max_hw_sharers)
    {
       return false;
    }
 
-   this->m_sharers[sharer_id] = true;
+   this->m_sharers.set(sharer_id);
    return true;
 }
 
@@ -68,8 +70,8 @@ void
 DirectoryEntryLimitedNoBroadcast<DirectorySharers>::removeSharer(core_id_t sharer_id, bool reply_expected)
 {
    assert(!reply_expected);
-   assert(this->m_sharers[sharer_id]);
-   this->m_sharers[sharer_id] = false;
+   assert(this->m_sharers.test(sharer_id));
+   this->m_sharers.reset(sharer_id);
 }
 
 template <class DirectorySharers>
@@ -84,7 +86,7 @@ void
 DirectoryEntryLimitedNoBroadcast<DirectorySharers>::setOwner(core_id_t owner_id)
 {
    if (owner_id != INVALID_CORE_ID)
-      assert(this->m_sharers[owner_id]);
+      assert(this->m_sharers.test(owner_id));
    this->m_owner_id = owner_id;
 }
 
@@ -92,12 +94,14 @@ template <class DirectorySharers>
 core_id_t
 DirectoryEntryLimitedNoBroadcast<DirectorySharers>::getOneSharer()
 {
-   std::pair<bool, std::vector<core_id_t> > sharers_list = this->getSharersList();
-   assert(!sharers_list.first);
-   assert(sharers_list.second.size() > 0);
-
-   SInt32 index = m_rand_num.next(sharers_list.second.size());
-   return sharers_list.second[index];
+   UInt32 num_sharers = this->getNumSharers();
+   assert(num_sharers > 0);
+
+   SInt32 index = m_rand_num.next(num_sharers);
+   core_id_t sharer_id = this->getFirstSharer();
+   while (index--)
+      sharer_id = this->getNextSharer(sharer_id);
+   return sharer_id;
 }
 
 template <class DirectorySharers>
@@ -53,7 +53,11 @@ DramCache::DramCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_pe
       m_queue_model = QueueModel::create("dram-cache-queue", m_core_id, queue_model_type, m_data_array_bandwidth.getRoundedLatency(8 * m_cache_block_size)); // bytes to bits
    }
 
-   m_prefetcher = Prefetcher::createPrefetcher(Sim()->getCfg()->getString("perf_model/dram/cache/prefetcher"), "dram/cache", m_core_id, 1);
+   String prefetcher_type = Sim()->getCfg()->getString("perf_model/dram/cache/prefetcher");
+   // The DRAM cache only sees requests from the directory, which do not carry the instruction pointer
+   if (prefetcher_type == "ip_stride")
+      LOG_PRINT_ERROR("Prefetcher type ip_stride is not supported for the DRAM cache: no instruction pointer is available");
+   m_prefetcher = Prefetcher::createPrefetcher(prefetcher_type, "dram/cache", m_core_id, 1, m_cache_block_size);
    m_prefetch_on_prefetch_hit = Sim()->getCfg()->getBool("perf_model/dram/cache/prefetcher/prefetch_on_prefetch_hit");
 
    registerStatsMetric("dram-cache", m_core_id, "reads", &m_reads);
@@ -203,14 +207,15 @@ void
 DramCache::callPrefetcher(IntPtr train_address, bool cache_hit, bool prefetch_hit, SubsecondTime t_issue)
 {
    // Always train the prefetcher
-   std::vector<IntPtr> prefetchList = m_prefetcher->getNextAddress(train_address, INVALID_CORE_ID);
+   IntPtr prefetchList[Prefetcher::MAX_PREFETCHES];
+   UInt32 numPrefetches = m_prefetcher->getNextAddress(train_address, 0, INVALID_CORE_ID, prefetchList);
 
    // Only do prefetches on misses, or on hits to lines previously brought in by the prefetcher (if enabled)
    if (!cache_hit || (m_prefetch_on_prefetch_hit && prefetch_hit))
    {
-      for(std::vector<IntPtr>::iterator it = prefetchList.begin(); it != prefetchList.end(); ++it)
+      for(UInt32 i = 0; i < numPrefetches; ++i)
       {
-         IntPtr prefetch_address = *it;
+         IntPtr prefetch_address = prefetchList[i];
          if (!m_cache->peekSingleLine(prefetch_address))
          {
             // Get data from DRAM
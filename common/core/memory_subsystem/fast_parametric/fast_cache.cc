@@ -0,0 +1,103 @@
+#include "fast_cache.h"
+#include "stats.h"
+
+namespace FastParametric
+{
+
+PrivateCacheBase::PrivateCacheBase(String name, core_id_t core_id)
+   : m_clock(0)
+   , m_loads(0)
+   , m_stores(0)
+   , m_load_misses(0)
+   , m_store_misses(0)
+{
+   registerStatsMetric(name, core_id, "loads", &m_loads);
+   registerStatsMetric(name, core_id, "stores", &m_stores);
+   registerStatsMetric(name, core_id, "load-misses", &m_load_misses);
+   registerStatsMetric(name, core_id, "store-misses", &m_store_misses);
+}
+
+SharedCacheBase::SharedCacheBase(String name, core_id_t core_id, UInt32 num_sharers, bool coherent)
+   : m_coherent(coherent)
+   , m_peers(num_sharers)
+   , m_clock(0)
+   , m_loads(0)
+   , m_stores(0)
+   , m_load_misses(0)
+   , m_store_misses(0)
+   , m_upgrades(0)
+   , m_invalidations(0)
+   , m_downgrades(0)
+{
+   LOG_ASSERT_ERROR(!coherent || num_sharers <= MAX_COHERENT_SHARERS,
+                    "%s: coherence is tracked for at most %u sharers", name.c_str(), MAX_COHERENT_SHARERS);
+
+   registerStatsMetric(name, core_id, "loads", &m_loads);
+   registerStatsMetric(name, core_id, "stores", &m_stores);
+   registerStatsMetric(name, core_id, "load-misses", &m_load_misses);
+   registerStatsMetric(name, core_id, "store-misses", &m_store_misses);
+   if (m_coherent)
+   {
+      registerStatsMetric(name, core_id, "coherency-upgrades", &m_upgrades);
+      registerStatsMetric(name, core_id, "coherency-invalidates", &m_invalidations);
+      registerStatsMetric(name, core_id, "coherency-downgrades", &m_downgrades);
+   }
+}
+
+state_t
+SharedCacheBase::hit(Line* line, UInt32 sharer, Core::mem_op_t mem_op_type)
+{
+   line->lru = ++m_clock;
+   if (!m_coherent)
+      return mem_op_type == Core::WRITE ? MODIFIED : EXCLUSIVE;
+
+   UInt64 bit = UInt64(1) << sharer;
+   if (mem_op_type == Core::WRITE)
+   {
+      invalidateSharers(line, bit);
+      line->sharers = bit;
+      line->owner = sharer;
+      return MODIFIED;
+   }
+
+   if (line->owner != -1 && line->owner != (SInt32)sharer)
+   {
+      m_peers[line->owner]->downgrade(line->tag);
+      ++m_downgrades;
+      line->owner = -1;
+   }
+   line->sharers |= bit;
+   if (line->sharers == bit)
+   {
+      line->owner = sharer;
+      return EXCLUSIVE;
+   }
+   return SHARED;
+}
+
+state_t
+SharedCacheBase::fill(Line* line, IntPtr tag, UInt32 sharer, Core::mem_op_t mem_op_type)
+{
+   // Inclusive: copies of the victim cannot outlive it
+   if (m_coherent && line->valid)
+      invalidateSharers(line, 0);
+
+   line->tag = tag;
+   line->valid = true;
+   line->lru = ++m_clock;
+   line->sharers = m_coherent ? UInt64(1) << sharer : 0;
+   line->owner = m_coherent ? (SInt32)sharer : -1;
+   return mem_op_type == Core::WRITE ? MODIFIED : EXCLUSIVE;
+}
+
+void
+SharedCacheBase::invalidateSharers(Line* line, UInt64 keep)
+{
+   for(UInt64 sharers = line->sharers & ~keep; sharers; sharers &= sharers - 1)
+   {
+      m_peers[__builtin_ctzll(sharers)]->invalidate(line->tag);
+      ++m_invalidations;
+   }
+}
+
+}
@@ -0,0 +1,314 @@
+#ifndef __FAST_PARAMETRIC_CACHE_H
+#define __FAST_PARAMETRIC_CACHE_H
+
+#include "fixed_types.h"
+#include "core.h"
+#include "lock.h"
+#include "log.h"
+#include "utils.h"
+
+#include <vector>
+
+namespace FastParametric
+{
+   enum state_t
+   {
+      INVALID = 0,
+      SHARED,
+      EXCLUSIVE,
+      MODIFIED,
+   };
+
+   /* Set indexing. The precompiled cache levels have the associativity and number of sets as template constants,
+      so the way loops are unrolled and the set index is a constant mask. Geometry<0, 0> takes both at run time,
+      for configurations that have no precompiled variant. */
+   template <UInt32 t_assoc, UInt32 t_num_sets>
+   class Geometry
+   {
+      static_assert(t_assoc > 0 && (t_num_sets & (t_num_sets - 1)) == 0, "Number of sets must be a power of 2");
+
+      protected:
+         Geometry(UInt32 assoc, UInt32 num_sets)
+         {
+            LOG_ASSERT_ERROR(assoc == t_assoc && num_sets == t_num_sets, "Expected %u sets of %u ways, got %u of %u",
+                             t_num_sets, t_assoc, num_sets, assoc);
+         }
+         UInt32 assoc() const { return t_assoc; }
+         UInt32 setIndex(IntPtr tag) const { return tag & (t_num_sets - 1); }
+   };
+
+   template <>
+   class Geometry<0, 0>
+   {
+      private:
+         const UInt32 m_assoc;
+         const UInt32 m_num_sets;
+         const bool m_power2;
+
+      protected:
+         Geometry(UInt32 assoc, UInt32 num_sets)
+            : m_assoc(assoc)
+            , m_num_sets(num_sets)
+            , m_power2(isPower2(num_sets))
+         {}
+         UInt32 assoc() const { return m_assoc; }
+         UInt32 setIndex(IntPtr tag) const { return m_power2 ? tag & (m_num_sets - 1) : tag % m_num_sets; }
+   };
+
+   /* A level of one core's private hierarchy. Only that core's thread looks up and fills lines, but other cores
+      invalidate or downgrade them (through SharedCacheBase) while it runs. Tag and state share a single word per line,
+      which the other cores only change with a compare-and-swap from the exact word they found, so they can never
+      clobber a line that the owner replaced in the meantime. Likewise the owner only changes the state of a line it
+      found with a compare-and-swap, and fills lines from the coherence point while that holds its lock. */
+   class PrivateCacheBase
+   {
+      protected:
+         struct Line
+         {
+            UInt64 word;                        // tag << 2 | state, zero is an invalid line
+            UInt64 lru;                         // m_clock at the last access
+         };
+
+         static UInt64 makeWord(IntPtr tag, state_t state) { return tag << 2 | state; }
+         static state_t getState(UInt64 word) { return state_t(word & 3); }
+         static bool matches(UInt64 word, IntPtr tag) { return (word >> 2) == tag && getState(word) != INVALID; }
+
+         UInt64 m_clock;
+         UInt64 m_loads, m_stores, m_load_misses, m_store_misses;
+
+      public:
+         PrivateCacheBase(String name, core_id_t core_id);
+         virtual ~PrivateCacheBase() {}
+
+         // Look up a line, count the access and make the line most recently used. Returns INVALID on a miss
+         virtual state_t access(Core::mem_op_t mem_op_type, IntPtr tag) = 0;
+         // Look up a line without counting the access or changing the replacement order
+         virtual state_t peek(IntPtr tag) = 0;
+         // Change the state of a line in this level from the state it was found in. Fails if another core
+         // invalidated or downgraded it in the meantime
+         virtual bool setState(IntPtr tag, state_t from, state_t to) = 0;
+         // Insert a line that missed, replacing an invalid or else the least recently used line
+         virtual void insert(IntPtr tag, state_t state) = 0;
+
+         // Called by other cores
+         virtual void invalidate(IntPtr tag) = 0;
+         virtual void downgrade(IntPtr tag) = 0;
+   };
+
+   template <UInt32 t_assoc, UInt32 t_num_sets>
+   class PrivateCache : public PrivateCacheBase, private Geometry<t_assoc, t_num_sets>
+   {
+      private:
+         std::vector<Line> m_lines;
+
+         Line* find(IntPtr tag, UInt64 &word)
+         {
+            Line* lines = &m_lines[this->setIndex(tag) * this->assoc()];
+            for(UInt32 way = 0; way < this->assoc(); ++way)
+            {
+               word = __atomic_load_n(&lines[way].word, __ATOMIC_RELAXED);
+               if (matches(word, tag))
+                  return &lines[way];
+            }
+            return NULL;
+         }
+
+         static bool exchange(Line* line, UInt64 expected, UInt64 desired)
+         {
+            return __atomic_compare_exchange_n(&line->word, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+         }
+
+      public:
+         PrivateCache(UInt32 assoc, UInt32 num_sets, String name, core_id_t core_id)
+            : PrivateCacheBase(name, core_id)
+            , Geometry<t_assoc, t_num_sets>(assoc, num_sets)
+            , m_lines(assoc * num_sets, Line())
+         {}
+
+         state_t access(Core::mem_op_t mem_op_type, IntPtr tag)
+         {
+            if (mem_op_type == Core::WRITE) ++m_stores; else ++m_loads;
+            UInt64 word;
+            if (Line* line = find(tag, word))
+            {
+               line->lru = ++m_clock;
+               return getState(word);
+            }
+            if (mem_op_type == Core::WRITE) ++m_store_misses; else ++m_load_misses;
+            return INVALID;
+         }
+
+         state_t peek(IntPtr tag)
+         {
+            UInt64 word;
+            return find(tag, word) ? getState(word) : INVALID;
+         }
+
+         bool setState(IntPtr tag, state_t from, state_t to)
+         {
+            UInt64 word;
+            Line* line = find(tag, word);
+            return line && getState(word) == from && exchange(line, word, makeWord(tag, to));
+         }
+
+         void insert(IntPtr tag, state_t state)
+         {
+            Line* lines = &m_lines[this->setIndex(tag) * this->assoc()];
+            Line* victim = &lines[0];
+            for(UInt32 way = 0; way < this->assoc(); ++way)
+            {
+               if (getState(__atomic_load_n(&lines[way].word, __ATOMIC_RELAXED)) == INVALID)
+               {
+                  victim = &lines[way];
+                  break;
+               }
+               if (lines[way].lru < victim->lru)
+                  victim = &lines[way];
+            }
+            __atomic_store_n(&victim->word, makeWord(tag, state), __ATOMIC_RELAXED);
+            victim->lru = ++m_clock;
+         }
+
+         void invalidate(IntPtr tag)
+         {
+            UInt64 word;
+            if (Line* line = find(tag, word))
+               exchange(line, word, 0);
+         }
+
+         void downgrade(IntPtr tag)
+         {
+            UInt64 word;
+            if (Line* line = find(tag, word))
+               if (getState(word) != SHARED)
+                  exchange(line, word, makeWord(tag, SHARED));
+         }
+   };
+
+   /* A level shared by several cores, serialized by a lock. The first shared level is the coherence point of a
+      simple MESI protocol: it is inclusive of the private levels and remembers, for each line, which of the sharing
+      cores may have a copy and which one may have it in EXCLUSIVE or MODIFIED state. Writes invalidate all other
+      copies, a read downgrades another core's exclusive copy to SHARED, and evicting a line invalidates all of its
+      copies. Private levels evict silently, so sharers are a superset of the actual copies. */
+   class SharedCacheBase
+   {
+      public:
+         // The private levels of one of the sharing cores
+         class Peer
+         {
+            public:
+               virtual ~Peer() {}
+               virtual void invalidate(IntPtr tag) = 0;
+               virtual void downgrade(IntPtr tag) = 0;
+               // Install a line in the private levels of the requester, in the state access() or upgrade() gives it.
+               // Called with the lock held, so no invalidation or downgrade by another core can overtake it
+               virtual void fill(IntPtr tag, state_t state) = 0;
+         };
+
+         static const UInt32 MAX_COHERENT_SHARERS = 64;
+
+      protected:
+         struct Line
+         {
+            IntPtr tag;
+            UInt64 lru;
+            UInt64 sharers;                     // One bit per sharing core
+            SInt32 owner;                       // Sharing core with an EXCLUSIVE or MODIFIED copy, or -1
+            bool valid;
+         };
+
+         Lock m_lock;
+         const bool m_coherent;
+         std::vector<Peer*> m_peers;
+         UInt64 m_clock;
+         UInt64 m_loads, m_stores, m_load_misses, m_store_misses;
+         UInt64 m_upgrades, m_invalidations, m_downgrades;
+
+         // Update a line on a hit or a fill, return the state the requester gets it in
+         state_t hit(Line* line, UInt32 sharer, Core::mem_op_t mem_op_type);
+         state_t fill(Line* line, IntPtr tag, UInt32 sharer, Core::mem_op_t mem_op_type);
+         void invalidateSharers(Line* line, UInt64 keep);
+
+      public:
+         SharedCacheBase(String name, core_id_t core_id, UInt32 num_sharers, bool coherent);
+         virtual ~SharedCacheBase() {}
+
+         bool isCoherent() const { return m_coherent; }
+         void setPeer(UInt32 sharer, Peer* peer) { m_peers[sharer] = peer; }
+
+         // Look up a line for a sharing core and insert it on a miss. Returns whether it hit, and the state the
+         // requester's private levels should hold the line in. A coherent cache installs it there through Peer::fill
+         virtual bool access(UInt32 sharer, Core::mem_op_t mem_op_type, IntPtr tag, state_t &state) = 0;
+         // The requester writes to a line it found in SHARED state, or that another core took away from it since:
+         // invalidate all other copies and fill the requester's as MODIFIED, unless the line was evicted meanwhile
+         virtual void upgrade(UInt32 sharer, IntPtr tag) = 0;
+   };
+
+   template <UInt32 t_assoc, UInt32 t_num_sets>
+   class SharedCache : public SharedCacheBase, private Geometry<t_assoc, t_num_sets>
+   {
+      private:
+         std::vector<Line> m_lines;
+
+         Line* find(IntPtr tag)
+         {
+            Line* lines = &m_lines[this->setIndex(tag) * this->assoc()];
+            for(UInt32 way = 0; way < this->assoc(); ++way)
+               if (lines[way].valid && lines[way].tag == tag)
+                  return &lines[way];
+            return NULL;
+         }
+
+      public:
+         SharedCache(UInt32 assoc, UInt32 num_sets, String name, core_id_t core_id, UInt32 num_sharers, bool coherent)
+            : SharedCacheBase(name, core_id, num_sharers, coherent)
+            , Geometry<t_assoc, t_num_sets>(assoc, num_sets)
+            , m_lines(assoc * num_sets, Line())
+         {}
+
+         bool access(UInt32 sharer, Core::mem_op_t mem_op_type, IntPtr tag, state_t &state)
+         {
+            ScopedLock sl(m_lock);
+            if (mem_op_type == Core::WRITE) ++m_stores; else ++m_loads;
+            if (Line* line = find(tag))
+            {
+               state = hit(line, sharer, mem_op_type);
+               if (m_coherent)
+                  m_peers[sharer]->fill(tag, state);
+               return true;
+            }
+            if (mem_op_type == Core::WRITE) ++m_store_misses; else ++m_load_misses;
+
+            Line* lines = &m_lines[this->setIndex(tag) * this->assoc()];
+            Line* victim = &lines[0];
+            for(UInt32 way = 0; way < this->assoc(); ++way)
+            {
+               if (!lines[way].valid)
+               {
+                  victim = &lines[way];
+                  break;
+               }
+               if (lines[way].lru < victim->lru)
+                  victim = &lines[way];
+            }
+            state = fill(victim, tag, sharer, mem_op_type);
+            if (m_coherent)
+               m_peers[sharer]->fill(tag, state);
+            return false;
+         }
+
+         void upgrade(UInt32 sharer, IntPtr tag)
+         {
+            ScopedLock sl(m_lock);
+            ++m_upgrades;
+            // Gone if the line was evicted (which invalidated the requester's copy) after the requester found it
+            if (Line* line = find(tag))
+            {
+               hit(line, sharer, Core::WRITE);
+               m_peers[sharer]->fill(tag, MODIFIED);
+            }
+         }
+   };
+}
+
+#endif // __FAST_PARAMETRIC_CACHE_H
@@ -0,0 +1,275 @@
+#include "memory_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "dvfs_manager.h"
+#include "stats.h"
+#include "log.h"
+#include "utils.h"
+
+// Geometries (associativity, size in KB) that have a precompiled cache level, covering the configurations in
+// config/. Any other geometry uses a run-time Geometry<0, 0>, which gives the same results but is slower.
+#define FAST_PARAMETRIC_GEOMETRIES(X) \
+   X(4, 32) X(6, 24) X(8, 32) X(12, 48) X(8, 64) \
+   X(8, 256) X(8, 512) X(16, 512) X(16, 1024) X(12, 3072) \
+   X(16, 2048) X(16, 4096) X(16, 8192) X(16, 16384) X(20, 5120) X(20, 10240) X(20, 20480)
+
+namespace FastParametric
+{
+
+std::map<std::pair<UInt32, core_id_t>, SharedCacheBase*> MemoryManager::s_shared_caches;
+
+template <class T_Base, template <UInt32, UInt32> class T_Cache, typename... Args>
+T_Base*
+MemoryManager::createCache(UInt32 assoc, UInt32 size_kb, bool &precompiled, String name, Args... args)
+{
+   LOG_ASSERT_ERROR(assoc > 0 && size_kb * 1024 % (assoc * CACHE_LINE_SIZE) == 0,
+                    "%s: %u KB cannot be split into %u-way sets of %u-byte lines", name.c_str(), size_kb, assoc, CACHE_LINE_SIZE);
+   UInt32 num_sets = size_kb * 1024 / CACHE_LINE_SIZE / assoc;
+
+   precompiled = true;
+   #define CREATE_PRECOMPILED(t_assoc, t_size_kb) \
+      if (assoc == t_assoc && size_kb == t_size_kb) \
+         return new T_Cache<t_assoc, t_size_kb * 1024 / CACHE_LINE_SIZE / t_assoc>(assoc, num_sets, name, args...);
+   FAST_PARAMETRIC_GEOMETRIES(CREATE_PRECOMPILED)
+   #undef CREATE_PRECOMPILED
+
+   precompiled = false;
+   return new T_Cache<0, 0>(assoc, num_sets, name, args...);
+}
+
+MemoryManager::MemoryManager(Core* core, Network* network, ShmemPerfModel* shmem_perf_model)
+   : MemoryManagerFast(core, network, shmem_perf_model)
+   , m_coherence_point(NULL)
+   , m_fill_levels(NULL)
+   , m_fill_count(0)
+   , m_dram_reads(0)
+   , m_dram_writes(0)
+   , m_dram_total_latency(SubsecondTime::Zero())
+{
+   const ComponentPeriod *global_domain = Sim()->getDvfsManager()->getGlobalDomain();
+   core_id_t core_id = core->getId();
+
+   UInt32 smt_cores = Sim()->getCfg()->getInt("perf_model/core/logical_cpus");
+   UInt32 last_level_cache = Sim()->getCfg()->getInt("perf_model/cache/levels") - 2 + MemComponent::L2_CACHE;
+   bool coherent = Sim()->getCfg()->getBool("caching_protocol/fast_parametric/coherent");
+
+   for(UInt32 i = MemComponent::FIRST_LEVEL_CACHE; i <= last_level_cache; ++i)
+   {
+      String configName, objectName;
+      switch((MemComponent::component_t)i) {
+         case MemComponent::L1_ICACHE:
+            configName = "l1_icache";
+            objectName = "L1-I";
+            break;
+         case MemComponent::L1_DCACHE:
+            configName = "l1_dcache";
+            objectName = "L1-D";
+            break;
+         default:
+            String level = itostr(i - MemComponent::L2_CACHE + 2);
+            configName = "l" + level + "_cache";
+            objectName = "L" + level;
+            break;
+      }
+
+      const ComponentPeriod *clock_domain = NULL;
+      String domain_name = Sim()->getCfg()->getStringArray("perf_model/" + configName + "/dvfs_domain", core_id);
+      if (domain_name == "core")
+         clock_domain = core->getDvfsDomain();
+      else if (domain_name == "global")
+         clock_domain = global_domain;
+      else
+         LOG_PRINT_ERROR("dvfs_domain %s is invalid", domain_name.c_str());
+
+      LOG_ASSERT_ERROR(Sim()->getCfg()->getInt("perf_model/" + configName + "/cache_block_size") == CACHE_LINE_SIZE,
+                       "The fast_parametric caching protocol requires a cache block size of %u for the %s", CACHE_LINE_SIZE, configName.c_str());
+      if (Sim()->getCfg()->getStringArray("perf_model/" + configName + "/address_hash", core_id) != "mask")
+         LOG_PRINT_WARNING_ONCE("The fast_parametric caching protocol only supports address_hash = mask");
+      if (Sim()->getCfg()->getStringArray("perf_model/" + configName + "/replacement_policy", core_id) != "lru")
+         LOG_PRINT_WARNING_ONCE("The fast_parametric caching protocol only supports replacement_policy = lru");
+
+      UInt32 size_kb = Sim()->getCfg()->getIntArray("perf_model/" + configName + "/cache_size", core_id);
+      UInt32 assoc = Sim()->getCfg()->getIntArray("perf_model/" + configName + "/associativity", core_id);
+      ComponentLatency data_latency(clock_domain, Sim()->getCfg()->getIntArray("perf_model/" + configName + "/data_access_time", core_id));
+      ComponentLatency tags_latency(clock_domain, Sim()->getCfg()->getIntArray("perf_model/" + configName + "/tags_access_time", core_id));
+      UInt32 shared_cores = Sim()->getCfg()->getIntArray("perf_model/" + configName + "/shared_cores", core_id) * smt_cores;
+      // As in ParametricDramDirectoryMSI: no caches shared between non-application threads
+      if (core_id >= (core_id_t) Sim()->getConfig()->getApplicationCores())
+         shared_cores = 1;
+
+      bool precompiled;
+      if (i < MemComponent::L2_CACHE || shared_cores == 1)
+      {
+         LOG_ASSERT_ERROR(m_shared.empty(), "The fast_parametric caching protocol does not support a private %s below a shared cache", objectName.c_str());
+
+         PrivateCacheBase* cache = createCache<PrivateCacheBase, PrivateCache>(assoc, size_kb, precompiled, objectName, core_id);
+         PrivateLevel level = { cache, data_latency, tags_latency };
+         if (i != MemComponent::L1_ICACHE)
+            m_private[false].push_back(level);
+         if (i != MemComponent::L1_DCACHE)
+            m_private[true].push_back(level);
+         m_private_caches.push_back(cache);
+      }
+      else
+      {
+         core_id_t master = core_id - core_id % shared_cores;
+         std::pair<UInt32, core_id_t> key(i, master);
+         if (core_id == master)
+         {
+            bool level_coherent = coherent && m_shared.empty();
+            if (level_coherent && shared_cores > SharedCacheBase::MAX_COHERENT_SHARERS)
+            {
+               LOG_PRINT_WARNING("The fast_parametric caching protocol does not keep more than %u cores sharing the %s coherent",
+                                 SharedCacheBase::MAX_COHERENT_SHARERS, objectName.c_str());
+               level_coherent = false;
+            }
+            s_shared_caches[key] = createCache<SharedCacheBase, SharedCache>(assoc, size_kb, precompiled, objectName, core_id, shared_cores, level_coherent);
+         }
+         else
+         {
+            LOG_ASSERT_ERROR(s_shared_caches.count(key), "%s of core %d was not created by core %d", objectName.c_str(), core_id, master);
+            precompiled = true;
+         }
+
+         SharedLevel level = { s_shared_caches[key], UInt32(core_id - master), data_latency, tags_latency };
+         level.cache->setPeer(level.sharer, this);
+         m_shared.push_back(level);
+      }
+
+      if (!precompiled)
+         LOG_PRINT_WARNING("%s of core %d: no precompiled fast cache for %u KB with associativity %u, using a slower generic one",
+                           objectName.c_str(), core_id, size_kb, assoc);
+   }
+
+   if (!m_shared.empty() && m_shared[0].cache->isCoherent())
+      m_coherence_point = m_shared[0].cache;
+   else if (coherent && Sim()->getConfig()->getApplicationCores() > 1 && core_id == 0)
+      LOG_PRINT_WARNING("The fast_parametric caching protocol only keeps caches coherent below a shared cache level");
+
+   m_dram_latency = SubsecondTime::FS() * static_cast<uint64_t>(TimeConverter<float>::NStoFS(Sim()->getCfg()->getFloat("perf_model/dram/latency")));
+   registerStatsMetric("dram", core_id, "reads", &m_dram_reads);
+   registerStatsMetric("dram", core_id, "writes", &m_dram_writes);
+   registerStatsMetric("dram", core_id, "total-access-latency", &m_dram_total_latency);
+}
+
+MemoryManager::~MemoryManager()
+{
+   for(UInt32 i = 0; i < m_private_caches.size(); ++i)
+      delete m_private_caches[i];
+   // The shared caches are left alone, other cores may still be destroying theirs
+}
+
+SubsecondTime
+MemoryManager::coreInitiateMemoryAccessFast(bool use_icache, Core::mem_op_t mem_op_type, IntPtr address)
+{
+   IntPtr tag = address >> CACHE_LINE_BITS;
+   const std::vector<PrivateLevel> &levels = m_private[use_icache];
+   SubsecondTime latency = SubsecondTime::Zero();
+
+   for(UInt32 level = 0; level < levels.size(); ++level)
+   {
+      state_t state = levels[level].cache->access(mem_op_type, tag);
+      if (state == INVALID)
+      {
+         latency += levels[level].tags_latency.getLatency();
+         continue;
+      }
+
+      if (mem_op_type == Core::WRITE && state != MODIFIED)
+      {
+         // Only the coherence point hands out SHARED lines, and only it takes lines away from us, in which case
+         // changing the state fails. It then invalidates the other copies and fills ours as MODIFIED.
+         if (state == SHARED || !levels[level].cache->setState(tag, state, MODIFIED))
+         {
+            LOG_ASSERT_ERROR(m_coherence_point, "Line %lx changed state without a coherent shared cache", tag);
+            m_fill_levels = &levels;
+            m_fill_count = level + 1;
+            m_coherence_point->upgrade(m_shared[0].sharer, tag);
+            return latency + m_shared[0].data_latency.getLatency() + levels[level].data_latency.getLatency();
+         }
+         state = MODIFIED;
+      }
+      if (level > 0)
+      {
+         for(UInt32 above = 0; above < level; ++above)
+            levels[above].cache->insert(tag, state);
+         // Another core may have invalidated or downgraded the line since we found it. invalidate() and downgrade()
+         // visit the levels from the bottom up, so either they see the copies just made, or we see their change here.
+         if (m_coherence_point)
+         {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            state_t current = levels[level].cache->peek(tag);
+            for(UInt32 above = 0; above < level && current != state; ++above)
+            {
+               if (current == INVALID)
+                  levels[above].cache->invalidate(tag);
+               else
+                  levels[above].cache->downgrade(tag);
+            }
+         }
+      }
+      return latency + levels[level].data_latency.getLatency();
+   }
+
+   // The coherence point fills the private levels, before it lets go of the line
+   m_fill_levels = &levels;
+   m_fill_count = levels.size();
+
+   bool hit = false;
+   for(UInt32 level = 0; level < m_shared.size() && !hit; ++level)
+   {
+      state_t shared_state;
+      hit = m_shared[level].cache->access(m_shared[level].sharer, mem_op_type, tag, shared_state);
+      latency += hit ? m_shared[level].data_latency.getLatency() : m_shared[level].tags_latency.getLatency();
+   }
+
+   if (!hit)
+   {
+      if (mem_op_type == Core::WRITE) ++m_dram_writes; else ++m_dram_reads;
+      m_dram_total_latency += m_dram_latency;
+      latency += m_dram_latency;
+   }
+
+   if (!m_coherence_point)
+      fill(tag, mem_op_type == Core::WRITE ? MODIFIED : EXCLUSIVE);
+   return latency;
+}
+
+void
+MemoryManager::invalidate(IntPtr tag)
+{
+   // Bottom up, see coreInitiateMemoryAccessFast
+   for(UInt32 i = m_private_caches.size(); i > 0; --i)
+   {
+      m_private_caches[i - 1]->invalidate(tag);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   }
+}
+
+void
+MemoryManager::downgrade(IntPtr tag)
+{
+   for(UInt32 i = m_private_caches.size(); i > 0; --i)
+   {
+      m_private_caches[i - 1]->downgrade(tag);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   }
+}
+
+void
+MemoryManager::fill(IntPtr tag, state_t state)
+{
+   const std::vector<PrivateLevel> &levels = *m_fill_levels;
+   for(UInt32 level = 0; level < m_fill_count; ++level)
+   {
+      // Only the level that hit on an upgrade can still hold the line
+      state_t current = levels[level].cache->peek(tag);
+      if (current == INVALID)
+         levels[level].cache->insert(tag, state);
+      else
+         levels[level].cache->setState(tag, current, state);
+   }
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef __FAST_PARAMETRIC_H
+#define __FAST_PARAMETRIC_H
+
+#include "memory_manager_fast.h"
+#include "fast_cache.h"
+
+#include <map>
+
+namespace FastParametric
+{
+   /* Fast-cache hierarchy built from the regular perf_model/l*_cache geometries, latencies and shared_cores.
+      Private levels come first, followed by any shared levels; the first shared level keeps the private levels
+      coherent. There is no timing model beyond a fixed latency per level: an access costs the tags_access_time of
+      each level that misses plus the data_access_time of the level that hits (or the DRAM latency). */
+   class MemoryManager : public MemoryManagerFast, public SharedCacheBase::Peer
+   {
+      private:
+         struct PrivateLevel
+         {
+            PrivateCacheBase* cache;
+            ComponentLatency data_latency, tags_latency;
+         };
+         struct SharedLevel
+         {
+            SharedCacheBase* cache;
+            UInt32 sharer;                      // Index of this core among the cores sharing the cache
+            ComponentLatency data_latency, tags_latency;
+         };
+
+         std::vector<PrivateLevel> m_private[2];     // Lookup order for data (L1-D first) and instructions (L1-I first)
+         std::vector<PrivateCacheBase*> m_private_caches;
+         std::vector<SharedLevel> m_shared;
+         SharedCacheBase* m_coherence_point;         // m_shared[0].cache when it tracks coherence, else NULL
+
+         // Private levels that fill() installs the line of the access in progress into
+         const std::vector<PrivateLevel>* m_fill_levels;
+         UInt32 m_fill_count;
+
+         SubsecondTime m_dram_latency;
+         UInt64 m_dram_reads, m_dram_writes;
+         SubsecondTime m_dram_total_latency;
+
+         // Shared caches by level and first core of the sharing group, created by that core
+         static std::map<std::pair<UInt32, core_id_t>, SharedCacheBase*> s_shared_caches;
+
+         template <class T_Base, template <UInt32, UInt32> class T_Cache, typename... Args>
+         static T_Base* createCache(UInt32 assoc, UInt32 size_kb, bool &precompiled, String name, Args... args);
+
+      public:
+         MemoryManager(Core* core, Network* network, ShmemPerfModel* shmem_perf_model);
+         ~MemoryManager();
+
+         SubsecondTime coreInitiateMemoryAccessFast(
+               bool use_icache,
+               Core::mem_op_t mem_op_type,
+               IntPtr address);
+
+         void invalidate(IntPtr tag);
+         void downgrade(IntPtr tag);
+         void fill(IntPtr tag, state_t state);
+   };
+}
+
+#endif // __FAST_PARAMETRIC_H
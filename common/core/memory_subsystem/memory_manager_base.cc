@@ -4,6 +4,7 @@
 #include "parametric_dram_directory_msi/memory_manager.h"
 #include "slme_dram_directory_msi/global_memory_manager.h"
 #include "fast_nehalem/memory_manager.h"
+#include "fast_parametric/memory_manager.h"
 #include "log.h"
 #include "config.hpp"
 
@@ -21,6 +22,9 @@ MemoryManagerBase::createMMU(String protocol_type,
       case FAST_NEHALEM:
          return new FastNehalem::MemoryManager(core, network, shmem_perf_model);
 
+      case FAST_PARAMETRIC:
+         return new FastParametric::MemoryManager(core, network, shmem_perf_model);
+
       case SINGLE_LEVEL_MEMORY:
          return new SingleLevelMemory::GlobalMemoryManager(core, network, shmem_perf_model);
 
@@ -37,6 +41,8 @@ MemoryManagerBase::parseProtocolType(String& protocol_type)
       return PARAMETRIC_DRAM_DIRECTORY_MSI;
    else if (protocol_type == "fast_nehalem")
       return FAST_NEHALEM;
+   else if (protocol_type == "fast_parametric")
+      return FAST_PARAMETRIC;
    else if (protocol_type == "single_level_memory")
       return SINGLE_LEVEL_MEMORY;
    else
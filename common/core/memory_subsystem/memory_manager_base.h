@@ -19,6 +19,7 @@ class MemoryManagerBase
       {
          PARAMETRIC_DRAM_DIRECTORY_MSI,
          FAST_NEHALEM,
+         FAST_PARAMETRIC,
          SINGLE_LEVEL_MEMORY,
          NUM_CACHING_PROTOCOL_TYPES
       };
@@ -51,7 +52,8 @@ class MemoryManagerBase
             Core::mem_op_t mem_op_type,
             IntPtr address, UInt32 offset,
             Byte* data_buf, UInt32 data_length,
-            Core::MemModeled modeled) = 0;
+            Core::MemModeled modeled,
+            IntPtr eip = 0) = 0;
       virtual SubsecondTime coreInitiateMemoryAccessFast(
             bool icache,
             Core::mem_op_t mem_op_type,
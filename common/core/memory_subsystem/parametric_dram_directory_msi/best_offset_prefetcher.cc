@@ -0,0 +1,96 @@
+#include "best_offset_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+#include "utils.h"
+
+#include <algorithm>
+
+BestOffsetPrefetcher::BestOffsetPrefetcher(String configName, core_id_t core_id, UInt32 cache_block_size)
+   : m_block_shift(floorLog2(cache_block_size))
+   , m_score_max(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/best_offset/score_max", core_id))
+   , m_round_max(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/best_offset/round_max", core_id))
+   , m_bad_score(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/best_offset/bad_score", core_id))
+   , m_recent_lines(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/best_offset/rr_size", core_id))
+   , m_test_index(0)
+   , m_round(0)
+   , m_best_offset(1)
+{
+   LOG_ASSERT_ERROR(m_recent_lines.size() > 0, "perf_model/%s/prefetcher/best_offset/rr_size must be positive", configName.c_str());
+
+   // Candidates are the offsets up to one page whose only prime factors are 2, 3 and 5
+   UInt32 lines_per_page = 1 << (PAGE_SHIFT - m_block_shift);
+   for(UInt32 offset = 1; offset < lines_per_page; ++offset)
+   {
+      UInt32 n = offset;
+      while (n % 2 == 0) n /= 2;
+      while (n % 3 == 0) n /= 3;
+      while (n % 5 == 0) n /= 5;
+      if (n == 1)
+         m_offsets.push_back(offset);
+   }
+   LOG_ASSERT_ERROR(m_offsets.size() > 0, "Cache block size %d too large for the best-offset prefetcher", cache_block_size);
+   m_scores.resize(m_offsets.size(), 0);
+}
+
+UInt32
+BestOffsetPrefetcher::getRecentIndex(IntPtr line) const
+{
+   return (line ^ (line >> 8)) % m_recent_lines.size();
+}
+
+void
+BestOffsetPrefetcher::endLearningPhase()
+{
+   UInt32 best = 0;
+   for(UInt32 i = 1; i < m_offsets.size(); ++i)
+      if (m_scores[i] > m_scores[best])
+         best = i;
+
+   m_best_offset = m_scores[best] > m_bad_score ? m_offsets[best] : 0;
+
+   std::fill(m_scores.begin(), m_scores.end(), 0);
+   m_test_index = 0;
+   m_round = 0;
+}
+
+UInt32
+BestOffsetPrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses)
+{
+   IntPtr line = current_address >> m_block_shift;
+
+   // Learning: score the next candidate offset if the line that would have triggered this access was seen recently
+   SInt64 offset = m_offsets[m_test_index];
+   IntPtr base_line = line - offset;
+   if ((base_line >> (PAGE_SHIFT - m_block_shift)) == (line >> (PAGE_SHIFT - m_block_shift))
+      && m_recent_lines[getRecentIndex(base_line)] == base_line + 1)
+   {
+      if (++m_scores[m_test_index] >= m_score_max)
+      {
+         // Clear winner, no need to finish the phase
+         m_test_index = m_offsets.size() - 1;
+         m_round = m_round_max - 1;
+      }
+   }
+
+   if (++m_test_index == m_offsets.size())
+   {
+      m_test_index = 0;
+      if (++m_round >= m_round_max)
+         endLearningPhase();
+   }
+
+   // The original design inserts X into the recent requests table when the prefetch for X + D completes, which
+   // requires fill notifications. We insert each accessed line instead, i.e., we assume prefetches are timely.
+   m_recent_lines[getRecentIndex(line)] = line + 1;
+
+   if (m_best_offset == 0)
+      return 0;
+
+   IntPtr prefetch_line = line + m_best_offset;
+   if ((prefetch_line >> (PAGE_SHIFT - m_block_shift)) != (line >> (PAGE_SHIFT - m_block_shift)))
+      return 0;
+
+   addresses[0] = prefetch_line << m_block_shift;
+   return 1;
+}
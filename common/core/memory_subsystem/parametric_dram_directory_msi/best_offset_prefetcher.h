@@ -0,0 +1,39 @@
+#ifndef __BEST_OFFSET_PREFETCHER_H
+#define __BEST_OFFSET_PREFETCHER_H
+
+#include "prefetcher.h"
+
+#include <vector>
+
+// Best-offset prefetcher (Michaud, HPCA 2016). On each access to line X, it prefetches line X + D within the
+// same page, where the offset D is chosen by a learning process running alongside: every access tests one
+// candidate offset d by looking up X - d in a table of recently accessed lines, and scores d on a hit.
+// After <round_max> passes over all candidates, or once a candidate reaches <score_max>, the highest scoring
+// offset becomes D. Prefetching is turned off while the best score is at most <bad_score>.
+class BestOffsetPrefetcher : public Prefetcher
+{
+   public:
+      BestOffsetPrefetcher(String configName, core_id_t core_id, UInt32 cache_block_size);
+      UInt32 getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses);
+
+   private:
+      static const UInt32 PAGE_SHIFT = 12;
+
+      const UInt32 m_block_shift;
+      const UInt32 m_score_max;
+      const UInt32 m_round_max;
+      const UInt32 m_bad_score;
+
+      std::vector<SInt64> m_offsets;      //< Candidate offsets, in cache lines
+      std::vector<UInt32> m_scores;
+      std::vector<IntPtr> m_recent_lines; //< Recent requests table, direct mapped, holds line numbers + 1 (0 is empty)
+
+      UInt32 m_test_index;
+      UInt32 m_round;
+      SInt64 m_best_offset;               //< Offset in use, 0 when prefetching is off
+
+      UInt32 getRecentIndex(IntPtr line) const;
+      void endLearningPhase();
+};
+
+#endif // __BEST_OFFSET_PREFETCHER_H
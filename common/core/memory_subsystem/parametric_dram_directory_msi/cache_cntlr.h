@@ -10,6 +10,7 @@
 #include "semaphore.h"
 #include "lock.h"
 #include "setlock.h"
+#include "mshr_table.h"
 #include "fixed_types.h"
 #include "shmem_perf_model.h"
 #include "contention_model.h"
@@ -141,11 +142,6 @@ namespace ParametricDramDirectoryMSI
 
    typedef ReqQueueListTemplate<CacheDirectoryWaiter> CacheDirectoryWaiterMap;
 
-   struct MshrEntry {
-      SubsecondTime t_issue, t_complete;
-   };
-   typedef std::unordered_map<IntPtr, MshrEntry> Mshr;
-
    class CacheMasterCntlr
    {
       private:
@@ -157,9 +153,11 @@ namespace ParametricDramDirectoryMSI
          DramCntlrInterface* m_dram_cntlr;
          ContentionModel* m_dram_outstanding_writebacks;
 
-         Mshr mshr;
+         LockWaitStats m_mshr_wait;
+         MshrTable mshr;   //< Completion times of recent misses, looked up without locking
          ContentionModel m_l1_mshr;
          ContentionModel m_next_level_read_bandwidth;
+         ReqQueueListStats m_directory_waiters_stats;
          CacheDirectoryWaiterMap m_directory_waiters;
          IntPtr m_evicting_address;
          Byte* m_evicting_buf;
@@ -167,6 +165,7 @@ namespace ParametricDramDirectoryMSI
          std::vector<ATD*> m_atds;
 
          std::vector<SetLock> m_setlocks;
+         LockWaitStats m_setlock_wait;
          UInt32 m_log_blocksize;
          UInt32 m_num_sets;
 
@@ -180,19 +179,34 @@ namespace ParametricDramDirectoryMSI
             String replacement_policy, CacheBase::hash_t hash_function);
          void accessATDs(Core::mem_op_t mem_op_type, bool hit, IntPtr address, UInt32 core_num);
 
-         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses)
+         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses, UInt32 mshr_banks, UInt32 mshr_entries)
             : m_cache(NULL)
             , m_prefetcher(NULL)
             , m_dram_cntlr(NULL)
             , m_dram_outstanding_writebacks(NULL)
+            , m_mshr_wait()
+            , mshr(mshr_banks, mshr_entries, &m_mshr_wait)
             , m_l1_mshr(name + ".mshr", core_id, outstanding_misses)
             , m_next_level_read_bandwidth(name + ".next_read", core_id)
+            , m_directory_waiters_stats()
+            , m_directory_waiters(&m_directory_waiters_stats)
             , m_evicting_address(0)
             , m_evicting_buf(NULL)
             , m_atds()
+            , m_setlock_wait()
             , m_prefetch_list()
             , m_prefetch_next(SubsecondTime::Zero())
-         {}
+         {
+            registerStatsMetric(name, core_id, "mshr-lock-contended", &m_mshr_wait.contended);
+            registerStatsMetric(name, core_id, "mshr-lock-wait-time", &m_mshr_wait.wait_time);
+            registerStatsMetric(name, core_id, "setlock-contended", &m_setlock_wait.contended);
+            registerStatsMetric(name, core_id, "setlock-wait-time", &m_setlock_wait.wait_time);
+            registerStatsMetric(name, core_id, "directory-waiters-addresses-max", &m_directory_waiters_stats.addresses_max);
+            registerStatsMetric(name, core_id, "directory-waiters-lookups", &m_directory_waiters_stats.lookups);
+            registerStatsMetric(name, core_id, "directory-waiters-probes", &m_directory_waiters_stats.probes);
+            registerStatsMetric(name, core_id, "directory-waiters-probes-max", &m_directory_waiters_stats.probes_max);
+            registerStatsMetric(name, core_id, "directory-waiters-overflows", &m_directory_waiters_stats.overflows);
+         }
          ~CacheMasterCntlr();
 
          friend class CacheCntlr;
@@ -213,6 +227,7 @@ namespace ParametricDramDirectoryMSI
          bool m_passthrough;
          bool m_coherent;
          bool m_prefetch_on_prefetch_hit;
+         IntPtr m_eip; //< Instruction pointer of the access being processed, passed to the prefetcher
          bool m_l1_mshr;
 
          struct {
@@ -225,7 +240,8 @@ namespace ParametricDramDirectoryMSI
            UInt64 loads_prefetch, stores_prefetch;
            UInt64 hits_prefetch, // lines which were prefetched and subsequently used by a non-prefetch access
                   evict_prefetch, // lines which were prefetched and evicted before being used
-                  invalidate_prefetch; // lines which were prefetched and invalidated before being used
+                  invalidate_prefetch, // lines which were prefetched and invalidated before being used
+                  hits_prefetch_late; // hits_prefetch where the prefetch was still in flight
                   // Note: hits_prefetch+evict_prefetch+invalidate_prefetch will not account for all prefetched lines,
                   // some may still be in the cache, or could have been removed for some other reason.
                   // Also, in a shared cache, the prefetch may have been triggered by another core than the one
@@ -237,6 +253,7 @@ namespace ParametricDramDirectoryMSI
            SubsecondTime snoop_latency;
            SubsecondTime qbs_query_latency;
            SubsecondTime mshr_latency;
+           SubsecondTime prefetch_late_latency; // part of mshr_latency spent waiting for late prefetches
            UInt64 prefetches;
            UInt64 coherency_downgrades, coherency_upgrades, coherency_invalidates, coherency_writebacks;
            #ifdef ENABLE_TRANSITIONS
@@ -250,7 +267,6 @@ namespace ParametricDramDirectoryMSI
          #endif
 
          void updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cache_hit, CacheState::cstate_t state, Prefetch::prefetch_type_t isPrefetch);
-         void cleanupMshr();
          void transition(IntPtr address, Transition::reason_t reason, CacheState::cstate_t old_state, CacheState::cstate_t new_state);
          void updateUncoreStatistics(HitWhere::where_t hit_where, SubsecondTime now);
 
@@ -378,7 +394,8 @@ namespace ParametricDramDirectoryMSI
                IntPtr ca_address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
                bool modeled,
-               bool count);
+               bool count,
+               IntPtr eip = 0);
          void updateHits(Core::mem_op_t mem_op_type, UInt64 hits);
 
          // Notify next level cache of so it can update its sharing set
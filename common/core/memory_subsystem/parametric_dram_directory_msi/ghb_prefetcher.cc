@@ -1,6 +1,7 @@
 #include "ghb_prefetcher.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "log.h"
 
 #include <algorithm>
 
@@ -16,22 +17,23 @@ GhbPrefetcher::GhbPrefetcher(String configName, core_id_t core_id)
    , m_tableHead(0)
    , m_ghbTable(m_tableSize)
 {
+   LOG_ASSERT_ERROR(m_prefetchWidth * m_prefetchDepth <= MAX_PREFETCHES, "perf_model/%s/prefetcher/ghb/width * depth can be at most %d", configName.c_str(), MAX_PREFETCHES);
 }
 
 GhbPrefetcher::~GhbPrefetcher()
 {
 }
 
-std::vector<IntPtr>
-GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
+UInt32
+GhbPrefetcher::getNextAddress(IntPtr currentAddress, IntPtr eip, core_id_t core_id, IntPtr *prefetchList)
 {
-   std::vector<IntPtr> prefetchList;
+   UInt32 numPrefetches = 0;
 
    //deal with prefether initialization
    if (m_lastAddress == INVALID_ADDRESS)
    {
       m_lastAddress = currentAddress;
-      return prefetchList;
+      return numPrefetches;
    }
 
    //determine the delta with the last address
@@ -64,8 +66,8 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
             newAddress += m_ghb[(ghbIndex + depth)%m_ghbSize].delta;
 
             //add address to the list if it wasn't in there already
-            if (find(prefetchList.begin(), prefetchList.end(), newAddress) == prefetchList.end())
-               prefetchList.push_back(newAddress);
+            if (std::find(prefetchList, prefetchList + numPrefetches, newAddress) == prefetchList + numPrefetches)
+               prefetchList[numPrefetches++] = newAddress;
 
             ++depth;
          }
@@ -133,5 +135,5 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
       m_generation = (m_generation + 1) % 4;
    }
 
-   return prefetchList;
+   return numPrefetches;
 }
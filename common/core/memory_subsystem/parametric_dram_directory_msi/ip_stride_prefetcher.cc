@@ -0,0 +1,65 @@
+#include "ip_stride_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+static const IntPtr PAGE_MASK = ~IntPtr(4096 - 1);
+
+IpStridePrefetcher::IpStridePrefetcher(String configName, core_id_t core_id)
+   : m_degree(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/degree", core_id))
+   , m_stop_at_page(Sim()->getCfg()->getBoolArray("perf_model/" + configName + "/prefetcher/ip_stride/stop_at_page_boundary", core_id))
+   , m_table(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/table_size", core_id))
+{
+   LOG_ASSERT_ERROR(m_table.size() > 0, "perf_model/%s/prefetcher/ip_stride/table_size must be positive", configName.c_str());
+   LOG_ASSERT_ERROR(m_degree <= MAX_PREFETCHES, "perf_model/%s/prefetcher/ip_stride/degree can be at most %d", configName.c_str(), MAX_PREFETCHES);
+}
+
+UInt32
+IpStridePrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses)
+{
+   // Accesses without a known instruction pointer (prefetches, page walks, ...) cannot be attributed to a stream
+   if (eip == 0)
+      return 0;
+
+   Entry &entry = m_table[eip % m_table.size()];
+
+   if (entry.eip != eip)
+   {
+      // Replace the entry, the stride is known from the next access onwards
+      entry.eip = eip;
+      entry.last_address = current_address;
+      entry.stride = 0;
+      entry.confidence = 0;
+      return 0;
+   }
+
+   SInt64 stride = current_address - entry.last_address;
+   if (stride == 0)
+      // Repeated access to the same cache line, nothing new to learn
+      return 0;
+   entry.last_address = current_address;
+
+   if (stride == entry.stride)
+   {
+      if (entry.confidence < CONFIDENCE_MAX)
+         entry.confidence++;
+   }
+   else if (entry.confidence > 0)
+      entry.confidence--;
+   else
+      entry.stride = stride;
+
+   UInt32 num_addresses = 0;
+   if (entry.confidence >= CONFIDENCE_THRESHOLD)
+   {
+      for(UInt32 i = 1; i <= m_degree; ++i)
+      {
+         IntPtr prefetch_address = current_address + i * entry.stride;
+         if (m_stop_at_page && (prefetch_address & PAGE_MASK) != (current_address & PAGE_MASK))
+            break;
+         addresses[num_addresses++] = prefetch_address;
+      }
+   }
+
+   return num_addresses;
+}
@@ -0,0 +1,35 @@
+#ifndef __IP_STRIDE_PREFETCHER_H
+#define __IP_STRIDE_PREFETCHER_H
+
+#include "prefetcher.h"
+
+#include <vector>
+
+// Stride prefetcher with a direct-mapped table indexed by the instruction pointer of the access. Each entry
+// tracks the last address and stride of one instruction, and a 2-bit confidence counter. Once the same stride
+// has been seen repeatedly, the next <degree> addresses along the stride are prefetched.
+class IpStridePrefetcher : public Prefetcher
+{
+   public:
+      IpStridePrefetcher(String configName, core_id_t core_id);
+      UInt32 getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses);
+
+   private:
+      static const UInt32 CONFIDENCE_MAX = 3;
+      static const UInt32 CONFIDENCE_THRESHOLD = 2;
+
+      struct Entry
+      {
+         IntPtr eip;
+         IntPtr last_address;
+         SInt64 stride;
+         UInt32 confidence;
+         Entry() : eip(0), last_address(0), stride(0), confidence(0) {}
+      };
+
+      const UInt32 m_degree;
+      const bool m_stop_at_page;
+      std::vector<Entry> m_table;
+};
+
+#endif // __IP_STRIDE_PREFETCHER_H
@@ -4,6 +4,7 @@
 #include "nuca_cache.h"
 #include "dram_cache.h"
 #include "tlb.h"
+#include "page_walker.h"
 #include "simulator.h"
 #include "log.h"
 #include "dvfs_manager.h"
@@ -38,6 +39,7 @@ MemoryManager::MemoryManager(Core* core,
    m_dram_directory_cntlr(NULL),
    m_dram_cntlr(NULL),
    m_itlb(NULL), m_dtlb(NULL), m_stlb(NULL),
+   m_page_walker(NULL),
    m_tlb_miss_penalty(NULL,0),
    m_tlb_miss_parallel(false),
    m_tag_directory_present(false),
@@ -306,6 +308,10 @@ MemoryManager::MemoryManager(Core* core,
       m_cache_cntlrs[(MemComponent::component_t)(i + 1)]->setPrevCacheCntlrs(prev_cache_cntlrs);
    }
 
+   // Page walks read the page table through the L1-D
+   if ((m_itlb || m_dtlb) && Sim()->getCfg()->getBool("perf_model/mmu/enabled"))
+      m_page_walker = new PageWalker(getCore()->getId(), m_cache_cntlrs[MemComponent::L1_DCACHE], getCacheBlockSize(), getShmemPerfModel());
+
    // Create Performance Models
    for(UInt32 i = MemComponent::FIRST_LEVEL_CACHE; i <= (UInt32)m_last_level_cache; ++i)
       m_cache_perf_models[(MemComponent::component_t)i] = CachePerfModel::create(
@@ -341,11 +347,13 @@ MemoryManager::MemoryManager(Core* core,
       // only have effect within a set as we see it. Turn of optimization...
       if (num_sets != (1UL << floorLog2(num_sets)))
          num_sets = 1;
-      for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
+      config::Handle<SInt64> l1_dcache_size = Sim()->getCfg()->getHandle<SInt64>("perf_model/l1_dcache/cache_size");
+      config::Handle<String> l1_dcache_address_hash = Sim()->getCfg()->getHandle<String>("perf_model/l1_dcache/address_hash");
+      for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores() && num_sets > 1; ++core_id)
       {
-         if (Sim()->getCfg()->getIntArray("perf_model/l1_dcache/cache_size", core_id) != cache_parameters[MemComponent::L1_DCACHE].size)
+         if (l1_dcache_size.get(core_id) != cache_parameters[MemComponent::L1_DCACHE].size)
             num_sets = 1;
-         if (Sim()->getCfg()->getStringArray("perf_model/l1_dcache/address_hash", core_id) != "mask")
+         if (l1_dcache_address_hash.get(core_id) != "mask")
             num_sets = 1;
          // FIXME: We really should check all cache levels
       }
@@ -383,6 +391,7 @@ MemoryManager::~MemoryManager()
 
    // Delete the Models
 
+   if (m_page_walker) delete m_page_walker;
    if (m_itlb) delete m_itlb;
    if (m_dtlb) delete m_dtlb;
    if (m_stlb) delete m_stlb;
@@ -421,15 +430,16 @@ MemoryManager::coreInitiateMemoryAccess(
       Core::mem_op_t mem_op_type,
       IntPtr address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
-      Core::MemModeled modeled)
+      Core::MemModeled modeled,
+      IntPtr eip)
 {
    LOG_ASSERT_ERROR(mem_component <= m_last_level_cache,
       "Error: invalid mem_component (%d) for coreInitiateMemoryAccess", mem_component);
 
    if (mem_component == MemComponent::L1_ICACHE && m_itlb)
-      accessTLB(m_itlb, address, true, modeled);
+      accessTLB(m_itlb, address, true, lock_signal, modeled);
    else if (mem_component == MemComponent::L1_DCACHE && m_dtlb)
-      accessTLB(m_dtlb, address, false, modeled);
+      accessTLB(m_dtlb, address, false, lock_signal, modeled);
 
    return m_cache_cntlrs[mem_component]->processMemOpFromCore(
          lock_signal,
@@ -437,7 +447,8 @@ MemoryManager::coreInitiateMemoryAccess(
          address, offset,
          data_buf, data_length,
          modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT ? false : true,
-         modeled == Core::MEM_MODELED_NONE ? false : true);
+         modeled == Core::MEM_MODELED_NONE ? false : true,
+         eip);
 }
 
 void
@@ -605,10 +616,31 @@ MYLOG("bcast msg");
 }
 
 void
-MemoryManager::accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::MemModeled modeled)
+MemoryManager::accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::lock_signal_t lock_signal, Core::MemModeled modeled)
 {
-   bool hit = tlb->lookup(address, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
+   UInt32 page_shift = m_page_walker ? m_page_walker->getPageShift(address) : 12;
+   bool hit = tlb->lookup(address, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD), true, page_shift);
    if (hit == false
+       && !(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT)
+       && m_page_walker && lock_signal != Core::UNLOCK
+   )
+   {
+      // Walk the page table through the cache hierarchy, which advances our time by the walk latency
+      SubsecondTime t_start = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+      SubsecondTime latency = m_page_walker->walk(address, page_shift) + m_tlb_miss_penalty.getLatency();
+      if (m_tlb_miss_parallel)
+      {
+         incrElapsedTime(m_tlb_miss_penalty.getLatency(), ShmemPerfModel::_USER_THREAD);
+      }
+      else
+      {
+         // Serialized page walk: move its latency from the memory access to a pseudo instruction
+         getShmemPerfModel()->setElapsedTime(ShmemPerfModel::_USER_THREAD, t_start);
+         PseudoInstruction *i = new TLBMissInstruction(latency, isIfetch);
+         getCore()->getPerformanceModel()->queuePseudoInstruction(i);
+      }
+   }
+   else if (hit == false
        && !(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT)
        && m_tlb_miss_penalty.getLatency() != SubsecondTime::Zero()
    )
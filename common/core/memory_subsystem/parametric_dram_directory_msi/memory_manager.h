@@ -22,6 +22,7 @@ class ShmemPerf;
 namespace ParametricDramDirectoryMSI
 {
    class TLB;
+   class PageWalker;
 
    typedef std::pair<core_id_t, MemComponent::component_t> CoreComponentType;
    typedef std::map<CoreComponentType, CacheCntlr*> CacheCntlrMap;
@@ -37,6 +38,7 @@ namespace ParametricDramDirectoryMSI
          AddressHomeLookup* m_tag_directory_home_lookup;
          AddressHomeLookup* m_dram_controller_home_lookup;
          TLB *m_itlb, *m_dtlb, *m_stlb;
+         PageWalker *m_page_walker;
          ComponentLatency m_tlb_miss_penalty;
          bool m_tlb_miss_parallel;
 
@@ -62,7 +64,7 @@ namespace ParametricDramDirectoryMSI
          // Global map of all caches on all cores (within this process!)
          static CacheCntlrMap m_all_cache_cntlrs;
 
-         void accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::MemModeled modeled);
+         void accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::lock_signal_t lock_signal, Core::MemModeled modeled);
 
       public:
          MemoryManager(Core* core, Network* network, ShmemPerfModel* shmem_perf_model);
@@ -90,7 +92,8 @@ namespace ParametricDramDirectoryMSI
                Core::mem_op_t mem_op_type,
                IntPtr address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
-               Core::MemModeled modeled);
+               Core::MemModeled modeled,
+               IntPtr eip = 0);
 
          void handleMsgFromNetwork(NetPacket& packet);
 
@@ -0,0 +1,184 @@
+#include "page_walker.h"
+#include "cache_cntlr.h"
+#include "shmem_perf_model.h"
+#include "simulator.h"
+#include "stats.h"
+#include "utils.h"
+#include "log.h"
+#include "config.hpp"
+
+#include <stdio.h>
+
+namespace ParametricDramDirectoryMSI
+{
+
+static const char* level_names[] = { "pml4", "pdp", "pd", "pt" };
+static_assert(PageWalker::NUM_LEVELS == sizeof(level_names) / sizeof(level_names[0]),
+              "Not enough values in level_names");
+
+static UInt32 parsePageSize(UInt64 page_size)
+{
+   UInt32 page_shift = floorLog2(page_size);
+   LOG_ASSERT_ERROR((1ULL << page_shift) == page_size && (page_shift == 12 || page_shift == 21 || page_shift == 30),
+                    "Invalid page size %ld, only 4KB, 2MB and 1GB pages are supported", page_size);
+   return page_shift;
+}
+
+PageSizeMap::PageSizeMap()
+{
+   m_default_page_shift = parsePageSize(Sim()->getCfg()->getInt("perf_model/mmu/page_size"));
+
+   String filename = Sim()->getCfg()->getString("perf_model/mmu/page_size_file");
+   if (filename != "")
+   {
+      FILE *fp = fopen(filename.c_str(), "r");
+      LOG_ASSERT_ERROR(fp, "Cannot open page size file %s", filename.c_str());
+
+      unsigned long start, end, page_size;
+      while (fscanf(fp, "%lx %lx %lu", &start, &end, &page_size) == 3)
+      {
+         Range range = { end, parsePageSize(page_size) };
+         LOG_ASSERT_ERROR(start < end && (start & (page_size - 1)) == 0 && (end & (page_size - 1)) == 0,
+                          "Invalid range %lx-%lx in %s, must be aligned to its page size", start, end, filename.c_str());
+         m_ranges[start] = range;
+      }
+      fclose(fp);
+   }
+}
+
+UInt32
+PageSizeMap::getPageShift(IntPtr address) const
+{
+   std::map<IntPtr, Range>::const_iterator it = m_ranges.upper_bound(address);
+   if (it == m_ranges.begin())
+      return m_default_page_shift;
+   --it;
+   return address < it->second.end ? it->second.page_shift : m_default_page_shift;
+}
+
+
+PageSizeMap *PageWalker::s_page_size_map = NULL;
+UInt32 PageWalker::s_num_users = 0;
+
+PageWalker::PageWalker(core_id_t core_id, CacheCntlr *l1_dcache_cntlr, UInt32 cache_block_size, ShmemPerfModel *shmem_perf_model)
+   : m_l1_dcache_cntlr(l1_dcache_cntlr)
+   , m_cache_block_size(cache_block_size)
+   , m_shmem_perf_model(shmem_perf_model)
+   , m_last_page(-1)
+   , m_last_page_shift(0)
+   , m_walk_latency(SubsecondTime::Zero())
+{
+   // Memory managers are created sequentially during startup, so no locking is needed here
+   if (!s_page_size_map)
+      s_page_size_map = new PageSizeMap();
+   ++s_num_users;
+
+   for(UInt32 level = 0; level < NUM_LEVELS; ++level)
+   {
+      m_walks[level] = 0;
+      m_levels[level].pwc_access = m_levels[level].pwc_miss = 0;
+      m_levels[level].access = m_levels[level].miss = 0;
+      m_levels[level].latency = SubsecondTime::Zero();
+
+      String prefix = String(level_names[level]) + "-";
+      if (level < LEVEL_PT)
+      {
+         // Page walk caches are fully associative, and hold one entry (pointing to a next-level table) per block
+         UInt32 size = Sim()->getCfg()->getIntArray(String("perf_model/mmu/pwc/") + level_names[level] + "_size", core_id);
+         m_walk_caches[level] = size ? new Cache(String("mmu-pwc-") + level_names[level], "perf_model/mmu", core_id, 1, size, 1 << 12, "lru", CacheBase::PR_L1_CACHE) : NULL;
+         registerStatsMetric("mmu", core_id, prefix + "pwc-access", &m_levels[level].pwc_access);
+         registerStatsMetric("mmu", core_id, prefix + "pwc-miss", &m_levels[level].pwc_miss);
+      }
+      registerStatsMetric("mmu", core_id, prefix + "access", &m_levels[level].access);
+      registerStatsMetric("mmu", core_id, prefix + "miss", &m_levels[level].miss);
+      registerStatsMetric("mmu", core_id, prefix + "latency", &m_levels[level].latency);
+   }
+   registerStatsMetric("mmu", core_id, "walks-1gb", &m_walks[LEVEL_PDP]);
+   registerStatsMetric("mmu", core_id, "walks-2mb", &m_walks[LEVEL_PD]);
+   registerStatsMetric("mmu", core_id, "walks-4kb", &m_walks[LEVEL_PT]);
+   registerStatsMetric("mmu", core_id, "walk-latency", &m_walk_latency);
+}
+
+PageWalker::~PageWalker()
+{
+   for(UInt32 level = 0; level < LEVEL_PT; ++level)
+      if (m_walk_caches[level])
+         delete m_walk_caches[level];
+
+   if (--s_num_users == 0)
+   {
+      delete s_page_size_map;
+      s_page_size_map = NULL;
+   }
+}
+
+UInt32
+PageWalker::getPageShift(IntPtr address)
+{
+   // Addresses within the same 4KB page always have the same page size
+   if ((address >> 12) != m_last_page)
+   {
+      m_last_page = address >> 12;
+      m_last_page_shift = s_page_size_map->getPageShift(address);
+   }
+   return m_last_page_shift;
+}
+
+IntPtr
+PageWalker::getEntryAddress(IntPtr address, UInt32 level)
+{
+   // Each level has its tables back-to-back in a 1TB region, the table for a given set of upper address bits
+   // sits at their index, so an entry's location is simply its index at this level times the 8-byte entry size
+   const IntPtr va_mask = (1ULL << 48) - 1;
+   return PAGE_TABLE_BASE + (IntPtr(level) << 40) + (((address & va_mask) >> getLevelShift(level)) << 3);
+}
+
+SubsecondTime
+PageWalker::walk(IntPtr address, UInt32 page_shift)
+{
+   SubsecondTime t_start = m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+   UInt32 leaf = LEVEL_PT - (page_shift - 12) / 9;
+
+   // Find the deepest non-leaf level with its entry in a page walk cache, the walk continues below it
+   UInt32 first = LEVEL_PML4;
+   for(SInt32 level = leaf - 1; level >= LEVEL_PML4; --level)
+   {
+      if (!m_walk_caches[level])
+         continue;
+      m_levels[level].pwc_access++;
+      if (m_walk_caches[level]->accessSingleLine((address >> getLevelShift(level)) << 12, Cache::LOAD, NULL, 0, t_start, true))
+      {
+         first = level + 1;
+         break;
+      }
+      m_levels[level].pwc_miss++;
+   }
+
+   for(UInt32 level = first; level <= leaf; ++level)
+   {
+      SubsecondTime t_level = m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+      IntPtr entry = getEntryAddress(address, level);
+
+      HitWhere::where_t hit_where = m_l1_dcache_cntlr->processMemOpFromCore(Core::NONE, Core::READ, entry & ~IntPtr(m_cache_block_size - 1), entry & (m_cache_block_size - 1), NULL, 8, true, true);
+
+      m_levels[level].access++;
+      if (hit_where != HitWhere::L1_OWN)
+         m_levels[level].miss++;
+      m_levels[level].latency += m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD) - t_level;
+
+      if (level < leaf && m_walk_caches[level])
+      {
+         bool eviction;
+         IntPtr evict_addr;
+         CacheBlockInfo evict_block_info;
+         m_walk_caches[level]->insertSingleLine((address >> getLevelShift(level)) << 12, NULL, &eviction, &evict_addr, &evict_block_info, NULL, t_start);
+      }
+   }
+
+   SubsecondTime latency = m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD) - t_start;
+   m_walks[leaf]++;
+   m_walk_latency += latency;
+   return latency;
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef PAGE_WALKER_H
+#define PAGE_WALKER_H
+
+#include "fixed_types.h"
+#include "cache.h"
+#include "subsecond_time.h"
+
+#include <map>
+
+class ShmemPerfModel;
+
+namespace ParametricDramDirectoryMSI
+{
+   class CacheCntlr;
+
+   // Page size of each virtual address: perf_model/mmu/page_size, except for the address ranges listed in
+   // perf_model/mmu/page_size_file. Shared by all cores, read-only after construction.
+   class PageSizeMap
+   {
+      private:
+         struct Range
+         {
+            IntPtr end;
+            UInt32 page_shift;
+         };
+         UInt32 m_default_page_shift;
+         std::map<IntPtr, Range> m_ranges; //< Indexed by range start
+
+      public:
+         PageSizeMap();
+         UInt32 getPageShift(IntPtr address) const;
+   };
+
+   // Hardware page walker for an x86-64 style 4-level radix page table. Page table entries are read through the
+   // L1-D cache, with page walk caches for the upper levels (PML4, PDP and PD entries) that allow skipping them.
+   // Page tables are laid out linearly in a reserved part of the address space, so neighbouring pages share the
+   // cache lines holding their entries.
+   class PageWalker
+   {
+      public:
+         enum level_t
+         {
+            LEVEL_PML4 = 0,
+            LEVEL_PDP,
+            LEVEL_PD,
+            LEVEL_PT,
+            NUM_LEVELS
+         };
+
+         PageWalker(core_id_t core_id, CacheCntlr *l1_dcache_cntlr, UInt32 cache_block_size, ShmemPerfModel *shmem_perf_model);
+         ~PageWalker();
+
+         UInt32 getPageShift(IntPtr address);
+         // Walk the page table for address, mapped by a page of size 1 << page_shift. Advances the user thread's time, returns the walk latency.
+         SubsecondTime walk(IntPtr address, UInt32 page_shift);
+
+      private:
+         static const IntPtr PAGE_TABLE_BASE = 0xffff800000000000ULL;
+
+         CacheCntlr *m_l1_dcache_cntlr;
+         UInt32 m_cache_block_size;
+         ShmemPerfModel *m_shmem_perf_model;
+         Cache *m_walk_caches[LEVEL_PT];    //< Page walk cache for each non-leaf level, NULL when disabled
+
+         static PageSizeMap *s_page_size_map;
+         static UInt32 s_num_users;
+         // Most recent page size lookup
+         IntPtr m_last_page;
+         UInt32 m_last_page_shift;
+
+         UInt64 m_walks[NUM_LEVELS];        //< Walks ending at each level, i.e. for 1GB, 2MB and 4KB pages
+         SubsecondTime m_walk_latency;
+         struct
+         {
+            UInt64 pwc_access, pwc_miss;
+            UInt64 access, miss;            //< Page table entry reads, and those that missed the L1-D
+            SubsecondTime latency;
+         } m_levels[NUM_LEVELS];
+
+         static UInt32 getLevelShift(UInt32 level) { return 12 + 9 * (LEVEL_PT - level); }
+         IntPtr getEntryAddress(IntPtr address, UInt32 level);
+   };
+}
+
+#endif // PAGE_WALKER_H
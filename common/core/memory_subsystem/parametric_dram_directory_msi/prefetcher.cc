@@ -4,8 +4,10 @@
 #include "log.h"
 #include "simple_prefetcher.h"
 #include "ghb_prefetcher.h"
+#include "ip_stride_prefetcher.h"
+#include "best_offset_prefetcher.h"
 
-Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores)
+Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores, UInt32 cache_block_size)
 {
    if (type == "none")
       return NULL;
@@ -13,6 +15,10 @@ Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id
       return new SimplePrefetcher(configName, core_id, shared_cores);
    else if (type == "ghb")
       return new GhbPrefetcher(configName, core_id);
+   else if (type == "ip_stride")
+      return new IpStridePrefetcher(configName, core_id);
+   else if (type == "best_offset")
+      return new BestOffsetPrefetcher(configName, core_id, cache_block_size);
 
    LOG_PRINT_ERROR("Invalid prefetcher type %s", type.c_str());
 }
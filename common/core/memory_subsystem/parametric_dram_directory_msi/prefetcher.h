@@ -3,14 +3,19 @@
 
 #include "fixed_types.h"
 
-#include <vector>
-
 class Prefetcher
 {
    public:
-      static Prefetcher* createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores);
+      // Maximum number of addresses a prefetcher may return for a single access
+      static const UInt32 MAX_PREFETCHES = 16;
+
+      static Prefetcher* createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores, UInt32 cache_block_size);
+
+      virtual ~Prefetcher() {}
 
-      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id) = 0;
+      // Train the prefetcher on an access to current_address by the instruction at eip (0 if unknown),
+      // write up to MAX_PREFETCHES addresses to prefetch into addresses, and return how many were written
+      virtual UInt32 getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses) = 0;
 };
 
 #endif // PREFETCHER_H
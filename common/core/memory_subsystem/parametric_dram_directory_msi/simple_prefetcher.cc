@@ -1,6 +1,7 @@
 #include "simple_prefetcher.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "log.h"
 
 #include <cstdlib>
 
@@ -15,16 +16,15 @@ SimplePrefetcher::SimplePrefetcher(String configName, core_id_t _core_id, UInt32
    , num_prefetches(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/simple/num_prefetches", core_id))
    , stop_at_page(Sim()->getCfg()->getBoolArray("perf_model/" + configName + "/prefetcher/simple/stop_at_page_boundary", core_id))
    , n_flow_next(0)
-   , m_prev_address(flows_per_core ? shared_cores : 1)
+   , m_prev_address((flows_per_core ? shared_cores : 1) * n_flows)
 {
-   for(UInt32 idx = 0; idx < (flows_per_core ? shared_cores : 1); ++idx)
-      m_prev_address.at(idx).resize(n_flows);
+   LOG_ASSERT_ERROR(num_prefetches <= MAX_PREFETCHES, "perf_model/%s/prefetcher/simple/num_prefetches can be at most %d", configName.c_str(), MAX_PREFETCHES);
 }
 
-std::vector<IntPtr>
-SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
+UInt32
+SimplePrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t _core_id, IntPtr *addresses)
 {
-   std::vector<IntPtr> &prev_address = m_prev_address.at(flows_per_core ? _core_id - core_id : 0);
+   IntPtr *prev_address = &m_prev_address.at((flows_per_core ? _core_id - core_id : 0) * n_flows);
 
    UInt32 n_flow = n_flow_next;
    IntPtr min_dist = PAGE_SIZE;
@@ -48,7 +48,7 @@ SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
    IntPtr stride = current_address - prev_address[n_flow];
    prev_address[n_flow] = current_address;
 
-   std::vector<IntPtr> addresses;
+   UInt32 num_addresses = 0;
    if (stride != 0)
    {
       for(unsigned int i = 0; i < num_prefetches; ++i)
@@ -56,9 +56,9 @@ SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
          IntPtr prefetch_address = current_address + i * stride;
          // But stay within the page if requested
          if (!stop_at_page || ((prefetch_address & PAGE_MASK) == (current_address & PAGE_MASK)))
-            addresses.push_back(prefetch_address);
+            addresses[num_addresses++] = prefetch_address;
       }
    }
 
-   return addresses;
+   return num_addresses;
 }
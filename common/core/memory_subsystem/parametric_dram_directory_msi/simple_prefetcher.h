@@ -3,11 +3,13 @@
 
 #include "prefetcher.h"
 
+#include <vector>
+
 class SimplePrefetcher : public Prefetcher
 {
    public:
       SimplePrefetcher(String configName, core_id_t core_id, UInt32 shared_cores);
-      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id);
+      virtual UInt32 getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id, IntPtr *addresses);
 
    private:
       const core_id_t core_id;
@@ -17,7 +19,7 @@ class SimplePrefetcher : public Prefetcher
       const UInt32 num_prefetches;
       const bool stop_at_page;
       UInt32 n_flow_next;
-      std::vector<std::vector<IntPtr> > m_prev_address;
+      std::vector<IntPtr> m_prev_address; //< n_flows previous addresses for each core (or for all cores)
 };
 
 #endif // __SIMPLE_PREFETCHER_H
@@ -19,9 +19,9 @@ TLB::TLB(String name, String cfgname, core_id_t core_id, UInt32 num_entries, UIn
 }
 
 bool
-TLB::lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss)
+TLB::lookupTag(IntPtr tag, SubsecondTime now, bool allocate_on_miss)
 {
-   bool hit = m_cache.accessSingleLine(address, Cache::LOAD, NULL, 0, now, true);
+   bool hit = m_cache.accessSingleLine(tag, Cache::LOAD, NULL, 0, now, true);
 
    m_access++;
 
@@ -32,28 +32,28 @@ TLB::lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss)
 
    if (m_next_level)
    {
-      hit = m_next_level->lookup(address, now, false /* no allocation */);
+      hit = m_next_level->lookupTag(tag, now, false /* no allocation */);
    }
 
    if (allocate_on_miss)
    {
-      allocate(address, now);
+      allocateTag(tag, now);
    }
 
    return hit;
 }
 
 void
-TLB::allocate(IntPtr address, SubsecondTime now)
+TLB::allocateTag(IntPtr tag, SubsecondTime now)
 {
    bool eviction;
    IntPtr evict_addr;
    CacheBlockInfo evict_block_info;
-   m_cache.insertSingleLine(address, NULL, &eviction, &evict_addr, &evict_block_info, NULL, now);
+   m_cache.insertSingleLine(tag, NULL, &eviction, &evict_addr, &evict_block_info, NULL, now);
 
    // Use next level as a victim cache
    if (eviction && m_next_level)
-      m_next_level->allocate(evict_addr, now);
+      m_next_level->allocateTag(evict_addr, now);
 }
 
 }
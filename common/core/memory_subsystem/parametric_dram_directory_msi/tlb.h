@@ -20,10 +20,18 @@ namespace ParametricDramDirectoryMSI
          TLB *m_next_level;
 
          UInt64 m_access, m_miss;
+
+         // Entries for 4KB, 2MB and 1GB pages share the same structure: tag on page number and page size
+         static IntPtr getTag(IntPtr address, UInt32 page_shift) { return ((address >> page_shift) | (IntPtr(page_shift - SIM_PAGE_SHIFT) << 46)) << SIM_PAGE_SHIFT; }
+         bool lookupTag(IntPtr tag, SubsecondTime now, bool allocate_on_miss);
+         void allocateTag(IntPtr tag, SubsecondTime now);
+
       public:
          TLB(String name, String cfgname, core_id_t core_id, UInt32 num_entries, UInt32 associativity, TLB *next_level);
-         bool lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss = true);
-         void allocate(IntPtr address, SubsecondTime now);
+         bool lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss = true, UInt32 page_shift = SIM_PAGE_SHIFT)
+         { return lookupTag(getTag(address, page_shift), now, allocate_on_miss); }
+         void allocate(IntPtr address, SubsecondTime now, UInt32 page_shift = SIM_PAGE_SHIFT)
+         { allocateTag(getTag(address, page_shift), now); }
    };
 }
 
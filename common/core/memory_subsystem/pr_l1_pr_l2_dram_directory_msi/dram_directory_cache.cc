@@ -1,6 +1,8 @@
 #include "dram_directory_cache.h"
 #include "log.h"
 #include "utils.h"
+#include "simulator.h"
+#include "checkpoint_manager.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -15,6 +17,7 @@ DramDirectoryCache::DramDirectoryCache(
       UInt32 max_num_sharers,
       ComponentLatency dram_directory_cache_access_time,
       ShmemPerfModel* shmem_perf_model):
+   m_core_id(core_id),
    m_total_entries(total_entries),
    m_associativity(associativity),
    m_cache_block_size(cache_block_size),
@@ -25,15 +28,18 @@ DramDirectoryCache::DramDirectoryCache(
 
    // Instantiate the directory
    m_directory = new Directory(core_id, directory_type_str, total_entries, max_hw_sharers, max_num_sharers);
-   m_replacement_ptrs = new UInt32[m_num_sets];
+   m_replacement_ptrs = new UInt32[m_num_sets]();
 
    // Logs
    m_log_num_sets = floorLog2(m_num_sets);
    m_log_cache_block_size = floorLog2(m_cache_block_size);
+
+   Sim()->getCheckpointManager()->registerObject("dram-directory", m_core_id, this);
 }
 
 DramDirectoryCache::~DramDirectoryCache()
 {
+   Sim()->getCheckpointManager()->unregisterObject("dram-directory", m_core_id);
    delete m_replacement_ptrs;
    delete m_directory;
 }
@@ -120,11 +126,11 @@ DramDirectoryCache::replaceDirectoryEntry(IntPtr replaced_address, IntPtr addres
       DirectoryEntry* replaced_directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
       if (replaced_directory_entry->getAddress() == replaced_address)
       {
-         m_replaced_directory_entry_list.push_back(replaced_directory_entry);
+         // The replaced entry keeps serving its outstanding requests from a separate copy
+         m_replaced_directory_entry_list.push_back(m_directory->evictDirectoryEntry(set_index * m_associativity + i));
 
-         DirectoryEntry* directory_entry = m_directory->createDirectoryEntry();
+         DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
          directory_entry->setAddress(address);
-         m_directory->setDirectoryEntry(set_index * m_associativity + i, directory_entry);
 
          return directory_entry;
       }
@@ -153,6 +159,67 @@ DramDirectoryCache::invalidateDirectoryEntry(IntPtr address)
    LOG_PRINT_ERROR("");
 }
 
+void
+DramDirectoryCache::saveState(CheckpointWriter &writer)
+{
+   writer.write(m_num_sets);
+   writer.write(m_associativity);
+   writer.write(m_replacement_ptrs, m_num_sets * sizeof(UInt32));
+
+   UInt32 num_valid = 0;
+   for (UInt32 i = 0; i < m_total_entries; i++)
+   {
+      DirectoryEntry* directory_entry = m_directory->peekDirectoryEntry(i);
+      if (directory_entry && directory_entry->getAddress() != INVALID_ADDRESS)
+         ++num_valid;
+   }
+   writer.write(num_valid);
+
+   for (UInt32 i = 0; i < m_total_entries; i++)
+   {
+      DirectoryEntry* directory_entry = m_directory->peekDirectoryEntry(i);
+      if (!directory_entry || directory_entry->getAddress() == INVALID_ADDRESS)
+         continue;
+
+      std::vector<core_id_t> sharers = directory_entry->getSharersList().second;
+      writer.write(i);
+      writer.write(directory_entry->getAddress());
+      writer.write<UInt32>(directory_entry->getDirectoryBlockInfo()->getDState());
+      writer.write(directory_entry->getOwner());
+      writer.writeVector(sharers);
+   }
+}
+
+void
+DramDirectoryCache::loadState(CheckpointReader::Section &section)
+{
+   UInt32 num_sets = section.read<UInt32>();
+   UInt32 associativity = section.read<UInt32>();
+   LOG_ASSERT_ERROR(num_sets == m_num_sets && associativity == m_associativity,
+      "Directory: checkpoint has %d sets and %d ways, but the directory has %d sets and %d ways",
+      num_sets, associativity, m_num_sets, m_associativity);
+   section.read(m_replacement_ptrs, m_num_sets * sizeof(UInt32));
+
+   UInt32 num_valid = section.read<UInt32>();
+   for (UInt32 n = 0; n < num_valid; n++)
+   {
+      UInt32 index = section.read<UInt32>();
+      LOG_ASSERT_ERROR(index < m_total_entries, "Directory: invalid entry %d in checkpoint", index);
+      DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(index);
+
+      directory_entry->setAddress(section.read<IntPtr>());
+      directory_entry->getDirectoryBlockInfo()->setDState((DirectoryState::dstate_t)section.read<UInt32>());
+      core_id_t owner = section.read<core_id_t>();
+
+      std::vector<core_id_t> sharers(section.read<UInt64>());
+      section.read(sharers.data(), sharers.size() * sizeof(core_id_t));
+      for (std::vector<core_id_t>::iterator it = sharers.begin(); it != sharers.end(); ++it)
+         directory_entry->addSharer(*it, m_directory->getMaxHwSharers());
+      // The owner must already be a sharer
+      directory_entry->setOwner(owner);
+   }
+}
+
 void
 DramDirectoryCache::splitAddress(IntPtr address, IntPtr& tag, UInt32& set_index)
 {
@@ -5,12 +5,14 @@
 #include "directory.h"
 #include "shmem_perf_model.h"
 #include "subsecond_time.h"
+#include "checkpoint.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
-   class DramDirectoryCache
+   class DramDirectoryCache : public Checkpointable
    {
       private:
+         core_id_t m_core_id;
          Directory* m_directory;
          UInt32* m_replacement_ptrs;
          std::vector<DirectoryEntry*> m_replaced_directory_entry_list;
@@ -53,5 +55,9 @@ namespace PrL1PrL2DramDirectoryMSI
          void getReplacementCandidates(IntPtr address, std::vector<DirectoryEntry*>& replacement_candidate_list);
 
          UInt32 getMaxHwSharers() const { return m_directory->getMaxHwSharers(); }
+
+         // Entries that were replaced but still have outstanding requests are not checkpointed
+         void saveState(CheckpointWriter &writer);
+         void loadState(CheckpointReader::Section &section);
    };
 }
@@ -23,6 +23,7 @@ namespace PrL1PrL2DramDirectoryMSI
          AddressHomeLookup* m_dram_controller_home_lookup;
          DramDirectoryCache* m_dram_directory_cache;
          ReqQueueList* m_dram_directory_req_queue_list;
+         ReqQueueListStats m_req_queue_stats;
 
          NucaCache* m_nuca_cache;
 
@@ -64,7 +64,8 @@ DirectoryMSIPolicy::DirectoryMSIPolicy(
          dram_directory_max_num_sharers,
          dram_directory_cache_access_time,
          m_shmem_perf_model);
-   m_dram_directory_req_queue_list = new ReqQueueList();
+   m_req_queue_stats = ReqQueueListStats();
+   m_dram_directory_req_queue_list = new ReqQueueList(&m_req_queue_stats);
    for(DirectoryState::dstate_t state = DirectoryState::dstate_t(0); state < DirectoryState::NUM_DIRECTORY_STATES; state = DirectoryState::dstate_t(int(state)+1))
    {
       if (state != DirectoryState::UNCACHED)
@@ -75,6 +76,11 @@ DirectoryMSIPolicy::DirectoryMSIPolicy(
    }
    registerStatsMetric("directory", core_id, "forward", &forward);
    registerStatsMetric("directory", core_id, "forward-failed", &forward_failed);
+   registerStatsMetric("directory", core_id, "req-queue-addresses-max", &m_req_queue_stats.addresses_max);
+   registerStatsMetric("directory", core_id, "req-queue-lookups", &m_req_queue_stats.lookups);
+   registerStatsMetric("directory", core_id, "req-queue-probes", &m_req_queue_stats.probes);
+   registerStatsMetric("directory", core_id, "req-queue-probes-max", &m_req_queue_stats.probes_max);
+   registerStatsMetric("directory", core_id, "req-queue-overflows", &m_req_queue_stats.overflows);
 
    String protocol = Sim()->getCfg()->getString("caching_protocol/variant");
    if (protocol == "msi")
@@ -385,36 +391,20 @@ DirectoryMSIPolicy::processNullifyReq(ShmemReq* shmem_req)
       case DirectoryState::SHARED:
 
          {
-            std::pair<bool, std::vector<SInt32> > sharers_list_pair = directory_entry->getSharersList();
-            if (sharers_list_pair.first == true)
+            // Send Invalidation Request to all sharers
+            for (core_id_t sharer_id = directory_entry->getFirstSharer(); sharer_id != INVALID_CORE_ID; sharer_id = directory_entry->getNextSharer(sharer_id))
             {
-               // Broadcast Invalidation Request to all cores
-               // (irrespective of whether they are sharers or not)
-               getMemoryManager()->broadcastMsg(ShmemMsg::INV_REQ,
+               getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
                      MemComponent::GMM, MemComponent::L2_CACHE,
                      requester /* requester */,
+                     sharer_id /* receiver */,
                      address,
+                     shmem_req->getShmemMsg()->getPhysAddress(),
                      NULL, 0,
-                     NULL,
+                     HitWhere::UNKNOWN,
+                     &m_dummy_shmem_perf,
                      ShmemPerfModel::_SIM_THREAD);
             }
-            else
-            {
-               // Send Invalidation Request to only a specific set of sharers
-               for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
-               {
-                  getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
-                        MemComponent::GMM, MemComponent::L2_CACHE,
-                        requester /* requester */,
-                        sharers_list_pair.second[i] /* receiver */,
-                        address,
-                        shmem_req->getShmemMsg()->getPhysAddress(),
-                        NULL, 0,
-                        HitWhere::UNKNOWN,
-                        &m_dummy_shmem_perf,
-                        ShmemPerfModel::_SIM_THREAD);
-               }
-            }
          }
          break;
 
@@ -477,36 +467,22 @@ DirectoryMSIPolicy::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
       case DirectoryState::SHARED:
       {
          assert(cached_data_buf == NULL);
-         std::pair<bool, std::vector<SInt32> > sharers_list_pair = directory_entry->getSharersList();
-         if (sharers_list_pair.first == true)
+         // Send Invalidation Request to all sharers
+         bool shmem_perf_sent = false;
+         for (core_id_t sharer_id = directory_entry->getFirstSharer(); sharer_id != INVALID_CORE_ID; sharer_id = directory_entry->getNextSharer(sharer_id))
          {
-            // Broadcast Invalidation Request to all cores
-            // (irrespective of whether they are sharers or not)
-            getMemoryManager()->broadcastMsg(ShmemMsg::INV_REQ,
+            MYLOG("Send INV_REQ>%d for %lx", sharer_id, address )
+            getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
                   MemComponent::GMM, MemComponent::L2_CACHE,
                   requester /* requester */,
+                  sharer_id /* receiver */,
                   address,
+                  shmem_req->getShmemMsg()->getPhysAddress(),
                   NULL, 0,
-                  NULL, // No ShmemPerf on broadcast
+                  HitWhere::UNKNOWN,
+                  shmem_perf_sent == false ? shmem_req->getShmemMsg()->getPerf() : &m_dummy_shmem_perf,
                   ShmemPerfModel::_SIM_THREAD);
-         }
-         else
-         {
-            // Send Invalidation Request to only a specific set of sharers
-            for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
-            {
-               MYLOG("Send INV_REQ>%d for %lx", sharers_list_pair.second[i], address )
-                        getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
-                              MemComponent::GMM, MemComponent::L2_CACHE,
-                              requester /* requester */,
-                              sharers_list_pair.second[i] /* receiver */,
-                              address,
-                              shmem_req->getShmemMsg()->getPhysAddress(),
-                              NULL, 0,
-                              HitWhere::UNKNOWN,
-                              i == 0 ? shmem_req->getShmemMsg()->getPerf() : &m_dummy_shmem_perf,
-                              ShmemPerfModel::_SIM_THREAD);
-            }
+            shmem_perf_sent = true;
          }
          break;
       }
@@ -954,18 +930,16 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
 
    DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
 
-   std::pair<bool, std::vector<SInt32> > sharers_list_pair = directory_entry->getSharersList();
+   core_id_t first_sharer = directory_entry->getFirstSharer();
+   UInt32 num_sharers = directory_entry->getNumSharers();
 
    DirectoryState::dstate_t curr_dstate = directory_block_info->getDState();
 
    MYLOG("state=%d :: ", curr_dstate);
    MYLOG("owner=%d" , directory_entry->getOwner());
-   if (!sharers_list_pair.first)
+   for (core_id_t sharer_id = first_sharer; sharer_id != INVALID_CORE_ID; sharer_id = directory_entry->getNextSharer(sharer_id))
    {
-      for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
-      {
-         MYLOG("sharer: %d",sharers_list_pair.second[i]);
-      }
+      MYLOG("sharer: %d", sharer_id);
    }
 
    updateShmemPerf(shmem_msg, ShmemPerf::TD_ACCESS);
@@ -975,7 +949,7 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
       case DirectoryState::EXCLUSIVE:
       case DirectoryState::MODIFIED:
       {
-         if (sharers_list_pair.second[0] == requester)
+         if (first_sharer == requester)
          {
             MYLOG("upgrade request immediately finished, sending UPGRADE_REP to %d", requester);
             assert (directory_entry->getOwner() == requester);
@@ -995,7 +969,7 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
          else
          {
             // Send FLUSH_REQ to the current owner
-            MYLOG("FLUSH REQ (UPGR)>%u @ %lx",sharers_list_pair.second[0] , address);
+            MYLOG("FLUSH REQ (UPGR)>%u @ %lx",first_sharer , address);
             getMemoryManager()->sendMsg(ShmemMsg::FLUSH_REQ,
                   MemComponent::GMM, MemComponent::L2_CACHE,
                   requester /* requester */,
@@ -1010,7 +984,7 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
       }
       case DirectoryState::SHARED:
       {
-         if ((sharers_list_pair.second.size() == 1) && (sharers_list_pair.second[0] == requester))
+         if ((num_sharers == 1) && (first_sharer == requester))
          {
             // Let the requester know it can take ownership
             MYLOG("sending UPGRADE_REP>%d", requester )
@@ -1032,46 +1006,30 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
             bool requesterHasCopy = directory_entry->hasSharer(requester);
             if (!requesterHasCopy)
             {
-               MYLOG("UPGRADE_REQ: %lu sharer(s), but the requester isn't holding a copy!?", sharers_list_pair.second.size());
+               MYLOG("UPGRADE_REQ: %lu sharer(s), but the requester isn't holding a copy!?", num_sharers);
             }
 
             // send inv_req to all sharers
-            if (sharers_list_pair.first == true)
+            bool shmem_perf_sent = false;
+            for (core_id_t sharer_id = first_sharer; sharer_id != INVALID_CORE_ID; sharer_id = directory_entry->getNextSharer(sharer_id))
             {
-               // Broadcast Invalidation Request to all cores
-               // (irrespective of whether they are sharers or not)
-               getMemoryManager()->broadcastMsg(ShmemMsg::INV_REQ,
-                     MemComponent::GMM, MemComponent::L2_CACHE,
-                     requester /* requester */,
-                     address,
-                     NULL, 0,
-                     NULL, // No ShmemPerf on broadcast
-                     ShmemPerfModel::_SIM_THREAD);
-            }
-            else
-            {
-               bool shmem_perf_sent = false;
-               // Send Invalidation Request to only a specific set of sharers
-               for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
+               if (sharer_id != requester)
                {
-                  if (sharers_list_pair.second[i] != requester)
-                  {
-                     MYLOG("INV REQ (UPGR)>%u @ %lx",sharers_list_pair.second[i] , shmem_msg->getAddress());
-                     // avoid having to fetch the data from DRAM, so ask at least one core to FLUSH instead of INV
-                     ShmemMsg::msg_t msg_type = (!requesterHasCopy && i==0) ? ShmemMsg::FLUSH_REQ : ShmemMsg::INV_REQ;
-                     //ShmemMsg::msg_t msg_type = ShmemMsg::INV_REQ;
-                     getMemoryManager()->sendMsg( msg_type, //ShmemMsg::INV_REQ,
-                           MemComponent::GMM, MemComponent::L2_CACHE,
-                           requester /* requester */,
-                           sharers_list_pair.second[i] /* receiver */,
-                           address,
-                           shmem_req->getShmemMsg()->getPhysAddress(),
-                           NULL, 0,
-                           HitWhere::UNKNOWN,
-                           shmem_perf_sent == false ? shmem_msg->getPerf() : &m_dummy_shmem_perf,
-                           ShmemPerfModel::_SIM_THREAD);
-                     shmem_perf_sent = true;
-                  }
+                  MYLOG("INV REQ (UPGR)>%u @ %lx", sharer_id, shmem_msg->getAddress());
+                  // avoid having to fetch the data from DRAM, so ask at least one core to FLUSH instead of INV
+                  ShmemMsg::msg_t msg_type = (!requesterHasCopy && sharer_id == first_sharer) ? ShmemMsg::FLUSH_REQ : ShmemMsg::INV_REQ;
+                  //ShmemMsg::msg_t msg_type = ShmemMsg::INV_REQ;
+                  getMemoryManager()->sendMsg( msg_type, //ShmemMsg::INV_REQ,
+                        MemComponent::GMM, MemComponent::L2_CACHE,
+                        requester /* requester */,
+                        sharer_id /* receiver */,
+                        address,
+                        shmem_req->getShmemMsg()->getPhysAddress(),
+                        NULL, 0,
+                        HitWhere::UNKNOWN,
+                        shmem_perf_sent == false ? shmem_msg->getPerf() : &m_dummy_shmem_perf,
+                        ShmemPerfModel::_SIM_THREAD);
+                  shmem_perf_sent = true;
                }
             }
          }
@@ -1080,7 +1038,7 @@ DirectoryMSIPolicy::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
       case DirectoryState::UNCACHED:
       {
          MYLOG("%lx is UNCACHED", address);
-         assert (sharers_list_pair.second.size() == 0);
+         assert (num_sharers == 0);
 
          // Modifiy the directory entry contents
          bool add_result = directory_entry->addSharer(requester, m_dram_directory_cache->getMaxHwSharers());
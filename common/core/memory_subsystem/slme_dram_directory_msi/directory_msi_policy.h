@@ -40,6 +40,7 @@ namespace SingleLevelMemory
          PrL1PrL2DramDirectoryMSI::DramDirectoryCache* m_dram_directory_cache;
          AddressHomeLookup* m_dram_controller_home_lookup;
          ReqQueueList* m_dram_directory_req_queue_list;
+         ReqQueueListStats m_req_queue_stats;
 
          core_id_t m_core_id;
          UInt32 m_cache_block_size;
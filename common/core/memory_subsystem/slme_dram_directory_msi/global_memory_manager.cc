@@ -42,7 +42,9 @@ GlobalMemoryManager::GlobalMemoryManager(Core* core,
    m_gmm_present(false),
    m_dram_cntlr_present(false),
    m_enabled(false),
-   m_default_policy(NULL)
+   m_default_policy(NULL),
+   m_segment_index(Sim()->getConfig()->getTotalCores() + 1),
+   m_replication_stats(NULL)
 {
    // Read Parameters from the Config file
    std::map<MemComponent::component_t, CacheParameters> cache_parameters;
@@ -291,11 +293,13 @@ GlobalMemoryManager::GlobalMemoryManager(Core* core,
       // only have effect within a set as we see it. Turn of optimization...
       if (num_sets != (1UL << floorLog2(num_sets)))
          num_sets = 1;
-      for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
+      config::Handle<SInt64> l1_dcache_size = Sim()->getCfg()->getHandle<SInt64>("perf_model/l1_dcache/cache_size");
+      config::Handle<String> l1_dcache_address_hash = Sim()->getCfg()->getHandle<String>("perf_model/l1_dcache/address_hash");
+      for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores() && num_sets > 1; ++core_id)
       {
-         if (Sim()->getCfg()->getIntArray("perf_model/l1_dcache/cache_size", core_id) != cache_parameters[MemComponent::L1_DCACHE].size)
+         if (l1_dcache_size.get(core_id) != cache_parameters[MemComponent::L1_DCACHE].size)
             num_sets = 1;
-         if (Sim()->getCfg()->getStringArray("perf_model/l1_dcache/address_hash", core_id) != "mask")
+         if (l1_dcache_address_hash.get(core_id) != "mask")
             num_sets = 1;
          // FIXME: We really should check all cache levels
       }
@@ -360,11 +364,15 @@ GlobalMemoryManager::~GlobalMemoryManager()
    if (m_default_policy)
       delete m_default_policy;
 
-   for (auto& segment: m_segment_table)
-   {
-      if (segment.m_policy)
-         delete segment.m_policy;
-   }
+   std::vector<PolicyBase*> policies;
+   m_segment_index.getPolicies(policies);
+   for (auto policy : policies)
+      delete policy;
+   for (auto policy : m_retired_policies)
+      delete policy;
+
+   if (m_replication_stats)
+      delete m_replication_stats;
 }
 
 HitWhere::where_t
@@ -374,7 +382,8 @@ GlobalMemoryManager::coreInitiateMemoryAccess(
       Core::mem_op_t mem_op_type,
       IntPtr address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
-      Core::MemModeled modeled)
+      Core::MemModeled modeled,
+      IntPtr eip)
 {
    LOG_ASSERT_ERROR(mem_component <= m_last_level_cache,
       "Error: invalid mem_component (%d) for coreInitiateMemoryAccess", mem_component);
@@ -385,7 +394,8 @@ GlobalMemoryManager::coreInitiateMemoryAccess(
          address, offset,
          data_buf, data_length,
          modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT ? false : true,
-         modeled == Core::MEM_MODELED_NONE ? false : true);
+         modeled == Core::MEM_MODELED_NONE ? false : true,
+         eip);
 }
 
 void
@@ -602,20 +612,11 @@ MYLOG("end");
 }
 
 PolicyBase*
-GlobalMemoryManager::policyLookup(IntPtr address)
+GlobalMemoryManager::policyLookup(IntPtr address, core_id_t requester)
 {
-   PolicyBase *policy = m_default_policy;
-   m_segment_table_lock.acquire_read();
-   for (const auto& seg : m_segment_table)
-      if (seg.contains(address) && seg.m_policy)
-      {
-         policy = seg.m_policy;
-         break;
-      }
-
-   m_segment_table_lock.release_read();
-
-   return policy;
+   // Readers 0 .. total_cores-1 are requesting cores, the last one is our own GMM
+   PolicyBase *policy = m_segment_index.lookup(address, requester == INVALID_CORE_ID ? Sim()->getConfig()->getTotalCores() : requester);
+   return policy ? policy : m_default_policy;
 }
 
 void
@@ -633,17 +634,13 @@ GlobalMemoryManager::createSegment(IntPtr start, uint64_t length)
    if (find(m_core_list_with_gmm.begin(), m_core_list_with_gmm.end(), getCore()->getId()) == m_core_list_with_gmm.end())
       return;
 
-   Segment new_seg{0, start, start + length, NULL};
    m_segment_table_lock.acquire();
-
-   for (const auto& seg : m_segment_table)
-      assert(seg != new_seg);
-
-   m_segment_table.push_back(new_seg);
+   bool inserted = m_segment_index.insert(start, start + length);
    m_segment_table_lock.release();
 
+   LOG_ASSERT_ERROR(inserted, "Segment %p - %p overlaps an existing segment", (void *)start, (void *)(start + length));
 
-   MYLOG("Created segment: %p - %p", (void *)new_seg.m_start, (void *)new_seg.m_end);
+   MYLOG("Created segment: %p - %p", (void *)start, (void *)(start + length));
 
 }
 
@@ -653,32 +650,38 @@ GlobalMemoryManager::segmentAssignPolicy(IntPtr start, uint64_t policy_id)
    if (find(m_core_list_with_gmm.begin(), m_core_list_with_gmm.end(), getCore()->getId()) == m_core_list_with_gmm.end())
       return;
 
-   m_segment_table_lock.acquire();
-   for (auto& seg : m_segment_table)
+   PolicyBase *policy = NULL;
+   if (policy_id == 1)
    {
-      if (seg.m_start == start)
-      {
-         if (policy_id == 1)
-         {
-            seg.m_policy = new ReplicationPolicy(getCore(),
-                  this,
-                  m_dram_controller_home_lookup,
-                  1024 * 1024,
-                  getShmemPerfModel());
-         }
-         else if (policy_id == 2)
-         {
-            seg.m_policy = new SubscriptionPolicy(this);
-         }
-         else
-         {
-            if (seg.m_policy)
-               delete seg.m_policy;
-            seg.m_policy = NULL;
-         }
+      m_segment_table_lock.acquire();
+      if (!m_replication_stats)
+         m_replication_stats = new ReplicationStats(getCore()->getId());
+      m_segment_table_lock.release();
+
+      policy = new ReplicationPolicy(getCore(),
+            this,
+            m_dram_controller_home_lookup,
+            1024 * 1024,
+            getShmemPerfModel(),
+            m_replication_stats);
+   }
+   else if (policy_id == 2)
+   {
+      policy = new SubscriptionPolicy(this);
+   }
 
-         MYLOG("Segment assign policy: %p - %d", (void *)seg.m_start, policy_id);
-      }
+   m_segment_table_lock.acquire();
+   PolicyBase *old_policy = NULL;
+   if (m_segment_index.setPolicy(start, policy, &old_policy))
+   {
+      // Lookups that started before the change may still be using the old policy
+      if (old_policy)
+         m_retired_policies.push_back(old_policy);
+      MYLOG("Segment assign policy: %p - %d", (void *)start, policy_id);
+   }
+   else
+   {
+      delete policy;
    }
    m_segment_table_lock.release();
 }
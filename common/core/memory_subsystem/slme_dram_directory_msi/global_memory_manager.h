@@ -14,6 +14,7 @@
 #include "shared_cache_block_info.h"
 #include "subsecond_time.h"
 #include "lock.h"
+#include "segment_table.h"
 
 #include <map>
 #include <vector>
@@ -25,7 +26,7 @@ namespace SingleLevelMemory
    class GMMCore;
    class PolicyBase;
    class DirectoryMSIPolicy;
-   class Segment;
+   struct ReplicationStats;
 
    typedef std::pair<core_id_t, MemComponent::component_t> CoreComponentType;
    typedef std::map<CoreComponentType, VirtCacheCntlr*> CacheCntlrMap;
@@ -55,8 +56,10 @@ namespace SingleLevelMemory
          ShmemPerf m_dummy_shmem_perf;
 
          DirectoryMSIPolicy* m_default_policy;
-         std::vector<Segment> m_segment_table;
-         Lock m_segment_table_lock;
+         SegmentIndex m_segment_index;
+         Lock m_segment_table_lock;    // Serializes writers, lookups are lock-free
+         std::vector<PolicyBase*> m_retired_policies;
+         ReplicationStats* m_replication_stats;   // Created the first time a segment of this core uses replication
 
          // Performance Models
          CachePerfModel* m_cache_perf_models[MemComponent::LAST_LEVEL_CACHE + 1];
@@ -96,7 +99,8 @@ namespace SingleLevelMemory
                Core::mem_op_t mem_op_type,
                IntPtr address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
-               Core::MemModeled modeled);
+               Core::MemModeled modeled,
+               IntPtr eip = 0);
 
          void handleMsgFromNetwork(NetPacket& packet) override;
 
@@ -125,6 +129,7 @@ namespace SingleLevelMemory
          void incrElapsedTime(MemComponent::component_t mem_component, CachePerfModel::CacheAccess_t access_type, ShmemPerfModel::Thread_t thread_num = ShmemPerfModel::NUM_CORE_THREADS);
 
          void Command(uint64_t cmd_type, IntPtr start, uint64_t arg1) override;
-         PolicyBase *policyLookup(IntPtr address);
+         // requester selects the lookup slot: the requesting core, or INVALID_CORE_ID when called by this GMM itself
+         PolicyBase *policyLookup(IntPtr address, core_id_t requester = INVALID_CORE_ID);
    };
 }
@@ -0,0 +1,206 @@
+#include "replica_table.h"
+#include "log.h"
+
+namespace SingleLevelMemory
+{
+
+static const UInt32 INITIAL_BITS = 4;
+
+ReplicaSet::ReplicaSet()
+   : m_slots(1 << INITIAL_BITS, EMPTY)
+   , m_shift(64 - INITIAL_BITS)
+   , m_size(0)
+{
+}
+
+bool
+ReplicaSet::contains(IntPtr addr, UInt64 &probes) const
+{
+   UInt64 mask = m_slots.size() - 1;
+   for (UInt64 index = slot(addr); ; index = (index + 1) & mask)
+   {
+      ++probes;
+      if (m_slots[index] == addr)
+         return true;
+      if (m_slots[index] == EMPTY)
+         return false;
+   }
+}
+
+bool
+ReplicaSet::insert(IntPtr addr, UInt64 &probes)
+{
+   LOG_ASSERT_ERROR(addr != EMPTY, "Invalid replica address");
+
+   // Keep the load factor at or below 1/2
+   if (2 * (m_size + 1) > m_slots.size())
+      grow();
+
+   UInt64 mask = m_slots.size() - 1;
+   for (UInt64 index = slot(addr); ; index = (index + 1) & mask)
+   {
+      ++probes;
+      if (m_slots[index] == addr)
+         return false;
+      if (m_slots[index] == EMPTY)
+      {
+         m_slots[index] = addr;
+         ++m_size;
+         return true;
+      }
+   }
+}
+
+void
+ReplicaSet::grow()
+{
+   std::vector<IntPtr> old_slots(2 * m_slots.size(), EMPTY);
+   old_slots.swap(m_slots);
+   --m_shift;
+
+   UInt64 mask = m_slots.size() - 1;
+   for (auto it = old_slots.begin(); it != old_slots.end(); ++it)
+   {
+      if (*it == EMPTY)
+         continue;
+      UInt64 index = slot(*it);
+      while (m_slots[index] != EMPTY)
+         index = (index + 1) & mask;
+      m_slots[index] = *it;
+   }
+}
+
+
+ReplicaRequestMap::ReplicaRequestMap()
+   : m_slots(1 << INITIAL_BITS, Slot{EMPTY, NONE, 0})
+   , m_shift(64 - INITIAL_BITS)
+   , m_size(0)
+   , m_free(NONE)
+   , m_num_requests(0)
+{
+}
+
+UInt64
+ReplicaRequestMap::find(IntPtr repl_addr, UInt64 &probes) const
+{
+   // Returns the slot holding repl_addr, or the empty slot where it would go
+   UInt64 mask = m_slots.size() - 1;
+   for (UInt64 index = slot(repl_addr); ; index = (index + 1) & mask)
+   {
+      ++probes;
+      if (m_slots[index].repl_addr == repl_addr || m_slots[index].repl_addr == EMPTY)
+         return index;
+   }
+}
+
+UInt32
+ReplicaRequestMap::allocNode()
+{
+   if (m_free == NONE)
+   {
+      m_nodes.push_back(Node{EMPTY, NONE});
+      return m_nodes.size() - 1;
+   }
+   UInt32 node = m_free;
+   m_free = m_nodes[node].next;
+   return node;
+}
+
+void
+ReplicaRequestMap::add(IntPtr repl_addr, IntPtr address, UInt64 &probes)
+{
+   LOG_ASSERT_ERROR(repl_addr != EMPTY, "Invalid replica address");
+
+   if (2 * (m_size + 1) > m_slots.size())
+      grow();
+
+   UInt64 index = find(repl_addr, probes);
+   Slot &s = m_slots[index];
+   if (s.repl_addr == EMPTY)
+   {
+      s.repl_addr = repl_addr;
+      s.head = NONE;
+      s.count = 0;
+      ++m_size;
+   }
+
+   UInt32 node = allocNode();
+   m_nodes[node].address = address;
+   m_nodes[node].next = s.head;
+   s.head = node;
+   ++s.count;
+   ++m_num_requests;
+}
+
+bool
+ReplicaRequestMap::remove(IntPtr repl_addr, IntPtr address, UInt64 &probes)
+{
+   UInt64 index = find(repl_addr, probes);
+   Slot &s = m_slots[index];
+   if (s.repl_addr == EMPTY)
+      return false;
+
+   for (UInt32 *link = &s.head; *link != NONE; link = &m_nodes[*link].next)
+   {
+      if (m_nodes[*link].address == address)
+      {
+         UInt32 node = *link;
+         *link = m_nodes[node].next;
+         m_nodes[node].next = m_free;
+         m_free = node;
+         --m_num_requests;
+         if (--s.count == 0)
+            erase(index);
+         return true;
+      }
+   }
+   return false;
+}
+
+UInt32
+ReplicaRequestMap::count(IntPtr repl_addr, UInt64 &probes) const
+{
+   return m_slots[find(repl_addr, probes)].count;
+}
+
+void
+ReplicaRequestMap::erase(UInt64 index)
+{
+   // Backward-shift deletion: move later entries of the probe sequence into the hole, so lookups
+   // never need tombstones
+   UInt64 mask = m_slots.size() - 1;
+   UInt64 hole = index;
+   for (UInt64 next = (hole + 1) & mask; m_slots[next].repl_addr != EMPTY; next = (next + 1) & mask)
+   {
+      UInt64 home = slot(m_slots[next].repl_addr);
+      // Only move entries whose home slot is not in (hole, next]
+      if (((next - home) & mask) >= ((next - hole) & mask))
+      {
+         m_slots[hole] = m_slots[next];
+         hole = next;
+      }
+   }
+   m_slots[hole] = Slot{EMPTY, NONE, 0};
+   --m_size;
+}
+
+void
+ReplicaRequestMap::grow()
+{
+   std::vector<Slot> old_slots(2 * m_slots.size(), Slot{EMPTY, NONE, 0});
+   old_slots.swap(m_slots);
+   --m_shift;
+
+   UInt64 mask = m_slots.size() - 1;
+   for (auto it = old_slots.begin(); it != old_slots.end(); ++it)
+   {
+      if (it->repl_addr == EMPTY)
+         continue;
+      UInt64 index = slot(it->repl_addr);
+      while (m_slots[index].repl_addr != EMPTY)
+         index = (index + 1) & mask;
+      m_slots[index] = *it;
+   }
+}
+
+}
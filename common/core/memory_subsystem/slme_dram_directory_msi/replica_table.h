@@ -0,0 +1,83 @@
+#pragma once
+
+#include "fixed_types.h"
+
+#include <vector>
+
+namespace SingleLevelMemory
+{
+   // Open-addressing (linear probing) tables for the replication policy's bookkeeping.
+   // Keys are replica block addresses. Tables are not thread-safe: a policy instance belongs
+   // to one GMM, and is only used from that GMM's thread.
+   //
+   // Lookups report how many slots they probed, so the policy can expose the lookup cost.
+
+   class ReplicaSet
+   {
+      public:
+         ReplicaSet();
+
+         bool contains(IntPtr addr, UInt64 &probes) const;
+         // Returns false if addr was already present
+         bool insert(IntPtr addr, UInt64 &probes);
+
+         UInt64 size() const { return m_size; }
+         UInt64 getBytes() const { return m_slots.size() * sizeof(IntPtr); }
+
+      private:
+         static const IntPtr EMPTY = ~IntPtr(0);
+
+         std::vector<IntPtr> m_slots;
+         UInt32 m_shift;   //< 64 - log2(m_slots.size())
+         UInt64 m_size;
+
+         UInt64 slot(IntPtr addr) const { return (addr * 0x9e3779b97f4a7c15ull) >> m_shift; }
+         void grow();
+   };
+
+   // Requests (cache line addresses) waiting for a replica block that is being fetched remotely.
+   // The per-block lists are linked through a shared node pool, so adding and removing requests
+   // does not allocate once the pool has grown to the peak number of outstanding requests.
+   class ReplicaRequestMap
+   {
+      public:
+         ReplicaRequestMap();
+
+         void add(IntPtr repl_addr, IntPtr address, UInt64 &probes);
+         // Returns false if address was not outstanding for repl_addr
+         bool remove(IntPtr repl_addr, IntPtr address, UInt64 &probes);
+         UInt32 count(IntPtr repl_addr, UInt64 &probes) const;
+
+         UInt64 size() const { return m_num_requests; }
+         UInt64 getBytes() const { return m_slots.size() * sizeof(Slot) + m_nodes.size() * sizeof(Node); }
+
+      private:
+         static const IntPtr EMPTY = ~IntPtr(0);
+         static const UInt32 NONE = ~UInt32(0);
+
+         struct Slot
+         {
+            IntPtr repl_addr;
+            UInt32 head;      //< First node of this block's list
+            UInt32 count;
+         };
+         struct Node
+         {
+            IntPtr address;
+            UInt32 next;
+         };
+
+         std::vector<Slot> m_slots;
+         UInt32 m_shift;
+         UInt64 m_size;       //< Blocks with outstanding requests
+         std::vector<Node> m_nodes;
+         UInt32 m_free;       //< Free list through m_nodes
+         UInt64 m_num_requests;
+
+         UInt64 slot(IntPtr addr) const { return (addr * 0x9e3779b97f4a7c15ull) >> m_shift; }
+         UInt64 find(IntPtr repl_addr, UInt64 &probes) const;
+         void erase(UInt64 index);
+         void grow();
+         UInt32 allocNode();
+   };
+}
@@ -9,7 +9,6 @@
 #include "directory_state.h"
 #include "thread_manager.h"
 #include "thread.h"
-#include <set>
 
 #if 0
    extern Lock iolock;
@@ -28,16 +27,18 @@ ReplicationPolicy::ReplicationPolicy(
       GlobalMemoryManager* memory_manager,
       AddressHomeLookup* dram_controller_home_lookup,
       UInt32 replica_block_size,
-      ShmemPerfModel* shmem_perf_model):
+      ShmemPerfModel* shmem_perf_model,
+      ReplicationStats* stats):
    PolicyBase(memory_manager, 1),
    m_dram_controller_home_lookup(dram_controller_home_lookup),
    m_core_id(core->getId()),
    m_replica_block_size(replica_block_size),
    m_shmem_perf_model(shmem_perf_model),
+   m_stats(stats),
    m_access_time(NULL, 0)
 {
    m_access_time = ComponentLatency(core->getDvfsDomain(), Sim()->getCfg()->getInt("perf_model/gmm_access_cycles"));
-   m_dram_directory_req_queue_list = new ReqQueueList();
+   m_dram_directory_req_queue_list = new ReqQueueList(&m_stats->req_queue);
 }
 
 ReplicationPolicy::~ReplicationPolicy()
@@ -45,6 +46,36 @@ ReplicationPolicy::~ReplicationPolicy()
    delete m_dram_directory_req_queue_list;
 }
 
+ReplicationStats::ReplicationStats(core_id_t core_id)
+   : replicas(0)
+   , replica_bytes(0)
+   , lookups(0)
+   , lookup_probes(0)
+   , outstanding_remote(0)
+   , outstanding_remote_max(0)
+   , table_bytes(0)
+   , req_queue()
+{
+   registerStatsMetric("replication", core_id, "replicas", &replicas);
+   registerStatsMetric("replication", core_id, "replica-bytes", &replica_bytes);
+   registerStatsMetric("replication", core_id, "lookups", &lookups);
+   registerStatsMetric("replication", core_id, "lookup-probes", &lookup_probes);
+   registerStatsMetric("replication", core_id, "outstanding-remote", &outstanding_remote);
+   registerStatsMetric("replication", core_id, "outstanding-remote-max", &outstanding_remote_max);
+   registerStatsMetric("replication", core_id, "table-bytes", &table_bytes);
+   registerStatsMetric("replication", core_id, "req-queue-addresses-max", &req_queue.addresses_max);
+   registerStatsMetric("replication", core_id, "req-queue-lookups", &req_queue.lookups);
+   registerStatsMetric("replication", core_id, "req-queue-probes", &req_queue.probes);
+   registerStatsMetric("replication", core_id, "req-queue-probes-max", &req_queue.probes_max);
+   registerStatsMetric("replication", core_id, "req-queue-overflows", &req_queue.overflows);
+}
+
+void
+ReplicationPolicy::updateTableBytes(UInt64 bytes_before)
+{
+   m_stats->table_bytes += m_replicas.getBytes() + m_outstanding_remote.getBytes() - bytes_before;
+}
+
 void
 ReplicationPolicy::handleMsgFromGMM(core_id_t sender, ShmemMsg* shmem_msg)
 {
@@ -183,11 +214,21 @@ ReplicationPolicy::retrieveDataAndSendToL2Cache(ShmemMsg::msg_t reply_msg_type,
    assert(phys_address != INVALID_ADDRESS);
 
    core_id_t dram_node;
-   if (m_replicas.count(repl_addr) == 0)
+   ++m_stats->lookups;
+   if (!m_replicas.contains(repl_addr, m_stats->lookup_probes))
    {
       dram_node = m_dram_controller_home_lookup->getHome(phys_address);
       if (dram_node != m_core_id)
+      {
          getShmemPerfModel()->incrElapsedTime(m_access_time.getLatency(), ShmemPerfModel::_SIM_THREAD);
+
+         UInt64 bytes_before = m_replicas.getBytes() + m_outstanding_remote.getBytes();
+         m_outstanding_remote.add(repl_addr, address, m_stats->lookup_probes);
+         updateTableBytes(bytes_before);
+         ++m_stats->outstanding_remote;
+         if (m_stats->outstanding_remote > m_stats->outstanding_remote_max)
+            m_stats->outstanding_remote_max = m_stats->outstanding_remote;
+      }
    }
    else
    {
@@ -242,14 +283,23 @@ ReplicationPolicy::processDRAMReply(core_id_t sender, ShmemMsg* shmem_msg)
    if (hit_where == HitWhere::DRAM)
       hit_where = (sender == shmem_msg->getRequester()) ? HitWhere::DRAM_LOCAL : HitWhere::DRAM_REMOTE;
 
+   IntPtr repl_addr = address - address % m_replica_block_size;
+   UInt64 bytes_before = m_replicas.getBytes() + m_outstanding_remote.getBytes();
+   if (sender != m_core_id && m_outstanding_remote.remove(repl_addr, address, m_stats->lookup_probes))
+      --m_stats->outstanding_remote;
+
    if (hit_where == HitWhere::DRAM_REMOTE)
    {
-      IntPtr repl_addr = address - address % m_replica_block_size;
       // assert(m_replicas.count(repl_addr) == 0);
-      m_replicas.insert(repl_addr);
+      if (m_replicas.insert(repl_addr, m_stats->lookup_probes))
+      {
+         ++m_stats->replicas;
+         m_stats->replica_bytes += m_replica_block_size;
+      }
       LOG_PRINT_WARNING("Replication Policy: Remote DRAM access: va = %p", address);
       MYLOG("Replicate @ %lx", repl_addr);
    }
+   updateTableBytes(bytes_before);
    // else
    // {
    //    LOG_PRINT_WARNING("Replication Policy: Local DRAM access: va = %p", address);
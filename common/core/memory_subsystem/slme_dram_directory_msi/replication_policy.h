@@ -11,13 +11,27 @@
 #include "shmem_perf.h"
 #include "mem_component.h"
 #include "coherency_protocol.h"
+#include "replica_table.h"
 
-#include <set>
-#include <map>
 #include <vector>
 
 namespace SingleLevelMemory
 {
+   // Shared by all replication policies (segments) of a core, owned by its GlobalMemoryManager
+   struct ReplicationStats
+   {
+      UInt64 replicas;
+      UInt64 replica_bytes;
+      UInt64 lookups;
+      UInt64 lookup_probes;
+      UInt64 outstanding_remote;
+      UInt64 outstanding_remote_max;
+      UInt64 table_bytes;
+      ReqQueueListStats req_queue;
+
+      ReplicationStats(core_id_t core_id);
+   };
+
    class ReplicationPolicy: public PolicyBase
    {
       public:
@@ -26,7 +40,8 @@ namespace SingleLevelMemory
                GlobalMemoryManager* memory_manager,
                AddressHomeLookup* dram_controller_home_lookup,
                UInt32 replica_block_size,
-               ShmemPerfModel* shmem_perf_model);
+               ShmemPerfModel* shmem_perf_model,
+               ReplicationStats* stats);
 
          ~ReplicationPolicy() override;
 
@@ -49,9 +64,13 @@ namespace SingleLevelMemory
          UInt64 evict[DirectoryState::NUM_DIRECTORY_STATES];
          UInt64 forward, forward_failed;
 
-         std::set<IntPtr> m_replicas;
+         // Policies are created per GMM core, and only run on that core's thread: these tables are
+         // per-core shards that need no locking
+         ReplicaSet m_replicas;
+         ReplicaRequestMap m_outstanding_remote;
 
-         std::map<IntPtr, std::set<IntPtr>> m_outstanding_remote;
+         ReplicationStats *m_stats;
+         void updateTableBytes(UInt64 bytes_before);
 
          ComponentLatency m_access_time;
 
@@ -1,5 +1,7 @@
 #include "segment_table.h"
 
+#include <algorithm>
+
 namespace SingleLevelMemory
 {
 
@@ -29,4 +31,232 @@ SegmentTable::lookup(IntPtr vaddr, IntPtr &paddr)
    }
 }
 
+static bool
+segmentStartLess(IntPtr address, const Segment &segment)
+{
+   return address < segment.m_start;
+}
+
+SegmentIndex::SegmentIndex(UInt32 num_readers) :
+   m_current(new Snapshot()),
+   m_readers(new Reader[num_readers]),
+   m_num_readers(num_readers),
+   m_size(0)
+{
+   m_current->version = 1;
+   for (UInt32 i = 0; i < m_num_readers; ++i)
+   {
+      m_readers[i].hazard = NULL;
+      m_readers[i].last_version = 0;
+      m_readers[i].last_segment = NULL;
+   }
+}
+
+SegmentIndex::~SegmentIndex()
+{
+   for (auto snapshot : m_retired)
+   {
+      for (auto chunk : snapshot->replaced)
+         delete chunk;
+      delete snapshot;
+   }
+   for (auto chunk : m_current->chunks)
+      delete chunk;
+   delete m_current;
+   delete [] m_readers;
+}
+
+const SegmentIndex::Snapshot*
+SegmentIndex::acquire(Reader &reader)
+{
+   // Announce the snapshot we are about to use, then make sure it was not replaced in the meantime:
+   // if it still is current, any writer replacing it from now on will see our announcement
+   const Snapshot *snapshot = __atomic_load_n(&m_current, __ATOMIC_ACQUIRE);
+   while (true)
+   {
+      __atomic_store_n(&reader.hazard, snapshot, __ATOMIC_SEQ_CST);
+      const Snapshot *current = __atomic_load_n(&m_current, __ATOMIC_SEQ_CST);
+      if (current == snapshot)
+         return snapshot;
+      snapshot = current;
+   }
+}
+
+const Segment*
+SegmentIndex::find(const Snapshot *snapshot, IntPtr address)
+{
+   auto it = std::upper_bound(snapshot->starts.begin(), snapshot->starts.end(), address);
+   if (it == snapshot->starts.begin())
+      return NULL;
+   const std::vector<Segment> &segments = snapshot->chunks[it - snapshot->starts.begin() - 1]->segments;
+   auto seg = std::upper_bound(segments.begin(), segments.end(), address, segmentStartLess);
+   // The chunk's first segment starts at or below address, so seg is never segments.begin()
+   --seg;
+   return seg->contains(address) ? &*seg : NULL;
+}
+
+PolicyBase*
+SegmentIndex::lookup(IntPtr address, UInt32 reader_id)
+{
+   Reader &reader = m_readers[reader_id];
+   const Snapshot *snapshot = acquire(reader);
+
+   const Segment *segment;
+   if (reader.last_version == snapshot->version && reader.last_segment->contains(address))
+   {
+      segment = reader.last_segment;
+   }
+   else
+   {
+      segment = find(snapshot, address);
+      if (segment)
+      {
+         reader.last_version = snapshot->version;
+         reader.last_segment = segment;
+      }
+   }
+   PolicyBase *policy = segment ? segment->m_policy : NULL;
+
+   __atomic_store_n(&reader.hazard, (const Snapshot*)NULL, __ATOMIC_RELEASE);
+   return policy;
+}
+
+size_t
+SegmentIndex::findChunk(IntPtr address) const
+{
+   // Index of the chunk that address belongs in: the last one starting at or below it, or the first one
+   auto it = std::upper_bound(m_current->starts.begin(), m_current->starts.end(), address);
+   return it == m_current->starts.begin() ? 0 : it - m_current->starts.begin() - 1;
+}
+
+bool
+SegmentIndex::insert(IntPtr start, IntPtr end)
+{
+   Segment new_seg{0, start, end, NULL};
+
+   if (m_current->chunks.empty())
+   {
+      Chunk *chunk = new Chunk();
+      chunk->segments.push_back(new_seg);
+
+      Snapshot *snapshot = new Snapshot();
+      snapshot->chunks.push_back(chunk);
+      snapshot->starts.push_back(start);
+      publish(snapshot, NULL);
+      ++m_size;
+      return true;
+   }
+
+   size_t index = findChunk(start);
+   const Chunk *chunk = m_current->chunks[index];
+   size_t pos = std::upper_bound(chunk->segments.begin(), chunk->segments.end(), start, segmentStartLess) - chunk->segments.begin();
+
+   // Only the neighbours in sorted order can overlap
+   if (pos > 0 && chunk->segments[pos - 1] == new_seg)
+      return false;
+   if (pos < chunk->segments.size() && chunk->segments[pos] == new_seg)
+      return false;
+   if (pos == chunk->segments.size() && index + 1 < m_current->chunks.size() && m_current->chunks[index + 1]->segments.front() == new_seg)
+      return false;
+
+   Chunk *updated = new Chunk(*chunk);
+   updated->segments.insert(updated->segments.begin() + pos, new_seg);
+
+   Snapshot *snapshot = new Snapshot();
+   snapshot->chunks.assign(m_current->chunks.begin(), m_current->chunks.begin() + index);
+   if (updated->segments.size() > ChunkSize)
+   {
+      Chunk *upper = new Chunk();
+      upper->segments.assign(updated->segments.begin() + updated->segments.size() / 2, updated->segments.end());
+      updated->segments.resize(updated->segments.size() / 2);
+      snapshot->chunks.push_back(updated);
+      snapshot->chunks.push_back(upper);
+   }
+   else
+   {
+      snapshot->chunks.push_back(updated);
+   }
+   snapshot->chunks.insert(snapshot->chunks.end(), m_current->chunks.begin() + index + 1, m_current->chunks.end());
+   snapshot->starts.reserve(snapshot->chunks.size());
+   for (auto c : snapshot->chunks)
+      snapshot->starts.push_back(c->segments.front().m_start);
+
+   publish(snapshot, chunk);
+   ++m_size;
+   return true;
+}
+
+bool
+SegmentIndex::setPolicy(IntPtr start, PolicyBase *policy, PolicyBase **old_policy)
+{
+   if (m_current->chunks.empty())
+      return false;
+
+   size_t index = findChunk(start);
+   const Chunk *chunk = m_current->chunks[index];
+   size_t pos = std::upper_bound(chunk->segments.begin(), chunk->segments.end(), start, segmentStartLess) - chunk->segments.begin();
+   if (pos == 0 || chunk->segments[pos - 1].m_start != start)
+      return false;
+
+   Chunk *updated = new Chunk(*chunk);
+   *old_policy = updated->segments[pos - 1].m_policy;
+   updated->segments[pos - 1].m_policy = policy;
+
+   Snapshot *snapshot = new Snapshot();
+   snapshot->chunks = m_current->chunks;
+   snapshot->chunks[index] = updated;
+   snapshot->starts = m_current->starts;
+
+   publish(snapshot, chunk);
+   return true;
+}
+
+void
+SegmentIndex::getPolicies(std::vector<PolicyBase*> &policies) const
+{
+   for (auto chunk : m_current->chunks)
+      for (const auto &seg : chunk->segments)
+         if (seg.m_policy)
+            policies.push_back(seg.m_policy);
+}
+
+void
+SegmentIndex::publish(Snapshot *snapshot, const Chunk *replaced)
+{
+   Snapshot *old = m_current;
+   snapshot->version = old->version + 1;
+   if (replaced)
+      old->replaced.push_back(replaced);
+
+   __atomic_store_n(&m_current, snapshot, __ATOMIC_SEQ_CST);
+   m_retired.push_back(old);
+
+   reclaim();
+}
+
+void
+SegmentIndex::reclaim()
+{
+   std::vector<const Snapshot*> hazards;
+   for (UInt32 i = 0; i < m_num_readers; ++i)
+   {
+      const Snapshot *hazard = __atomic_load_n(&m_readers[i].hazard, __ATOMIC_SEQ_CST);
+      if (hazard)
+         hazards.push_back(hazard);
+   }
+
+   // Chunks replaced in a snapshot can still be used by all older snapshots, so free in order
+   // and stop at the oldest snapshot that may still be in use
+   auto it = m_retired.begin();
+   for ( ; it != m_retired.end(); ++it)
+   {
+      if (std::find(hazards.begin(), hazards.end(), *it) != hazards.end())
+         break;
+      for (auto chunk : (*it)->replaced)
+         delete chunk;
+      delete *it;
+   }
+   m_retired.erase(m_retired.begin(), it);
+}
+
 }
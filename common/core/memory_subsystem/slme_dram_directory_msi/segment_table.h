@@ -3,6 +3,7 @@
 // #include <map>
 #include "fixed_types.h"
 #include <set>
+#include <vector>
 
 namespace SingleLevelMemory
 {
@@ -77,6 +78,67 @@ namespace SingleLevelMemory
       }
    };
 
+   // Sorted index of non-overlapping segments with lock-free readers
+   //
+   // Readers see an immutable snapshot: a sorted array of chunks, each holding up to ChunkSize sorted
+   // segments. A writer copies the chunk it changes and the (small) chunk array, then publishes the new
+   // snapshot. Each reader has its own slot, in which it announces the snapshot version it is using
+   // (so retired snapshots are only freed once no reader can still see them) and remembers its last hit.
+   // Lookups are O(1) when hitting the same segment again, O(log n) otherwise.
+   class SegmentIndex
+   {
+      public:
+         SegmentIndex(UInt32 num_readers);
+         ~SegmentIndex();
+
+         // Readers: reader must be < num_readers, and a reader slot must only be used by one thread at a time.
+         // Returns the policy of the segment containing address, or NULL.
+         PolicyBase* lookup(IntPtr address, UInt32 reader);
+
+         // Writers, need to be serialized by the caller
+         bool insert(IntPtr start, IntPtr end);   //< Returns false if the segment overlaps an existing one
+         // Set the policy of the segment starting at start, returns false if there is no such segment.
+         // The previous policy is returned in old_policy, it may still be in use by concurrent readers.
+         bool setPolicy(IntPtr start, PolicyBase *policy, PolicyBase **old_policy);
+         size_t size() const { return m_size; }
+         // All policies currently set, for cleanup
+         void getPolicies(std::vector<PolicyBase*> &policies) const;
+
+      private:
+         static const UInt32 ChunkSize = 128;
+
+         struct Chunk
+         {
+            std::vector<Segment> segments;
+         };
+         struct Snapshot
+         {
+            UInt64 version;
+            std::vector<const Chunk*> chunks;
+            std::vector<IntPtr> starts;             //< First segment start of each chunk
+            std::vector<const Chunk*> replaced;     //< Once retired: chunks that no newer snapshot uses
+         };
+         struct Reader
+         {
+            const Snapshot * volatile hazard;       //< Snapshot in use, NULL when not reading
+            UInt64 last_version;                    //< Snapshot version last_segment belongs to
+            const Segment *last_segment;
+            UInt8 _pad[40];
+         };
+
+         Snapshot *m_current;
+         std::vector<Snapshot*> m_retired;
+         Reader *m_readers;
+         UInt32 m_num_readers;
+         size_t m_size;
+
+         const Snapshot* acquire(Reader &reader);
+         static const Segment* find(const Snapshot *snapshot, IntPtr address);
+         size_t findChunk(IntPtr address) const;
+         void publish(Snapshot *snapshot, const Chunk *replaced);
+         void reclaim();
+   };
+
    class GlobalMemoryManager;
 
    class SegmentTable
@@ -72,12 +72,6 @@ const char * ReasonString(Transition::reason_t reason) {
    }
 }
 
-MshrEntry make_mshr(SubsecondTime t_issue, SubsecondTime t_complete) {
-   MshrEntry e;
-   e.t_issue = t_issue; e.t_complete = t_complete;
-   return e;
-}
-
 #ifdef ENABLE_TRACK_SHARING_PREVCACHES
 PrevCacheIndex CacheCntlrList::find(core_id_t core_id, MemComponent::component_t mem_component)
 {
@@ -92,7 +86,7 @@ void CacheMasterCntlr::createSetLocks(UInt32 cache_block_size, UInt32 num_sets,
 {
    m_log_blocksize = floorLog2(cache_block_size);
    m_num_sets = num_sets;
-   m_setlocks.resize(m_num_sets, SetLock(core_offset, num_cores));
+   m_setlocks.resize(m_num_sets, SetLock(core_offset, num_cores, &m_setlock_wait));
 }
 
 SetLock*
@@ -148,6 +142,7 @@ VirtCacheCntlr::VirtCacheCntlr(MemComponent::component_t mem_component,
    m_passthrough(Sim()->getCfg()->getBoolArray("perf_model/" + cache_params.configName + "/passthrough", core_id)),
    m_coherent(cache_params.coherent),
    m_prefetch_on_prefetch_hit(false),
+   m_eip(0),
    m_l1_mshr(cache_params.outstanding_misses > 0),
    m_core_id(core_id),
    m_cache_block_size(cache_block_size),
@@ -173,7 +168,10 @@ VirtCacheCntlr::VirtCacheCntlr(MemComponent::component_t mem_component,
    if (isMasterCache())
    {
       /* Master cache */
-      m_master = new CacheMasterCntlr(name, core_id, cache_params.outstanding_misses);
+      // Shared caches partition their MSHR into banks so cores missing on different lines do not contend
+      m_master = new CacheMasterCntlr(name, core_id, cache_params.outstanding_misses,
+         m_shared_cores > 1 ? Sim()->getCfg()->getInt("perf_model/cache/mshr_banks") : 1,
+         Sim()->getCfg()->getInt("perf_model/cache/mshr_entries"));
       m_master->m_cache = new Cache(name,
             "perf_model/" + cache_params.configName,
             m_core_id,
@@ -186,7 +184,7 @@ VirtCacheCntlr::VirtCacheCntlr(MemComponent::component_t mem_component,
             Sim()->getFaultinjectionManager()
                ? Sim()->getFaultinjectionManager()->getFaultInjector(m_core_id_master, mem_component)
                : NULL);
-      m_master->m_prefetcher = Prefetcher::createPrefetcher(cache_params.prefetcher, cache_params.configName, m_core_id, m_shared_cores);
+      m_master->m_prefetcher = Prefetcher::createPrefetcher(cache_params.prefetcher, cache_params.configName, m_core_id, m_shared_cores, m_cache_block_size);
 
       if (Sim()->getCfg()->getBoolDefault("perf_model/" + cache_params.configName + "/atd/enabled", false))
       {
@@ -327,13 +325,16 @@ VirtCacheCntlr::processMemOpFromCore(
       IntPtr ca_address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
       bool modeled,
-      bool count)
+      bool count,
+      IntPtr eip)
 {
    HitWhere::where_t hit_where = HitWhere::MISS;
 
    // Protect against concurrent access from sibling SMT threads
    ScopedLock sl_smt(m_master->m_smt_lock);
 
+   m_eip = eip;
+
    LOG_PRINT("processMemOpFromCore(), lock_signal(%u), mem_op_type(%u), ca_address(0x%x)",
              lock_signal, mem_op_type, ca_address);
 MYLOG("----------------------------------------------");
@@ -341,7 +342,7 @@ MYLOG("%c%c %lx+%u..+%u", mem_op_type == Core::WRITE ? 'W' : 'R', mem_op_type ==
 LOG_ASSERT_ERROR((ca_address & (getCacheBlockSize() - 1)) == 0, "address at cache line + %x", ca_address & (getCacheBlockSize() - 1));
 LOG_ASSERT_ERROR(offset + data_length <= getCacheBlockSize(), "access until %u > %u", offset + data_length, getCacheBlockSize());
 
-   if (dynamic_cast<GlobalMemoryManager *>(Sim()->getCoreManager()->getCoreFromID(0)->getMemoryManager())->policyLookup(ca_address)->getId() == 2)
+   if (dynamic_cast<GlobalMemoryManager *>(Sim()->getCoreManager()->getCoreFromID(0)->getMemoryManager())->policyLookup(ca_address, m_core_id)->getId() == 2)
    {
       // LOG_PRINT_WARNING("Subsription policy handles %lx", ca_address);
       hit_where = (HitWhere::where_t)m_mem_component;
@@ -438,13 +439,14 @@ MYLOG("L1 hit");
 
       if (modeled)
       {
-         ScopedLock sl(getLock());
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
+         // The MSHR lookup is lock-free, only take the cache lock when there is something to update.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(ca_address)
-            && (m_master->mshr[ca_address].t_issue < t_now && m_master->mshr[ca_address].t_complete > t_now))
+         SubsecondTime t_complete;
+         if (m_master->mshr.isOverlapping(ca_address, t_now, &t_complete))
          {
-            SubsecondTime latency = m_master->mshr[ca_address].t_complete - t_now;
+            ScopedLock sl(getLock());
+            SubsecondTime latency = t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
          }
@@ -685,7 +687,8 @@ VirtCacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hi
    ScopedLock sl(getLock());
 
    // Always train the prefetcher
-   std::vector<IntPtr> prefetchList = m_master->m_prefetcher->getNextAddress(address, m_core_id);
+   IntPtr prefetchList[Prefetcher::MAX_PREFETCHES];
+   UInt32 numPrefetches = m_master->m_prefetcher->getNextAddress(address, m_eip, m_core_id, prefetchList);
 
    // Only do prefetches on misses, or on hits to lines previously brought in by the prefetcher (if enabled)
    if (!cache_hit || (m_prefetch_on_prefetch_hit && prefetch_hit))
@@ -694,13 +697,13 @@ VirtCacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hi
       // Just talked to the next-level cache, wait a bit before we start to prefetch
       m_master->m_prefetch_next = t_issue + PREFETCH_INTERVAL;
 
-      for(std::vector<IntPtr>::iterator it = prefetchList.begin(); it != prefetchList.end(); ++it)
+      for(UInt32 i = 0; i < numPrefetches; ++i)
       {
          // Keep at most PREFETCH_MAX_QUEUE_LENGTH entries in the prefetch queue
          if (m_master->m_prefetch_list.size() > PREFETCH_MAX_QUEUE_LENGTH)
             break;
-         if (!operationPermissibleinCache(*it, Core::READ))
-            m_master->m_prefetch_list.push_back(*it);
+         if (!operationPermissibleinCache(prefetchList[i], Core::READ))
+            m_master->m_prefetch_list.push_back(prefetchList[i]);
       }
    }
 }
@@ -777,6 +780,9 @@ VirtCacheCntlr::doPrefetch(IntPtr prefetch_address, SubsecondTime t_start)
 HitWhere::where_t
 VirtCacheCntlr::processShmemReqFromPrevCache(VirtCacheCntlr* requester, Core::mem_op_t mem_op_type, IntPtr address, bool modeled, bool count, Prefetch::prefetch_type_t isPrefetch, SubsecondTime t_issue, bool have_write_lock)
 {
+   // Demand accesses are attributed to the instruction that missed in the previous level
+   m_eip = isPrefetch == Prefetch::NONE ? requester->m_eip : 0;
+
    #ifdef PRIVATE_L2_OPTIMIZATION
    bool have_write_lock_internal = have_write_lock;
    if (! have_write_lock && m_shared_cores > 1)
@@ -841,13 +847,14 @@ VirtCacheCntlr::processShmemReqFromPrevCache(VirtCacheCntlr* requester, Core::me
          of the previous-level cache, not our (longer) access time */
       if (modeled)
       {
-         ScopedLock sl(getLock());
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
+         // The MSHR lookup is lock-free, only take the cache lock when there is something to update.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(address)
-            && (m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now))
+         SubsecondTime t_complete;
+         if (m_master->mshr.isOverlapping(address, t_now, &t_complete))
          {
-            SubsecondTime latency = m_master->mshr[address].t_complete - t_now;
+            ScopedLock sl(getLock());
+            SubsecondTime latency = t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
          }
@@ -1022,11 +1029,7 @@ VirtCacheCntlr::processShmemReqFromPrevCache(VirtCacheCntlr* requester, Core::me
       retrieveCacheBlock(address, data_buf, ShmemPerfModel::_USER_THREAD, first_hit && count);
       /* Store completion time so we can detect overlapping accesses */
       if (modeled && !first_hit && !m_passthrough)
-      {
-         ScopedLock sl(getLock());
-         m_master->mshr[address] = make_mshr(t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
-         cleanupMshr();
-      }
+         m_master->mshr.insert(address, t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
    }
 
    if (modeled && m_master->m_prefetcher)
@@ -1912,11 +1915,7 @@ MYLOG("wakeup user #%u", request->cache_cntlr->m_core_id);
          waitForUserThread(request->cache_cntlr->m_network_thread_sem);
          acquireStackLock(address);
 
-         {
-            ScopedLock sl(request->cache_cntlr->getLock());
-            request->cache_cntlr->m_master->mshr[address] = make_mshr(request->t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD));
-            cleanupMshr();
-         }
+         request->cache_cntlr->m_master->mshr.insert(address, request->t_issue, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD));
 
          getLock().acquire();
          MYLOG("about to dequeue request (%p) for address %lx", m_master->m_directory_waiters.front(address), address );
@@ -2140,7 +2139,7 @@ VirtCacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool
       operationPermissibleinCache() will think it's a hit (so cache_hit == true) since the processing
       of the previous miss was done instantaneously. But mshr[address] contains its completion time */
    SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-   bool overlapping = m_master->mshr.count(address) && m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now;
+   bool overlapping = m_master->mshr.isOverlapping(address, t_now);
 
    // ATD doesn't track state, so when reporting hit/miss to it we shouldn't either (i.e. write hit to shared line becomes hit, not miss)
    bool cache_data_hit = (state != CacheState::INVALID);
@@ -2177,8 +2176,6 @@ VirtCacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool
       }
    }
 
-   cleanupMshr();
-
    #ifdef ENABLE_TRANSITIONS
    transition(
       address,
@@ -2189,23 +2186,6 @@ VirtCacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool
    #endif
 }
 
-void
-VirtCacheCntlr::cleanupMshr()
-{
-   /* Keep only last 8 MSHR entries */
-   while(m_master->mshr.size() > 8) {
-      IntPtr address_min = 0;
-      SubsecondTime time_min = SubsecondTime::MaxTime();
-      for(Mshr::iterator it = m_master->mshr.begin(); it != m_master->mshr.end(); ++it) {
-         if (it->second.t_complete < time_min) {
-            address_min = it->first;
-            time_min = it->second.t_complete;
-         }
-      }
-      m_master->mshr.erase(address_min);
-   }
-}
-
 void
 VirtCacheCntlr::transition(IntPtr address, Transition::reason_t reason, CacheState::cstate_t old_state, CacheState::cstate_t new_state)
 {
@@ -11,6 +11,7 @@
 #include "semaphore.h"
 #include "lock.h"
 #include "setlock.h"
+#include "mshr_table.h"
 #include "fixed_types.h"
 #include "shmem_perf_model.h"
 #include "contention_model.h"
@@ -75,11 +76,6 @@ namespace SingleLevelMemory
 
    typedef ReqQueueListTemplate<CacheDirectoryWaiter> CacheDirectoryWaiterMap;
 
-   struct MshrEntry {
-      SubsecondTime t_issue, t_complete;
-   };
-   typedef std::unordered_map<IntPtr, MshrEntry> Mshr;
-
    class CacheMasterCntlr
    {
       private:
@@ -91,9 +87,11 @@ namespace SingleLevelMemory
          DramCntlrInterface* m_dram_cntlr;
          ContentionModel* m_dram_outstanding_writebacks;
 
-         Mshr mshr;
+         LockWaitStats m_mshr_wait;
+         MshrTable mshr;   //< Completion times of recent misses, looked up without locking
          ContentionModel m_l1_mshr;
          ContentionModel m_next_level_read_bandwidth;
+         ReqQueueListStats m_directory_waiters_stats;
          CacheDirectoryWaiterMap m_directory_waiters;
          IntPtr m_evicting_address;
          Byte* m_evicting_buf;
@@ -101,6 +99,7 @@ namespace SingleLevelMemory
          std::vector<ATD*> m_atds;
 
          std::vector<SetLock> m_setlocks;
+         LockWaitStats m_setlock_wait;
          UInt32 m_log_blocksize;
          UInt32 m_num_sets;
 
@@ -114,19 +113,34 @@ namespace SingleLevelMemory
             String replacement_policy, CacheBase::hash_t hash_function);
          void accessATDs(Core::mem_op_t mem_op_type, bool hit, IntPtr address, UInt32 core_num);
 
-         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses)
+         CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses, UInt32 mshr_banks, UInt32 mshr_entries)
             : m_cache(NULL)
             , m_prefetcher(NULL)
             , m_dram_cntlr(NULL)
             , m_dram_outstanding_writebacks(NULL)
+            , m_mshr_wait()
+            , mshr(mshr_banks, mshr_entries, &m_mshr_wait)
             , m_l1_mshr(name + ".mshr", core_id, outstanding_misses)
             , m_next_level_read_bandwidth(name + ".next_read", core_id)
+            , m_directory_waiters_stats()
+            , m_directory_waiters(&m_directory_waiters_stats)
             , m_evicting_address(0)
             , m_evicting_buf(NULL)
             , m_atds()
+            , m_setlock_wait()
             , m_prefetch_list()
             , m_prefetch_next(SubsecondTime::Zero())
-         {}
+         {
+            registerStatsMetric(name, core_id, "mshr-lock-contended", &m_mshr_wait.contended);
+            registerStatsMetric(name, core_id, "mshr-lock-wait-time", &m_mshr_wait.wait_time);
+            registerStatsMetric(name, core_id, "setlock-contended", &m_setlock_wait.contended);
+            registerStatsMetric(name, core_id, "setlock-wait-time", &m_setlock_wait.wait_time);
+            registerStatsMetric(name, core_id, "directory-waiters-addresses-max", &m_directory_waiters_stats.addresses_max);
+            registerStatsMetric(name, core_id, "directory-waiters-lookups", &m_directory_waiters_stats.lookups);
+            registerStatsMetric(name, core_id, "directory-waiters-probes", &m_directory_waiters_stats.probes);
+            registerStatsMetric(name, core_id, "directory-waiters-probes-max", &m_directory_waiters_stats.probes_max);
+            registerStatsMetric(name, core_id, "directory-waiters-overflows", &m_directory_waiters_stats.overflows);
+         }
          ~CacheMasterCntlr();
 
          friend class VirtCacheCntlr;
@@ -147,6 +161,7 @@ namespace SingleLevelMemory
          bool m_passthrough;
          bool m_coherent;
          bool m_prefetch_on_prefetch_hit;
+         IntPtr m_eip; //< Instruction pointer of the access being processed, passed to the prefetcher
          bool m_l1_mshr;
 
          struct {
@@ -184,7 +199,6 @@ namespace SingleLevelMemory
          #endif
 
          void updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cache_hit, CacheState::cstate_t state, Prefetch::prefetch_type_t isPrefetch);
-         void cleanupMshr();
          void transition(IntPtr address, Transition::reason_t reason, CacheState::cstate_t old_state, CacheState::cstate_t new_state);
          void updateUncoreStatistics(HitWhere::where_t hit_where, SubsecondTime now);
 
@@ -317,7 +331,8 @@ namespace SingleLevelMemory
                IntPtr ca_address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
                bool modeled,
-               bool count);
+               bool count,
+               IntPtr eip = 0);
          void updateHits(Core::mem_op_t mem_op_type, UInt64 hits);
 
          // Notify next level cache of so it can update its sharing set
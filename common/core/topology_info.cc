@@ -19,7 +19,8 @@ void TopologyInfo::setup(UInt32 smt_cores, UInt32 llc_sharers)
 
    // Core level
    UInt32 cores_per_package;
-   if (Sim()->getCfg()->getString("network/memory_model_1") == "emesh_hop_by_hop")
+   String network_type = Sim()->getCfg()->getString("network/memory_model_1");
+   if (network_type == "emesh_hop_by_hop" || network_type == "emesh_parallel")
       // Mesh NoC: assume single chip
       cores_per_package = Sim()->getConfig()->getApplicationCores();
    else
@@ -27,6 +27,8 @@ public:
    virtual ~_Thread() { };
 
    virtual void run() = 0;
+   // Wait for the thread function to return
+   virtual void join() = 0;
 };
 
 #endif // THREAD_H
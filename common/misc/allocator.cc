@@ -0,0 +1,254 @@
+#include "allocator.h"
+#include "stats.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <pthread.h>
+
+// All magazine allocators by index, NULL once destroyed. Indices are not reused, so a thread-local table entry of
+// a destroyed allocator is never looked up again.
+struct MagazineAllocatorBase::Registry
+{
+   Lock lock;
+   std::vector<MagazineAllocatorBase*> allocators;
+   pthread_key_t thread_key;   //< Calls threadExit() with the thread's magazine table
+};
+
+__thread std::vector<MagazineAllocatorBase::Magazine*> *MagazineAllocatorBase::t_magazines = NULL;
+
+MagazineAllocatorBase::Registry* MagazineAllocatorBase::getRegistry()
+{
+   // Never destroyed: threads may exit after static destructors have run
+   static Registry *s_registry = NULL;
+   static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+   struct Init
+   {
+      static void create()
+      {
+         s_registry = new Registry();
+         pthread_key_create(&s_registry->thread_key, threadExit);
+      }
+   };
+   pthread_once(&s_once, Init::create);
+   return s_registry;
+}
+
+UInt32 MagazineAllocatorBase::addAllocator(MagazineAllocatorBase *allocator)
+{
+   Registry *registry = getRegistry();
+   ScopedLock sl(registry->lock);
+   registry->allocators.push_back(allocator);
+   return registry->allocators.size() - 1;
+}
+
+MagazineAllocatorBase::MagazineAllocatorBase(size_t elem_size, UInt32 max_items, const char *type_name)
+   : m_elem_size((elem_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+   , m_slab_size(getSlabSize(m_elem_size, SLAB_ITEMS))
+   , m_slab_items((m_slab_size - sizeof(Slab)) / m_elem_size)
+   , m_max_items(max_items)
+   , m_type_name(type_name)
+   , m_index(addAllocator(this))
+   , m_magazines(NULL)
+   , m_orphans(NULL)
+   , m_num_slabs(0)
+{
+}
+
+MagazineAllocatorBase::~MagazineAllocatorBase()
+{
+   // Exiting threads no longer hand their magazines back to us once we are out of the registry
+   {
+      Registry *registry = getRegistry();
+      ScopedLock sl(registry->lock);
+      registry->allocators[m_index] = NULL;
+   }
+
+   UInt64 items = 0;
+   while (m_magazines)
+   {
+      Magazine *magazine = m_magazines;
+      m_magazines = magazine->next;
+      for(FreeElement *elem = magazine->remote_free; elem; elem = elem->next)
+         ++magazine->remote_frees;
+      items += magazine->allocs - magazine->local_frees - magazine->remote_frees;
+      while (magazine->slabs)
+      {
+         Slab *slab = magazine->slabs;
+         magazine->slabs = slab->next;
+         free(slab);
+      }
+      delete magazine;
+   }
+
+   if (items)
+   {
+      int status;
+      char *nameoftype = abi::__cxa_demangle(m_type_name, 0, 0, &status);
+      printf("[ALLOC] %" PRIu64 " items of type %s not freed\n", items, nameoftype);
+      free(nameoftype);
+   }
+}
+
+size_t MagazineAllocatorBase::getSlabSize(size_t elem_size, UInt32 slab_items)
+{
+   // Round up to a power of two so the slab header can be found by masking an element's address
+   size_t bytes = sizeof(Slab) + slab_items * elem_size, size = 4096;
+   while (size < bytes)
+      size <<= 1;
+   return size;
+}
+
+MagazineAllocatorBase::Magazine* MagazineAllocatorBase::createMagazine()
+{
+   if (!t_magazines)
+   {
+      t_magazines = new std::vector<Magazine*>();
+      pthread_setspecific(getRegistry()->thread_key, t_magazines);
+   }
+   if (t_magazines->size() <= m_index)
+      t_magazines->resize(m_index + 1, NULL);
+
+   Magazine *magazine;
+   {
+      ScopedLock sl(m_lock);
+      if (m_orphans)
+      {
+         // Adopt the magazine of a thread that exited, elements free'd to it since are on its remote-free stack
+         magazine = m_orphans;
+         m_orphans = magazine->next_orphan;
+      }
+      else
+      {
+         magazine = new Magazine();
+         magazine->next_orphan = NULL;
+         magazine->local_free = NULL;
+         magazine->remote_free = NULL;
+         magazine->slabs = NULL;
+         magazine->allocs = magazine->local_frees = magazine->remote_frees = magazine->num_slabs = 0;
+         magazine->next = m_magazines;
+         m_magazines = magazine;
+      }
+   }
+
+   (*t_magazines)[m_index] = magazine;
+   return magazine;
+}
+
+void MagazineAllocatorBase::threadExit(void *arg)
+{
+   std::vector<Magazine*> *magazines = (std::vector<Magazine*>*)arg;
+   t_magazines = NULL;
+
+   Registry *registry = getRegistry();
+   ScopedLock sl(registry->lock);
+   for(UInt32 index = 0; index < magazines->size(); ++index)
+      if ((*magazines)[index] && registry->allocators[index])
+         registry->allocators[index]->orphan((*magazines)[index]);
+   delete magazines;
+}
+
+void MagazineAllocatorBase::orphan(Magazine *magazine)
+{
+   ScopedLock sl(m_lock);
+   magazine->next_orphan = m_orphans;
+   m_orphans = magazine;
+}
+
+MagazineAllocatorBase::FreeElement* MagazineAllocatorBase::refill(Magazine *magazine)
+{
+   // Take the complete remote-free stack at once: as no single elements are ever popped from it, there is no ABA problem
+   FreeElement *list = __atomic_exchange_n(&magazine->remote_free, (FreeElement*)NULL, __ATOMIC_ACQUIRE);
+   if (list)
+   {
+      for(FreeElement *elem = list; elem; elem = elem->next)
+         ++magazine->remote_frees;
+      return list;
+   }
+
+   UInt64 num_slabs = __atomic_fetch_add(&m_num_slabs, 1, __ATOMIC_RELAXED);
+   if (m_max_items)
+   {
+      int status;
+      char *nameoftype = abi::__cxa_demangle(m_type_name, 0, 0, &status);
+      LOG_ASSERT_ERROR(num_slabs * m_slab_items < m_max_items, "Maximum number of slabs exceeded for allocator of %lu-sized objects of %s", m_elem_size, nameoftype);
+      free(nameoftype);
+   }
+
+   void *ptr;
+   if (posix_memalign(&ptr, m_slab_size, m_slab_size))
+      LOG_PRINT_ERROR("Cannot allocate %lu bytes for %s", m_slab_size, m_type_name);
+   Slab *slab = (Slab*)ptr;
+   slab->owner = magazine;
+   slab->next = magazine->slabs;
+   magazine->slabs = slab;
+   ++magazine->num_slabs;
+
+   char *data = (char*)ptr + sizeof(Slab);
+   for(UInt32 i = 0; i < m_slab_items; ++i)
+   {
+      FreeElement *elem = (FreeElement*)(data + i * m_elem_size);
+      elem->next = i + 1 < m_slab_items ? (FreeElement*)(data + (i + 1) * m_elem_size) : NULL;
+   }
+   return (FreeElement*)data;
+}
+
+void* MagazineAllocatorBase::alloc(size_t bytes)
+{
+   Magazine *magazine = getMagazine();
+
+   FreeElement *elem = magazine->local_free;
+   if (!elem)
+      elem = refill(magazine);
+   magazine->local_free = elem->next;
+   ++magazine->allocs;
+
+   DataElement *data_elem = (DataElement*)elem;
+   data_elem->allocator = this;
+   return data_elem->data;
+}
+
+void MagazineAllocatorBase::_dealloc(void* ptr)
+{
+   // Called with the DataElement, which starts the element
+   FreeElement *elem = (FreeElement*)ptr;
+   Magazine *magazine = ((Slab*)((uintptr_t)ptr & ~(uintptr_t)(m_slab_size - 1)))->owner;
+
+   if (magazine == findMagazine())
+   {
+      elem->next = magazine->local_free;
+      magazine->local_free = elem;
+      ++magazine->local_frees;
+   }
+   else
+   {
+      elem->next = __atomic_load_n(&magazine->remote_free, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n(&magazine->remote_free, &elem->next, elem, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+         ;
+   }
+}
+
+UInt64 MagazineAllocatorBase::getStat(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   MagazineAllocatorBase *self = (MagazineAllocatorBase *)arg;
+   ScopedLock sl(self->m_lock);
+   UInt64 value = 0;
+   for(Magazine *magazine = self->m_magazines; magazine; magazine = magazine->next)
+   {
+      if (metricName == "allocs")
+         value += magazine->allocs;
+      else if (metricName == "remote_frees")
+         value += magazine->remote_frees;
+      else if (metricName == "slabs")
+         value += magazine->num_slabs;
+      else if (metricName == "threads")
+         value += 1;
+   }
+   return value;
+}
+
+void MagazineAllocatorBase::registerStats(String objectName, core_id_t core_id)
+{
+   const char *metrics[] = { "allocs", "remote_frees", "slabs", "threads" };
+   for(unsigned int i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i)
+      Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(objectName, core_id, metrics[i], getStat, (UInt64)this));
+}
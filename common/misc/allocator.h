@@ -3,15 +3,17 @@
 
 #include "fixed_types.h"
 #include "FSBAllocator.hh"
+#include "lock.h"
 
 #include <typeinfo>
 #include <cxxabi.h>
+#include <vector>
 
 // Pool allocator
 
 class Allocator
 {
-   private:
+   protected:
       struct DataElement
       {
           Allocator *allocator;
@@ -22,6 +24,7 @@ class Allocator
 
       virtual void *alloc(size_t bytes) = 0;
       virtual void _dealloc(void *ptr) = 0;
+      virtual void registerStats(String objectName, core_id_t core_id) {}
 
       static void dealloc(void* ptr)
       {
@@ -73,4 +76,91 @@ template <typename T, unsigned MaxItems = 0> class TypedAllocator : public Alloc
       }
 };
 
+// Thread-caching pool allocator
+//
+// Each host thread that allocates gets its own magazine, found through a thread-local table indexed by the
+// allocator's number. A magazine carves elements from size-aligned slabs it owns and recycles them through a free
+// list that only its own thread touches. Frees by other threads (in ROB-SMT, DynamicMicroOps are free'd in
+// simulate() which can be called by anyone) are pushed onto the owning magazine's remote-free stack with a single
+// compare-and-swap, and are taken back in one go by the owner once its own free list runs dry. Slabs are aligned to
+// their size, so the owning magazine of an element is found from its address. When a thread exits, its magazine
+// (with its free elements, and any remote frees still to come) is handed over to the next thread that needs one.
+
+class MagazineAllocatorBase : public Allocator
+{
+   private:
+      struct FreeElement
+      {
+         FreeElement *next;
+      };
+      struct Slab;
+      struct Magazine
+      {
+         Magazine *next;                        //< Next magazine of this allocator, protected by m_lock
+         Magazine *next_orphan;                 //< Next magazine without a thread, protected by m_lock
+         FreeElement *local_free;               //< Owner thread only
+         Slab *slabs;
+         UInt64 allocs, local_frees, remote_frees, num_slabs;
+         FreeElement *remote_free __attribute__((aligned(64)));   //< Pushed by any thread, drained by the owner
+      };
+      struct Slab
+      {
+         Magazine *owner;
+         Slab *next;
+      };
+      struct Registry;
+
+      static const UInt32 SLAB_ITEMS = 512;   //< Minimum number of elements per slab
+
+      const size_t m_elem_size;
+      const size_t m_slab_size;
+      const UInt32 m_slab_items;
+      const UInt32 m_max_items;                //< For the allocator as a whole, zero if unlimited
+      const char *m_type_name;
+      const UInt32 m_index;                    //< Index into the thread-local magazine tables
+
+      Lock m_lock;                             //< Taken only when a thread gets its magazine, or exits
+      Magazine *m_magazines;
+      Magazine *m_orphans;                     //< Magazines of threads that exited, to be adopted
+      UInt64 m_num_slabs;                      //< Updated atomically
+
+      static __thread std::vector<Magazine*> *t_magazines;
+
+      // This thread's magazine, or NULL if it has none yet
+      Magazine *findMagazine() const
+      {
+         std::vector<Magazine*> *magazines = t_magazines;
+         return magazines && m_index < magazines->size() ? (*magazines)[m_index] : NULL;
+      }
+      Magazine *getMagazine()
+      {
+         Magazine *magazine = findMagazine();
+         return magazine ? magazine : createMagazine();
+      }
+      Magazine *createMagazine();
+      FreeElement *refill(Magazine *magazine);
+      void orphan(Magazine *magazine);
+      static size_t getSlabSize(size_t elem_size, UInt32 slab_items);
+      static Registry* getRegistry();
+      static UInt32 addAllocator(MagazineAllocatorBase *allocator);
+      static void threadExit(void *arg);
+      static UInt64 getStat(String objectName, UInt32 index, String metricName, UInt64 arg);
+
+   public:
+      MagazineAllocatorBase(size_t elem_size, UInt32 max_items, const char *type_name);
+      virtual ~MagazineAllocatorBase();
+
+      virtual void* alloc(size_t bytes);
+      virtual void _dealloc(void* ptr);
+      virtual void registerStats(String objectName, core_id_t core_id);
+};
+
+template <typename T, unsigned MaxItems = 0> class MagazineAllocator : public MagazineAllocatorBase
+{
+   public:
+      MagazineAllocator()
+         : MagazineAllocatorBase(sizeof(DataElement) + sizeof(T), MaxItems, typeid(T).name())
+      {}
+};
+
 #endif // __ALLOCATOR_H
@@ -0,0 +1,163 @@
+#include "checkpoint.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char checkpoint_magic[8] = { 'S', 'N', 'I', 'P', 'C', 'K', 'P', 'T' };
+static const UInt32 checkpoint_version = 1;
+
+struct CheckpointHeader
+{
+   char magic[8];
+   UInt32 version;
+   UInt32 num_sections;
+   UInt64 index_offset;
+};
+
+CheckpointWriter::CheckpointWriter(String filename)
+   : m_filename(filename)
+   , m_offset(0)
+   , m_in_section(false)
+{
+   m_fp = fopen(m_filename.c_str(), "w");
+   LOG_ASSERT_ERROR(m_fp, "Cannot create checkpoint file %s", m_filename.c_str());
+
+   // Placeholder, rewritten with the index location once all sections are known
+   CheckpointHeader header;
+   memset(&header, 0, sizeof(header));
+   write(header);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+   LOG_ASSERT_ERROR(!m_in_section, "Checkpoint section %s was not ended", m_index.back().name.c_str());
+
+   align();
+   CheckpointHeader header;
+   memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+   header.version = checkpoint_version;
+   header.num_sections = m_index.size();
+   header.index_offset = m_offset;
+
+   for(std::vector<IndexEntry>::iterator it = m_index.begin(); it != m_index.end(); ++it)
+   {
+      write<UInt32>(it->name.size());
+      write(it->name.c_str(), it->name.size());
+      write(it->offset);
+      write(it->size);
+   }
+
+   fseek(m_fp, 0, SEEK_SET);
+   fwrite(&header, sizeof(header), 1, m_fp);
+   fclose(m_fp);
+}
+
+void
+CheckpointWriter::align()
+{
+   static const char padding[8] = { 0 };
+   if (m_offset % 8)
+      write(padding, 8 - m_offset % 8);
+}
+
+void
+CheckpointWriter::beginSection(String name)
+{
+   LOG_ASSERT_ERROR(!m_in_section, "Cannot start checkpoint section %s inside section %s", name.c_str(), m_index.back().name.c_str());
+   align();
+   IndexEntry entry = { name, m_offset, 0 };
+   m_index.push_back(entry);
+   m_in_section = true;
+}
+
+void
+CheckpointWriter::endSection()
+{
+   LOG_ASSERT_ERROR(m_in_section, "No checkpoint section to end");
+   m_index.back().size = m_offset - m_index.back().offset;
+   m_in_section = false;
+}
+
+void
+CheckpointWriter::write(const void *data, UInt64 size)
+{
+   if (size == 0)
+      return;
+   __attribute__((unused)) size_t res = fwrite(data, size, 1, m_fp);
+   LOG_ASSERT_ERROR(res == 1, "Error writing to checkpoint file %s", m_filename.c_str());
+   m_offset += size;
+}
+
+void
+CheckpointWriter::writeVector(const std::vector<bool> &values)
+{
+   // Packed one bit per element
+   std::vector<UInt8> bits((values.size() + 7) / 8, 0);
+   for(UInt64 i = 0; i < values.size(); ++i)
+      if (values[i])
+         bits[i / 8] |= 1 << (i % 8);
+   write<UInt64>(values.size());
+   write(bits.data(), bits.size());
+}
+
+
+void
+CheckpointReader::Section::readVector(std::vector<bool> &values)
+{
+   UInt64 count = read<UInt64>();
+   LOG_ASSERT_ERROR(count == values.size(), "Checkpoint section %s: found %ld elements, expected %ld", m_name.c_str(), count, values.size());
+   const UInt8 *bits = (const UInt8 *)read((count + 7) / 8);
+   for(UInt64 i = 0; i < count; ++i)
+      values[i] = bits[i / 8] & (1 << (i % 8));
+}
+
+CheckpointReader::CheckpointReader(String filename)
+   : m_filename(filename)
+{
+   int fd = open(m_filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Cannot open checkpoint file %s", m_filename.c_str());
+   struct stat st;
+   __attribute__((unused)) int rc = fstat(fd, &st);
+   LOG_ASSERT_ERROR(rc == 0, "Cannot stat checkpoint file %s", m_filename.c_str());
+   m_size = st.st_size;
+   LOG_ASSERT_ERROR(m_size >= sizeof(CheckpointHeader), "Checkpoint file %s is truncated", m_filename.c_str());
+
+   // Sections are only touched when their object is restored, let the kernel read ahead for the sequential copies
+   m_data = (char*)mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   LOG_ASSERT_ERROR(m_data != MAP_FAILED, "Cannot map checkpoint file %s", m_filename.c_str());
+   close(fd);
+   madvise(m_data, m_size, MADV_SEQUENTIAL);
+
+   const CheckpointHeader *header = (const CheckpointHeader *)m_data;
+   LOG_ASSERT_ERROR(memcmp(header->magic, checkpoint_magic, sizeof(checkpoint_magic)) == 0, "%s is not a checkpoint file", m_filename.c_str());
+   LOG_ASSERT_ERROR(header->version == checkpoint_version, "Checkpoint file %s has version %d, expected %d", m_filename.c_str(), header->version, checkpoint_version);
+   LOG_ASSERT_ERROR(header->index_offset <= m_size, "Checkpoint file %s is truncated", m_filename.c_str());
+
+   Section index("index", m_data + header->index_offset, m_size - header->index_offset);
+   for(UInt32 i = 0; i < header->num_sections; ++i)
+   {
+      UInt32 length = index.read<UInt32>();
+      String name((const char *)index.read(length), length);
+      UInt64 offset = index.read<UInt64>();
+      UInt64 size = index.read<UInt64>();
+      LOG_ASSERT_ERROR(offset + size <= header->index_offset, "Checkpoint file %s: section %s out of bounds", m_filename.c_str(), name.c_str());
+      m_sections[name] = std::make_pair(offset, size);
+   }
+}
+
+CheckpointReader::~CheckpointReader()
+{
+   munmap(m_data, m_size);
+}
+
+bool
+CheckpointReader::getSection(String name, Section &section) const
+{
+   std::map<String, std::pair<UInt64, UInt64> >::const_iterator it = m_sections.find(name);
+   if (it == m_sections.end())
+      return false;
+   section = Section(name, m_data + it->second.first, it->second.second);
+   return true;
+}
@@ -0,0 +1,114 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <map>
+
+// Microarchitectural state checkpoint file (caches, TLBs, branch predictors, directory).
+//
+// Layout: a fixed header, followed by one section per object, each starting at an 8-byte aligned offset,
+// and finally an index of (name, offset, size) records pointed to by the header. Sections hold raw
+// little-endian arrays so that a reader can mmap the file and copy them straight into the simulator's
+// data structures, restoring a multi-gigabyte checkpoint costs little more than the page faults.
+
+class CheckpointWriter
+{
+   public:
+      CheckpointWriter(String filename);
+      ~CheckpointWriter();
+
+      void beginSection(String name);
+      void endSection();
+
+      void write(const void *data, UInt64 size);
+      template <class T> void write(const T &value) { write(&value, sizeof(T)); }
+      // Element count followed by the elements, T must be trivially copyable
+      template <class T> void writeVector(const std::vector<T> &values)
+      {
+         write<UInt64>(values.size());
+         write(values.data(), values.size() * sizeof(T));
+      }
+      void writeVector(const std::vector<bool> &values);
+
+   private:
+      struct IndexEntry
+      {
+         String name;
+         UInt64 offset, size;
+      };
+
+      String m_filename;
+      FILE *m_fp;
+      UInt64 m_offset;
+      std::vector<IndexEntry> m_index;
+      bool m_in_section;
+
+      void align();
+};
+
+class CheckpointReader
+{
+   public:
+      // A read cursor over one section of the mapped file
+      class Section
+      {
+         public:
+            Section() : m_name(""), m_data(NULL), m_size(0), m_pos(0) {}
+            Section(String name, const char *data, UInt64 size) : m_name(name), m_data(data), m_size(size), m_pos(0) {}
+
+            // Pointer to the next size bytes of the mapped file, not necessarily aligned
+            const void* read(UInt64 size)
+            {
+               LOG_ASSERT_ERROR(m_pos + size <= m_size, "Checkpoint section %s: read of %ld bytes at offset %ld past its end (%ld bytes)", m_name.c_str(), size, m_pos, m_size);
+               const void *data = m_data + m_pos;
+               m_pos += size;
+               return data;
+            }
+            void read(void *data, UInt64 size) { memcpy(data, read(size), size); }
+            template <class T> T read() { T value; read(&value, sizeof(T)); return value; }
+            // Counterpart of CheckpointWriter::writeVector, the element count must match that of values
+            template <class T> void readVector(std::vector<T> &values)
+            {
+               UInt64 count = read<UInt64>();
+               LOG_ASSERT_ERROR(count == values.size(), "Checkpoint section %s: found %ld elements, expected %ld", m_name.c_str(), count, values.size());
+               read(values.data(), count * sizeof(T));
+            }
+            void readVector(std::vector<bool> &values);
+
+            String getName() const { return m_name; }
+            bool done() const { return m_pos == m_size; }
+
+         private:
+            String m_name;
+            const char *m_data;
+            UInt64 m_size, m_pos;
+      };
+
+      CheckpointReader(String filename);
+      ~CheckpointReader();
+
+      bool getSection(String name, Section &section) const;
+      UInt32 getNumSections() const { return m_sections.size(); }
+
+   private:
+      String m_filename;
+      char *m_data;
+      UInt64 m_size;
+      std::map<String, std::pair<UInt64, UInt64> > m_sections;   //< name -> (offset, size)
+};
+
+// Objects whose state can be checkpointed, registered with the CheckpointManager
+class Checkpointable
+{
+   public:
+      virtual ~Checkpointable() {}
+      virtual void saveState(CheckpointWriter &writer) = 0;
+      virtual void loadState(CheckpointReader::Section &section) = 0;
+};
+
+#endif // CHECKPOINT_H
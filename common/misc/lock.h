@@ -122,6 +122,15 @@ typedef TLock<LockCreator_Spinlock> SpinLock;
 typedef TLock<LockCreator_NullLock> NullLock;
 
 
+/* Contention counters for locks that time their slow path, can be shared by several locks */
+
+struct LockWaitStats
+{
+   UInt64 contended;   //< Number of acquisitions that had to wait
+   UInt64 wait_time;   //< Wall-clock time (ns) spent waiting
+};
+
+
 /* Helper class: hold a lock for the scope of this object */
 
 class ScopedLock
@@ -0,0 +1,183 @@
+#include "mshr_table.h"
+#include "timer.h"
+#include "log.h"
+#include "utils.h"
+
+#include <algorithm>
+
+MshrTable::MshrTable(UInt32 num_banks, UInt32 num_entries, LockWaitStats *stats)
+   : m_num_banks(std::max(1u, std::min(num_banks, num_entries)))
+   , m_entries_per_bank(num_entries / m_num_banks)
+   , m_slots_per_bank(1 << ceilLog2(2 * std::max(1u, m_entries_per_bank)))
+   , m_banks(new Bank[m_num_banks])
+   , m_entries(UInt64(m_num_banks) * m_slots_per_bank)
+   , m_stats(stats)
+{
+   LOG_ASSERT_ERROR(num_banks > 0 && num_entries > 0, "MSHR table needs at least one bank and one entry");
+   LOG_ASSERT_ERROR(num_entries % m_num_banks == 0, "MSHR table of %u entries cannot be split evenly over %u banks", num_entries, m_num_banks);
+
+   for(UInt32 b = 0; b < m_num_banks; ++b)
+   {
+      m_banks[b].seq = 0;
+      m_banks[b].lock = 0;
+      m_banks[b].size = 0;
+      m_banks[b].entries = &m_entries[UInt64(b) * m_slots_per_bank];
+      for(UInt32 s = 0; s < m_slots_per_bank; ++s)
+         m_banks[b].entries[s].address = INVALID_ADDRESS;
+   }
+}
+
+MshrTable::~MshrTable()
+{
+   delete [] m_banks;
+}
+
+bool
+MshrTable::isOverlapping(IntPtr address, SubsecondTime t_now, SubsecondTime *t_complete) const
+{
+   const Bank &bank = getBank(address);
+   const UInt32 first = getSlot(address);
+   while (true)
+   {
+      UInt32 seq = __atomic_load_n(&bank.seq, __ATOMIC_ACQUIRE);
+      if (seq & 1)
+      {
+         __builtin_ia32_pause();
+         continue;
+      }
+
+      bool found = false;
+      UInt64 issue = 0, complete = 0;
+      for(UInt32 s = first, n = 0; n < m_slots_per_bank; s = (s + 1) & (m_slots_per_bank - 1), ++n)
+      {
+         IntPtr entry_address = __atomic_load_n(&bank.entries[s].address, __ATOMIC_RELAXED);
+         if (entry_address == address)
+         {
+            issue = __atomic_load_n(&bank.entries[s].t_issue, __ATOMIC_RELAXED);
+            complete = __atomic_load_n(&bank.entries[s].t_complete, __ATOMIC_RELAXED);
+            found = true;
+            break;
+         }
+         else if (entry_address == INVALID_ADDRESS)
+            break;
+      }
+
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&bank.seq, __ATOMIC_RELAXED) != seq)
+         continue;
+
+      if (found && issue < t_now.getFS() && complete > t_now.getFS())
+      {
+         if (t_complete)
+            *t_complete = SubsecondTime::FS(complete);
+         return true;
+      }
+      return false;
+   }
+}
+
+void
+MshrTable::insert(IntPtr address, SubsecondTime t_issue, SubsecondTime t_complete)
+{
+   Bank &bank = getBank(address);
+   const UInt32 mask = m_slots_per_bank - 1;
+
+   lockBank(bank);
+   __atomic_store_n(&bank.seq, bank.seq + 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   UInt32 slot = getSlot(address);
+   while (bank.entries[slot].address != INVALID_ADDRESS && bank.entries[slot].address != address)
+      slot = (slot + 1) & mask;
+
+   if (bank.entries[slot].address == INVALID_ADDRESS)
+   {
+      bool do_insert = true;
+      if (bank.size == m_entries_per_bank)
+      {
+         // Full: keep only the entries that complete last
+         UInt32 slot_min = 0;
+         UInt64 time_min = UINT64_MAX;
+         for(UInt32 s = 0; s < m_slots_per_bank; ++s)
+            if (bank.entries[s].address != INVALID_ADDRESS && bank.entries[s].t_complete < time_min)
+            {
+               slot_min = s;
+               time_min = bank.entries[s].t_complete;
+            }
+         if (t_complete.getFS() < time_min)
+            do_insert = false;
+         else
+         {
+            erase(bank, slot_min);
+            slot = getSlot(address);
+            while (bank.entries[slot].address != INVALID_ADDRESS)
+               slot = (slot + 1) & mask;
+         }
+      }
+      if (do_insert)
+      {
+         __atomic_store_n(&bank.entries[slot].address, address, __ATOMIC_RELAXED);
+         ++bank.size;
+      }
+      else
+         slot = m_slots_per_bank;
+   }
+
+   if (slot < m_slots_per_bank)
+   {
+      __atomic_store_n(&bank.entries[slot].t_issue, t_issue.getFS(), __ATOMIC_RELAXED);
+      __atomic_store_n(&bank.entries[slot].t_complete, t_complete.getFS(), __ATOMIC_RELAXED);
+   }
+
+   __atomic_store_n(&bank.seq, bank.seq + 1, __ATOMIC_RELEASE);
+   unlockBank(bank);
+}
+
+// Backward-shift deletion, keeps probe sequences intact without tombstones. Called with the bank locked.
+void
+MshrTable::erase(Bank &bank, UInt32 slot)
+{
+   const UInt32 mask = m_slots_per_bank - 1;
+   UInt32 hole = slot;
+   for(UInt32 s = (hole + 1) & mask; bank.entries[s].address != INVALID_ADDRESS; s = (s + 1) & mask)
+   {
+      // An entry can move into the hole only if its home slot is not cyclically in (hole, s]
+      UInt32 home = getSlot(bank.entries[s].address);
+      bool stays = hole <= s ? (home > hole && home <= s) : (home > hole || home <= s);
+      if (stays)
+         continue;
+      __atomic_store_n(&bank.entries[hole].t_issue, bank.entries[s].t_issue, __ATOMIC_RELAXED);
+      __atomic_store_n(&bank.entries[hole].t_complete, bank.entries[s].t_complete, __ATOMIC_RELAXED);
+      __atomic_store_n(&bank.entries[hole].address, bank.entries[s].address, __ATOMIC_RELAXED);
+      hole = s;
+   }
+   __atomic_store_n(&bank.entries[hole].address, INVALID_ADDRESS, __ATOMIC_RELAXED);
+   --bank.size;
+}
+
+void
+MshrTable::lockBank(Bank &bank)
+{
+   if (__atomic_exchange_n(&bank.lock, 1, __ATOMIC_ACQUIRE) == 0)
+      return;
+
+   UInt64 t_start = Timer::now();
+   do
+   {
+      while (__atomic_load_n(&bank.lock, __ATOMIC_RELAXED))
+         __builtin_ia32_pause();
+   }
+   while (__atomic_exchange_n(&bank.lock, 1, __ATOMIC_ACQUIRE));
+
+   if (m_stats)
+   {
+      __atomic_fetch_add(&m_stats->contended, 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&m_stats->wait_time, Timer::now() - t_start, __ATOMIC_RELAXED);
+   }
+}
+
+void
+MshrTable::unlockBank(Bank &bank)
+{
+   __atomic_store_n(&bank.lock, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,61 @@
+#ifndef MSHR_TABLE_H
+#define MSHR_TABLE_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "lock.h"
+
+#include <vector>
+
+/* Completion times of recent misses, used to detect accesses that overlap with a miss still in flight.
+
+   The table holds <num_entries> entries in total, partitioned by address into at most <num_banks> banks (never
+   more banks than entries). Each bank is a fixed-capacity, open-addressed (linear probing) array that keeps its
+   share of the entries with the latest completion time. Lookups, which are done on
+   every cache hit, take no lock: each bank has a sequence number that is odd while a writer is modifying the bank,
+   readers retry when it changed while they were reading. Inserts, done only on misses, take a per-bank spin lock. */
+
+class MshrTable
+{
+   public:
+      MshrTable(UInt32 num_banks, UInt32 num_entries, LockWaitStats *stats = NULL);
+      ~MshrTable();
+
+      // True if <address> has an entry with t_issue < t_now < t_complete, in which case *t_complete is set
+      bool isOverlapping(IntPtr address, SubsecondTime t_now, SubsecondTime *t_complete = NULL) const;
+      void insert(IntPtr address, SubsecondTime t_issue, SubsecondTime t_complete);
+
+   private:
+      struct Entry
+      {
+         IntPtr address;
+         UInt64 t_issue;      // In femtoseconds, so lookups can read them with atomic loads
+         UInt64 t_complete;
+      };
+
+      struct Bank
+      {
+         UInt32 seq;
+         UInt32 lock;
+         UInt32 size;
+         Entry *entries;
+      } __attribute__ ((aligned (64)));
+
+      const UInt32 m_num_banks;
+      const UInt32 m_entries_per_bank;
+      const UInt32 m_slots_per_bank;   // Power of two, at least twice m_entries_per_bank to keep probe sequences short
+      Bank *m_banks;
+      std::vector<Entry> m_entries;
+      LockWaitStats *m_stats;          // Time spent waiting for a bank lock
+
+      // Addresses are cache-line aligned, multiplicative hashing moves their entropy into the upper bits
+      static UInt64 hash(IntPtr address) { return address * 0x9e3779b97f4a7c15ULL; }
+      Bank &getBank(IntPtr address) const { return m_banks[(hash(address) >> 40) % m_num_banks]; }
+      UInt32 getSlot(IntPtr address) const { return (hash(address) >> 24) & (m_slots_per_bank - 1); }
+
+      void lockBank(Bank &bank);
+      void unlockBank(Bank &bank);
+      void erase(Bank &bank, UInt32 slot);
+};
+
+#endif // MSHR_TABLE_H
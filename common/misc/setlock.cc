@@ -1,15 +1,33 @@
 #include "setlock.h"
+#include "timer.h"
 #include <assert.h>
 
-_SetLock::_SetLock(UInt32 core_offset, UInt32 num_sharers)
+_SetLock::_SetLock(UInt32 core_offset, UInt32 num_sharers, LockWaitStats *stats)
    : m_locks(num_sharers)
    , m_core_offset(core_offset)
+   , m_stats(stats)
 {
    #ifdef TIME_LOCKS
    _timer = TotalTimer::getTimerByStacktrace("setlock@" + itostr(this));
    #endif
 }
 
+// Uncontended acquisitions only cost a trylock, time the others
+void
+_SetLock::acquire(PersetLock &lock)
+{
+   if (lock.try_acquire())
+      return;
+
+   UInt64 t_start = Timer::now();
+   lock.acquire();
+   if (m_stats)
+   {
+      __atomic_fetch_add(&m_stats->contended, 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&m_stats->wait_time, Timer::now() - t_start, __ATOMIC_RELAXED);
+   }
+}
+
 // Acquire exclusive access
 void
 _SetLock::acquire_exclusive(void)
@@ -19,7 +37,7 @@ _SetLock::acquire_exclusive(void)
    #endif
 
    for(std::vector<PersetLock>::iterator it = m_locks.begin(); it != m_locks.end(); ++it)
-      (*it).acquire();
+      acquire(*it);
 }
 
 // Release exclusive access
@@ -40,7 +58,7 @@ _SetLock::acquire_shared(UInt32 core_id)
 
    assert(core_id >= m_core_offset);
    assert(core_id < m_core_offset + m_locks.size());
-   m_locks.at(core_id - m_core_offset).acquire();
+   acquire(m_locks.at(core_id - m_core_offset));
 }
 
 // Release shared access
@@ -12,7 +12,7 @@
 class _SetLock
 {
    public:
-      _SetLock(UInt32 core_offset, UInt32 num_sharers);
+      _SetLock(UInt32 core_offset, UInt32 num_sharers, LockWaitStats *stats = NULL);
       void acquire_exclusive(void);
       void release_exclusive(void);
       void acquire_shared(UInt32 core_id);
@@ -26,6 +26,7 @@ class _SetLock
          public:
             PersetLock() { pthread_mutex_init(&_mutx, NULL); }
             void acquire() { pthread_mutex_lock(&_mutx); }
+            bool try_acquire() { return pthread_mutex_trylock(&_mutx) == 0; }
             void release() { pthread_mutex_unlock(&_mutx); }
          private:
             pthread_mutex_t _mutx;
@@ -33,15 +34,18 @@ class _SetLock
 
       std::vector<PersetLock> m_locks;
       UInt32 m_core_offset;
+      LockWaitStats *m_stats;
       #ifdef TIME_LOCKS
       TotalTimer* _timer;
       #endif
+
+      void acquire(PersetLock &lock);
 };
 
 class _SELock : SELock
 {
    public:
-      _SELock(UInt32 core_offset, UInt32 num_sharers) : SELock() {}
+      _SELock(UInt32 core_offset, UInt32 num_sharers, LockWaitStats *stats = NULL) : SELock() {}
       void acquire_shared(UInt32 core_id) { SELock::acquire_shared(); }
       void release_shared(UInt32 core_id) { SELock::release_shared(); }
       void downgrade(UInt32 core_id)      { SELock::downgrade(); }
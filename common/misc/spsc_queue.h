@@ -0,0 +1,96 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+#include <sched.h>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+//
+// Entries are filled in place: the producer fills the slot returned by back() and publishes it with push(),
+// the consumer reads front() and releases it with pop(). Head and tail live on separate cache lines, and
+// each side keeps a cached copy of the other's index so it only touches the shared line when the queue
+// looks full (empty). Neither side blocks: callers wait using backoff(), so they can check for other events.
+
+template <class T> class SPSCQueue
+{
+   public:
+      SPSCQueue(UInt32 size)
+         : m_slots(roundUp(size))
+         , m_mask(m_slots.size() - 1)
+         , m_head(0)
+         , m_tail_cached(0)
+         , m_tail(0)
+         , m_head_cached(0)
+      {}
+
+      // Producer side: the slot to fill next, or NULL when the queue is full
+      T* back()
+      {
+         if (m_tail - m_head_cached == m_slots.size())
+         {
+            m_head_cached = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+            if (m_tail - m_head_cached == m_slots.size())
+               return NULL;
+         }
+         return &m_slots[m_tail & m_mask];
+      }
+      void push()
+      {
+         __atomic_store_n(&m_tail, m_tail + 1, __ATOMIC_RELEASE);
+      }
+
+      // Consumer side: the oldest slot, or NULL when the queue is empty
+      T* front()
+      {
+         if (m_head == m_tail_cached)
+         {
+            m_tail_cached = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+            if (m_head == m_tail_cached)
+               return NULL;
+         }
+         return &m_slots[m_head & m_mask];
+      }
+      void pop()
+      {
+         __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELEASE);
+      }
+
+      // Call while waiting for the other side, with spin counting up from zero
+      static void backoff(UInt64 spin)
+      {
+         if (spin < 1000)
+         {
+            #if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+            #endif
+         }
+         else
+            sched_yield();
+      }
+
+   private:
+      static UInt32 roundUp(UInt32 size)
+      {
+         LOG_ASSERT_ERROR(size > 0, "Queue size must be positive");
+         UInt32 slots = 1;
+         while (slots < size)
+            slots <<= 1;
+         return slots;
+      }
+
+      std::vector<T> m_slots;
+      const UInt64 m_mask;
+
+      // Consumer
+      UInt64 m_head __attribute__((aligned(64)));
+      UInt64 m_tail_cached;
+
+      // Producer
+      UInt64 m_tail __attribute__((aligned(64)));
+      UInt64 m_head_cached;
+};
+
+#endif // SPSC_QUEUE_H
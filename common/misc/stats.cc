@@ -3,11 +3,14 @@
 #include "hooks_manager.h"
 #include "utils.h"
 #include "itostr.h"
+#include "config.hpp"
+#include "timer.h"
 
 #include <math.h>
 #include <stdio.h>
 #include <sstream>
 #include <unordered_set>
+#include <algorithm>
 #include <string>
 #include <cstring>
 #include <zlib.h>
@@ -32,6 +35,14 @@ const char db_insert_stmt_name[] = "INSERT INTO `names` (nameid, objectname, met
 const char db_insert_stmt_prefix[] = "INSERT INTO `prefixes` (prefixid, prefixname) VALUES (?, ?);";
 const char db_insert_stmt_value[] = "INSERT INTO `values` (prefixid, nameid, core, value) VALUES (?, ?, ?, ?);";
 
+// sim.stats.bin: this header, followed by one record per snapshot:
+//   UInt64 prefixid, UInt32 num_new_slots, { UInt64 nameid, UInt32 core } x num_new_slots,
+//   UInt32 num_values, UInt32 slot[num_values], UInt64 value[num_values]
+// Slots are numbered in the order they appear in the file, and only values that changed since
+// the previous record are stored. Prefix names, metric names, topology and events are in sim.stats.sqlite3.
+const char binary_magic[8] = { 'S', 'N', 'I', 'P', 'S', 'T', 'A', 'T' };
+const UInt32 binary_version = 1;
+
 UInt64 getWallclockTimeCallback(String objectName, UInt32 index, String metricName, UInt64 arg)
 {
    struct timeval tv = {0,0};
@@ -44,14 +55,42 @@ StatsManager::StatsManager()
    : m_keyid(0)
    , m_prefixnum(0)
    , m_db(NULL)
+   , m_async(false)
+   , m_binary(NULL)
+   , m_num_recorded_slots(0)
+   , m_thread(NULL)
+   , m_writing(false)
+   , m_stop(false)
+   , m_running(false)
+   , m_snapshots(0)
+   , m_record_time(0)
+   , m_write_time(0)
+   , m_stall_time(0)
 {
    init();
 
    registerMetric(new StatsMetricCallback("time", 0, "walltime", getWallclockTimeCallback, 0));
+   registerMetric(new StatsMetric<UInt64>("stats", 0, "snapshots", &m_snapshots));
+   registerMetric(new StatsMetric<UInt64>("stats", 0, "record-time", &m_record_time));
+   registerMetric(new StatsMetric<UInt64>("stats", 0, "write-time", &m_write_time));
+   registerMetric(new StatsMetric<UInt64>("stats", 0, "stall-time", &m_stall_time));
 }
 
 StatsManager::~StatsManager()
 {
+   if (m_thread)
+   {
+      ScopedLock sl(m_queue_lock);
+      m_stop = true;
+      m_queue_cond.signal();
+      while (m_running)
+         m_done_cond.wait(m_queue_lock);
+   }
+   delete m_thread;
+
+   if (m_binary)
+      fclose(m_binary);
+
    for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
       for (StatsMetricList::iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
          for(StatsIndexList::iterator it3 = it2->second.second.begin(); it3 != it2->second.second.end(); ++it3)
@@ -90,6 +129,20 @@ StatsManager::init()
    sqlite3_prepare(m_db, db_insert_stmt_prefix, -1, &m_stmt_insert_prefix, NULL);
    sqlite3_prepare(m_db, db_insert_stmt_value, -1, &m_stmt_insert_value, NULL);
 
+   m_async = Sim()->getCfg()->getBool("stats/async");
+   String format = Sim()->getCfg()->getString("stats/format");
+   String binary_filename = Sim()->getConfig()->formatOutputFileName("sim.stats.bin");
+   unlink(binary_filename.c_str());
+   if (format == "binary")
+   {
+      m_binary = fopen(binary_filename.c_str(), "w");
+      LOG_ASSERT_ERROR(m_binary, "Cannot create %s", binary_filename.c_str());
+      fwrite(binary_magic, sizeof(binary_magic), 1, m_binary);
+      fwrite(&binary_version, sizeof(binary_version), 1, m_binary);
+   }
+   else if (format != "sqlite")
+      LOG_PRINT_ERROR("Unknown stats/format %s, should be sqlite or binary", format.c_str());
+
    sqlite3_exec(m_db, "BEGIN TRANSACTION", NULL, NULL, NULL);
    for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
    {
@@ -117,6 +170,7 @@ void
 StatsManager::recordMetricName(UInt64 keyId, std::string objectName, std::string metricName)
 {
    int res;
+   ScopedLock sl(m_db_lock);
    sqlite3_reset(m_stmt_insert_name);
    sqlite3_bind_int(m_stmt_insert_name, 1, keyId);
    sqlite3_bind_text(m_stmt_insert_name, 2, objectName.c_str(), -1, SQLITE_TRANSIENT);
@@ -133,41 +187,180 @@ StatsManager::recordStats(String prefix)
    // Allow lazily-maintained statistics to be updated
    Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)prefix.c_str());
 
+   ScopedLock sl(m_record_lock);
+   UInt64 start = Timer::monotonic();
+
+   StatsSnapshot *snapshot = new StatsSnapshot;
+   snapshot->prefixid = ++m_prefixnum;
+   snapshot->prefix = prefix.c_str();
+   snapshot->new_slots.assign(m_slots.begin() + m_num_recorded_slots, m_slots.end());
+
+   for(UInt32 slot = 0; slot < m_metrics.size(); ++slot)
+   {
+      UInt64 value = m_metrics[slot]->recordMetric();
+      bool is_default = m_metrics[slot]->isDefault();
+      if (slot >= m_num_recorded_slots || value != m_recorded[slot].value || is_default != m_recorded[slot].is_default)
+      {
+         snapshot->deltas.push_back(StatsDelta{slot, is_default, value});
+         m_recorded[slot].value = value;
+         m_recorded[slot].is_default = is_default;
+      }
+   }
+   m_num_recorded_slots = m_metrics.size();
+
+   ++m_snapshots;
+   m_record_time += Timer::monotonic() - start;
+
+   if (!m_async)
+   {
+      writeSnapshot(snapshot);
+      return;
+   }
+
+   ScopedLock sq(m_queue_lock);
+   if (!m_thread)
+   {
+      m_running = true;
+      m_thread = _Thread::create(this);
+      m_thread->run();
+   }
+   // Don't let the writer fall arbitrarily far behind
+   if (m_queue.size() >= MAX_PENDING_SNAPSHOTS)
+   {
+      UInt64 stall_start = Timer::monotonic();
+      while (m_queue.size() >= MAX_PENDING_SNAPSHOTS)
+         m_done_cond.wait(m_queue_lock);
+      m_stall_time += Timer::monotonic() - stall_start;
+   }
+   m_queue.push_back(snapshot);
+   m_queue_cond.signal();
+}
+
+void
+StatsManager::flush()
+{
+   ScopedLock sl(m_queue_lock);
+   UInt64 start = Timer::monotonic();
+   while (!m_queue.empty() || m_writing)
+      m_done_cond.wait(m_queue_lock);
+   m_stall_time += Timer::monotonic() - start;
+}
+
+void
+StatsManager::run()
+{
+   ScopedLock sl(m_queue_lock);
+   while (true)
+   {
+      if (!m_queue.empty())
+      {
+         StatsSnapshot *snapshot = m_queue.front();
+         m_queue.pop_front();
+         m_writing = true;
+
+         m_queue_lock.release();
+         writeSnapshot(snapshot);
+         m_queue_lock.acquire();
+
+         m_writing = false;
+         m_done_cond.broadcast();
+      }
+      else if (m_stop)
+         break;
+      else
+         m_queue_cond.wait(m_queue_lock);
+   }
+   m_running = false;
+   m_done_cond.broadcast();
+}
+
+void
+StatsManager::writeSnapshot(StatsSnapshot *snapshot)
+{
+   UInt64 start = Timer::monotonic();
+
+   for(auto it = snapshot->new_slots.begin(); it != snapshot->new_slots.end(); ++it)
+   {
+      m_writer_slots.push_back(*it);
+      m_written.push_back(StatsValue{0, true});
+   }
+   for(auto it = snapshot->deltas.begin(); it != snapshot->deltas.end(); ++it)
+   {
+      m_written[it->slot].value = it->value;
+      m_written[it->slot].is_default = it->is_default;
+   }
+
+   if (m_binary)
+      writeBinary(snapshot);
+   writeSqlite(snapshot);
+
+   delete snapshot;
+   __atomic_fetch_add(&m_write_time, Timer::monotonic() - start, __ATOMIC_RELAXED);
+}
+
+void
+StatsManager::writeSqlite(const StatsSnapshot *snapshot)
+{
    int res;
-   int prefixid = ++m_prefixnum;
+   ScopedLock sl(m_db_lock);
 
    res = sqlite3_exec(m_db, "BEGIN TRANSACTION", NULL, NULL, NULL);
    LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 
    sqlite3_reset(m_stmt_insert_prefix);
-   sqlite3_bind_int(m_stmt_insert_prefix, 1, prefixid);
-   sqlite3_bind_text(m_stmt_insert_prefix, 2, prefix.c_str(), -1, SQLITE_TRANSIENT);
+   sqlite3_bind_int(m_stmt_insert_prefix, 1, snapshot->prefixid);
+   sqlite3_bind_text(m_stmt_insert_prefix, 2, snapshot->prefix.c_str(), -1, SQLITE_TRANSIENT);
    res = sqlite3_step(m_stmt_insert_prefix);
    LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 
-   for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
+   // With the binary format, values only go into sim.stats.bin
+   if (!m_binary)
    {
-      for (StatsMetricList::iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
+      for(UInt32 slot = 0; slot < m_written.size(); ++slot)
       {
-         for(StatsIndexList::iterator it3 = it2->second.second.begin(); it3 != it2->second.second.end(); ++it3)
+         if (!m_written[slot].is_default)
          {
-            if (!it3->second->isDefault())
-            {
-               sqlite3_reset(m_stmt_insert_value);
-               sqlite3_bind_int(m_stmt_insert_value, 1, prefixid);
-               sqlite3_bind_int(m_stmt_insert_value, 2, it2->second.first);   // Metric ID
-               sqlite3_bind_int(m_stmt_insert_value, 3, it3->second->index);  // Core ID
-               sqlite3_bind_int64(m_stmt_insert_value, 4, it3->second->recordMetric());
-               res = sqlite3_step(m_stmt_insert_value);
-               LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
-            }
+            sqlite3_reset(m_stmt_insert_value);
+            sqlite3_bind_int(m_stmt_insert_value, 1, snapshot->prefixid);
+            sqlite3_bind_int(m_stmt_insert_value, 2, m_writer_slots[slot].nameid);   // Metric ID
+            sqlite3_bind_int(m_stmt_insert_value, 3, m_writer_slots[slot].index);    // Core ID
+            sqlite3_bind_int64(m_stmt_insert_value, 4, m_written[slot].value);
+            res = sqlite3_step(m_stmt_insert_value);
+            LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
          }
       }
    }
+
    res = sqlite3_exec(m_db, "END TRANSACTION", NULL, NULL, NULL);
    LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 }
 
+void
+StatsManager::writeBinary(const StatsSnapshot *snapshot)
+{
+   UInt32 num_new_slots = snapshot->new_slots.size(), num_values = snapshot->deltas.size();
+   std::vector<UInt32> slots(num_values);
+   std::vector<UInt64> values(num_values);
+   for(UInt32 i = 0; i < num_values; ++i)
+   {
+      slots[i] = snapshot->deltas[i].slot;
+      values[i] = snapshot->deltas[i].value;
+   }
+
+   fwrite(&snapshot->prefixid, sizeof(UInt64), 1, m_binary);
+   fwrite(&num_new_slots, sizeof(UInt32), 1, m_binary);
+   for(auto it = snapshot->new_slots.begin(); it != snapshot->new_slots.end(); ++it)
+   {
+      fwrite(&it->nameid, sizeof(UInt64), 1, m_binary);
+      fwrite(&it->index, sizeof(UInt32), 1, m_binary);
+   }
+   fwrite(&num_values, sizeof(UInt32), 1, m_binary);
+   fwrite(slots.data(), sizeof(UInt32), num_values, m_binary);
+   fwrite(values.data(), sizeof(UInt64), num_values, m_binary);
+   // Make each snapshot visible to readers as a whole
+   fflush(m_binary);
+}
+
 void
 StatsManager::registerMetric(StatsMetricBase *metric)
 {
@@ -186,6 +379,11 @@ StatsManager::registerMetric(StatsMetricBase *metric)
          recordMetricName(m_keyid, _objectName, _metricName);
       }
    }
+
+   ScopedLock sl(m_record_lock);
+   m_metrics.push_back(metric);
+   m_slots.push_back(StatsSlot{m_objects[_objectName][_metricName].first, metric->index});
+   m_recorded.push_back(StatsValue{0, true});
 }
 
 StatsMetricBase *
@@ -201,9 +399,24 @@ StatsManager::getMetricObject(String objectName, UInt32 index, String metricName
    return m_objects[_objectName][_metricName].second[index];
 }
 
+std::vector<StatsMetricBase *>
+StatsManager::getMetricObjects(String objectName, String metricName)
+{
+   std::vector<StatsMetricBase *> metrics;
+   std::string _objectName(objectName.c_str()), _metricName(metricName.c_str());
+   if (m_objects.count(_objectName) == 0 || m_objects[_objectName].count(_metricName) == 0)
+      return metrics;
+   StatsIndexList &indices = m_objects[_objectName][_metricName].second;
+   for(StatsIndexList::iterator it = indices.begin(); it != indices.end(); ++it)
+      metrics.push_back(it->second);
+   std::sort(metrics.begin(), metrics.end(), [](StatsMetricBase *a, StatsMetricBase *b) { return a->index < b->index; });
+   return metrics;
+}
+
 void
 StatsManager::logTopology(String component, core_id_t core_id, core_id_t master_id)
 {
+   ScopedLock sl(m_db_lock);
    sqlite3_stmt *stmt;
    sqlite3_prepare(m_db, "INSERT INTO topology (componentname, coreid, masterid) VALUES (?, ?, ?);", -1, &stmt, NULL);
    sqlite3_bind_text(stmt, 1, component.c_str(), -1, SQLITE_TRANSIENT);
@@ -220,6 +433,7 @@ StatsManager::logEvent(event_type_t event, SubsecondTime time, core_id_t core_id
    if (time == SubsecondTime::MaxTime())
       time = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
 
+   ScopedLock sl(m_db_lock);
    sqlite3_stmt *stmt;
    sqlite3_prepare(m_db, "INSERT INTO event (event, time, core, thread, value0, value1, description) VALUES (?, ?, ?, ?, ?, ?, ?);", -1, &stmt, NULL);
    sqlite3_bind_int(stmt, 1, event);
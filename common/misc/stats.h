@@ -2,8 +2,12 @@
 
 #include "simulator.h"
 #include "itostr.h"
+#include "_thread.h"
+#include "lock.h"
+#include "cond.h"
 
 #include <cstring>
+#include <deque>
 #include <sqlite3.h>
 
 class StatsMetricBase
@@ -55,7 +59,10 @@ class StatsMetricCallback : public StatsMetricBase
 };
 
 
-class StatsManager
+// Snapshots are taken on the calling thread, which only copies the values that changed since the previous
+// snapshot into a delta buffer. Writing them out (into sim.stats.sqlite3, or a columnar sim.stats.bin file)
+// is done by a background thread, one transaction per snapshot, unless stats/async is disabled.
+class StatsManager : public Runnable
 {
    public:
       // Event type                 core              thread            arg0           arg1              description
@@ -72,14 +79,46 @@ class StatsManager
       ~StatsManager();
       void init();
       void recordStats(String prefix);
+      // Wait until all recorded snapshots have been written out, so others can read them from the database
+      void flush();
       void registerMetric(StatsMetricBase *metric);
       StatsMetricBase *getMetricObject(String objectName, UInt32 index, String metricName);
+      // All indices of objectName.metricName, in index order
+      std::vector<StatsMetricBase *> getMetricObjects(String objectName, String metricName);
       void logTopology(String component, core_id_t core_id, core_id_t master_id);
       void logMarker(SubsecondTime time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char * description)
       { logEvent(EVENT_MARKER, time, core_id, thread_id, value0, value1, description); }
       void logEvent(event_type_t event, SubsecondTime time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char * description);
 
    private:
+      // Position of a metric in registration order, and where it goes in the database
+      struct StatsSlot
+      {
+         UInt64 nameid;
+         UInt32 index;
+      };
+      struct StatsDelta
+      {
+         UInt32 slot;
+         UInt32 is_default;
+         UInt64 value;
+      };
+      struct StatsSnapshot
+      {
+         UInt64 prefixid;
+         std::string prefix;
+         std::vector<StatsSlot> new_slots;   //< Metrics registered since the previous snapshot
+         std::vector<StatsDelta> deltas;
+      };
+      // Last value of each slot, as seen by the recording resp. writing side
+      struct StatsValue
+      {
+         UInt64 value;
+         bool is_default;
+      };
+
+      static const UInt32 MAX_PENDING_SNAPSHOTS = 64;
+
       UInt64 m_keyid;
       UInt64 m_prefixnum;
 
@@ -87,6 +126,34 @@ class StatsManager
       sqlite3_stmt *m_stmt_insert_name;
       sqlite3_stmt *m_stmt_insert_prefix;
       sqlite3_stmt *m_stmt_insert_value;
+      Lock m_db_lock;
+
+      bool m_async;
+      FILE *m_binary;                        //< Columnar values file, when stats/format = binary
+
+      // Recording side, protected by m_record_lock
+      Lock m_record_lock;
+      std::vector<StatsMetricBase *> m_metrics;
+      std::vector<StatsSlot> m_slots;
+      std::vector<StatsValue> m_recorded;
+      UInt32 m_num_recorded_slots;           //< Slots the writer already knows about
+
+      // Writer thread
+      _Thread *m_thread;
+      Lock m_queue_lock;
+      ConditionVariable m_queue_cond;        //< Signaled when a snapshot was queued
+      ConditionVariable m_done_cond;         //< Signaled when a snapshot was written, or the writer exited
+      std::deque<StatsSnapshot *> m_queue;
+      bool m_writing;
+      bool m_stop;
+      bool m_running;
+      std::vector<StatsSlot> m_writer_slots;
+      std::vector<StatsValue> m_written;
+
+      UInt64 m_snapshots;
+      UInt64 m_record_time;                  //< Wall-clock time (ns) spent taking snapshots
+      UInt64 m_write_time;                   //< Wall-clock time (ns) spent writing them out
+      UInt64 m_stall_time;                   //< Wall-clock time (ns) spent waiting for a full queue or flush()
 
       // Use std::string here because String (__versa_string) does not provide a hash function for STL containers with gcc < 4.6
       typedef std::unordered_map<UInt64, StatsMetricBase *> StatsIndexList;
@@ -99,6 +166,11 @@ class StatsManager
       int busy_handler(int count);
 
       void recordMetricName(UInt64 keyId, std::string objectName, std::string metricName);
+
+      void run();
+      void writeSnapshot(StatsSnapshot *snapshot);
+      void writeSqlite(const StatsSnapshot *snapshot);
+      void writeBinary(const StatsSnapshot *snapshot);
 };
 
 template <class T> void registerStatsMetric(String objectName, UInt32 index, String metricName, T *metric)
@@ -63,6 +63,13 @@ UInt64 Timer::now()
    return (UInt64(t.tv_sec) * 1000000000) + t.tv_nsec;
 }
 
+UInt64 Timer::monotonic()
+{
+   timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (UInt64(t.tv_sec) * 1000000000) + t.tv_nsec;
+}
+
 void Timer::start()
 {
    #ifdef TIMER_TRACK_CPUID
@@ -21,6 +21,8 @@ class Timer
       /** Return elapsed time in nanoseconds */
       UInt64 getTime(void);
       static UInt64 now(void);
+      /** Monotonic wall-clock time in nanoseconds, for measuring durations */
+      static UInt64 monotonic(void);
 
    private:
       UInt64 t_start;
@@ -1,6 +1,7 @@
 #include <string.h>
 
 #include "transport.h"
+#include "packet_arena.h"
 #include "core.h"
 #include "network.h"
 #include "memory_manager_base.h"
@@ -78,7 +79,8 @@ void Network::netPullFromTransport()
    {
       LOG_PRINT("Entering netPullFromTransport");
 
-      NetPacket packet(_transport->recv());
+      Byte *buffer = _transport->recv();
+      NetPacket packet(buffer);
 
       LOG_PRINT("Pull packet : type %i, from %i, time %s", (SInt32)packet.type, packet.sender, itostr(packet.time).c_str());
       assert(0 <= packet.sender && packet.sender < _numMod);
@@ -95,8 +97,7 @@ void Network::netPullFromTransport()
          // if this isn't a broadcast message, then we shouldn't process it further
          if (packet.receiver != NetPacket::BROADCAST)
          {
-            if (packet.length > 0)
-               delete [] (Byte*) packet.data;
+            PacketArena::free(buffer);
             continue;
          }
       }
@@ -117,8 +118,7 @@ void Network::netPullFromTransport()
 
          callback(_callbackObjs[packet.type], packet);
 
-         if (packet.length > 0)
-            delete [] (Byte*) packet.data;
+         PacketArena::free(buffer);
       }
 
       // synchronous I/O support
@@ -126,6 +126,14 @@ void Network::netPullFromTransport()
       {
          LOG_PRINT("Enqueuing packet : type %i, from %i, to %i, core_id %i, time %s.",
                (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
+         // Packets returned by netRecv() own their data
+         if (packet.length > 0)
+         {
+            Byte *data = new Byte[packet.length];
+            memcpy(data, packet.data, packet.length);
+            packet.data = data;
+         }
+         PacketArena::free(buffer);
          _netQueueLock.acquire();
          _netQueue.push_back(packet);
          _netQueueLock.release();
@@ -158,7 +166,6 @@ SInt32 Network::netSend(NetPacket& packet)
    std::vector<NetworkModel::Hop> hopVec;
    model->routePacket(packet, hopVec);
 
-   Byte *buffer = packet.makeBuffer();
    SubsecondTime start_time = packet.time;
 
    for (UInt32 i = 0; i < hopVec.size(); i++)
@@ -188,6 +195,8 @@ SInt32 Network::netSend(NetPacket& packet)
          }
       }
 
+      // Every hop gets its own buffer, which is handed to the transport without copying
+      Byte *buffer = packet.makeBuffer();
       NetPacket* buff_pkt = (NetPacket*) buffer;
 
       if (_core->getId() == buff_pkt->sender)
@@ -196,13 +205,11 @@ SInt32 Network::netSend(NetPacket& packet)
       buff_pkt->time = hopVec[i].time;
       buff_pkt->receiver = hopVec[i].final_dest;
 
-      _transport->send(hopVec[i].next_dest, buffer, packet.bufferSize());
+      _transport->sendBuffer(hopVec[i].next_dest, buffer, packet.bufferSize());
 
       LOG_PRINT("Sent packet");
    }
 
-   delete [] buffer;
-
    return packet.length;
 }
 
@@ -510,14 +517,7 @@ NetPacket::NetPacket(Byte *buffer)
    memcpy(this, buffer, sizeof(*this));
 
    // LOG_ASSERT_ERROR(length > 0, "type(%u), sender(%i), receiver(%i), length(%u)", type, sender, receiver, length);
-   if (length > 0)
-   {
-      Byte* data_buffer = new Byte[length];
-      memcpy(data_buffer, buffer + sizeof(*this), length);
-      data = data_buffer;
-   }
-
-   delete [] buffer;
+   data = length > 0 ? buffer + sizeof(*this) : NULL;
 }
 
 // This implementation is slightly wasteful because there is no need
@@ -533,7 +533,7 @@ Byte* NetPacket::makeBuffer() const
    UInt32 size = bufferSize();
    assert(size >= sizeof(NetPacket));
 
-   Byte *buffer = new Byte[size];
+   Byte *buffer = PacketArena::alloc(size);
 
    memcpy(buffer, this, sizeof(*this));
    memcpy(buffer + sizeof(*this), data, length);
@@ -33,11 +33,13 @@ public:
    const void *data;
 
    NetPacket();
+   // Points data into the buffer (as returned by makeBuffer), which must outlive the packet
    explicit NetPacket(Byte*);
    NetPacket(SubsecondTime time, PacketType type, SInt32 sender,
              SInt32 receiver, UInt32 length, const void *data);
 
    UInt32 bufferSize() const;
+   // Header and data in one PacketArena buffer
    Byte *makeBuffer() const;
 
    static const SInt32 BROADCAST = 0xDEADBABE;
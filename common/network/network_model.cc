@@ -7,6 +7,7 @@
 #include "network_model_emesh_hop_counter.h"
 #include "network_model_emesh_hop_by_hop.h"
 #include "network_model_bus.h"
+#include "network_model_emesh_parallel.h"
 #include "stats.h"
 #include "log.h"
 #include "config.hpp"
@@ -58,6 +59,9 @@ NetworkModel::createModel(Network *net, UInt32 model_type, EStaticNetwork net_ty
    case NETWORK_BUS:
       return new NetworkModelBus(net, net_type);
 
+   case NETWORK_EMESH_PARALLEL:
+      return new NetworkModelEMeshParallel(net, net_type);
+
    default:
       assert(false);
       return NULL;
@@ -75,6 +79,8 @@ NetworkModel::parseNetworkType(String str)
       return NETWORK_EMESH_HOP_BY_HOP;
    else if (str == "bus")
       return NETWORK_BUS;
+   else if (str == "emesh_parallel")
+      return NETWORK_EMESH_PARALLEL;
    else
       return (UInt32)-1;
 }
@@ -90,6 +96,7 @@ NetworkModel::computeCoreCountConstraints(UInt32 network_type, SInt32 core_count
          return std::make_pair(false,core_count);
 
       case NETWORK_EMESH_HOP_BY_HOP:
+      case NETWORK_EMESH_PARALLEL:
          return NetworkModelEMeshHopByHop::computeCoreCountConstraints(core_count);
 
       default:
@@ -119,6 +126,7 @@ NetworkModel::computeMemoryControllerPositions(UInt32 network_type, SInt32 num_m
          }
 
       case NETWORK_EMESH_HOP_BY_HOP:
+      case NETWORK_EMESH_PARALLEL:
          return NetworkModelEMeshHopByHop::computeMemoryControllerPositions(num_memory_controllers, core_count);
 
       default:
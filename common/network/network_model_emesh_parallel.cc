@@ -0,0 +1,403 @@
+#include "network_model_emesh_parallel.h"
+#include "network_model_emesh_hop_by_hop.h"
+#include "core.h"
+#include "simulator.h"
+#include "config.h"
+#include "memory_manager_base.h"
+#include "dvfs_manager.h"
+#include "stats.h"
+#include "log.h"
+#include "config.hpp"
+
+NetworkModelEMeshParallel::Mesh *NetworkModelEMeshParallel::s_meshes[NUM_STATIC_NETWORKS] = { NULL };
+
+static const char* link_names[] = {
+   "up", "down", "left", "right", "in", "out"
+};
+static_assert(NetworkModelEMeshParallel::NUM_LINKS == sizeof(link_names) / sizeof(link_names[0]),
+              "Not enough values in link_names");
+
+NetworkModelEMeshParallel::Mesh::Mesh(EStaticNetwork net_type, SubsecondTime min_processing_time)
+   : m_num_users(0)
+{
+   NetworkModelEMeshHopByHop::computeMeshDimensions(m_mesh_width, m_mesh_height);
+   // Hop counts in a dimension are stored in 8 bits
+   LOG_ASSERT_ERROR(m_mesh_width <= 256 && m_mesh_height <= 256, "Mesh of %d x %d nodes is too large, at most 256 x 256 is supported", m_mesh_width, m_mesh_height);
+
+   UInt32 smt_cores = Sim()->getCfg()->getInt("perf_model/core/logical_cpus");
+   m_concentration = Sim()->getCfg()->getInt("network/emesh_hop_by_hop/concentration") * smt_cores;
+   bool wrap_around = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/wrap_around");
+   m_queue_model_enabled = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/queue_model/enabled");
+   String queue_model_type = Sim()->getCfg()->getString("network/emesh_hop_by_hop/queue_model/type");
+   if (Sim()->getCfg()->getBool("network/emesh_hop_by_hop/broadcast_tree/enabled"))
+      LOG_PRINT_WARNING("network/emesh_hop_by_hop/broadcast_tree is not supported by emesh_parallel, broadcasts are sent as unicasts");
+
+   String routing = Sim()->getCfg()->getString("network/emesh_parallel/routing");
+   if (routing == "xy")
+      m_routing = ROUTING_XY;
+   else if (routing == "yx")
+      m_routing = ROUTING_YX;
+   else if (routing == "adaptive")
+      m_routing = ROUTING_ADAPTIVE;
+   else
+      LOG_PRINT_ERROR("Invalid network/emesh_parallel/routing %s, expected xy, yx or adaptive", routing.c_str());
+
+   m_num_nodes = m_mesh_width * m_mesh_height;
+
+   // Neighbouring node in each direction, including the wrap-around links of a ring or torus
+   m_neighbours.resize(m_num_nodes * NUM_MESH_DIRECTIONS);
+   for(SInt32 node = 0; node < m_num_nodes; ++node)
+   {
+      SInt32 x = node % m_mesh_width, y = node / m_mesh_width;
+      m_neighbours[node * NUM_MESH_DIRECTIONS + UP] = ((y + 1) % m_mesh_height) * m_mesh_width + x;
+      m_neighbours[node * NUM_MESH_DIRECTIONS + DOWN] = ((y + m_mesh_height - 1) % m_mesh_height) * m_mesh_width + x;
+      m_neighbours[node * NUM_MESH_DIRECTIONS + LEFT] = y * m_mesh_width + (x + m_mesh_width - 1) % m_mesh_width;
+      m_neighbours[node * NUM_MESH_DIRECTIONS + RIGHT] = y * m_mesh_width + (x + 1) % m_mesh_width;
+   }
+
+   computeRoutes(m_x_routes, m_mesh_width, wrap_around, LEFT, RIGHT);
+   computeRoutes(m_y_routes, m_mesh_height, wrap_around, DOWN, UP);
+
+   String name = String("network.")+EStaticNetworkStrings[net_type]+".mesh";
+   m_links = new Link[m_num_nodes * NUM_LINKS];
+   for(SInt32 node = 0; node < m_num_nodes; ++node)
+   {
+      core_id_t core_id = node * m_concentration;
+      for(UInt32 direction = 0; direction < NUM_LINKS; ++direction)
+      {
+         Link &link = getLink(node, LinkDirection(direction));
+         String link_name = name + ".link-" + link_names[direction];
+         if (m_queue_model_enabled)
+            link.queue_model = QueueModel::create(link_name, core_id, queue_model_type, min_processing_time);
+         registerStatsMetric(link_name, core_id, "packets", &link.packets);
+         registerStatsMetric(link_name, core_id, "bytes", &link.bytes);
+         registerStatsMetric(link_name, core_id, "busy-time", &link.busy_time);
+         registerStatsMetric(link_name, core_id, "contention-delay", &link.contention_delay);
+      }
+   }
+}
+
+NetworkModelEMeshParallel::Mesh::~Mesh()
+{
+   delete [] m_links;
+}
+
+void
+NetworkModelEMeshParallel::Mesh::computeRoutes(std::vector<DimensionRoute> &routes, SInt32 width, bool wrap_around, LinkDirection dir_down, LinkDirection dir_up)
+{
+   routes.resize(width * width);
+   for(SInt32 src = 0; src < width; ++src)
+      for(SInt32 dst = 0; dst < width; ++dst)
+         computeRoute(src, dst, wrap_around ? width : 0, dir_down, dir_up, routes[src * width + dst]);
+}
+
+void
+NetworkModelEMeshParallel::Mesh::computeRoute(SInt32 sx, SInt32 dx, SInt32 width, LinkDirection dir_down, LinkDirection dir_up, DimensionRoute &route)
+{
+   // Same direction choice as NetworkModelEMeshHopByHop::getNextDest, width is zero without wrap-around links
+   route.hops = 0;
+   route.dir = dir_up;
+   while (sx != dx)
+   {
+      LinkDirection direction = ((sx > dx) ^ (width && abs(sx - dx) > (width + 1) / 2)) ? dir_down : dir_up;
+      LOG_ASSERT_ERROR(route.hops == 0 || direction == route.dir, "Route changes direction");
+      route.dir = direction;
+      sx = width ? (sx + (direction == dir_up ? 1 : width - 1)) % width : sx + (direction == dir_up ? 1 : -1);
+      ++route.hops;
+   }
+}
+
+NetworkModelEMeshParallel::NetworkModelEMeshParallel(Network* net, EStaticNetwork net_type)
+   : NetworkModel(net, net_type)
+   , m_net_type(net_type)
+   , m_core_id(getNetwork()->getCore()->getId())
+   , m_enabled(false)
+   , m_link_bandwidth(Sim()->getDvfsManager()->getCoreDomain(m_core_id), Sim()->getCfg()->getInt("network/emesh_hop_by_hop/link_bandwidth"))
+   , m_hop_latency(Sim()->getDvfsManager()->getCoreDomain(m_core_id), Sim()->getCfg()->getInt("network/emesh_hop_by_hop/hop_latency"))
+   , m_total_bytes_sent(0)
+   , m_total_packets_sent(0)
+   , m_total_bytes_received(0)
+   , m_total_packets_received(0)
+   , m_total_contention_delay(0)
+   , m_total_packet_latency(0)
+{
+   // Network models are created sequentially during startup, so no locking is needed here
+   if (!s_meshes[net_type])
+      s_meshes[net_type] = new Mesh(net_type, m_link_bandwidth.getPeriod());
+   m_mesh = s_meshes[net_type];
+   m_mesh->m_num_users++;
+
+   m_node = m_core_id / m_mesh->m_concentration;
+   if (m_node >= m_mesh->m_num_nodes)
+      m_node = -1;
+   m_fake_node = m_node == -1 || m_core_id % m_mesh->m_concentration != 0;
+
+   String name = String("network.")+EStaticNetworkStrings[net_type]+".mesh";
+   registerStatsMetric(name, m_core_id, "bytes-out", &m_total_bytes_sent);
+   registerStatsMetric(name, m_core_id, "packets-out", &m_total_packets_sent);
+   registerStatsMetric(name, m_core_id, "bytes-in", &m_total_bytes_received);
+   registerStatsMetric(name, m_core_id, "packets-in", &m_total_packets_received);
+   registerStatsMetric(name, m_core_id, "contention-delay", &m_total_contention_delay);
+   registerStatsMetric(name, m_core_id, "total-delay", &m_total_packet_latency);
+}
+
+NetworkModelEMeshParallel::~NetworkModelEMeshParallel()
+{
+   if (--m_mesh->m_num_users == 0)
+   {
+      delete m_mesh;
+      s_meshes[m_net_type] = NULL;
+   }
+}
+
+core_id_t
+NetworkModelEMeshParallel::getRequester(const NetPacket &pkt)
+{
+   core_id_t requester = INVALID_CORE_ID;
+
+   if (pkt.type == SHARED_MEM_1 || pkt.type == SLME_MAGIC)
+      requester = getNetwork()->getCore()->getMemoryManager()->getShmemRequester(pkt.data);
+   else // Other Packet types
+      requester = pkt.sender;
+
+   LOG_ASSERT_ERROR((requester >= 0) && (requester < (core_id_t) Config::getSingleton()->getTotalCores()),
+         "requester(%i)", requester);
+
+   return requester;
+}
+
+void
+NetworkModelEMeshParallel::routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops)
+{
+   core_id_t requester = getRequester(pkt);
+   UInt32 pkt_length = getNetwork()->getModeledLength(pkt);
+
+   if (pkt.sender == m_core_id)
+   {
+      __atomic_fetch_add(&m_total_packets_sent, 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&m_total_bytes_sent, pkt_length, __ATOMIC_RELAXED);
+   }
+
+   Hop h;
+
+   if (pkt.receiver == NetPacket::BROADCAST)
+   {
+      // Broadcast messages are sent as a collection of unicast messages
+      for (core_id_t i = 0; i < (core_id_t) Config::getSingleton()->getTotalCores(); i++)
+      {
+         h.final_dest = h.next_dest = i;
+         if (m_fake_node)
+            h.time = pkt.time;
+         else
+         {
+            // Injection Port Modeling
+            SubsecondTime curr_time = pkt.time;
+            if (i != m_core_id)
+               curr_time += computePortDelay(INJECT, pkt.time, pkt_length);
+            h.time = routeUnicast(i, curr_time, pkt_length, requester, NULL);
+         }
+         nextHops.push_back(h);
+      }
+   }
+   else
+   {
+      h.final_dest = h.next_dest = pkt.receiver;
+
+      if (pkt.type == SLME_MAGIC || m_node == -1)
+      {
+         h.time = pkt.time;
+      }
+      else
+      {
+         // Injection Port Modeling
+         SubsecondTime injection_port_queue_delay = SubsecondTime::Zero();
+         if (pkt.receiver != m_node * m_mesh->m_concentration)
+         {
+            injection_port_queue_delay = computePortDelay(INJECT, pkt.time, pkt_length);
+            *(subsecond_time_t*)&pkt.queue_delay += injection_port_queue_delay;
+         }
+
+         h.time = routeUnicast(pkt.receiver, pkt.time + injection_port_queue_delay, pkt_length, requester,
+                               (subsecond_time_t*)&pkt.queue_delay);
+      }
+
+      nextHops.push_back(h);
+   }
+}
+
+SubsecondTime
+NetworkModelEMeshParallel::routeUnicast(core_id_t receiver, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats)
+{
+   // Non-application cores are not part of the mesh, and peers on our concentrated node are reached directly
+   if (m_node == -1 || receiver >= (core_id_t) Config::getSingleton()->getApplicationCores())
+      return pkt_time;
+   SInt32 dst_node = receiver / m_mesh->m_concentration;
+   if (dst_node == m_node)
+      return pkt_time;
+
+   if ( (!m_enabled) || (requester >= (core_id_t) Config::getSingleton()->getApplicationCores()) )
+      return pkt_time;
+
+   Route route = m_mesh->getRoute(m_node, dst_node);
+   SubsecondTime processing_time = computeProcessingTime(pkt_length);
+   SubsecondTime queue_delay = SubsecondTime::Zero();
+   SInt32 node = m_node;
+
+   if (useYXRoute(route, pkt_time))
+   {
+      pkt_time = traverse(node, LinkDirection(route.y_dir), route.y_hops, pkt_time, pkt_length, processing_time, queue_delay);
+      pkt_time = traverse(node, LinkDirection(route.x_dir), route.x_hops, pkt_time, pkt_length, processing_time, queue_delay);
+   }
+   else
+   {
+      pkt_time = traverse(node, LinkDirection(route.x_dir), route.x_hops, pkt_time, pkt_length, processing_time, queue_delay);
+      pkt_time = traverse(node, LinkDirection(route.y_dir), route.y_hops, pkt_time, pkt_length, processing_time, queue_delay);
+   }
+   LOG_ASSERT_ERROR(node == dst_node, "Route from %d to %d ended at node %d", m_node, dst_node, node);
+
+   if (queue_delay_stats)
+      *queue_delay_stats += queue_delay;
+
+   return pkt_time;
+}
+
+bool
+NetworkModelEMeshParallel::useYXRoute(const Route &route, SubsecondTime pkt_time)
+{
+   switch(m_mesh->m_routing)
+   {
+      case ROUTING_XY:
+         return false;
+      case ROUTING_YX:
+         return true;
+      case ROUTING_ADAPTIVE:
+      {
+         if (route.x_hops == 0 || route.y_hops == 0)
+            return false;
+
+         // Estimate the backlog on both routes by how far ahead of us each link is reserved
+         UInt64 time = pkt_time.getFS();
+         UInt64 backlog[2] = { 0, 0 };
+         for(int yx = 0; yx < 2; ++yx)
+         {
+            SInt32 node = m_node;
+            for(int dim = 0; dim < 2; ++dim)
+            {
+               bool is_y = (dim == 0) == (yx == 1);
+               LinkDirection direction = LinkDirection(is_y ? route.y_dir : route.x_dir);
+               for(UInt32 hop = 0; hop < (is_y ? route.y_hops : route.x_hops); ++hop)
+               {
+                  UInt64 busy_until = __atomic_load_n(&m_mesh->getLink(node, direction).busy_until, __ATOMIC_RELAXED);
+                  if (busy_until > time)
+                     backlog[yx] += busy_until - time;
+                  node = m_mesh->getNeighbour(node, direction);
+               }
+            }
+         }
+         return backlog[1] < backlog[0];
+      }
+   }
+   return false;
+}
+
+SubsecondTime
+NetworkModelEMeshParallel::traverse(SInt32 &node, LinkDirection direction, UInt32 hops, SubsecondTime pkt_time, UInt32 pkt_length, SubsecondTime processing_time, SubsecondTime &queue_delay)
+{
+   if (!m_mesh->m_queue_model_enabled)
+   {
+      // Without contention, the latency of all hops can be computed at once
+      for(UInt32 hop = 0; hop < hops; ++hop)
+      {
+         Link &link = m_mesh->getLink(node, direction);
+         __atomic_fetch_add(&link.packets, 1, __ATOMIC_RELAXED);
+         __atomic_fetch_add(&link.bytes, pkt_length, __ATOMIC_RELAXED);
+         __atomic_fetch_add(&link.busy_time, processing_time.getFS(), __ATOMIC_RELAXED);
+         node = m_mesh->getNeighbour(node, direction);
+      }
+      return pkt_time + hops * m_hop_latency.getLatency();
+   }
+
+   SubsecondTime hop_latency = m_hop_latency.getLatency();
+   for(UInt32 hop = 0; hop < hops; ++hop)
+   {
+      Link &link = m_mesh->getLink(node, direction);
+      SubsecondTime delay;
+      {
+         ScopedLock sl(link.lock);
+         delay = link.queue_model->computeQueueDelay(pkt_time, processing_time);
+         link.busy_until = std::max(link.busy_until, (pkt_time + delay + processing_time).getFS());
+      }
+      __atomic_fetch_add(&link.packets, 1, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&link.bytes, pkt_length, __ATOMIC_RELAXED);
+      __atomic_fetch_add(&link.busy_time, processing_time.getFS(), __ATOMIC_RELAXED);
+      __atomic_fetch_add(&link.contention_delay, delay.getFS(), __ATOMIC_RELAXED);
+
+      LOG_PRINT("Queue Delay(%s), Hop Latency(%s)", itostr(delay).c_str(), itostr(hop_latency).c_str());
+      queue_delay += delay;
+      pkt_time += hop_latency + delay;
+      node = m_mesh->getNeighbour(node, direction);
+   }
+   return pkt_time;
+}
+
+void
+NetworkModelEMeshParallel::processReceivedPacket(NetPacket& pkt)
+{
+   UInt32 pkt_length = getNetwork()->getModeledLength(pkt);
+   core_id_t requester = getRequester(pkt);
+
+   if ( (!m_enabled) || (requester >= (core_id_t) Config::getSingleton()->getApplicationCores())
+                     || (m_core_id >= (core_id_t) Config::getSingleton()->getApplicationCores()))
+      return;
+
+   SInt32 src_node = pkt.sender / m_mesh->m_concentration;
+   UInt32 distance = src_node < m_mesh->m_num_nodes ? m_mesh->getRoute(src_node, m_node).length() : 0;
+
+   SubsecondTime packet_latency = pkt.time - pkt.start_time;
+   SubsecondTime contention_delay = packet_latency - (distance * m_hop_latency.getLatency());
+
+   if (pkt.sender != m_core_id && !m_fake_node)
+   {
+      SubsecondTime processing_time = computeProcessingTime(pkt_length);
+      SubsecondTime ejection_port_queue_delay = computePortDelay(EJECT, pkt.time, pkt_length);
+
+      packet_latency += (ejection_port_queue_delay + processing_time);
+      contention_delay += ejection_port_queue_delay;
+      pkt.time += (ejection_port_queue_delay + processing_time);
+      pkt.queue_delay += ejection_port_queue_delay;
+   }
+
+   __atomic_fetch_add(&m_total_packets_received, 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&m_total_bytes_received, pkt_length, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&m_total_packet_latency, packet_latency.getFS(), __ATOMIC_RELAXED);
+   __atomic_fetch_add(&m_total_contention_delay, contention_delay.getFS(), __ATOMIC_RELAXED);
+}
+
+SubsecondTime
+NetworkModelEMeshParallel::computePortDelay(LinkDirection direction, SubsecondTime pkt_time, UInt32 pkt_length)
+{
+   if (!m_mesh->m_queue_model_enabled)
+      return SubsecondTime::Zero();
+
+   Link &link = m_mesh->getLink(m_node, direction);
+   SubsecondTime processing_time = computeProcessingTime(pkt_length);
+   SubsecondTime delay;
+   {
+      ScopedLock sl(link.lock);
+      delay = link.queue_model->computeQueueDelay(pkt_time, processing_time);
+   }
+   __atomic_fetch_add(&link.packets, 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&link.bytes, pkt_length, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&link.busy_time, processing_time.getFS(), __ATOMIC_RELAXED);
+   __atomic_fetch_add(&link.contention_delay, delay.getFS(), __ATOMIC_RELAXED);
+   return delay;
+}
+
+SubsecondTime
+NetworkModelEMeshParallel::computeProcessingTime(UInt32 pkt_length)
+{
+   // Send: (pkt_length * 8) bits
+   // Bandwidth: (m_link_bandwidth) bits/cycle
+   UInt32 num_bits = pkt_length * 8;
+   return m_link_bandwidth.getRoundedLatency(num_bits);
+}
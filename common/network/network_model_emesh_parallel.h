@@ -0,0 +1,143 @@
+#ifndef __NETWORK_MODEL_EMESH_PARALLEL_H__
+#define __NETWORK_MODEL_EMESH_PARALLEL_H__
+
+#include "network.h"
+#include "network_model.h"
+#include "fixed_types.h"
+#include "queue_model.h"
+#include "lock.h"
+#include "subsecond_time.h"
+
+// Mesh/torus network with the same topology, latencies and configuration as NetworkModelEMeshHopByHop
+// (network/emesh_hop_by_hop/*), but which routes a packet over its complete path at the sending node.
+//
+// All node models of a network share one Mesh object with the links and routes. There is no per-node lock:
+// each link has its own lock protecting its queue model, which is only held while computing the delay on
+// that link. Routes are looked up in two tables holding the direction and hop count from each row to each
+// other row and from each column to each other column, so their size grows with the mesh width and height
+// rather than with the square of the number of nodes. Packets are routed in dimension order (network/emesh_parallel/routing
+// = xy or yx), or adaptively, taking the XY or the YX route depending on which has the lowest backlog.
+class NetworkModelEMeshParallel : public NetworkModel
+{
+   public:
+      typedef enum
+      {
+         UP = 0,
+         DOWN,
+         LEFT,
+         RIGHT,
+         NUM_MESH_DIRECTIONS,
+         INJECT = NUM_MESH_DIRECTIONS,
+         EJECT,
+         NUM_LINKS
+      } LinkDirection;
+
+      typedef enum
+      {
+         ROUTING_XY,
+         ROUTING_YX,
+         ROUTING_ADAPTIVE,
+      } routing_t;
+
+      NetworkModelEMeshParallel(Network* net, EStaticNetwork net_type);
+      ~NetworkModelEMeshParallel();
+
+      void routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops);
+      void processReceivedPacket(NetPacket &pkt);
+
+      void enable() { m_enabled = true; }
+      void disable() { m_enabled = false; }
+
+   private:
+      // One direction of a link between two network nodes, or the injection or ejection port of a node
+      struct Link
+      {
+         Link() : queue_model(NULL), busy_until(0), packets(0), bytes(0), busy_time(0), contention_delay(0) {}
+         ~Link() { delete queue_model; }
+
+         SpinLock lock;                //< Protects queue_model and busy_until
+         QueueModel *queue_model;
+         UInt64 busy_until;            //< Time (in fs) at which the last packet reserved on this link has left it
+         // Statistics, updated atomically
+         UInt64 packets;
+         UInt64 bytes;
+         UInt64 busy_time;             //< Total time (in fs) the link was transmitting
+         UInt64 contention_delay;      //< Total queue delay (in fs)
+      } __attribute__((aligned(64)));
+
+      // Number of hops and direction from one row or column to another
+      struct DimensionRoute
+      {
+         UInt8 dir, hops;
+      };
+
+      // Route from one node to another: number of hops and direction in each dimension
+      struct Route
+      {
+         UInt8 x_dir, x_hops;
+         UInt8 y_dir, y_hops;
+         UInt32 length() const { return x_hops + y_hops; }
+      };
+
+      class Mesh
+      {
+         public:
+            Mesh(EStaticNetwork net_type, SubsecondTime min_processing_time);
+            ~Mesh();
+
+            Route getRoute(SInt32 src_node, SInt32 dst_node) const
+            {
+               const DimensionRoute &x = m_x_routes[(src_node % m_mesh_width) * m_mesh_width + dst_node % m_mesh_width];
+               const DimensionRoute &y = m_y_routes[(src_node / m_mesh_width) * m_mesh_height + dst_node / m_mesh_width];
+               Route route = { x.dir, x.hops, y.dir, y.hops };
+               return route;
+            }
+            Link& getLink(SInt32 node, LinkDirection direction) { return m_links[node * NUM_LINKS + direction]; }
+            SInt32 getNeighbour(SInt32 node, LinkDirection direction) const { return m_neighbours[node * NUM_MESH_DIRECTIONS + direction]; }
+
+            SInt32 m_mesh_width, m_mesh_height;
+            SInt32 m_num_nodes;
+            SInt32 m_concentration;
+            bool m_queue_model_enabled;
+            routing_t m_routing;
+            UInt32 m_num_users;
+
+         private:
+            std::vector<DimensionRoute> m_x_routes;   //< Indexed by source column * width + destination column
+            std::vector<DimensionRoute> m_y_routes;   //< Indexed by source row * height + destination row
+            std::vector<SInt32> m_neighbours;
+            Link *m_links;
+
+            static void computeRoutes(std::vector<DimensionRoute> &routes, SInt32 width, bool wrap_around, LinkDirection dir_down, LinkDirection dir_up);
+            static void computeRoute(SInt32 sx, SInt32 dx, SInt32 width, LinkDirection dir_down, LinkDirection dir_up, DimensionRoute &route);
+      };
+
+      static Mesh *s_meshes[NUM_STATIC_NETWORKS];
+
+      Mesh *m_mesh;
+      EStaticNetwork m_net_type;
+      core_id_t m_core_id;
+      SInt32 m_node;
+      bool m_fake_node; //< True for nodes that are not the master of their concentrated node
+      bool m_enabled;
+
+      ComponentBandwidthPerCycle m_link_bandwidth;
+      ComponentLatency m_hop_latency;
+
+      // Counters, updated atomically. Delays are in fs.
+      UInt64 m_total_bytes_sent;
+      UInt64 m_total_packets_sent;
+      UInt64 m_total_bytes_received;
+      UInt64 m_total_packets_received;
+      UInt64 m_total_contention_delay;
+      UInt64 m_total_packet_latency;
+
+      core_id_t getRequester(const NetPacket &pkt);
+      SubsecondTime computeProcessingTime(UInt32 pkt_length);
+      SubsecondTime computePortDelay(LinkDirection direction, SubsecondTime pkt_time, UInt32 pkt_length);
+      bool useYXRoute(const Route &route, SubsecondTime pkt_time);
+      SubsecondTime routeUnicast(core_id_t receiver, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats);
+      SubsecondTime traverse(SInt32 &node, LinkDirection direction, UInt32 hops, SubsecondTime pkt_time, UInt32 pkt_length, SubsecondTime processing_time, SubsecondTime &queue_delay);
+};
+
+#endif /* __NETWORK_MODEL_EMESH_PARALLEL_H__ */
@@ -7,6 +7,7 @@ enum NetworkType
    NETWORK_EMESH_HOP_COUNTER,
    NETWORK_EMESH_HOP_BY_HOP,
    NETWORK_BUS,
+   NETWORK_EMESH_PARALLEL,
    NUM_NETWORK_TYPES
 };
 
@@ -4,23 +4,38 @@
 #include "pentium_m_branch_predictor.h"
 #include "config.hpp"
 #include "stats.h"
+#include "checkpoint_manager.h"
 
 BranchPredictor::BranchPredictor()
-   : m_correct_predictions(0)
+   : m_name("")
+   , m_core_id(INVALID_CORE_ID)
+   , m_correct_predictions(0)
    , m_incorrect_predictions(0)
 {
 }
 
 BranchPredictor::BranchPredictor(String name, core_id_t core_id)
-   : m_correct_predictions(0)
+   : m_name(name)
+   , m_core_id(core_id)
+   , m_correct_predictions(0)
    , m_incorrect_predictions(0)
 {
   registerStatsMetric(name, core_id, "num-correct", &m_correct_predictions);
   registerStatsMetric(name, core_id, "num-incorrect", &m_incorrect_predictions);
+  Sim()->getCheckpointManager()->registerObject(name, core_id, this);
 }
 
 BranchPredictor::~BranchPredictor()
-{ }
+{
+   // Only top-level predictors (constructed with a name) are registered, not their component tables
+   if (m_core_id != INVALID_CORE_ID)
+      Sim()->getCheckpointManager()->unregisterObject(m_name, m_core_id);
+}
+
+void BranchPredictor::saveState(CheckpointWriter &writer)
+{
+   LOG_PRINT_WARNING_ONCE("Branch predictor does not support checkpointing, it will start cold when restoring");
+}
 
 UInt64 BranchPredictor::m_mispredict_penalty;
 
@@ -4,8 +4,9 @@
 #include <iostream>
 
 #include "fixed_types.h"
+#include "checkpoint.h"
 
-class BranchPredictor
+class BranchPredictor : public Checkpointable
 {
 public:
    BranchPredictor();
@@ -23,10 +24,16 @@ public:
 
    void resetCounters();
 
+   // Predictor tables, for warm-state checkpoints. Predictors that do not override these start cold.
+   virtual void saveState(CheckpointWriter &writer);
+   virtual void loadState(CheckpointReader::Section &section) {}
+
 protected:
    void updateCounters(bool predicted, bool actual);
 
 private:
+   String m_name;
+   core_id_t m_core_id;
    UInt64 m_correct_predictions;
    UInt64 m_incorrect_predictions;
 
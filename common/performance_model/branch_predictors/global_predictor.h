@@ -117,6 +117,30 @@ public:
       return;
    }
 
+   void saveState(CheckpointWriter &writer)
+   {
+      writer.write(m_lru_use_count);
+      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      {
+         writer.writeVector(m_ways[w].m_valid);
+         writer.writeVector(m_ways[w].m_tags);
+         writer.writeVector(m_ways[w].m_predictors);
+         writer.writeVector(m_ways[w].m_lru);
+      }
+   }
+
+   void loadState(CheckpointReader::Section &section)
+   {
+      m_lru_use_count = section.read<UInt64>();
+      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      {
+         section.readVector(m_ways[w].m_valid);
+         section.readVector(m_ways[w].m_tags);
+         section.readVector(m_ways[w].m_predictors);
+         section.readVector(m_ways[w].m_lru);
+      }
+   }
+
 private:
 
    class Way
@@ -259,6 +259,36 @@ public:
 
    }
 
+   void saveState(CheckpointWriter &writer)
+   {
+      writer.write(m_lru_use_count);
+      for (UInt32 w = 0 ; w < m_num_ways ; ++w )
+      {
+         writer.writeVector(m_ways[w].m_tags);
+         writer.writeVector(m_ways[w].m_previous_actual);
+         writer.writeVector(m_ways[w].m_enabled);
+         writer.writeVector(m_ways[w].m_predictors);
+         writer.writeVector(m_ways[w].m_lru);
+         writer.writeVector(m_ways[w].m_count);
+         writer.writeVector(m_ways[w].m_limit);
+      }
+   }
+
+   void loadState(CheckpointReader::Section &section)
+   {
+      m_lru_use_count = section.read<UInt64>();
+      for (UInt32 w = 0 ; w < m_num_ways ; ++w )
+      {
+         section.readVector(m_ways[w].m_tags);
+         section.readVector(m_ways[w].m_previous_actual);
+         section.readVector(m_ways[w].m_enabled);
+         section.readVector(m_ways[w].m_predictors);
+         section.readVector(m_ways[w].m_lru);
+         section.readVector(m_ways[w].m_count);
+         section.readVector(m_ways[w].m_limit);
+      }
+   }
+
 private:
 
    class Way
@@ -23,3 +23,13 @@ void OneBitBranchPredictor::update(bool predicted, bool actual, IntPtr ip, IntPt
    UInt32 index = ip % m_bits.size();
    m_bits[index] = actual;
 }
+
+void OneBitBranchPredictor::saveState(CheckpointWriter &writer)
+{
+   writer.writeVector(m_bits);
+}
+
+void OneBitBranchPredictor::loadState(CheckpointReader::Section &section)
+{
+   section.readVector(m_bits);
+}
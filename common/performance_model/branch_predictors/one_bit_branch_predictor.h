@@ -14,6 +14,9 @@ public:
    bool predict(IntPtr ip, IntPtr target);
    void update(bool predicted, bool actual, IntPtr ip, IntPtr target);
 
+   void saveState(CheckpointWriter &writer);
+   void loadState(CheckpointReader::Section &section);
+
 private:
    std::vector<bool> m_bits;
 };
@@ -86,3 +86,27 @@ void PentiumMBranchPredictor::update_pir(bool actual, IntPtr ip, IntPtr target,
 
    m_pir = ((m_pir << 2) ^ rhs) & 0x7fff;
 }
+
+void PentiumMBranchPredictor::saveState(CheckpointWriter &writer)
+{
+   m_global_predictor.saveState(writer);
+   m_btb.saveState(writer);
+   m_bimodal_table.saveState(writer);
+   m_lpb.saveState(writer);
+   writer.write(m_pir);
+   writer.write(m_last_gp_hit);
+   writer.write(m_last_bm_pred);
+   writer.write(m_last_lpb_hit);
+}
+
+void PentiumMBranchPredictor::loadState(CheckpointReader::Section &section)
+{
+   m_global_predictor.loadState(section);
+   m_btb.loadState(section);
+   m_bimodal_table.loadState(section);
+   m_lpb.loadState(section);
+   m_pir = section.read<IntPtr>();
+   m_last_gp_hit = section.read<bool>();
+   m_last_bm_pred = section.read<bool>();
+   m_last_lpb_hit = section.read<bool>();
+}
@@ -49,6 +49,16 @@ public:
       }
    }
 
+   void saveState(CheckpointWriter &writer)
+   {
+      writer.writeVector(m_table);
+   }
+
+   void loadState(CheckpointReader::Section &section)
+   {
+      section.readVector(m_table);
+   }
+
 private:
 
    template<typename Addr>
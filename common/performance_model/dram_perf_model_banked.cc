@@ -0,0 +1,263 @@
+#include "dram_perf_model_banked.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "stats.h"
+#include "shmem_perf.h"
+#include "utils.h"
+
+static SubsecondTime nsToTime(float ns)
+{
+   return SubsecondTime::FS() * static_cast<uint64_t>(TimeConverter<float>::NStoFS(ns)); // Operate in fs for higher precision before converting to uint64_t/SubsecondTime
+}
+
+static SubsecondTime getTiming(String name)
+{
+   return nsToTime(Sim()->getCfg()->getFloat("perf_model/dram/banked/" + name));
+}
+
+DramPerfModelBanked::DramPerfModelBanked(core_id_t core_id,
+      UInt32 cache_block_size):
+   DramPerfModel(core_id, cache_block_size),
+   m_num_channels(Sim()->getCfg()->getInt("perf_model/dram/banked/channels")),
+   m_num_ranks(Sim()->getCfg()->getInt("perf_model/dram/banked/ranks")),
+   m_num_banks(Sim()->getCfg()->getInt("perf_model/dram/banked/banks")),
+   m_block_shift(floorLog2(cache_block_size)),
+   m_column_lines(Sim()->getCfg()->getInt("perf_model/dram/banked/row_size") / cache_block_size),
+   m_interleave_lines(Sim()->getCfg()->getInt("perf_model/dram/banked/interleave") ? Sim()->getCfg()->getInt("perf_model/dram/banked/interleave") : m_column_lines),
+   m_closed_page(Sim()->getCfg()->getString("perf_model/dram/banked/page_policy") == "closed"),
+   m_frfcfs_cap(Sim()->getCfg()->getInt("perf_model/dram/banked/frfcfs_cap")),
+   m_controller_latency(getTiming("controller_latency")),
+   m_tCAS(getTiming("tCAS")),
+   m_tRCD(getTiming("tRCD")),
+   m_tRP(getTiming("tRP")),
+   m_tRAS(getTiming("tRAS")),
+   m_tRRD(getTiming("tRRD")),
+   m_tFAW(getTiming("tFAW")),
+   m_tWR(getTiming("tWR")),
+   m_tRTP(getTiming("tRTP")),
+   m_tCCD(getTiming("tCCD")),
+   m_tREFI(getTiming("tREFI")),
+   m_tRFC(getTiming("tRFC")),
+   m_row_hits(0),
+   m_row_misses(0),
+   m_row_conflicts(0),
+   m_row_hits_reordered(0),
+   m_total_queueing_delay(SubsecondTime::Zero()),
+   m_total_bus_delay(SubsecondTime::Zero()),
+   m_total_access_latency(SubsecondTime::Zero())
+{
+   LOG_ASSERT_ERROR(isPower2(m_num_channels) && isPower2(m_num_ranks) && isPower2(m_num_banks),
+                    "perf_model/dram/banked: channels, ranks and banks must be powers of two");
+   LOG_ASSERT_ERROR(m_column_lines > 0 && isPower2(m_column_lines),
+                    "perf_model/dram/banked/row_size must be a power-of-two multiple of the cache block size");
+   LOG_ASSERT_ERROR(isPower2(m_interleave_lines) && m_interleave_lines <= m_column_lines,
+                    "perf_model/dram/banked/interleave must be a power of two, and at most one row");
+
+   // Channels split the controller's bandwidth, a burst transfers one cache line
+   ComponentBandwidth channel_bandwidth(8 * Sim()->getCfg()->getFloat("perf_model/dram/per_controller_bandwidth") / m_num_channels); // Convert bytes to bits
+   m_tBURST = channel_bandwidth.getRoundedLatency(8 * cache_block_size); // bytes to bits
+
+   Bank bank;
+   bank.open_row = NO_ROW;
+   bank.cas_ready = bank.pre_ready = SubsecondTime::Zero();
+   bank.prev_row = NO_ROW;
+   bank.prev_cas_ready = bank.prev_closed = SubsecondTime::Zero();
+   bank.reordered = 0;
+   bank.num_accesses = 0;
+   bank.total_queueing_delay = SubsecondTime::Zero();
+   m_banks.resize(m_num_channels * m_num_ranks * m_num_banks, bank);
+
+   Rank rank;
+   for(UInt32 i = 0; i < 4; ++i)
+      rank.act_times[i] = SubsecondTime::Zero();
+   rank.act_index = 0;
+   rank.refresh_epoch = 0;
+   m_ranks.resize(m_num_channels * m_num_ranks, rank);
+
+   for(UInt32 channel = 0; channel < m_num_channels; ++channel)
+      m_data_bus.push_back(QueueModel::create("dram-bus", core_id * m_num_channels + channel,
+                                              Sim()->getCfg()->getString("perf_model/dram/queue_model/type"), m_tBURST));
+
+   registerStatsMetric("dram", core_id, "total-access-latency", &m_total_access_latency);
+   registerStatsMetric("dram", core_id, "total-queueing-delay", &m_total_queueing_delay);
+   registerStatsMetric("dram", core_id, "total-bus-delay", &m_total_bus_delay);
+   registerStatsMetric("dram", core_id, "row-hits", &m_row_hits);
+   registerStatsMetric("dram", core_id, "row-misses", &m_row_misses);
+   registerStatsMetric("dram", core_id, "row-conflicts", &m_row_conflicts);
+   registerStatsMetric("dram", core_id, "row-hits-reordered", &m_row_hits_reordered);
+   for(UInt32 i = 0; i < m_banks.size(); ++i)
+   {
+      registerStatsMetric("dram", core_id, "bank" + itostr(i) + "-accesses", &m_banks[i].num_accesses);
+      registerStatsMetric("dram", core_id, "bank" + itostr(i) + "-queueing-delay", &m_banks[i].total_queueing_delay);
+   }
+}
+
+DramPerfModelBanked::~DramPerfModelBanked()
+{
+   for(auto it = m_data_bus.begin(); it != m_data_bus.end(); ++it)
+      delete *it;
+}
+
+void
+DramPerfModelBanked::mapAddress(IntPtr address, UInt32 &channel, UInt32 &rank, UInt32 &bank, UInt64 &row) const
+{
+   UInt64 line = address >> m_block_shift;
+   line /= m_interleave_lines;
+   channel = line & (m_num_channels - 1);
+   line /= m_num_channels;
+   bank = line & (m_num_banks - 1);
+   line /= m_num_banks;
+   rank = line & (m_num_ranks - 1);
+   line /= m_num_ranks;
+   row = line / (m_column_lines / m_interleave_lines);
+   // Permutation-based interleaving: rows that would map to the same bank are spread out
+   bank ^= row & (m_num_banks - 1);
+}
+
+SubsecondTime
+DramPerfModelBanked::activate(Rank &rank, SubsecondTime t)
+{
+   // At most one ACT per tRRD, and four per tFAW
+   SubsecondTime last = rank.act_times[(rank.act_index + 3) % 4];
+   SubsecondTime oldest = rank.act_times[rank.act_index];
+   if (t < last + m_tRRD)
+      t = last + m_tRRD;
+   if (t < oldest + m_tFAW)
+      t = oldest + m_tFAW;
+   rank.act_times[rank.act_index] = t;
+   rank.act_index = (rank.act_index + 1) % 4;
+   return t;
+}
+
+SubsecondTime
+DramPerfModelBanked::refresh(Rank &rank, UInt32 rank_index, SubsecondTime t)
+{
+   if (m_tREFI == SubsecondTime::Zero())
+      return t;
+
+   // Ranks refresh in turn, each for tRFC out of every tREFI
+   SubsecondTime stagger = m_tREFI * rank_index / m_ranks.size();
+   if (t < stagger)
+      return t;
+   UInt64 epoch = (t - stagger).getFS() / m_tREFI.getFS();
+   SubsecondTime refresh_start = stagger + m_tREFI * epoch;
+
+   if (epoch > rank.refresh_epoch)
+   {
+      // Refresh precharges all banks
+      rank.refresh_epoch = epoch;
+      for(UInt32 b = 0; b < m_num_banks; ++b)
+      {
+         m_banks[rank_index * m_num_banks + b].open_row = NO_ROW;
+         m_banks[rank_index * m_num_banks + b].prev_row = NO_ROW;
+      }
+   }
+
+   if (t < refresh_start + m_tRFC)
+      t = refresh_start + m_tRFC;
+   return t;
+}
+
+SubsecondTime
+DramPerfModelBanked::getAccessLatency(SubsecondTime pkt_time, UInt64 pkt_size, core_id_t requester, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf)
+{
+   if ((!m_enabled) ||
+         (requester >= (core_id_t) Config::getSingleton()->getApplicationCores()))
+   {
+      return SubsecondTime::Zero();
+   }
+
+   UInt32 channel_index, rank_index, bank_index;
+   UInt64 row;
+   mapAddress(address, channel_index, rank_index, bank_index, row);
+   rank_index += channel_index * m_num_ranks;
+   Rank &rank = m_ranks[rank_index];
+   Bank &bank = m_banks[rank_index * m_num_banks + bank_index];
+
+   SubsecondTime t = refresh(rank, rank_index, pkt_time);
+   const bool is_write = access_type == DramCntlrInterface::WRITE;
+   // Time after the CAS until the row can be precharged
+   const SubsecondTime recovery = is_write ? m_tCAS + m_tBURST + m_tWR : m_tRTP;
+
+   SubsecondTime cas, unloaded;
+
+   if (bank.open_row == row)
+   {
+      // Row hit
+      cas = std::max(t, bank.cas_ready);
+      unloaded = SubsecondTime::Zero();
+      bank.cas_ready = cas + m_tCCD;
+      bank.pre_ready = std::max(bank.pre_ready, cas + recovery);
+      ++m_row_hits;
+   }
+   else if (bank.prev_row == row && t < bank.prev_closed && bank.reordered < m_frfcfs_cap
+            && std::max(t, bank.prev_cas_ready) + recovery <= bank.prev_closed)
+   {
+      // The row was still open when we arrived, FR-FCFS serves us before the row conflict that closed it
+      cas = std::max(t, bank.prev_cas_ready);
+      unloaded = SubsecondTime::Zero();
+      bank.prev_cas_ready = cas + m_tCCD;
+      ++bank.reordered;
+      ++m_row_hits;
+      ++m_row_hits_reordered;
+   }
+   else
+   {
+      SubsecondTime act;
+      if (bank.open_row == NO_ROW)
+      {
+         // Bank is precharged (closed page policy, refresh, or first access)
+         act = activate(rank, std::max(t, bank.pre_ready));
+         unloaded = m_tRCD;
+         bank.prev_row = NO_ROW;
+         ++m_row_misses;
+      }
+      else
+      {
+         SubsecondTime pre = std::max(t, bank.pre_ready);
+         act = activate(rank, pre + m_tRP);
+         unloaded = m_tRP + m_tRCD;
+         bank.prev_row = bank.open_row;
+         bank.prev_cas_ready = bank.cas_ready;
+         bank.prev_closed = pre;
+         ++m_row_conflicts;
+      }
+      bank.reordered = 0;
+      cas = act + m_tRCD;
+      bank.open_row = row;
+      bank.cas_ready = cas + m_tCCD;
+      bank.pre_ready = std::max(act + m_tRAS, cas + recovery);
+   }
+
+   if (m_closed_page && bank.open_row == row)
+   {
+      // Precharge right away, the next ACT can follow tRP later
+      bank.open_row = NO_ROW;
+      bank.pre_ready = bank.pre_ready + m_tRP;
+   }
+
+   // Transfer the data over the channel
+   SubsecondTime data_ready = cas + m_tCAS;
+   SubsecondTime bus_delay = m_data_bus[channel_index]->computeQueueDelay(data_ready, m_tBURST, requester);
+   SubsecondTime data_end = data_ready + bus_delay + m_tBURST;
+
+   SubsecondTime access_latency = data_end - pkt_time + m_controller_latency;
+   SubsecondTime queue_delay = cas - pkt_time - unloaded;
+
+   perf->updateTime(pkt_time);
+   perf->updateTime(pkt_time + queue_delay, ShmemPerf::DRAM_QUEUE);
+   perf->updateTime(data_ready, ShmemPerf::DRAM_DEVICE);
+   perf->updateTime(data_end, ShmemPerf::DRAM_BUS);
+   perf->updateTime(pkt_time + access_latency, ShmemPerf::DRAM_DEVICE);
+
+   // Update Memory Counters
+   m_num_accesses ++;
+   m_total_access_latency += access_latency;
+   m_total_queueing_delay += queue_delay;
+   m_total_bus_delay += bus_delay;
+   bank.num_accesses ++;
+   bank.total_queueing_delay += queue_delay;
+
+   return access_latency;
+}
@@ -0,0 +1,87 @@
+#ifndef __DRAM_PERF_MODEL_BANKED_H__
+#define __DRAM_PERF_MODEL_BANKED_H__
+
+#include "dram_perf_model.h"
+#include "queue_model.h"
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "dram_cntlr_interface.h"
+
+#include <vector>
+
+// DRAM model with channels, ranks and banks
+//
+// Addresses are mapped (from low to high bits, above the cache line offset) to a group of interleave
+// lines, channel, bank, rank, the rest of the column, and row; bank bits are XORed with the low row bits
+// to spread strided streams. With interleave equal to a whole row, a row is contiguous in memory.
+// Each bank keeps its open row and the earliest time the next CAS, PRE and ACT can be issued,
+// following tRCD/tCAS/tRP/tRAS/tRTP/tWR/tCCD. ACTs within a rank are limited by tRRD and tFAW,
+// ranks are blocked for tRFC every tREFI, and data transfers contend for the channel's data bus.
+//
+// Requests are timed one at a time, as they are simulated. Scheduling is FR-FCFS-like: a request
+// to a row that a bank only just closed, for an older request that arrived later, is still served
+// as a row hit before that precharge (at most frfcfs_cap times in a row).
+class DramPerfModelBanked : public DramPerfModel
+{
+   private:
+      struct Bank
+      {
+         UInt64 open_row;
+         SubsecondTime cas_ready;         //< Earliest next CAS to the open row
+         SubsecondTime pre_ready;         //< Earliest PRE of the open row (tRAS, tRTP, tWR)
+         // Row that was open before the last row conflict, and when it was precharged
+         UInt64 prev_row;
+         SubsecondTime prev_cas_ready;
+         SubsecondTime prev_closed;
+         UInt32 reordered;                //< Row hits served ahead of the last row conflict
+
+         UInt64 num_accesses;
+         SubsecondTime total_queueing_delay;
+      };
+      struct Rank
+      {
+         SubsecondTime act_times[4];      //< Last four ACTs, for tFAW
+         UInt32 act_index;
+         UInt64 refresh_epoch;            //< Refresh interval of the last access, rows are closed by refresh
+      };
+
+      static const UInt64 NO_ROW = ~UInt64(0);
+
+      const UInt32 m_num_channels;
+      const UInt32 m_num_ranks;
+      const UInt32 m_num_banks;
+      const UInt32 m_block_shift;
+      const UInt32 m_column_lines;        //< Cache lines per row
+      const UInt32 m_interleave_lines;    //< Consecutive cache lines in the same row
+      const bool m_closed_page;
+      const UInt32 m_frfcfs_cap;
+
+      const SubsecondTime m_controller_latency;
+      const SubsecondTime m_tCAS, m_tRCD, m_tRP, m_tRAS, m_tRRD, m_tFAW, m_tWR, m_tRTP, m_tCCD;
+      const SubsecondTime m_tREFI, m_tRFC;
+      SubsecondTime m_tBURST;
+
+      std::vector<Bank> m_banks;          //< Indexed by (channel * ranks + rank) * banks + bank
+      std::vector<Rank> m_ranks;          //< Indexed by channel * ranks + rank
+      std::vector<QueueModel*> m_data_bus; //< Per channel
+
+      UInt64 m_row_hits;
+      UInt64 m_row_misses;                //< Bank had no open row
+      UInt64 m_row_conflicts;
+      UInt64 m_row_hits_reordered;
+      SubsecondTime m_total_queueing_delay;
+      SubsecondTime m_total_bus_delay;
+      SubsecondTime m_total_access_latency;
+
+      void mapAddress(IntPtr address, UInt32 &channel, UInt32 &rank, UInt32 &bank, UInt64 &row) const;
+      SubsecondTime activate(Rank &rank, SubsecondTime t);
+      SubsecondTime refresh(Rank &rank, UInt32 rank_index, SubsecondTime t);
+
+   public:
+      DramPerfModelBanked(core_id_t core_id, UInt32 cache_block_size);
+      ~DramPerfModelBanked();
+
+      SubsecondTime getAccessLatency(SubsecondTime pkt_time, UInt64 pkt_size, core_id_t requester, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf);
+};
+
+#endif /* __DRAM_PERF_MODEL_BANKED_H__ */
@@ -71,6 +71,7 @@ PerformanceModel::PerformanceModel(Core *core)
    m_instruction_tracer = InstructionTracer::create(core);
 
    registerStatsMetric("performance_model", core->getId(), "instruction_count", &m_instruction_count);
+   m_dynins_alloc->registerStats("dynins_alloc", core->getId());
 
    registerStatsMetric("performance_model", core->getId(), "elapsed_time", &m_elapsed_time);
    registerStatsMetric("performance_model", core->getId(), "idle_elapsed_time", &m_idle_elapsed_time);
@@ -1,7 +1,7 @@
 #include "memory_dependencies.h"
 
-MemoryDependencies::MemoryDependencies()
-   : producers(1024) // Maximum size should be one ROB worth of instructions
+MemoryDependencies::MemoryDependencies(uint32_t max_producers)
+   : producers(max_producers) // Maximum size should be one ROB worth of instructions
 {
    clear();
 }
@@ -29,7 +29,7 @@ class MemoryDependencies
       void clean(uint64_t lowestValidSequenceNumber);
 
    public:
-      MemoryDependencies();
+      MemoryDependencies(uint32_t max_producers = 1024);
       ~MemoryDependencies();
 
       void setDependencies(DynamicMicroOp &microOp, uint64_t lowestValidSequenceNumber);
@@ -31,6 +31,7 @@ MicroOpPerformanceModel::MicroOpPerformanceModel(Core *core, bool issue_memops)
    registerStatsMetric("performance_model", core->getId(), "dyninsn_count", &m_dyninsn_count);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_cost", &m_dyninsn_cost);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_zero_count", &m_dyninsn_zero_count);
+   m_allocator->registerStats("uop_alloc", core->getId());
 #if DEBUG_DYN_INSN_LOG
    String filename;
    filename = "sim.dyninsn_log." + itostr(core->getId());
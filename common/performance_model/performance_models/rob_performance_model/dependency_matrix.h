@@ -0,0 +1,77 @@
+#ifndef __DEPENDENCY_MATRIX_H
+#define __DEPENDENCY_MATRIX_H
+
+#include "fixed_types.h"
+
+#include <vector>
+
+// Fixed-size wakeup matrix for the ROB: one row of bits per producer slot, with a bit set for each slot
+// that waits for it. Slots are sequence numbers modulo the number of slots, which must be at least the ROB capacity;
+// it is rounded up to a power of two (and at least one 64-bit word) so that the slot is a mask of the sequence number.
+
+class DependencyMatrix
+{
+   public:
+      DependencyMatrix(uint64_t num_slots)
+         : m_num_slots(roundUp(num_slots))
+         , m_mask(m_num_slots - 1)
+         , m_words(m_num_slots / 64)
+         , m_bits(m_num_slots * m_words, 0)
+      {}
+
+      uint64_t getNumSlots() const { return m_num_slots; }
+      uint64_t getSlot(uint64_t sequenceNumber) const { return sequenceNumber & m_mask; }
+
+      // Returns false if the dependency was already there
+      bool set(uint64_t producer, uint64_t dependant)
+      {
+         uint64_t &word = m_bits[getSlot(producer) * m_words + getSlot(dependant) / 64];
+         uint64_t bit = 1ull << (getSlot(dependant) & 63);
+         bool is_new = !(word & bit);
+         word |= bit;
+         return is_new;
+      }
+      bool test(uint64_t producer, uint64_t dependant) const
+      {
+         return m_bits[getSlot(producer) * m_words + getSlot(dependant) / 64] & (1ull << (getSlot(dependant) & 63));
+      }
+
+      // Call func with the sequence number of every dependant of producer, in no particular order
+      template <typename F> void forEach(uint64_t producer, F func) const
+      {
+         uint64_t slot = getSlot(producer);
+         const uint64_t *row = &m_bits[slot * m_words];
+         for(uint64_t w = 0; w < m_words; ++w)
+         {
+            for(uint64_t bits = row[w]; bits; bits &= bits - 1)
+            {
+               uint64_t dependant = w * 64 + __builtin_ctzll(bits);
+               // Dependants are younger than their producer, and less than one ROB away
+               func(producer + ((dependant - slot) & m_mask));
+            }
+         }
+      }
+
+      void clear(uint64_t producer)
+      {
+         uint64_t *row = &m_bits[getSlot(producer) * m_words];
+         for(uint64_t w = 0; w < m_words; ++w)
+            row[w] = 0;
+      }
+
+   private:
+      static uint64_t roundUp(uint64_t num_slots)
+      {
+         uint64_t size = 64;
+         while (size < num_slots)
+            size <<= 1;
+         return size;
+      }
+
+      const uint64_t m_num_slots;
+      const uint64_t m_mask;
+      const uint64_t m_words;
+      std::vector<uint64_t> m_bits;
+};
+
+#endif // __DEPENDENCY_MATRIX_H
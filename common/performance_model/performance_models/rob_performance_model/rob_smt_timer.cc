@@ -39,7 +39,9 @@ RobSmtTimer::RobThread::RobThread(Core *_core, int window_size)
       , in_pause(false)
       , next_event(SubsecondTime::Zero())
       , registerDependencies(new RegisterDependencies())
-      , memoryDependencies(new MemoryDependencies())
+      , memoryDependencies(new MemoryDependencies(window_size + 256))
+      , dependants(window_size + 256)
+      , address_dependants(window_size + 256)
       , m_cpiCurrentFrontEndStall(&m_cpiSMT)
 {
 }
@@ -248,52 +250,13 @@ void RobSmtTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
-   numInlineDependants = 0;
-   vectorDependants = NULL;
-
-   numAddressProducers = 0;
+   pendingDependencies = 0;
+   pendingAddressProducers = 0;
 }
 
 void RobSmtTimer::RobEntry::free()
 {
    delete uop;
-   if (vectorDependants)
-      delete vectorDependants;
-}
-
-void RobSmtTimer::RobEntry::addDependant(RobSmtTimer::RobEntry* dep)
-{
-   if (numInlineDependants < MAX_INLINE_DEPENDANTS)
-   {
-      inlineDependants[numInlineDependants++] = dep;
-   }
-   else
-   {
-      if (vectorDependants == NULL)
-      {
-         vectorDependants = new std::vector<RobEntry*>();
-      }
-      vectorDependants->push_back(dep);
-   }
-}
-
-uint64_t RobSmtTimer::RobEntry::getNumDependants() const
-{
-   return numInlineDependants + (vectorDependants ? vectorDependants->size() : 0);
-}
-
-RobSmtTimer::RobEntry* RobSmtTimer::RobEntry::getDependant(size_t idx) const
-{
-   if (idx < MAX_INLINE_DEPENDANTS)
-   {
-      LOG_ASSERT_ERROR(idx < numInlineDependants, "Invalid idx %d", idx);
-      return inlineDependants[idx];
-   }
-   else
-   {
-      LOG_ASSERT_ERROR(idx - MAX_INLINE_DEPENDANTS < vectorDependants->size(), "Invalid idx %d", idx);
-      return (*vectorDependants)[idx - MAX_INLINE_DEPENDANTS];
-   }
 }
 
 void RobSmtTimer::setDependencies(smtthread_id_t thread_id, RobEntry *entry)
@@ -324,8 +287,13 @@ void RobSmtTimer::setDependencies(smtthread_id_t thread_id, RobEntry *entry)
             // Add dependencies to the producers of the value being stored instead
             // Remark: one of these may be producing the store address, but because the store has to be
             //         disambiguated, it's correct to have the load depend on the address producers as well.
+            // The store's dependency list is not updated when its producers issue, so skip those that did.
             for(unsigned int j = 0; j < prodEntry->uop->getDependenciesLength(); ++j)
-               entry->uop->addDependency(prodEntry->uop->getDependency(j));
+            {
+               uint64_t dependency = prodEntry->uop->getDependency(j);
+               if (dependency >= lowestValidSequenceNumber && this->findEntryBySequenceNumber(thread_id, dependency)->done == SubsecondTime::MaxTime())
+                  entry->uop->addDependency(dependency);
+            }
 
             break;
          }
@@ -354,33 +322,13 @@ void RobSmtTimer::setDependencies(smtthread_id_t thread_id, RobEntry *entry)
             deps_to_remove[num_dtr++] = entry->uop->getDependency(i);
             entry->readyMax = std::max(entry->readyMax, prodEntry->done);
          }
-         else
+         else if (thread->dependants.set(prodEntry->uop->getSequenceNumber(), entry->uop->getSequenceNumber()))
          {
-            prodEntry->addDependant(entry);
+            ++entry->pendingDependencies;
          }
       }
    }
 
-   #ifdef DEBUG_PERCYCLE
-   // Make sure we are in the dependant list of all of our address producers
-   for(unsigned int i = 0; i < entry->getNumAddressProducers(); ++i)
-   {
-      if (thread->rob.size() && entry->getAddressProducer(i) >= thread->rob[0].uop->getSequenceNumber())
-      {
-         RobEntry *prodEntry = this->findEntryBySequenceNumber(thread_id, entry->getAddressProducer(i));
-         bool found = false;
-         for(unsigned int j = 0; j < prodEntry->getNumDependants(); ++j)
-            if (prodEntry->getDependant(j) == entry)
-            {
-               found = true;
-               break;
-            }
-         LOG_ASSERT_ERROR(found == true, "Store %ld depends on %ld for address production, but is not in its dependants list",
-                          entry->uop->getSequenceNumber(), prodEntry->uop->getSequenceNumber());
-      }
-   }
-   #endif
-
    if (minProducerDistance != UINT64_MAX)
    {
       thread->m_totalProducerInsDistance += minProducerDistance;
@@ -399,7 +347,7 @@ void RobSmtTimer::setDependencies(smtthread_id_t thread_id, RobEntry *entry)
    LOG_ASSERT_ERROR(num_dtr < sizeof(deps_to_remove)/sizeof(8), "Have to remove more dependencies than I expected");
    for(uint64_t i = 0; i < num_dtr; ++i)
       entry->uop->removeDependency(deps_to_remove[i]);
-   if (entry->uop->getDependenciesLength() == 0)
+   if (entry->pendingDependencies == 0)
    {
       // We have no dependencies in the ROB: mark ourselves as ready
       entry->ready = entry->readyMax;
@@ -419,11 +367,11 @@ void RobSmtTimer::setStoreAddressProducers(smtthread_id_t thread_id, RobEntry *e
          RobEntry *prodEntry = findEntryBySequenceNumber(thread_id, addressProducer);
          if (prodEntry->done != SubsecondTime::MaxTime())
             entry->addressReadyMax = std::max(entry->addressReadyMax, prodEntry->done);
-         else
-            entry->addAddressProducer(addressProducer);
+         else if (thread->address_dependants.set(addressProducer, entry->uop->getSequenceNumber()))
+            ++entry->pendingAddressProducers;
       }
    }
-   if (entry->getNumAddressProducers() == 0)
+   if (entry->pendingAddressProducers == 0)
       entry->addressReady = entry->addressReadyMax;
 }
 
@@ -470,7 +418,10 @@ void RobSmtTimer::pushInstructions(smtthread_id_t thread_id, const std::vector<D
       }
 
       RobEntry *entry = &thread->rob.next();
-      entry->init(*it, thread->nextSequenceNumber++);
+      entry->init(*it, thread->nextSequenceNumber);
+      thread->dependants.clear(thread->nextSequenceNumber);
+      thread->address_dependants.clear(thread->nextSequenceNumber);
+      ++thread->nextSequenceNumber;
 
       #ifdef DEBUG_PERCYCLE
          std::cout<<"** ["<<int(thread_id)<<"] simulate: "<<entry->uop->getMicroOp()->toShortString(true)<<std::endl;
@@ -847,53 +798,39 @@ void RobSmtTimer::issueInstruction(smtthread_id_t thread_num, uint64_t idx, Subs
       std::cout<<"["<<int(thread_num)<<"] ISSUE    "<<entry->uop->getMicroOp()->toShortString()<<"   latency="<<uop.getExecLatency()<<std::endl;
    #endif
 
-   for(size_t idx = 0; idx < entry->getNumDependants(); ++idx)
+   thread->dependants.forEach(uop.getSequenceNumber(), [&](uint64_t sequenceNumber)
    {
-      RobEntry *depEntry = entry->getDependant(idx);
-      LOG_ASSERT_ERROR(depEntry->uop->getDependenciesLength()> 0, "??");
+      RobEntry *depEntry = this->findEntryBySequenceNumber(thread_num, sequenceNumber);
+      LOG_ASSERT_ERROR(depEntry->pendingDependencies > 0, "??");
 
       // Remove uop from dependency list and update readyMax
       depEntry->readyMax = std::max(depEntry->readyMax, cycle_depend.getElapsedTime());
-      depEntry->uop->removeDependency(uop.getSequenceNumber());
 
       // If all dependencies are resolved, mark the uop ready
-      if (depEntry->uop->getDependenciesLength() == 0)
+      if (--depEntry->pendingDependencies == 0)
       {
          depEntry->ready = depEntry->readyMax;
          //std::cout<<"    ready @ "<<depEntry->ready<<std::endl;
       }
+   });
+   thread->dependants.clear(uop.getSequenceNumber());
 
-      // For stores, check if their address has been produced
-      if (depEntry->uop->getMicroOp()->isStore() && depEntry->addressReady == SubsecondTime::MaxTime())
-      {
-         bool ready = true;
-         for(unsigned int i = 0; i < depEntry->getNumAddressProducers(); ++i)
-         {
-            uint64_t addressProducer = depEntry->getAddressProducer(i);
-            RobEntry *prodEntry = addressProducer >= thread->rob.front().uop->getSequenceNumber()
-                                ? this->findEntryBySequenceNumber(thread_num, addressProducer) : NULL;
-
-            if (prodEntry == entry)
-            {
-               // The instruction we just executed is producing an address. Update the store's addressReadyMax
-               depEntry->addressReadyMax = std::max(depEntry->addressReadyMax, cycle_depend.getElapsedTime());
-            }
+   // For stores, check if their address has been produced
+   thread->address_dependants.forEach(uop.getSequenceNumber(), [&](uint64_t sequenceNumber)
+   {
+      RobEntry *depEntry = this->findEntryBySequenceNumber(thread_num, sequenceNumber);
 
-            if (prodEntry && prodEntry->done == SubsecondTime::MaxTime())
-            {
-               // An address producer has not yet been issued: address remains not ready
-               ready = false;
-            }
-         }
+      // The instruction we just executed is producing an address. Update the store's addressReadyMax
+      depEntry->addressReadyMax = std::max(depEntry->addressReadyMax, cycle_depend.getElapsedTime());
 
-         if (ready)
-         {
-            // We did not find any address producing instructions that have not yet been issued.
-            // Store address will be ready at addressReadyMax
-            depEntry->addressReady = depEntry->addressReadyMax;
-         }
+      if (--depEntry->pendingAddressProducers == 0)
+      {
+         // All address producing instructions have been issued.
+         // Store address will be ready at addressReadyMax
+         depEntry->addressReady = depEntry->addressReadyMax;
       }
-   }
+   });
+   thread->address_dependants.clear(uop.getSequenceNumber());
 
    // After issuing a mispredicted branch: allow the ROB to refill after flushing the pipeline
    if (uop.getMicroOp()->isBranch() && uop.isBranchMispredicted())
@@ -1120,10 +1057,11 @@ SubsecondTime RobSmtTimer::doCommit()
       }
    }
 
-   if (m_rob_threads[0]->rob.size()) // NOTE: for SMT, skip is ignored anyway
-      return m_rob_threads[0]->rob.front().done;
-   else
-      return SubsecondTime::MaxTime();
+   SubsecondTime next_event = SubsecondTime::MaxTime();
+   for(smtthread_id_t thread_num = 0; thread_num < m_threads.size(); ++thread_num)
+      if (m_rob_threads[thread_num]->rob.size())
+         next_event = std::min(next_event, m_rob_threads[thread_num]->rob.front().done);
+   return next_event;
 }
 
 bool RobSmtTimer::canExecute(smtthread_id_t thread_num)
@@ -1200,23 +1138,34 @@ SubsecondTime RobSmtTimer::executeCycle()
    #ifdef DEBUG_PERCYCLE
       std::cout<<"Next event: D("<<next_dispatch<<") I("<<next_issue<<") C("<<next_commit<<")"<<std::endl;
    #endif
-   SubsecondTime next_event = std::min(next_dispatch, std::min(next_issue, next_commit));
+   // With a single thread, skip exactly as the timer always did. With SMT, next_dispatch only covers the threads
+   // that tried to dispatch, getNextEvent() looks at all of them.
+   SubsecondTime next_event = m_threads.size() == 1
+      ? std::min(next_dispatch, std::min(next_issue, next_commit))
+      : std::min(std::min(next_issue, next_commit), getNextEvent());
    SubsecondTime skip;
-   if (m_threads.size() > 1)
+   if (next_event != SubsecondTime::MaxTime() && next_event > now + 1ul)
    {
-      // SMT: we would need to check all ROBs at all cycles. For now, don't bother skipping
-      will_skip = false;
-      skip = now.getPeriod();
-      // Also, CPI stack code is concentrated at dispatch and wouldn't know about skipping
-   }
-   else if (next_event != SubsecondTime::MaxTime() && next_event > now + 1ul)
-   {
-      #ifdef DEBUG_PERCYCLE
-         std::cout<<"++ Skip "<<(next_event - now)<<std::endl;
-      #endif
       will_skip = true;
-      skip = next_event - now;
-      LOG_ASSERT_WARNING(skip > SubsecondTime::NS(1000), "Instruction took too long (%lu).", skip.getNS());
+      if (m_threads.size() == 1)
+      {
+         #ifdef DEBUG_PERCYCLE
+            std::cout<<"++ Skip "<<(next_event - now)<<std::endl;
+         #endif
+         skip = next_event - now;
+         LOG_ASSERT_WARNING(skip > SubsecondTime::NS(1000), "Instruction took too long (%lu).", skip.getNS());
+      }
+      else
+      {
+         // Nothing happens on any thread until next_event: jump to the first cycle at or after it
+         uint64_t cycles = SubsecondTime::divideRounded(next_event - now, now.getPeriod());
+         if ((now + cycles).getElapsedTime() < next_event)
+            ++cycles;
+         #ifdef DEBUG_PERCYCLE
+            std::cout<<"++ Skip "<<cycles<<std::endl;
+         #endif
+         skip = cycles * now.getPeriod();
+      }
    }
    else
    {
@@ -1230,10 +1179,24 @@ SubsecondTime RobSmtTimer::executeCycle()
       if (will_skip)
          time_skipped += now.getPeriod();
    #else
-      now += skip;
+      if (m_threads.size() == 1)
+      {
+         // As before SMT skipping: skipped time is not accounted in the CPI stack
+         now += skip;
+         if (skip > now.getPeriod())
+            time_skipped += (skip - now.getPeriod());
+      }
+      else
+      {
+         // Skipped cycles get the CPI components and round-robin movement that stepping through them would give
+         now += now.getPeriod();
+         if (skip > now.getPeriod())
+         {
+            skipCycles(skip - now.getPeriod());
+            time_skipped += (skip - now.getPeriod());
+         }
+      }
       latency += skip;
-      if (skip > now.getPeriod())
-         time_skipped += (skip - now.getPeriod());
    #endif
 
    if (m_mlp_histogram)
@@ -1245,6 +1208,82 @@ SubsecondTime RobSmtTimer::executeCycle()
    return latency;
 }
 
+SubsecondTime RobSmtTimer::getDispatchEvent(smtthread_id_t thread_num)
+{
+   // Earliest time, from the next cycle on, at which this thread's front-end may change state.
+   // Follows the checks in doDispatch() and tryDispatch(): MaxTime means waiting for an event in the ROB.
+   RobThread *thread = m_rob_threads[thread_num];
+   SubsecondTime next_cycle = (now + 1ul).getElapsedTime();
+
+   if (thread->frontend_stalled_until > next_cycle)
+      return thread->frontend_stalled_until;
+   else if (thread->now > next_cycle)
+      return thread->now;
+   else if (thread->m_num_in_rob >= currentWindowSize)
+      return SubsecondTime::MaxTime();
+   else if (m_threads[thread_num]->running && thread->rob.size() < thread->m_num_in_rob + 2*dispatchWidth)
+      return next_cycle;   // canExecute() will ask for more instructions
+   else if (thread->m_num_in_rob >= thread->rob.size())
+      return SubsecondTime::MaxTime();
+
+   // Only a full RS keeps a dispatch attempt from changing anything, unless the next uop starts an I-cache miss or pause
+   const DynamicMicroOp &uop = *thread->rob.at(thread->m_num_in_rob).uop;
+   if (m_rs_entries_used == rsEntries
+       && (uop.getICacheHitWhere() == HitWhere::L1I || thread->in_icache_miss)
+       && (!uop.getMicroOp()->isPause() || thread->in_pause))
+      return SubsecondTime::MaxTime();
+   else
+      return next_cycle;
+}
+
+SubsecondTime RobSmtTimer::getNextEvent()
+{
+   SubsecondTime next_event = SubsecondTime::MaxTime();
+   for(smtthread_id_t thread_num = 0; thread_num < m_threads.size(); ++thread_num)
+   {
+      RobThread *thread = m_rob_threads[thread_num];
+      // doIssue() does not look at this thread before its next_event
+      if (thread->m_num_in_rob > 0)
+         next_event = std::min(next_event, thread->next_event);
+      next_event = std::min(next_event, getDispatchEvent(thread_num));
+   }
+   return next_event;
+}
+
+void RobSmtTimer::skipCycles(SubsecondTime time)
+{
+   // Do what doDispatch() and doIssue() would have done in each of these idle cycles: account them to
+   // the current CPI component of each thread, and move the round-robin pointers along
+   uint64_t cycles = SubsecondTime::divideRounded(time, now.getPeriod());
+
+   for(smtthread_id_t thread_num = 0; thread_num < m_threads.size(); ++thread_num)
+   {
+      RobThread *thread = m_rob_threads[thread_num];
+      SubsecondTime *cpiComponent, *cpiRobHead = findCpiComponent(thread_num);
+
+      if (thread->frontend_stalled_until > now)
+         cpiComponent = cpiRobHead ? cpiRobHead : thread->m_cpiCurrentFrontEndStall;
+      else if (thread->now > now)
+         cpiComponent = &thread->m_cpiIdle;
+      else if (thread->m_num_in_rob >= currentWindowSize)
+         cpiComponent = cpiRobHead ? cpiRobHead : &thread->m_cpiBase;
+      else
+      {
+         // tryDispatch() would find nothing to dispatch, or a full RS
+         thread->m_cpiCurrentFrontEndStall = thread->m_num_in_rob < thread->rob.size() ? &thread->m_cpiRSFull : NULL;
+         cpiComponent = thread->m_cpiCurrentFrontEndStall ? thread->m_cpiCurrentFrontEndStall : &thread->m_cpiBase;
+      }
+
+      LOG_ASSERT_ERROR(cpiComponent != NULL, "We expected cpiComponent to be set, but it wasn't");
+      *cpiComponent += time;
+   }
+
+   dispatch_thread = (dispatch_thread + cycles) % m_threads.size();
+   issue_thread = (issue_thread + cycles) % m_threads.size();
+
+   now += time;
+}
+
 void RobSmtTimer::countOutstandingMemop(smtthread_id_t thread_num, SubsecondTime time)
 {
    RobThread *thread = m_rob_threads[thread_num];
@@ -1307,7 +1346,9 @@ void RobSmtTimer::printRob(smtthread_id_t thread_num)
       {
          state<<"DEPS ";
          for(uint32_t j = 0; j < e->uop->getDependenciesLength(); j++)
-            state << std::dec << e->uop->getDependency(j) << " ";
+            if (e->uop->getDependency(j) >= thread->rob.front().uop->getSequenceNumber()
+                && findEntryBySequenceNumber(thread_num, e->uop->getDependency(j))->done == SubsecondTime::MaxTime())
+               state << std::dec << e->uop->getDependency(j) << " ";
       }
       std::cout<<std::left<<std::setw(20)<<state.str()<<"   ";
       std::cout<<std::right<<std::setw(10)<<e->uop->getSequenceNumber()<<"  ";
@@ -8,37 +8,19 @@
 #include "interval_timer.h"
 #include "smt_timer.h"
 #include "rob_contention.h"
+#include "dependency_matrix.h"
 
 #include <deque>
 
 class RobSmtTimer : public SmtTimer {
 private:
    class RobEntry {
-      private:
-         static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
-         RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-
-         static const size_t MAX_ADDRESS_PRODUCERS = 4;
-         size_t numAddressProducers;
-         uint64_t addressProducers[MAX_ADDRESS_PRODUCERS];
-
       public:
          void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
          void free();
 
-         void addDependant(RobEntry* dep);
-         uint64_t getNumDependants() const;
-         RobEntry* getDependant(size_t idx) const;
-
-         void addAddressProducer(uint64_t sequenceNumber)
-         {
-            LOG_ASSERT_ERROR(numAddressProducers < MAX_ADDRESS_PRODUCERS, "Too many address producers, increase MAX_ADDRESS_PRODUCERS(%d)", MAX_ADDRESS_PRODUCERS);
-            addressProducers[numAddressProducers++] = sequenceNumber;
-         }
-         size_t getNumAddressProducers() const { return numAddressProducers; }
-         uint64_t getAddressProducer(size_t idx) const { return addressProducers[idx]; }
+         uint32_t pendingDependencies;       // Producers that have not yet issued, see RobThread::dependants
+         uint32_t pendingAddressProducers;   // For stores: producers of the address that have not yet issued
 
          DynamicMicroOp *uop;
          SubsecondTime dispatched;
@@ -71,6 +53,8 @@ private:
 
          RegisterDependencies* const registerDependencies;
          MemoryDependencies* const memoryDependencies;
+         DependencyMatrix dependants;           // Register and memory dependants waiting for each producer to issue
+         DependencyMatrix address_dependants;   // Stores waiting for each producer to compute their address
 
          SubsecondTime *m_cpiCurrentFrontEndStall;
 
@@ -179,6 +163,10 @@ private:
    SubsecondTime doIssue();
    SubsecondTime doCommit();
 
+   SubsecondTime getDispatchEvent(smtthread_id_t thread_num);
+   SubsecondTime getNextEvent();
+   void skipCycles(SubsecondTime time);
+
    bool canExecute(smtthread_id_t thread_num);
    bool canExecute();
    bool tryDispatch(smtthread_id_t thread_num, SubsecondTime &next_event);
@@ -55,7 +55,9 @@ RobTimer::RobTimer(
       , will_skip(false)
       , time_skipped(SubsecondTime::Zero())
       , registerDependencies(new RegisterDependencies())
-      , memoryDependencies(new MemoryDependencies())
+      , memoryDependencies(new MemoryDependencies(window_size + 256))
+      , m_dependants(window_size + 256)
+      , m_address_dependants(window_size + 256)
       , perf(_perf)
       , m_cpiCurrentFrontEndStall(NULL)
       , m_mlp_histogram(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/mlp_histogram", core->getId()))
@@ -191,52 +193,13 @@ void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
-   addressProducers.clear();
-
-   numInlineDependants = 0;
-   vectorDependants = NULL;
+   pendingDependencies = 0;
+   pendingAddressProducers = 0;
 }
 
 void RobTimer::RobEntry::free()
 {
    delete uop;
-   if (vectorDependants)
-      delete vectorDependants;
-}
-
-void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep)
-{
-   if (numInlineDependants < MAX_INLINE_DEPENDANTS)
-   {
-      inlineDependants[numInlineDependants++] = dep;
-   }
-   else
-   {
-      if (vectorDependants == NULL)
-      {
-         vectorDependants = new std::vector<RobEntry*>();
-      }
-      vectorDependants->push_back(dep);
-   }
-}
-
-uint64_t RobTimer::RobEntry::getNumDependants() const
-{
-   return numInlineDependants + (vectorDependants ? vectorDependants->size() : 0);
-}
-
-RobTimer::RobEntry* RobTimer::RobEntry::getDependant(size_t idx) const
-{
-   if (idx < MAX_INLINE_DEPENDANTS)
-   {
-      LOG_ASSERT_ERROR(idx < numInlineDependants, "Invalid idx %d", idx);
-      return inlineDependants[idx];
-   }
-   else
-   {
-      LOG_ASSERT_ERROR(idx - MAX_INLINE_DEPENDANTS < vectorDependants->size(), "Invalid idx %d", idx);
-      return (*vectorDependants)[idx - MAX_INLINE_DEPENDANTS];
-   }
 }
 
 RobTimer::RobEntry *RobTimer::findEntryBySequenceNumber(UInt64 sequenceNumber)
@@ -264,7 +227,10 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
       }
 
       RobEntry *entry = &this->rob.next();
-      entry->init(*it, nextSequenceNumber++);
+      entry->init(*it, nextSequenceNumber);
+      m_dependants.clear(nextSequenceNumber);
+      m_address_dependants.clear(nextSequenceNumber);
+      ++nextSequenceNumber;
 
       // Add = calculate dependencies, add yourself to list of depenants
       // If no dependants in window: set ready = now()
@@ -280,11 +246,11 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
                RobEntry *prodEntry = this->findEntryBySequenceNumber(addressProducer);
                if (prodEntry->done != SubsecondTime::MaxTime())
                   entry->addressReadyMax = std::max(entry->addressReadyMax, prodEntry->done);
-               else
-                  entry->addAddressProducer(addressProducer);
+               else if (m_address_dependants.set(addressProducer, entry->uop->getSequenceNumber()))
+                  ++entry->pendingAddressProducers;
             }
          }
-         if (entry->getNumAddressProducers() == 0)
+         if (entry->pendingAddressProducers == 0)
             entry->addressReady = entry->addressReadyMax;
       }
       this->registerDependencies->setDependencies(*entry->uop, lowestValidSequenceNumber);
@@ -304,8 +270,13 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
                // Add dependencies to the producers of the value being stored instead
                // Remark: one of these may be producing the store address, but because the store has to be
                //         disambiguated, it's correct to have the load depend on the address producers as well.
+               // The store's dependency list is not updated when its producers issue, so skip those that did.
                for(unsigned int j = 0; j < prodEntry->uop->getDependenciesLength(); ++j)
-                  entry->uop->addDependency(prodEntry->uop->getDependency(j));
+               {
+                  uint64_t dependency = prodEntry->uop->getDependency(j);
+                  if (dependency >= lowestValidSequenceNumber && this->findEntryBySequenceNumber(dependency)->done == SubsecondTime::MaxTime())
+                     entry->uop->addDependency(dependency);
+               }
 
                break;
             }
@@ -326,31 +297,11 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
             deps_to_remove[num_dtr++] = entry->uop->getDependency(i);
             entry->readyMax = std::max(entry->readyMax, prodEntry->done);
          }
-         else
-         {
-            prodEntry->addDependant(entry);
-         }
-      }
-
-      #ifdef DEBUG_PERCYCLE
-      // Make sure we are in the dependant list of all of our address producers
-      for(unsigned int i = 0; i < entry->getNumAddressProducers(); ++i)
-      {
-         if (rob.size() && entry->getAddressProducer(i) >= rob[0].uop->getSequenceNumber())
+         else if (m_dependants.set(prodEntry->uop->getSequenceNumber(), entry->uop->getSequenceNumber()))
          {
-            RobEntry *prodEntry = this->findEntryBySequenceNumber(entry->getAddressProducer(i));
-            bool found = false;
-            for(unsigned int j = 0; j < prodEntry->getNumDependants(); ++j)
-               if (prodEntry->getDependant(j) == entry)
-               {
-                  found = true;
-                  break;
-               }
-            LOG_ASSERT_ERROR(found == true, "Store %ld depends on %ld for address production, but is not in its dependants list",
-                             entry->uop->getSequenceNumber(), prodEntry->uop->getSequenceNumber());
+            ++entry->pendingDependencies;
          }
       }
-      #endif
 
       if (minProducerDistance != UINT64_MAX)
       {
@@ -370,7 +321,7 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
       LOG_ASSERT_ERROR(num_dtr < sizeof(deps_to_remove)/sizeof(8), "Have to remove more dependencies than I expected");
       for(uint64_t i = 0; i < num_dtr; ++i)
          entry->uop->removeDependency(deps_to_remove[i]);
-      if (entry->uop->getDependenciesLength() == 0)
+      if (entry->pendingDependencies == 0)
       {
          // We have no dependencies in the ROB: mark ourselves as ready
          entry->ready = entry->readyMax;
@@ -636,53 +587,39 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
       std::cout<<"ISSUE    "<<entry->uop->getMicroOp()->toShortString()<<"   latency="<<uop.getExecLatency()<<std::endl;
    #endif
 
-   for(size_t idx = 0; idx < entry->getNumDependants(); ++idx)
+   m_dependants.forEach(uop.getSequenceNumber(), [&](uint64_t sequenceNumber)
    {
-      RobEntry *depEntry = entry->getDependant(idx);
-      LOG_ASSERT_ERROR(depEntry->uop->getDependenciesLength()> 0, "??");
+      RobEntry *depEntry = this->findEntryBySequenceNumber(sequenceNumber);
+      LOG_ASSERT_ERROR(depEntry->pendingDependencies > 0, "??");
 
       // Remove uop from dependency list and update readyMax
       depEntry->readyMax = std::max(depEntry->readyMax, cycle_depend.getElapsedTime());
-      depEntry->uop->removeDependency(uop.getSequenceNumber());
 
       // If all dependencies are resolved, mark the uop ready
-      if (depEntry->uop->getDependenciesLength() == 0)
+      if (--depEntry->pendingDependencies == 0)
       {
          depEntry->ready = depEntry->readyMax;
          //std::cout<<"    ready @ "<<depEntry->ready<<std::endl;
       }
+   });
+   m_dependants.clear(uop.getSequenceNumber());
 
-      // For stores, check if their address has been produced
-      if (depEntry->uop->getMicroOp()->isStore() && depEntry->addressReady == SubsecondTime::MaxTime())
-      {
-         bool ready = true;
-         for(unsigned int i = 0; i < depEntry->getNumAddressProducers(); ++i)
-         {
-            uint64_t addressProducer = depEntry->getAddressProducer(i);
-            RobEntry *prodEntry = addressProducer >= this->rob.front().uop->getSequenceNumber()
-                                ? this->findEntryBySequenceNumber(addressProducer) : NULL;
+   // For stores, check if their address has been produced
+   m_address_dependants.forEach(uop.getSequenceNumber(), [&](uint64_t sequenceNumber)
+   {
+      RobEntry *depEntry = this->findEntryBySequenceNumber(sequenceNumber);
 
-            if (prodEntry == entry)
-            {
-               // The instruction we just executed is producing an address. Update the store's addressReadyMax
-               depEntry->addressReadyMax = std::max(depEntry->addressReadyMax, cycle_depend.getElapsedTime());
-            }
+      // The instruction we just executed is producing an address. Update the store's addressReadyMax
+      depEntry->addressReadyMax = std::max(depEntry->addressReadyMax, cycle_depend.getElapsedTime());
 
-            if (prodEntry && prodEntry->done == SubsecondTime::MaxTime())
-            {
-               // An address producer has not yet been issued: address remains not ready
-               ready = false;
-            }
-         }
-
-         if (ready)
-         {
-            // We did not find any address producing instructions that have not yet been issued.
-            // Store address will be ready at addressReadyMax
-            depEntry->addressReady = depEntry->addressReadyMax;
-         }
+      if (--depEntry->pendingAddressProducers == 0)
+      {
+         // All address producing instructions have been issued.
+         // Store address will be ready at addressReadyMax
+         depEntry->addressReady = depEntry->addressReadyMax;
       }
-   }
+   });
+   m_address_dependants.clear(uop.getSequenceNumber());
 
    // After issuing a mispredicted branch: allow the ROB to refill after flushing the pipeline
    if (uop.getMicroOp()->isBranch() && uop.isBranchMispredicted())
@@ -1000,7 +937,9 @@ void RobTimer::printRob()
       {
          state<<"DEPS ";
          for(uint32_t j = 0; j < e->uop->getDependenciesLength(); j++)
-            state << std::dec << e->uop->getDependency(j) << " ";
+            if (e->uop->getDependency(j) >= rob.front().uop->getSequenceNumber()
+                && findEntryBySequenceNumber(e->uop->getDependency(j))->done == SubsecondTime::MaxTime())
+               state << std::dec << e->uop->getDependency(j) << " ";
       }
       std::cout<<std::left<<std::setw(20)<<state.str()<<"   ";
       std::cout<<std::right<<std::setw(10)<<e->uop->getSequenceNumber()<<"  ";
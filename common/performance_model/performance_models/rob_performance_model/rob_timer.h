@@ -7,6 +7,7 @@
 
 #include "interval_timer.h"
 #include "rob_contention.h"
+#include "dependency_matrix.h"
 #include "stats.h"
 
 #include <deque>
@@ -16,24 +17,12 @@ class RobTimer
 private:
    class RobEntry
    {
-      private:
-         static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
-         RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-         std::vector<uint64_t> addressProducers;
-
       public:
          void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
          void free();
 
-         void addDependant(RobEntry* dep);
-         uint64_t getNumDependants() const;
-         RobEntry* getDependant(size_t idx) const;
-
-         void addAddressProducer(UInt64 sequenceNumber) { addressProducers.push_back(sequenceNumber); }
-         UInt64 getNumAddressProducers() const { return addressProducers.size(); }
-         UInt64 getAddressProducer(size_t idx) const { return addressProducers.at(idx); }
+         uint32_t pendingDependencies;       // Producers that have not yet issued, see RobTimer::m_dependants
+         uint32_t pendingAddressProducers;   // For stores: producers of the address that have not yet issued
 
          DynamicMicroOp *uop;
          SubsecondTime dispatched;
@@ -75,6 +64,8 @@ private:
 
    RegisterDependencies* const registerDependencies;
    MemoryDependencies* const memoryDependencies;
+   DependencyMatrix m_dependants;            // Register and memory dependants waiting for each producer to issue
+   DependencyMatrix m_address_dependants;    // Stores waiting for each producer to compute their address
 
    int addressMask;
 
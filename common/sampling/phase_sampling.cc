@@ -0,0 +1,340 @@
+#include "phase_sampling.h"
+#include "sampling_manager.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "fastforward_performance_model.h"
+#include "bbv_count.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+#include <cmath>
+
+PhaseSampling::PhaseSampling(SamplingManager *sampling_manager)
+   : SamplingAlgorithm(sampling_manager)
+   , m_num_cores(Sim()->getConfig()->getApplicationCores())
+   // Length of an interval, the unit of phase classification
+   , m_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/phase/interval")))
+   // Cache warmup before a detailed interval that follows fast-forwarding
+   , m_warmup_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/phase/warmup_interval")))
+   // Time between core synchronizations in fast-forward mode
+   , m_fastforward_sync_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/phase/fastforward_sync_interval")))
+   // Number of intervals of each phase to simulate in detail
+   , m_detailed_intervals(Sim()->getCfg()->getInt("sampling/phase/detailed_intervals"))
+   // Maximum distance between an interval's BBV and the centroid of the phase it is assigned to
+   , m_threshold(Sim()->getCfg()->getFloat("sampling/phase/threshold"))
+   , m_max_phases(Sim()->getCfg()->getInt("sampling/phase/max_phases"))
+   , m_detailed_sync(Sim()->getCfg()->getBool("sampling/phase/detailed_sync"))
+   , m_dispatch_width(Sim()->getCfg()->getInt("perf_model/core/interval_timer/dispatch_width"))
+   , m_mode(MODE_DETAILED)
+   , m_interval_start(SubsecondTime::Zero())
+   , m_time_remaining(SubsecondTime::Zero())
+   , m_phase(-1)
+   , m_bbv_last(m_num_cores * BbvCount::NUM_BBV, 0)
+   , m_bbv_instrs_last(m_num_cores, 0)
+   , m_instrs_last(m_num_cores, 0)
+   , m_num_intervals(0)
+   , m_num_intervals_detailed(0)
+   , m_num_phases(0)
+   , m_instructions_total(0)
+   , m_instructions_detailed(0)
+{
+   LOG_ASSERT_ERROR(m_interval > SubsecondTime::Zero(), "sampling/phase/interval must be positive");
+   LOG_ASSERT_ERROR(m_fastforward_sync_interval > SubsecondTime::Zero() && m_fastforward_sync_interval <= m_interval, "fastforward_sync_interval must be between 0 and interval");
+   LOG_ASSERT_ERROR(m_detailed_intervals >= 1, "sampling/phase/detailed_intervals must be at least 1");
+   LOG_ASSERT_ERROR(m_max_phases >= 1, "sampling/phase/max_phases must be at least 1");
+
+   registerStatsMetric("sampling", 0, "intervals", &m_num_intervals);
+   registerStatsMetric("sampling", 0, "intervals-detailed", &m_num_intervals_detailed);
+   registerStatsMetric("sampling", 0, "phases", &m_num_phases);
+   registerStatsMetric("sampling", 0, "instructions", &m_instructions_total);
+   registerStatsMetric("sampling", 0, "instructions-detailed", &m_instructions_detailed);
+}
+
+PhaseSampling::~PhaseSampling()
+{
+   printSummary();
+}
+
+UInt64
+PhaseSampling::getSignature(std::vector<double> &signature)
+{
+   // Concatenation of the per-core BBVs of this interval, each normalized to the number of instructions.
+   // BbvCount uses 16-bit projection weights, so each dimension ends up between 0 and 1.
+   UInt64 instructions = 0;
+   signature.resize(m_num_cores * BbvCount::NUM_BBV);
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      BbvCount *bbv = core->getBbvCount();
+
+      UInt64 bbv_instrs = bbv->getInstructionCount() - m_bbv_instrs_last[core_id];
+      m_bbv_instrs_last[core_id] = bbv->getInstructionCount();
+      for(int dim = 0; dim < BbvCount::NUM_BBV; ++dim)
+      {
+         UInt32 idx = core_id * BbvCount::NUM_BBV + dim;
+         UInt64 value = bbv->getDimension(dim);
+         signature[idx] = bbv_instrs ? (value - m_bbv_last[idx]) / (65536. * bbv_instrs) : 0.;
+         m_bbv_last[idx] = value;
+      }
+
+      instructions += core->getInstructionCount() - m_instrs_last[core_id];
+      m_instrs_last[core_id] = core->getInstructionCount();
+   }
+   return instructions;
+}
+
+UInt32
+PhaseSampling::classify(const std::vector<double> &signature)
+{
+   SInt32 nearest = -1;
+   double nearest_distance = INFINITY;
+   for(UInt32 idx = 0; idx < m_phases.size(); ++idx)
+   {
+      double distance = 0;
+      for(UInt32 dim = 0; dim < signature.size(); ++dim)
+         distance += fabs(signature[dim] - m_phases[idx].centroid[dim]);
+      distance /= signature.size();
+      if (distance < nearest_distance)
+      {
+         nearest = idx;
+         nearest_distance = distance;
+      }
+   }
+
+   if (nearest == -1 || (nearest_distance > m_threshold && m_phases.size() < m_max_phases))
+   {
+      Phase phase;
+      phase.centroid = signature;
+      phase.intervals = 0;
+      phase.instructions = 0;
+      phase.samples = 0;
+      phase.cpi_sum.resize(m_num_cores, 0.);
+      phase.cpi_count.resize(m_num_cores, 0);
+      phase.sample_sum = phase.sample_sum2 = 0.;
+      m_phases.push_back(phase);
+      m_num_phases = m_phases.size();
+      return m_phases.size() - 1;
+   }
+   else
+   {
+      // Move the centroid towards this interval, so it remains the average of all intervals in the phase
+      Phase &phase = m_phases[nearest];
+      for(UInt32 dim = 0; dim < signature.size(); ++dim)
+         phase.centroid[dim] += (signature[dim] - phase.centroid[dim]) / (phase.intervals + 1);
+      return nearest;
+   }
+}
+
+void
+PhaseSampling::addSample(Phase &phase)
+{
+   double sample = 0.;
+   UInt32 count = 0;
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      // Only use the CPI if the core has been executing instructions for at least 20% of the interval
+      SubsecondTime cpi = m_sampling_manager->getCoreHistoricCPI(core, m_detailed_sync, m_interval / 5);
+      if (cpi != SubsecondTime::Zero() && cpi != SubsecondTime::MaxTime())
+      {
+         phase.cpi_sum[core_id] += cpi.getFS();
+         phase.cpi_count[core_id]++;
+         sample += cpi.getFS();
+         count++;
+      }
+   }
+
+   phase.samples++;
+   if (count)
+   {
+      sample /= count;
+      phase.sample_sum += sample;
+      phase.sample_sum2 += sample * sample;
+   }
+}
+
+void
+PhaseSampling::setFastForwardCPIs(const Phase &phase)
+{
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      SubsecondTime period = core->getDvfsDomain()->getPeriod();
+      SubsecondTime cpi;
+      // Assume one IPC for cores that were not running during this phase's detailed intervals
+      if (phase.cpi_count[core_id])
+         cpi = SubsecondTime::FS(UInt64(phase.cpi_sum[core_id] / phase.cpi_count[core_id]));
+      else
+         cpi = period;
+
+      SubsecondTime min_cpi = period / m_dispatch_width;
+      if (cpi < min_cpi)
+         cpi = min_cpi; // max. m_dispatch_width IPC
+      else if (cpi > period * 100)
+         cpi = period * 100; // min. .01 IPC
+      core->getPerformanceModel()->getFastforwardPerformanceModel()->setCurrentCPI(cpi);
+   }
+}
+
+void
+PhaseSampling::endInterval(SubsecondTime time)
+{
+   bool detailed = m_mode == MODE_DETAILED;
+
+   std::vector<double> signature;
+   UInt64 instructions = getSignature(signature);
+
+   ++m_num_intervals;
+   m_instructions_total += instructions;
+   if (detailed)
+   {
+      ++m_num_intervals_detailed;
+      m_instructions_detailed += instructions;
+   }
+
+   // Idle intervals say nothing about the phase, keep the current prediction
+   if (instructions)
+   {
+      m_phase = classify(signature);
+      Phase &phase = m_phases[m_phase];
+      phase.intervals++;
+      phase.instructions += instructions;
+      if (detailed)
+         addSample(phase);
+   }
+
+   // Predict that the next interval is in the same phase as this one. Simulate it in detail if that phase does
+   // not have enough detailed samples yet, else fast-forward using the phase's CPI.
+   if (m_phase == -1 || m_phases[m_phase].samples < m_detailed_intervals)
+   {
+      if (detailed)
+      {
+         m_sampling_manager->resetCoreHistoricCPIs();
+         m_interval_start = time;
+      }
+      else if (m_warmup_interval > SubsecondTime::Zero())
+      {
+         m_mode = MODE_WARMUP;
+         m_time_remaining = m_warmup_interval;
+         stepFastForward(time, true);
+      }
+      else
+      {
+         m_sampling_manager->disableFastForward();
+         startDetailed(time);
+      }
+   }
+   else
+   {
+      setFastForwardCPIs(m_phases[m_phase]);
+      m_mode = MODE_FASTFORWARD;
+      m_time_remaining = m_interval;
+      stepFastForward(time, false);
+   }
+}
+
+bool
+PhaseSampling::stepFastForward(SubsecondTime time, bool warmup)
+{
+   if (m_time_remaining == SubsecondTime::Zero())
+      return true;
+
+   SubsecondTime time_to_fastforward = std::min(m_time_remaining, m_fastforward_sync_interval);
+   m_time_remaining -= time_to_fastforward;
+   m_sampling_manager->enableFastForward(time + time_to_fastforward, warmup, m_detailed_sync);
+   return false;
+}
+
+void
+PhaseSampling::startDetailed(SubsecondTime time)
+{
+   m_mode = MODE_DETAILED;
+   m_sampling_manager->resetCoreHistoricCPIs();
+   m_interval_start = time;
+}
+
+void
+PhaseSampling::callbackDetailed(SubsecondTime time)
+{
+   if (time >= m_interval_start + m_interval)
+      endInterval(time);
+}
+
+void
+PhaseSampling::callbackFastForward(SubsecondTime time, bool in_warmup)
+{
+   if (!stepFastForward(time, m_mode == MODE_WARMUP))
+      return;
+
+   if (m_mode == MODE_FASTFORWARD)
+   {
+      endInterval(time);
+   }
+   else
+   {
+      // Warmup done: the instructions executed during warmup count towards the detailed interval's phase signature
+      m_sampling_manager->disableFastForward();
+      startDetailed(time);
+   }
+}
+
+void
+PhaseSampling::printSummary()
+{
+   if (m_num_intervals == 0)
+      return;
+
+   // Estimated CPI is the instruction-weighted average of the per-phase CPIs. Its standard error follows from
+   // the variance of each phase's detailed samples (stratified sampling); phases with a single sample are assumed
+   // to have the average relative variance of the others. Intervals fast-forwarded through while the phase
+   // prediction was wrong are not accounted for.
+   double instructions = 0, cpi = 0, rel_variance = 0;
+   UInt32 num_rel_variance = 0;
+   for(std::vector<Phase>::const_iterator it = m_phases.begin(); it != m_phases.end(); ++it)
+   {
+      if (it->samples == 0 || it->sample_sum == 0)
+         continue;
+      double mean = it->sample_sum / it->samples;
+      instructions += it->instructions;
+      cpi += it->instructions * mean;
+      if (it->samples >= 2)
+      {
+         double variance = std::max(0., (it->sample_sum2 - it->sample_sum * mean) / (it->samples - 1));
+         rel_variance += variance / (mean * mean);
+         num_rel_variance++;
+      }
+   }
+
+   double error = -1;
+   if (instructions && num_rel_variance)
+   {
+      cpi /= instructions;
+      rel_variance /= num_rel_variance;
+      double se2 = 0;
+      for(std::vector<Phase>::const_iterator it = m_phases.begin(); it != m_phases.end(); ++it)
+      {
+         if (it->samples == 0 || it->sample_sum == 0)
+            continue;
+         double mean = it->sample_sum / it->samples;
+         double variance = it->samples >= 2
+            ? std::max(0., (it->sample_sum2 - it->sample_sum * mean) / (it->samples - 1))
+            : rel_variance * mean * mean;
+         double weight = it->instructions / instructions;
+         se2 += weight * weight * variance / it->samples;
+      }
+      // 95% confidence interval
+      error = 1.96 * sqrt(se2) / cpi;
+   }
+
+   // Speedup assumes fast-forwarding and warmup come for free, relative to detailed simulation
+   double speedup = m_instructions_total / double(m_instructions_detailed ? m_instructions_detailed : 1);
+
+   printf("[SNIPER] Phase sampling: %u phases, %" PRIu64 " of %" PRIu64 " intervals in detail, speedup %.1fx, estimated CPI error ",
+      UInt32(m_phases.size()), m_num_intervals_detailed, m_num_intervals, speedup);
+   if (error >= 0)
+      printf("%.2f%%\n", 100 * error);
+   else
+      printf("unknown\n");
+}
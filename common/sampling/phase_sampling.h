@@ -0,0 +1,81 @@
+#ifndef __PHASE_SAMPLING
+#define __PHASE_SAMPLING
+
+#include "fixed_types.h"
+#include "sampling_algorithm.h"
+
+#include <vector>
+
+// Phase-based sampling: execution is divided into fixed-length intervals, and each interval is classified
+// into a phase using its basic-block vector (randomly projected by BbvCount), normalized per instruction.
+// Phases are formed online: an interval joins the phase with the nearest centroid if it is within
+// sampling/phase/threshold, else it starts a new phase. The first detailed_intervals intervals of each
+// phase are simulated in detail (preceded by cache warmup if coming from fast-forward), after which the
+// phase's average CPI is used to fast-forward through subsequent intervals predicted to be in the same phase.
+class PhaseSampling : public SamplingAlgorithm
+{
+   private:
+      enum mode_t
+      {
+         MODE_DETAILED,
+         MODE_FASTFORWARD,
+         MODE_WARMUP,
+      };
+
+      struct Phase
+      {
+         std::vector<double> centroid;
+         UInt64 intervals;
+         UInt64 instructions;
+         UInt32 samples;                  //< Number of detailed intervals
+         std::vector<double> cpi_sum;     //< Per core: sum of CPIs (in fs) over the detailed intervals
+         std::vector<UInt32> cpi_count;   //< Per core: number of detailed intervals with a valid CPI
+         double sample_sum, sample_sum2;  //< Sum and sum of squares of the average CPI over all cores, for error estimation
+      };
+
+      const UInt32 m_num_cores;
+      const SubsecondTime m_interval;
+      const SubsecondTime m_warmup_interval;
+      const SubsecondTime m_fastforward_sync_interval;
+      const UInt32 m_detailed_intervals;
+      const double m_threshold;
+      const UInt32 m_max_phases;
+      const bool m_detailed_sync;
+      const int m_dispatch_width;
+
+      mode_t m_mode;
+      SubsecondTime m_interval_start;     //< Start of the measured part of the current interval
+      SubsecondTime m_time_remaining;     //< Fast-forward or warmup time left in the current interval
+      SInt32 m_phase;                     //< Phase of the last completed interval, -1 if none
+      std::vector<Phase> m_phases;
+
+      // BBV and instruction counts at the start of the current interval
+      std::vector<UInt64> m_bbv_last;
+      std::vector<UInt64> m_bbv_instrs_last;
+      std::vector<UInt64> m_instrs_last;
+
+      // Statistics
+      UInt64 m_num_intervals;
+      UInt64 m_num_intervals_detailed;
+      UInt64 m_num_phases;
+      UInt64 m_instructions_total;
+      UInt64 m_instructions_detailed;
+
+      UInt64 getSignature(std::vector<double> &signature);
+      UInt32 classify(const std::vector<double> &signature);
+      void addSample(Phase &phase);
+      void setFastForwardCPIs(const Phase &phase);
+      void endInterval(SubsecondTime time);
+      bool stepFastForward(SubsecondTime time, bool warmup);
+      void startDetailed(SubsecondTime time);
+      void printSummary();
+
+   public:
+      PhaseSampling(SamplingManager *sampling_manager);
+      ~PhaseSampling();
+
+      virtual void callbackDetailed(SubsecondTime now);
+      virtual void callbackFastForward(SubsecondTime now, bool in_warmup);
+};
+
+#endif /* __PHASE_SAMPLING */
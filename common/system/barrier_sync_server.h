@@ -11,7 +11,7 @@ class CoreManager;
 
 class BarrierSyncServer : public ClockSkewMinimizationServer
 {
-   private:
+   protected:
       SubsecondTime m_barrier_interval;
       SubsecondTime m_next_barrier_time;
       std::vector<SubsecondTime> m_local_clock_list;
@@ -26,10 +26,10 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
 
       bool isBarrierReached(void);
       bool barrierRelease(thread_id_t thread_id = INVALID_THREAD_ID, bool continue_until_release = false);
-      void abortBarrier(void);
+      virtual void abortBarrier(void);
       bool isCoreRunning(core_id_t core_id, bool siblings = true);
       void releaseThread(thread_id_t thread_id);
-      void signal();
+      virtual void signal();
       void doRelease(int n);
 
       static SInt64 hookThreadExit(UInt64 object, UInt64 argument) {
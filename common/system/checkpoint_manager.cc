@@ -0,0 +1,155 @@
+#include "checkpoint_manager.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "config.hpp"
+#include "itostr.h"
+#include "log.h"
+
+CheckpointManager::CheckpointManager()
+   : m_save_at(SAVE_NEVER)
+   , m_save_marker(0)
+   , m_save_pending(false)
+   , m_saved(false)
+{
+}
+
+CheckpointManager::~CheckpointManager()
+{
+}
+
+String
+CheckpointManager::getKey(String name, core_id_t core_id)
+{
+   return name + "/" + itostr(core_id);
+}
+
+void
+CheckpointManager::registerObject(String name, core_id_t core_id, Checkpointable *object)
+{
+   ScopedLock sl(m_lock);
+   String key = getKey(name, core_id);
+   LOG_ASSERT_ERROR(m_objects.count(key) == 0, "Checkpointable object %s registered twice", key.c_str());
+   m_objects[key] = object;
+}
+
+void
+CheckpointManager::unregisterObject(String name, core_id_t core_id)
+{
+   ScopedLock sl(m_lock);
+   m_objects.erase(getKey(name, core_id));
+}
+
+void
+CheckpointManager::init()
+{
+   String load_filename = Sim()->getCfg()->getString("checkpoint/load");
+   if (load_filename != "")
+      load(load_filename);
+
+   if (Sim()->getCfg()->getString("checkpoint/save") != "")
+   {
+      // Without barriers, other cores keep modifying their caches and predictors while they are being saved
+      if (!Sim()->getConfig()->getEnableSync())
+         LOG_PRINT_ERROR("checkpoint/save requires all cores to stop at periodic barriers, clock_skew_minimization/scheme cannot be none");
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, CheckpointManager::hookPeriodic, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, CheckpointManager::hookSimEnd, (UInt64)this);
+
+      String save_at = Sim()->getCfg()->getString("checkpoint/save_at");
+      if (save_at == "roi-begin")
+      {
+         m_save_at = SAVE_ROI_BEGIN;
+         Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, CheckpointManager::hookRoiBegin, (UInt64)this);
+      }
+      else if (save_at == "marker")
+      {
+         m_save_at = SAVE_MARKER;
+         m_save_marker = Sim()->getCfg()->getInt("checkpoint/save_marker");
+         Sim()->getHooksManager()->registerHook(HookType::HOOK_MAGIC_MARKER, CheckpointManager::hookMagicMarker, (UInt64)this);
+      }
+      else
+         LOG_PRINT_ERROR("Invalid value for checkpoint/save_at: %s, should be roi-begin or marker", save_at.c_str());
+   }
+}
+
+SInt64
+CheckpointManager::hookMagicMarker(UInt64 object, UInt64 argument)
+{
+   CheckpointManager *manager = (CheckpointManager*)object;
+   MagicServer::MagicMarkerType *marker = (MagicServer::MagicMarkerType*)argument;
+   if (marker->arg0 == manager->m_save_marker)
+      manager->requestSave();
+   return 0;
+}
+
+SInt64
+CheckpointManager::hookSimEnd(UInt64 object, UInt64 argument)
+{
+   CheckpointManager *manager = (CheckpointManager*)object;
+   if (manager->m_save_pending)
+      LOG_PRINT_WARNING("No periodic barrier was reached after checkpoint/save_at, checkpoint %s was not saved",
+                        Sim()->getCfg()->getString("checkpoint/save").c_str());
+   return 0;
+}
+
+void
+CheckpointManager::requestSave()
+{
+   ScopedLock sl(m_lock);
+   if (!m_saved)
+      m_save_pending = true;
+}
+
+void
+CheckpointManager::savePending()
+{
+   {
+      ScopedLock sl(m_lock);
+      if (!m_save_pending)
+         return;
+      m_save_pending = false;
+      m_saved = true;
+   }
+   save(Sim()->getConfig()->formatOutputFileName(Sim()->getCfg()->getString("checkpoint/save")));
+}
+
+void
+CheckpointManager::save(String filename)
+{
+   ScopedLock sl(m_lock);
+
+   // Only called from HOOK_PERIODIC, all cores are stopped at the barrier so no object changes while it is saved
+   CheckpointWriter writer(filename);
+   for(std::map<String, Checkpointable*>::iterator it = m_objects.begin(); it != m_objects.end(); ++it)
+   {
+      writer.beginSection(it->first);
+      it->second->saveState(writer);
+      writer.endSection();
+   }
+
+   printf("[SNIPER] Saved checkpoint of %d objects to %s\n", (int)m_objects.size(), filename.c_str());
+}
+
+void
+CheckpointManager::load(String filename)
+{
+   ScopedLock sl(m_lock);
+
+   CheckpointReader reader(filename);
+   UInt32 num_missing = 0;
+   for(std::map<String, Checkpointable*>::iterator it = m_objects.begin(); it != m_objects.end(); ++it)
+   {
+      CheckpointReader::Section section;
+      if (!reader.getSection(it->first, section))
+      {
+         LOG_PRINT_WARNING("Checkpoint %s has no state for %s, it will start cold", filename.c_str(), it->first.c_str());
+         ++num_missing;
+         continue;
+      }
+      it->second->loadState(section);
+      LOG_ASSERT_ERROR(section.done(), "Checkpoint %s: state for %s was not fully restored, was the checkpoint made with a different configuration?", filename.c_str(), it->first.c_str());
+   }
+
+   printf("[SNIPER] Restored %d objects from checkpoint %s (%d missing, %d unused)\n",
+      (int)m_objects.size() - num_missing, filename.c_str(), num_missing, reader.getNumSections() - ((int)m_objects.size() - num_missing));
+}
@@ -0,0 +1,60 @@
+#ifndef CHECKPOINT_MANAGER_H
+#define CHECKPOINT_MANAGER_H
+
+#include "fixed_types.h"
+#include "checkpoint.h"
+#include "lock.h"
+
+#include <map>
+
+// Saves the warm microarchitectural state of all registered objects at checkpoint/save_at (ROI begin or a
+// magic marker) into checkpoint/save, and restores it from checkpoint/load at the end of startup, so that
+// detailed simulation can start warm without fast-forwarding through the warmup region.
+// Saving is deferred to the first periodic barrier after save_at, where all cores are stopped, so that the
+// checkpoint is a consistent snapshot.
+// Checkpoints can only be restored into an identical configuration of the checkpointed structures.
+class CheckpointManager
+{
+   public:
+      CheckpointManager();
+      ~CheckpointManager();
+
+      // Objects are identified by name and core, this must be the same between saving and restoring runs
+      void registerObject(String name, core_id_t core_id, Checkpointable *object);
+      void unregisterObject(String name, core_id_t core_id);
+
+      // Called once all objects have been created
+      void init();
+
+      // Must be called while all cores are stopped
+      void save(String filename);
+      void load(String filename);
+
+   private:
+      enum save_at_t
+      {
+         SAVE_NEVER,
+         SAVE_ROI_BEGIN,
+         SAVE_MARKER,
+      };
+
+      std::map<String, Checkpointable*> m_objects;
+      Lock m_lock;
+      save_at_t m_save_at;
+      UInt64 m_save_marker;
+      bool m_save_pending;
+      bool m_saved;
+
+      static String getKey(String name, core_id_t core_id);
+
+      void requestSave();
+      void savePending();
+      static SInt64 hookRoiBegin(UInt64 object, UInt64 argument)
+      { ((CheckpointManager*)object)->requestSave(); return 0; }
+      static SInt64 hookMagicMarker(UInt64 object, UInt64 argument);
+      static SInt64 hookPeriodic(UInt64 object, UInt64 argument)
+      { ((CheckpointManager*)object)->savePending(); return 0; }
+      static SInt64 hookSimEnd(UInt64 object, UInt64 argument);
+};
+
+#endif // CHECKPOINT_MANAGER_H
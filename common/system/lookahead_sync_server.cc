@@ -0,0 +1,198 @@
+#include "lookahead_sync_server.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "core.h"
+#include "thread.h"
+#include "thread_manager.h"
+#include "performance_model.h"
+#include "hooks_manager.h"
+#include "dvfs_manager.h"
+#include "config.h"
+#include "log.h"
+#include "stats.h"
+#include "config.hpp"
+#include "circular_log.h"
+
+// m_floor and m_next_barrier_time are only written with the thread manager lock held,
+// but are read without it on the fast path of synchronize()
+static SubsecondTime loadTime(const SubsecondTime &time)
+{
+   SubsecondTime value;
+   __atomic_load(&time, &value, __ATOMIC_RELAXED);
+   return value;
+}
+
+LookaheadSyncServer::LookaheadSyncServer()
+   : BarrierSyncServer()
+   , m_lookahead(Sim()->getConfig()->getApplicationCores(), SubsecondTime::Zero())
+   , m_max_lookahead(SubsecondTime::Zero())
+   , m_periodic_interval(SubsecondTime::NS() * (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lookahead/periodic"))
+   , m_floor(SubsecondTime::Zero())
+   , m_num_waiting(0)
+   , m_syncs_fast(0)
+   , m_syncs_slow(0)
+   , m_waits(0)
+{
+   m_barrier_interval = SubsecondTime::NS() * (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lookahead/quantum");
+   LOG_ASSERT_ERROR(m_periodic_interval > SubsecondTime::Zero() && m_periodic_interval.getFS() % m_barrier_interval.getFS() == 0,
+                    "clock_skew_minimization/lookahead/periodic must be a multiple of clock_skew_minimization/lookahead/quantum");
+   m_next_barrier_time = m_periodic_interval;
+
+   SubsecondTime lookahead = SubsecondTime::NS() * (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lookahead/lookahead");
+   for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
+   {
+      m_lookahead[core_id] = lookahead > SubsecondTime::Zero() ? lookahead : deriveLookahead(core_id);
+      m_max_lookahead = std::max(m_max_lookahead, m_lookahead[core_id]);
+   }
+
+   registerStatsMetric("lookahead", 0, "syncs-fast", &m_syncs_fast);
+   registerStatsMetric("lookahead", 0, "syncs-slow", &m_syncs_slow);
+   registerStatsMetric("lookahead", 0, "waits", &m_waits);
+   registerStatsMetric("lookahead", 0, "max-lookahead", &m_max_lookahead);
+}
+
+LookaheadSyncServer::~LookaheadSyncServer()
+{
+}
+
+SubsecondTime
+LookaheadSyncServer::deriveLookahead(core_id_t core_id)
+{
+   // Another core can only affect this one through the memory subsystem: its request travels to a
+   // directory, which then sends an invalidation or reply to us. Take one hop each way (the closest
+   // possible other core) and the directory access, in cycles of this core's clock.
+   String network_type = Sim()->getCfg()->getString("network/memory_model_1");
+   UInt64 hop_cycles = 0;
+   if (network_type == "emesh_hop_counter" || network_type == "emesh_hop_by_hop")
+      hop_cycles = Sim()->getCfg()->getInt("network/" + network_type + "/hop_latency");
+   else if (network_type == "emesh_parallel")
+      hop_cycles = Sim()->getCfg()->getInt("network/emesh_hop_by_hop/hop_latency");
+   UInt64 directory_cycles = Sim()->getCfg()->getInt("perf_model/dram_directory/directory_cache_access_time");
+
+   return ComponentLatency(Sim()->getDvfsManager()->getCoreDomain(core_id), 2 * hop_cycles + directory_cycles).getLatency();
+}
+
+void
+LookaheadSyncServer::synchronize(core_id_t core_id, SubsecondTime time)
+{
+   if (m_fastforward)
+   {
+      BarrierSyncServer::synchronize(core_id, time);
+      return;
+   }
+
+   core_id_t master_core_id = m_core_group[core_id] == INVALID_CORE_ID ? core_id : m_core_group[core_id];
+
+   // Without the lock: we are inside our window (which ends at the next periodic barrier at the latest),
+   // and nobody is waiting to be woken up
+   if (time < loadTime(m_floor) + m_barrier_interval + m_lookahead[master_core_id]
+       && time < loadTime(m_next_barrier_time)
+       && __atomic_load_n(&m_num_waiting, __ATOMIC_RELAXED) == 0)
+   {
+      __atomic_fetch_add(&m_syncs_fast, 1, __ATOMIC_RELAXED);
+      return;
+   }
+
+   ScopedLock sl(Sim()->getThreadManager()->getLock());
+   if (m_disable || m_fastforward)
+      return;
+
+   Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+   thread_id_t thread_me = core->getThread()->getId();
+
+   CLOG("lookahead", "Core %d entry (master core %d, thread %d) at %" PRId64 "ns, floor %" PRId64 "ns", core_id, master_core_id, thread_me, time.getNS(), m_floor.getNS());
+   LOG_ASSERT_ERROR(m_barrier_acquire_list[master_core_id] == false, "Core(%i) or its sibling is already waiting (this is thread %d, we have thread %d)", master_core_id, thread_me, m_core_thread[master_core_id]);
+
+   ++m_syncs_slow;
+
+   SubsecondTime prev_time = m_local_clock_list[master_core_id];
+   m_local_clock_list[master_core_id] = time;
+   m_core_thread[master_core_id] = thread_me;
+
+   // Only the core(s) at the floor can move it up, others just need to wake up waiters
+   if (prev_time <= m_floor || m_num_waiting)
+      update(thread_me);
+
+   if (m_disable || time < getWindow(master_core_id))
+      return;
+
+   // Our lookahead is exhausted, or we reached the periodic barrier: wait for the slowest cores to catch up
+   CLOG("lookahead", "Core %d waits", core_id);
+   ++m_waits;
+   doRelease(1);
+   core->getPerformanceModel()->barrierEnter();
+   m_barrier_acquire_list[master_core_id] = true;
+   __atomic_fetch_add(&m_num_waiting, 1, __ATOMIC_RELAXED);
+
+   m_core_cond[master_core_id]->wait(Sim()->getThreadManager()->getLock());
+
+   CLOG("lookahead", "Core %d exit (master core %d, thread %d)", core_id, master_core_id, thread_me);
+}
+
+void
+LookaheadSyncServer::update(thread_id_t caller_id)
+{
+   // New floor: the lowest clock of all running cores (group masters only)
+   SubsecondTime floor = SubsecondTime::MaxTime();
+   for (core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+   {
+      if (m_core_group[core_id] == INVALID_CORE_ID && isCoreRunning(core_id))
+         floor = std::min(floor, m_local_clock_list[core_id]);
+   }
+   // When no core is running, ThreadManager will call advance()
+   if (floor != SubsecondTime::MaxTime() && floor > m_floor)
+      __atomic_store(&m_floor, &floor, __ATOMIC_RELAXED);
+
+   // All running cores have reached the periodic barrier, and as no core may pass it, they are all waiting
+   // for us (or, for the caller, checking in): the hooks see every core stopped, as with BarrierSyncServer
+   while (m_floor >= m_next_barrier_time)
+   {
+      m_global_time = m_next_barrier_time;
+      CLOG("lookahead", "Periodic %" PRId64 "ns", m_next_barrier_time.getNS());
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC, static_cast<subsecond_time_t>(m_next_barrier_time).m_time);
+
+      // If the barrier was disabled from HOOK_PERIODIC (for instance, if roi-end was triggered from a script), stop here
+      if (m_disable)
+         return;
+
+      SubsecondTime next_barrier_time = m_next_barrier_time + m_periodic_interval;
+      __atomic_store(&m_next_barrier_time, &next_barrier_time, __ATOMIC_RELAXED);
+   }
+
+   // Wake up cores that are inside their window again
+   for (core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+   {
+      if (m_barrier_acquire_list[core_id] && m_local_clock_list[core_id] < getWindow(core_id))
+      {
+         m_barrier_acquire_list[core_id] = false;
+         __atomic_fetch_sub(&m_num_waiting, 1, __ATOMIC_RELAXED);
+
+         LOG_ASSERT_ERROR(m_core_thread[core_id] != caller_id, "Thread %d is waiting and calling", caller_id);
+         Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+         core->getPerformanceModel()->barrierExit();
+         m_to_release.push_back(core_id);
+      }
+   }
+
+   doRelease(Sim()->getConfig()->getNumHostCores());
+}
+
+void
+LookaheadSyncServer::abortBarrier()
+{
+   BarrierSyncServer::abortBarrier();
+   __atomic_store_n(&m_num_waiting, 0, __ATOMIC_RELAXED);
+}
+
+void
+LookaheadSyncServer::signal()
+{
+   if (m_disable || m_fastforward)
+   {
+      BarrierSyncServer::signal();
+      return;
+   }
+
+   // A core stopped running, which may raise the floor
+   update(INVALID_THREAD_ID);
+}
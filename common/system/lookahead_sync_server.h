@@ -0,0 +1,45 @@
+#ifndef __LOOKAHEAD_SYNC_SERVER_H__
+#define __LOOKAHEAD_SYNC_SERVER_H__
+
+#include "clock_skew_minimization_object.h"
+#include "barrier_sync_server.h"
+
+// Clock skew minimization with per-core lookahead
+//
+// The barrier stops every core at each quantum boundary until the slowest core has arrived there.
+// Here, cores only wait when they get more than one quantum plus their lookahead ahead of the slowest
+// running core (the floor). The lookahead is the minimum time it takes another core to affect this one
+// (a request and its reply over the memory network, plus a directory access) unless configured explicitly.
+// Cores of similar speed therefore never block, only cores that run away from a bottleneck do.
+//
+// HOOK_PERIODIC subscribers (schedulers, sampling, statistics) expect all cores to be stopped, so every
+// periodic interval (a multiple of the quantum) the cores still meet at a full barrier, where the hooks
+// are called. Fast-forward mode uses the plain barrier.
+class LookaheadSyncServer : public BarrierSyncServer
+{
+   private:
+      std::vector<SubsecondTime> m_lookahead;
+      SubsecondTime m_max_lookahead;
+      SubsecondTime m_periodic_interval;
+      SubsecondTime m_floor;        //< Lowest clock of all running cores, as of their last check-in
+      UInt32 m_num_waiting;
+
+      UInt64 m_syncs_fast;          //< Check-ins that did not need the lock
+      UInt64 m_syncs_slow;
+      UInt64 m_waits;               //< Check-ins that exhausted their lookahead window
+
+      SubsecondTime deriveLookahead(core_id_t core_id);
+      // No core passes the next periodic barrier (m_next_barrier_time) before all have reached it
+      SubsecondTime getWindow(core_id_t core_id) const { return std::min(m_floor + m_barrier_interval + m_lookahead[core_id], m_next_barrier_time); }
+      void update(thread_id_t caller_id);
+      void signal();
+      void abortBarrier();
+
+   public:
+      LookaheadSyncServer();
+      ~LookaheadSyncServer();
+
+      void synchronize(core_id_t core_id, SubsecondTime time);
+};
+
+#endif /* __LOOKAHEAD_SYNC_SERVER_H__ */
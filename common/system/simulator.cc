@@ -27,6 +27,8 @@
 #include "instruction_tracer.h"
 #include "memory_tracker.h"
 #include "circular_log.h"
+#include "checkpoint_manager.h"
+#include "stats_sampler.h"
 
 #include <sstream>
 
@@ -122,6 +124,8 @@ Simulator::Simulator()
    , m_faultinjection_manager(NULL)
    , m_rtn_tracer(NULL)
    , m_memory_tracker(NULL)
+   , m_checkpoint_manager(new CheckpointManager())
+   , m_stats_sampler(NULL)
    , m_running(false)
    , m_inst_mode_output(true)
 {
@@ -202,6 +206,11 @@ void Simulator::start()
 // PIN_SpawnInternalThread doesn't schedule its threads until after PIN_StartProgram
 //   m_transport->barrier();
 
+   // All checkpointable objects exist by now, restore their state before simulation starts
+   m_checkpoint_manager->init();
+   // All statistics are registered by now as well
+   m_stats_sampler = StatsSampler::create();
+
    m_hooks_manager->callHooks(HookType::HOOK_SIM_START, 0);
    m_stats_manager->recordStats("start");
    if (Sim()->getFastForwardPerformanceManager())
@@ -258,6 +267,10 @@ Simulator::~Simulator()
    // Don't remove the trace manager as threads could still be alive even if they are done
    //delete m_trace_manager;             m_trace_manager = NULL;
    delete m_sampling_manager;          m_sampling_manager = NULL;
+   if (m_stats_sampler)
+   {
+      delete m_stats_sampler;          m_stats_sampler = NULL;
+   }
    if (m_faultinjection_manager)
    {
       delete m_faultinjection_manager; m_faultinjection_manager = NULL;
@@ -267,6 +280,7 @@ Simulator::~Simulator()
    //delete m_thread_manager;            m_thread_manager = NULL;
    delete m_thread_stats_manager;      m_thread_stats_manager = NULL;
    delete m_core_manager;              m_core_manager = NULL;
+   delete m_checkpoint_manager;        m_checkpoint_manager = NULL;
    delete m_dvfs_manager;              m_dvfs_manager = NULL;
    delete m_magic_server;              m_magic_server = NULL;
    delete m_sync_server;               m_sync_server = NULL;
@@ -29,6 +29,8 @@ class FaultinjectionManager;
 class TagsManager;
 class RoutineTracer;
 class MemoryTracker;
+class CheckpointManager;
+class StatsSampler;
 namespace config { class Config; }
 
 class Simulator
@@ -75,6 +77,8 @@ public:
    TagsManager *getTagsManager() { return m_tags_manager; }
    RoutineTracer *getRoutineTracer() { return m_rtn_tracer; }
    MemoryTracker *getMemoryTracker() { return m_memory_tracker; }
+   CheckpointManager *getCheckpointManager() { return m_checkpoint_manager; }
+   StatsSampler *getStatsSampler() { return m_stats_sampler; }
    void setMemoryTracker(MemoryTracker *memory_tracker) { m_memory_tracker = memory_tracker; }
 
    bool isRunning() { return m_running; }
@@ -112,6 +116,8 @@ private:
    FaultinjectionManager *m_faultinjection_manager;
    RoutineTracer *m_rtn_tracer;
    MemoryTracker *m_memory_tracker;
+   CheckpointManager *m_checkpoint_manager;
+   StatsSampler *m_stats_sampler;
 
    bool m_running;
    bool m_inst_mode_output;
@@ -0,0 +1,252 @@
+#include "stats_sampler.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "clock_skew_minimization_object.h"
+#include "stats.h"
+#include "timer.h"
+#include "config.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+// File layout (little endian):
+//   char magic[8] = "SNIPSMPL", UInt32 version, UInt32 num_columns, UInt64 interval (fs)
+//   num_columns times: UInt32 index (core), UInt32 length, char name[length] ("object.metric")
+//   records until the end of the file: varint time delta (fs), num_columns times zigzag varint value delta
+// The first record holds the time and values since zero, so running sums give absolute values.
+static const char sampler_magic[8] = { 'S', 'N', 'I', 'P', 'S', 'M', 'P', 'L' };
+static const UInt32 sampler_version = 1;
+
+static void putVarint(std::vector<UInt8> &buffer, UInt64 value)
+{
+   while (value >= 0x80)
+   {
+      buffer.push_back(value | 0x80);
+      value >>= 7;
+   }
+   buffer.push_back(value);
+}
+
+StatsSampler *
+StatsSampler::create()
+{
+   if (Sim()->getCfg()->getBool("stats/sampler/enabled"))
+      return new StatsSampler();
+   else
+      return NULL;
+}
+
+StatsSampler::StatsSampler()
+   : m_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("stats/sampler/interval")))
+   , m_roi_only(Sim()->getCfg()->getBool("stats/sampler/roi_only"))
+   , m_last_time(SubsecondTime::Zero())
+   , m_next_time(SubsecondTime::Zero())
+   , m_enabled(false)
+   , m_ring_records(Sim()->getCfg()->getInt("stats/sampler/ring_size"))
+   , m_head(0)
+   , m_tail(0)
+   , m_stop(false)
+   , m_running(false)
+   , m_thread(NULL)
+   , m_samples(0)
+   , m_stall_time(0)
+{
+   LOG_ASSERT_ERROR(m_interval > SubsecondTime::Zero(), "stats/sampler/interval must be positive");
+   LOG_ASSERT_ERROR(m_ring_records >= 4, "stats/sampler/ring_size must be at least 4");
+
+   // Metrics are given as object.metric, separated by spaces or commas, and are sampled for all indices
+   String names = Sim()->getCfg()->getString("stats/sampler/metrics");
+   std::string list(names.c_str());
+   std::replace(list.begin(), list.end(), ',', ' ');
+   std::istringstream iss(list);
+   std::string name;
+   std::vector<String> column_names;
+   while (iss >> name)
+   {
+      size_t dot = name.find('.');
+      LOG_ASSERT_ERROR(dot != std::string::npos, "Invalid metric %s in stats/sampler/metrics, should be object.metric", name.c_str());
+      std::vector<StatsMetricBase *> metrics = Sim()->getStatsManager()->getMetricObjects(name.substr(0, dot).c_str(), name.substr(dot + 1).c_str());
+      if (metrics.empty())
+         LOG_PRINT_WARNING("Statistic %s does not exist, not sampling it", name.c_str());
+      for(std::vector<StatsMetricBase *>::iterator it = metrics.begin(); it != metrics.end(); ++it)
+      {
+         m_metrics.push_back(*it);
+         column_names.push_back(name.c_str());
+      }
+   }
+   m_last_values.resize(m_metrics.size(), 0);
+
+   m_stride = 1 + m_metrics.size();
+   m_ring.resize(UInt64(m_ring_records) * m_stride);
+   m_buffer.reserve(UInt64(m_ring_records) * m_stride * 10);
+
+   String filename = Sim()->getConfig()->formatOutputFileName("sim.stats.periodic");
+   m_fp = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(m_fp, "Cannot create %s", filename.c_str());
+   UInt32 num_columns = m_metrics.size();
+   UInt64 interval = m_interval.getFS();
+   fwrite(sampler_magic, sizeof(sampler_magic), 1, m_fp);
+   fwrite(&sampler_version, sizeof(sampler_version), 1, m_fp);
+   fwrite(&num_columns, sizeof(num_columns), 1, m_fp);
+   fwrite(&interval, sizeof(interval), 1, m_fp);
+   for(UInt32 i = 0; i < num_columns; ++i)
+   {
+      UInt32 index = m_metrics[i]->index, length = column_names[i].size();
+      fwrite(&index, sizeof(index), 1, m_fp);
+      fwrite(&length, sizeof(length), 1, m_fp);
+      fwrite(column_names[i].c_str(), length, 1, m_fp);
+   }
+
+   registerStatsMetric("stats", 0, "sampler-samples", &m_samples);
+   registerStatsMetric("stats", 0, "sampler-stall-time", &m_stall_time);
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, StatsSampler::hook_periodic, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, StatsSampler::hook_roi_begin, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, StatsSampler::hook_roi_end, (UInt64)this);
+
+   m_running = true;
+   m_thread = _Thread::create(this);
+   m_thread->run();
+
+   if (!m_roi_only)
+   {
+      ScopedLock sl(m_sample_lock);
+      m_enabled = true;
+      sample(SubsecondTime::Zero());
+   }
+}
+
+StatsSampler::~StatsSampler()
+{
+   {
+      ScopedLock sl(m_ring_lock);
+      m_stop = true;
+      m_ring_cond.broadcast();
+      while (m_running)
+         m_ring_cond.wait(m_ring_lock);
+   }
+   delete m_thread;
+   fclose(m_fp);
+}
+
+void
+StatsSampler::periodic(SubsecondTime time)
+{
+   if (!m_enabled || time < m_next_time)
+      return;
+
+   ScopedLock sl(m_sample_lock);
+   if (m_enabled && time >= m_next_time)
+      sample(time);
+}
+
+void
+StatsSampler::roiBegin()
+{
+   if (!m_roi_only)
+      return;
+
+   ScopedLock sl(m_sample_lock);
+   m_enabled = true;
+   sample(Sim()->getClockSkewMinimizationServer()->getGlobalTime());
+}
+
+void
+StatsSampler::roiEnd()
+{
+   ScopedLock sl(m_sample_lock);
+   if (!m_enabled)
+      return;
+
+   sample(Sim()->getClockSkewMinimizationServer()->getGlobalTime());
+   if (m_roi_only)
+      m_enabled = false;
+}
+
+void
+StatsSampler::sample(SubsecondTime time)
+{
+   // Periodic callbacks come at barrier granularity, sample at the first one at or after the interval
+   if (time < m_last_time)
+      time = m_last_time;
+   m_next_time = time + m_interval;
+
+   // Allow lazily-maintained statistics to be updated, as before writing a snapshot
+   Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)"stats-sampler");
+
+   const UInt64 tail = m_tail;
+   {
+      ScopedLock sl(m_ring_lock);
+      if (tail - m_head == m_ring_records)
+      {
+         UInt64 stall_start = Timer::monotonic();
+         while (tail - m_head == m_ring_records)
+            m_ring_cond.wait(m_ring_lock);
+         m_stall_time += Timer::monotonic() - stall_start;
+      }
+   }
+
+   // The writer does not touch records at or beyond m_tail, so no lock is needed while filling this one
+   UInt64 *record = &m_ring[(tail % m_ring_records) * m_stride];
+   record[0] = (time - m_last_time).getFS();
+   m_last_time = time;
+   for(UInt32 i = 0; i < m_metrics.size(); ++i)
+   {
+      UInt64 value = m_metrics[i]->recordMetric();
+      record[1 + i] = value - m_last_values[i];
+      m_last_values[i] = value;
+   }
+
+   ++m_samples;
+
+   ScopedLock sl(m_ring_lock);
+   m_tail = tail + 1;
+   // Wake up the writer once per batch rather than for every record
+   if (m_tail - m_head >= m_ring_records / 4)
+      m_ring_cond.broadcast();
+}
+
+void
+StatsSampler::run()
+{
+   ScopedLock sl(m_ring_lock);
+   while (true)
+   {
+      if (m_tail - m_head >= m_ring_records / 4 || (m_stop && m_tail != m_head))
+      {
+         UInt64 first = m_head, last = m_tail;
+
+         m_ring_lock.release();
+         writeRecords(first, last);
+         m_ring_lock.acquire();
+
+         m_head = last;
+         m_ring_cond.broadcast();
+      }
+      else if (m_stop)
+         break;
+      else
+         m_ring_cond.wait(m_ring_lock);
+   }
+   m_running = false;
+   m_ring_cond.broadcast();
+}
+
+void
+StatsSampler::writeRecords(UInt64 first, UInt64 last)
+{
+   m_buffer.clear();
+   for(UInt64 r = first; r < last; ++r)
+   {
+      const UInt64 *record = &m_ring[(r % m_ring_records) * m_stride];
+      putVarint(m_buffer, record[0]);
+      // Most metrics only grow, but some (e.g. occupancy gauges) can go down: zigzag-encode deltas as signed
+      for(UInt32 i = 1; i < m_stride; ++i)
+      {
+         SInt64 delta = record[i];
+         putVarint(m_buffer, (UInt64(delta) << 1) ^ UInt64(delta >> 63));
+      }
+   }
+   fwrite(m_buffer.data(), 1, m_buffer.size(), m_fp);
+   fflush(m_fp);
+}
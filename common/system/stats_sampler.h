@@ -0,0 +1,68 @@
+#ifndef STATS_SAMPLER_H
+#define STATS_SAMPLER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "_thread.h"
+#include "lock.h"
+#include "cond.h"
+
+#include <cstdio>
+#include <vector>
+
+class StatsMetricBase;
+
+// Native periodic statistics sampler: every stats/sampler/interval nanoseconds (on HOOK_PERIODIC, so at barrier
+// granularity), read the configured metrics for all cores and append their deltas to a preallocated ring.
+// A background thread encodes the ring contents as variable-length integers into sim.stats.periodic,
+// to be read with tools/sniper_periodic.py. This replaces Python periodic-stats scripts for fine-grained traces.
+class StatsSampler : public Runnable
+{
+   public:
+      static StatsSampler* create();
+
+      StatsSampler();
+      ~StatsSampler();
+
+   private:
+      const SubsecondTime m_interval;
+      const bool m_roi_only;
+      std::vector<StatsMetricBase *> m_metrics;
+      std::vector<UInt64> m_last_values;   //< Values at the previous sample
+      SubsecondTime m_last_time;
+      SubsecondTime m_next_time;
+      bool m_enabled;
+      Lock m_sample_lock;                  //< Samples are taken from HOOK_PERIODIC and the ROI hooks
+
+      // Ring of records: time delta followed by one delta per metric. The sampling side owns
+      // [m_tail, m_head + size), the writer [m_head, m_tail), both indices only grow.
+      const UInt32 m_ring_records;
+      UInt32 m_stride;
+      std::vector<UInt64> m_ring;
+      UInt64 m_head, m_tail;
+      Lock m_ring_lock;
+      ConditionVariable m_ring_cond;       //< Signaled when a batch is ready, or when the writer freed space
+      bool m_stop;
+      bool m_running;
+      _Thread *m_thread;
+
+      FILE *m_fp;
+      std::vector<UInt8> m_buffer;
+
+      UInt64 m_samples;
+      UInt64 m_stall_time;                 //< Wall-clock time (ns) spent waiting for a full ring
+
+      void sample(SubsecondTime time);
+      void periodic(SubsecondTime time);
+      void roiBegin();
+      void roiEnd();
+
+      void run();
+      void writeRecords(UInt64 first, UInt64 last);
+
+      static SInt64 hook_periodic(UInt64 self, UInt64 time) { ((StatsSampler*)self)->periodic(*(subsecond_time_t*)&time); return 0; }
+      static SInt64 hook_roi_begin(UInt64 self, UInt64) { ((StatsSampler*)self)->roiBegin(); return 0; }
+      static SInt64 hook_roi_end(UInt64 self, UInt64) { ((StatsSampler*)self)->roiEnd(); return 0; }
+};
+
+#endif // STATS_SAMPLER_H
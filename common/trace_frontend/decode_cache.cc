@@ -0,0 +1,168 @@
+#include "decode_cache.h"
+#include "simulator.h"
+#include "instruction.h"
+#include "stats.h"
+#include "log.h"
+
+#include <cstring>
+
+DecodeCache::DecodeCache(UInt32 index)
+   : m_shards(NUM_SHARDS)
+   , m_epoch(0)
+   , m_hits(0)
+   , m_shared_hits(0)
+   , m_misses(0)
+   , m_invalidations(0)
+   , m_entries(0)
+   , m_instructions(0)
+   , m_retired_entries(0)
+   , m_bytes(0)
+{
+   registerStatsMetric("decode-cache", index, "hits", &m_hits);
+   registerStatsMetric("decode-cache", index, "shared-hits", &m_shared_hits);
+   registerStatsMetric("decode-cache", index, "misses", &m_misses);
+   registerStatsMetric("decode-cache", index, "invalidations", &m_invalidations);
+   registerStatsMetric("decode-cache", index, "entries", &m_entries);
+   registerStatsMetric("decode-cache", index, "instructions", &m_instructions);
+   registerStatsMetric("decode-cache", index, "retired", &m_retired_entries);
+   registerStatsMetric("decode-cache", index, "bytes", &m_bytes);
+}
+
+DecodeCache::~DecodeCache()
+{
+   for(auto shard = m_shards.begin(); shard != m_shards.end(); ++shard)
+      for(auto it = shard->entries.begin(); it != shard->entries.end(); ++it)
+         deleteEntry(it->second);
+   for(auto it = m_retired.begin(); it != m_retired.end(); ++it)
+      deleteEntry(*it);
+}
+
+void DecodeCache::deleteEntry(Entry *entry)
+{
+   delete entry->instruction;
+   delete entry->dec_inst;
+   delete entry;
+}
+
+DecodeCache::Entry* DecodeCache::lookup(const Sift::Instruction &inst)
+{
+   IntPtr addr = inst.sinst->addr;
+   Shard &shard = getShard(addr);
+   ScopedLock sl(shard.lock);
+
+   // Missing pages are at generation zero, no need to insert them here
+   auto gen = shard.generations.find(addr & Sift::ICACHE_PAGE_MASK);
+   Key key = { addr, inst.isa, gen == shard.generations.end() ? 0 : gen->second };
+
+   auto it = shard.entries.find(key);
+   if (it != shard.entries.end())
+   {
+      __atomic_fetch_add(&m_shared_hits, 1, __ATOMIC_RELAXED);
+      return it->second;
+   }
+
+   // Decode while holding the shard lock: threads that miss on the same code at the same time
+   // (e.g. all threads entering a parallel region) wait for one decode rather than each doing their own
+   Entry *entry = new Entry();
+   entry->addr = addr;
+   entry->isa = inst.isa;
+   entry->generation = key.generation;
+   LOG_ASSERT_ERROR(inst.sinst->size <= sizeof(entry->code), "Instruction size %d too large", inst.sinst->size);
+   memcpy(entry->code, inst.sinst->data, inst.sinst->size);
+   dl::DecodedInst *dec_inst = m_factory.CreateInstruction(Sim()->getDecoder(), entry->code, inst.sinst->size, addr);
+   Sim()->getDecoder()->decode(dec_inst, (dl::dl_isa)inst.isa);
+   entry->dec_inst = dec_inst;
+   entry->instruction = NULL;
+
+   shard.entries[key] = entry;
+
+   __atomic_fetch_add(&m_misses, 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&m_entries, 1, __ATOMIC_RELAXED);
+   // Bookkeeping only, the decoder's own representation is not included
+   __atomic_fetch_add(&m_bytes, sizeof(Entry) + sizeof(Key) + 2 * sizeof(void*), __ATOMIC_RELAXED);
+
+   return entry;
+}
+
+Instruction* DecodeCache::setInstruction(Entry *entry, Instruction *instruction)
+{
+   Instruction *expected = NULL;
+   if (__atomic_compare_exchange_n(&entry->instruction, &expected, instruction, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+   {
+      __atomic_fetch_add(&m_instructions, 1, __ATOMIC_RELAXED);
+      return instruction;
+   }
+   else
+   {
+      delete instruction;
+      return expected;
+   }
+}
+
+void DecodeCache::invalidate(IntPtr page)
+{
+   std::vector<Entry*> retired;
+   {
+      Shard &shard = getShard(page);
+      ScopedLock sl(shard.lock);
+
+      // New lookups will no longer find the old entries, even while we are still removing them
+      ++shard.generations[page];
+
+      for(auto it = shard.entries.begin(); it != shard.entries.end(); )
+      {
+         if ((it->first.addr & Sift::ICACHE_PAGE_MASK) == page)
+         {
+            retired.push_back(it->second);
+            it = shard.entries.erase(it);
+         }
+         else
+            ++it;
+      }
+   }
+
+   __atomic_fetch_add(&m_epoch, 1, __ATOMIC_RELEASE);
+   __atomic_fetch_add(&m_invalidations, 1, __ATOMIC_RELAXED);
+
+   if (retired.size())
+   {
+      // Other threads may still hold pointers to these (in their Front or in in-flight dynamic instructions)
+      ScopedLock sl(m_retired_lock);
+      m_retired.insert(m_retired.end(), retired.begin(), retired.end());
+      __atomic_fetch_sub(&m_entries, retired.size(), __ATOMIC_RELAXED);
+      __atomic_fetch_add(&m_retired_entries, retired.size(), __ATOMIC_RELAXED);
+   }
+}
+
+
+DecodeCache::Front::Front(DecodeCache *cache)
+   : m_cache(cache)
+   , m_slots(NUM_SLOTS, NULL)
+   , m_epoch(__atomic_load_n(&cache->m_epoch, __ATOMIC_ACQUIRE))
+   , m_hits(0)
+{
+}
+
+DecodeCache::Front::~Front()
+{
+   publish();
+}
+
+void DecodeCache::Front::reset()
+{
+   m_epoch = __atomic_load_n(&m_cache->m_epoch, __ATOMIC_ACQUIRE);
+   std::fill(m_slots.begin(), m_slots.end(), (Entry*)NULL);
+}
+
+void DecodeCache::Front::publish()
+{
+   // Hits are counted locally so the hot path does not share a cache line with other threads
+   __atomic_fetch_add(&m_cache->m_hits, m_hits, __ATOMIC_RELAXED);
+   m_hits = 0;
+}
+
+void DecodeCache::Front::invalidate(IntPtr page)
+{
+   m_cache->invalidate(page);
+   reset();
+}
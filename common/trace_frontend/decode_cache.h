@@ -0,0 +1,130 @@
+#ifndef __DECODE_CACHE_H
+#define __DECODE_CACHE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "sift_reader.h"
+
+#include <decoder.h>
+
+#include <unordered_map>
+#include <vector>
+
+class Instruction;
+
+// Decoded instructions shared by all trace threads of an application
+//
+// Entries are keyed by (address, ISA, code page generation). Invalidating a page bumps its generation,
+// which makes the old entries unreachable; they are kept alive (retired) until the cache is destroyed
+// since other threads may still be using them. Lookups normally go through a per-thread Front, a small
+// direct-mapped table that needs no locking and is reset whenever any page is invalidated.
+
+class DecodeCache
+{
+   public:
+      struct Entry
+      {
+         IntPtr addr;
+         int isa;
+         UInt32 generation;
+         uint8_t code[16];                   //< Private copy: the decoded instruction points into it
+         const dl::DecodedInst *dec_inst;
+         Instruction *instruction;           //< Set by the first thread that simulates it in detail
+      };
+
+      class Front
+      {
+         public:
+            Front(DecodeCache *cache);
+            ~Front();
+
+            Entry* lookup(const Sift::Instruction &inst)
+            {
+               if (__atomic_load_n(&m_cache->m_epoch, __ATOMIC_ACQUIRE) != m_epoch)
+                  reset();
+               Entry *&slot = m_slots[(inst.sinst->addr ^ (inst.sinst->addr >> 12)) & (NUM_SLOTS - 1)];
+               if (slot && slot->addr == inst.sinst->addr && slot->isa == inst.isa)
+               {
+                  if (++m_hits == PUBLISH_INTERVAL)
+                     publish();
+                  return slot;
+               }
+               slot = m_cache->lookup(inst);
+               return slot;
+            }
+            Instruction* setInstruction(Entry *entry, Instruction *instruction)
+            { return m_cache->setInstruction(entry, instruction); }
+            void invalidate(IntPtr page);
+
+         private:
+            static const UInt32 NUM_SLOTS = 4096;
+            static const UInt64 PUBLISH_INTERVAL = 1 << 16;
+
+            DecodeCache *m_cache;
+            std::vector<Entry*> m_slots;
+            UInt64 m_epoch;
+            UInt64 m_hits;
+
+            void reset();
+            void publish();
+      };
+
+      DecodeCache(UInt32 index);
+      ~DecodeCache();
+
+      // Find or decode an instruction, can be called concurrently from any thread
+      Entry* lookup(const Sift::Instruction &inst);
+      // Attach a (thread-independent) Instruction to an entry. If another thread got there first,
+      // instruction is deleted and theirs is returned.
+      Instruction* setInstruction(Entry *entry, Instruction *instruction);
+      // Drop all instructions on a code page, for all threads
+      void invalidate(IntPtr page);
+
+   private:
+      static const UInt32 NUM_SHARDS = 64;
+
+      struct Key
+      {
+         IntPtr addr;
+         int isa;
+         UInt32 generation;
+         bool operator==(const Key &other) const
+         { return addr == other.addr && isa == other.isa && generation == other.generation; }
+      };
+      struct KeyHash
+      {
+         size_t operator()(const Key &key) const
+         { return std::hash<IntPtr>()(key.addr ^ (IntPtr(key.isa) << 56) ^ (IntPtr(key.generation) << 40)); }
+      };
+
+      // Instructions are sharded by code page, so a page's generation and its entries share a lock
+      struct Shard
+      {
+         Lock lock;
+         std::unordered_map<Key, Entry*, KeyHash> entries;
+         std::unordered_map<IntPtr, UInt32> generations;
+      };
+
+      dl::DecoderFactory m_factory;
+      std::vector<Shard> m_shards;
+      std::vector<Entry*> m_retired;
+      Lock m_retired_lock;
+      UInt64 m_epoch;   //< Incremented on every invalidation, Fronts reset when it changes
+
+      UInt64 m_hits;
+      UInt64 m_shared_hits;
+      UInt64 m_misses;
+      UInt64 m_invalidations;
+      UInt64 m_entries;
+      UInt64 m_instructions;
+      UInt64 m_retired_entries;
+      UInt64 m_bytes;
+
+      Shard& getShard(IntPtr addr)
+      { return m_shards[((addr >> 12) ^ (addr >> 20)) % NUM_SHARDS]; }
+      void deleteEntry(Entry *entry);
+
+      friend class Front;
+};
+
+#endif // __DECODE_CACHE_H
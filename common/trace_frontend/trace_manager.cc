@@ -1,5 +1,6 @@
 #include "trace_manager.h"
 #include "trace_thread.h"
+#include "decode_cache.h"
 #include "simulator.h"
 #include "thread_manager.h"
 #include "hooks_manager.h"
@@ -24,11 +25,28 @@ TraceManager::TraceManager()
    , m_tracefiles(0)
    , m_responsefiles(0)
    , m_trace_prefix("")
+   , m_shared_decode_cache(Sim()->getCfg()->getBool("traceinput/shared_decode_cache"))
 {
 }
 
 TraceManager::~TraceManager()
 {
+   for(auto it = m_decode_caches.begin(); it != m_decode_caches.end(); ++it)
+      delete it->second;
+}
+
+DecodeCache* TraceManager::getDecodeCache(app_id_t app_id, thread_id_t thread_id)
+{
+   // Threads of the same application run the same code and can share decoded instructions.
+   // In system mode, threads are vCPUs that can each be running different processes.
+   if (m_shared_decode_cache && app_id != INVALID_APP_ID)
+      thread_id = INVALID_THREAD_ID;
+
+   ScopedLock sl(m_decode_cache_lock);
+   DecodeCache *&cache = m_decode_caches[std::make_pair(app_id, thread_id)];
+   if (!cache)
+      cache = new DecodeCache(thread_id == INVALID_THREAD_ID ? app_id : thread_id);
+   return cache;
 }
 
 void TraceManager::start()
@@ -266,7 +284,7 @@ thread_id_t UserTraceManager::newThread(app_id_t app_id, bool first, bool init_f
 
    m_num_threads_running++;
    Thread *thread = Sim()->getThreadManager()->createThread(app_id, creator_thread_id);
-   TraceThread *tthread = new TraceThread(thread, time, tracefile, responsefile, app_id, init_fifo /*cleaup*/);
+   TraceThread *tthread = new TraceThread(thread, time, tracefile, responsefile, app_id, getDecodeCache(app_id, thread->getId()), init_fifo /*cleaup*/);
    m_threads.push_back(tthread);
 
    if (spawn)
@@ -413,7 +431,7 @@ void SystemTraceManager::init()
       String responsefile = m_responsefiles[threadid];
       m_num_threads_running++;
       Thread *thread = Sim()->getThreadManager()->createThread(INVALID_APP_ID, INVALID_THREAD_ID);
-      TraceThread *tthread = new TraceThread(thread, SubsecondTime::Zero(), tracefile, responsefile, INVALID_APP_ID, false);
+      TraceThread *tthread = new TraceThread(thread, SubsecondTime::Zero(), tracefile, responsefile, INVALID_APP_ID, getDecodeCache(INVALID_APP_ID, thread->getId()), false);
       m_threads.push_back(tthread);
    }
 }
@@ -5,10 +5,13 @@
 #include "semaphore.h"
 #include "core.h" // for lock_signal_t and mem_op_t
 #include "_thread.h"
+#include "lock.h"
 
+#include <map>
 #include <vector>
 
 class TraceThread;
+class DecodeCache;
 
 class TraceManager
 {
@@ -33,9 +36,14 @@ class TraceManager
       std::vector<String> m_tracefiles;
       std::vector<String> m_responsefiles;
       String m_trace_prefix;
+      const bool m_shared_decode_cache;
+      std::map<std::pair<app_id_t, thread_id_t>, DecodeCache *> m_decode_caches;
+      Lock m_decode_cache_lock;
 
       friend class Monitor;
 
+      DecodeCache* getDecodeCache(app_id_t app_id, thread_id_t thread_id);
+
       TraceManager();
       virtual ~TraceManager();
 
@@ -35,7 +35,7 @@
 //bool TraceThread::xed_initialized = false;
 int TraceThread::m_isa = 0;
 
-TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup)
+TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, DecodeCache *decode_cache, bool cleanup)
    : m__thread(NULL)
    , m_thread(thread)
    , m_time_start(time_start)
@@ -44,6 +44,8 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_address_randomization(Sim()->getCfg()->getBool("traceinput/address_randomization"))
    , m_appid_from_coreid(Sim()->getCfg()->getString("scheduler/type") == "sequential" ? true : false)
    , m_stop(false)
+   , m_decode_cache(decode_cache)
+   , m_share_instructions(false)
    , m_bbv_base(0)
    , m_bbv_count(0)
    , m_bbv_last(0)
@@ -57,6 +59,12 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_started(false)
    , m_flushed(false)
    , m_virt_cache(false)
+   , m_pipeline(false)
+   , m_queue(NULL)
+   , m_reader(this)
+   , m_reader_thread(NULL)
+   , m_reader_stop(false)
+   , m_sinst_index(0)
    , m_stopped(false)
 {
 
@@ -69,6 +77,7 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    //   xed_initialized = true;
    //}
 
+   m_trace.setDecompressionThreads(Sim()->getCfg()->getInt("traceinput/decompression_threads"));
    m_trace.setHandleInstructionCountFunc(TraceThread::__handleInstructionCountFunc, this);
    m_trace.setHandleCacheOnlyFunc(TraceThread::__handleCacheOnlyFunc, this);
    if (Sim()->getCfg()->getBool("traceinput/mirror_output"))
@@ -114,15 +123,20 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
 TraceThread::~TraceThread()
 {
    delete m__thread;
+   if (m_reader_thread)
+   {
+      // The reader exits at its next queue operation, or at the end of the trace when it is blocked reading it.
+      // Pipelining requires a trace without response file, so the recorder never waits for us and will get there.
+      __atomic_store_n(&m_reader_stop, true, __ATOMIC_RELEASE);
+      m_reader_thread->join();
+      delete m_reader_thread;
+   }
+   delete m_queue;
    if (m_cleanup)
    {
       unlink(m_tracefile.c_str());
       unlink(m_responsefile.c_str());
    }
-   for(std::unordered_map<IntPtr, const dl::DecodedInst *>::iterator i = m_decoder_cache.begin() ; i != m_decoder_cache.end() ; ++i)
-   {
-      delete (*i).second;
-   }
 }
 
 UInt64 TraceThread::va2pa(UInt64 va, bool *noMapping)
@@ -450,15 +464,10 @@ SubsecondTime TraceThread::getCurrentTime() const
    return m_thread->getCore()->getPerformanceModel()->getElapsedTime();
 }
 
-Instruction* TraceThread::decode(Sift::Instruction &inst)
+Instruction* TraceThread::decode(Sift::Instruction &inst, const dl::DecodedInst &dec_inst)
 {
 
    //printf("PC: %lx Size: %d num_addresses=%d is_branch=%d\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch);
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-
-   const dl::DecodedInst& dec_inst = *(m_decoder_cache[inst.sinst->addr]);
-
    OperandList list;
 
    // Ignore memory-referencing operands in NOP instructions
@@ -583,20 +592,9 @@ void TraceThread::handleCacheOnlyFunc(uint8_t icount, Sift::CacheOnlyType type,
    }
 }
 
-const dl::DecodedInst* TraceThread::staticDecode(Sift::Instruction &inst)
-{
-   dl::DecodedInst *dec_inst = m_factory->CreateInstruction(Sim()->getDecoder(), inst.sinst->data,
-                                                            inst.sinst->size, inst.sinst->addr);
-   Sim()->getDecoder()->decode(dec_inst, (dl::dl_isa)inst.isa);
-   return dec_inst;
-}
-
-void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size)
+void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, const Predecoded &predecoded, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size)
 {
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   const dl::DecodedInst &dec_inst = *(predecoded.entry ? predecoded.entry : m_decode_cache.lookup(inst))->dec_inst;
 
    // Warmup instruction caches
 
@@ -702,16 +700,7 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
 
 void TraceThread::handleICacheFlushFunc(uint64_t page)
 {
-   for (auto it = m_decoder_cache.begin(); it != m_decoder_cache.end(); )
-   {
-      if ((it->first & Sift::ICACHE_PAGE_MASK) == page)
-      {
-         delete it->second;
-         it = m_decoder_cache.erase(it);
-      }
-      else
-         ++ it;
-   }
+   m_decode_cache.invalidate(page);
 
    for (auto it = m_icache.begin(); it != m_icache.end(); )
    {
@@ -727,17 +716,31 @@ void TraceThread::handleICacheFlushFunc(uint64_t page)
    m_flushed = true;
 }
 
-void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl)
+void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, const Predecoded &predecoded, Sift::Instruction &next_inst, PerformanceModel *prfmdl)
 {
 
    // Set up instruction
 
-   if (m_icache.count(inst.sinst->addr) == 0)
-      m_icache[inst.sinst->addr] = decode(inst);
-   // Here get the decoder instruction without checking, because we must have it for sure
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   DecodeCache::Entry *entry = predecoded.entry ? predecoded.entry : m_decode_cache.lookup(inst);
+   const dl::DecodedInst &dec_inst = *entry->dec_inst;
 
-   Instruction *ins = m_icache[inst.sinst->addr];
+   Instruction *ins;
+   if (predecoded.instruction)
+   {
+      ins = predecoded.instruction;
+   }
+   else if (m_share_instructions)
+   {
+      ins = __atomic_load_n(&entry->instruction, __ATOMIC_ACQUIRE);
+      if (!ins)
+         ins = m_decode_cache.setInstruction(entry, decode(inst, dec_inst));
+   }
+   else
+   {
+      if (m_icache.count(inst.sinst->addr) == 0)
+         m_icache[inst.sinst->addr] = decode(inst, dec_inst);
+      ins = m_icache[inst.sinst->addr];
+   }
    DynamicInstruction *dynins = prfmdl->createDynamicInstruction(ins, m_virt_cache ? inst.sinst->addr : va2pa(inst.sinst->addr));
 
    // Add dynamic instruction info
@@ -874,6 +877,23 @@ void TraceThread::run()
    // Open the trace (be sure to do this before potentially blocking on reschedule() as this causes deadlock)
    m_trace.initStream();
    m_trace_has_pa = m_trace.getTraceHasPhysicalAddresses();
+   // Instructions carry a translated address, they can only be shared when translation does not depend on the thread
+   m_share_instructions = m_virt_cache || (!m_trace_has_pa && !m_appid_from_coreid);
+
+   // Reading ahead is only safe when nothing else uses the reader: without a response channel (emulated memory
+   // accesses go through it) and physical addresses (the reader's mapping would run ahead of the timing)
+   if (Sim()->getCfg()->getBool("traceinput/pipeline"))
+   {
+      if (m_responsefile == "" && !m_trace_has_pa)
+      {
+         m_pipeline = true;
+         m_queue = new SPSCQueue<PipelineEntry>(Sim()->getCfg()->getInt("traceinput/pipeline_depth"));
+         m_reader_thread = _Thread::create(&m_reader);
+         m_reader_thread->run();
+      }
+      else
+         LOG_PRINT_WARNING_ONCE("traceinput/pipeline requires traces without response files or physical addresses, not pipelining");
+   }
 
    // Only wait for a core in user simulation. In system simulation we are always stalled on thread start
    // because simulated vcpu might be halted at beginning. We wait for first instruction to resume the thread.
@@ -885,8 +905,9 @@ void TraceThread::run()
    }
 
    Sift::Instruction inst, next_inst;
+   Predecoded predecoded, next_predecoded;
 
-   bool have_first = m_trace.Read(inst);
+   bool have_first = readInstruction(inst, predecoded);
    // If we fast forward through lift time of the thread, we are finished already now.
    Core *core = m_thread->getCore();
    PerformanceModel *prfmdl = core ? core->getPerformanceModel() : NULL;
@@ -895,7 +916,7 @@ void TraceThread::run()
    if (!m_started)
       signalStarted();
 
-   while(have_first && m_trace.Read(next_inst))
+   while(have_first && readInstruction(next_inst, next_predecoded))
    {
       if (m_blocked)
       {
@@ -941,11 +962,11 @@ void TraceThread::run()
                break;
 
             case InstMode::CACHE_ONLY:
-               handleInstructionWarmup(inst, next_inst, core, do_icache_warmup, icache_warmup_addr, icache_warmup_size);
+               handleInstructionWarmup(inst, predecoded, next_inst, core, do_icache_warmup, icache_warmup_addr, icache_warmup_size);
                break;
 
             case InstMode::DETAILED:
-               handleInstructionDetailed(inst, next_inst, prfmdl);
+               handleInstructionDetailed(inst, predecoded, next_inst, prfmdl);
                break;
 
             default:
@@ -968,6 +989,14 @@ void TraceThread::run()
       }
 
       inst = next_inst;
+      predecoded = next_predecoded;
+   }
+
+   if (m_pipeline)
+   {
+      // When we stopped early, the reader may be blocked on the trace. As with the reader itself when not
+      // pipelining, don't wait for it; just make sure it stops when it gets the chance.
+      __atomic_store_n(&m_reader_stop, true, __ATOMIC_RELEASE);
    }
 
    printf("[TRACE:%u] -- %s --\n", m_thread->getId(), m_stop ? "STOP" : "DONE");
@@ -978,6 +1007,116 @@ void TraceThread::run()
    Sim()->getTraceManager()->signalDone(this, time_end, m_stop /*aborted*/);
 }
 
+bool TraceThread::readInstruction(Sift::Instruction &inst, Predecoded &predecoded)
+{
+   if (!m_pipeline)
+   {
+      predecoded.entry = NULL;
+      predecoded.instruction = NULL;
+      return m_trace.Read(inst);
+   }
+
+   while (true)
+   {
+      PipelineEntry *entry;
+      for(UInt64 spin = 0; (entry = m_queue->front()) == NULL; ++spin)
+         SPSCQueue<PipelineEntry>::backoff(spin);
+
+      switch(entry->type)
+      {
+         case PipelineEntry::CALL:
+            entry->call->call();
+            __atomic_store_n(&entry->call->m_done, true, __ATOMIC_RELEASE);
+            m_queue->pop();
+            break;
+
+         case PipelineEntry::END:
+            // Leave it in the queue, we may be called again
+            return false;
+
+         case PipelineEntry::INSTRUCTION:
+            // inst is kept for one more iteration as the previous instruction, alternate between two copies of its static info
+            m_sinst_index ^= 1;
+            m_sinst[m_sinst_index] = entry->sinst;
+            inst = entry->inst;
+            inst.sinst = &m_sinst[m_sinst_index];
+            predecoded.entry = entry->entry;
+            predecoded.instruction = entry->instruction;
+            m_queue->pop();
+            return true;
+      }
+   }
+}
+
+void TraceThread::runReader()
+{
+   // Set thread name for Sniper-in-Sniper simulations
+   String threadName = String("trace-reader-") + itostr(m_thread->getId());
+   SimSetThreadName(threadName.c_str());
+
+   Sift::Instruction inst;
+   bool have_inst;
+   do
+   {
+      have_inst = m_trace.Read(inst);
+
+      PipelineEntry *entry;
+      for(UInt64 spin = 0; (entry = m_queue->back()) == NULL; ++spin)
+      {
+         if (__atomic_load_n(&m_reader_stop, __ATOMIC_ACQUIRE))
+            return;
+         SPSCQueue<PipelineEntry>::backoff(spin);
+      }
+
+      if (have_inst)
+      {
+         entry->type = PipelineEntry::INSTRUCTION;
+         entry->inst = inst;
+         entry->sinst = *inst.sinst;
+         entry->sinst.next = NULL;
+         entry->entry = m_decode_cache.lookup(inst);
+         entry->instruction = NULL;
+         // Build the Instruction as well if the timing thread will need it. If the mode changes before it
+         // gets there, it will either ignore it or build its own.
+         if (m_share_instructions && Sim()->getInstrumentationMode() == InstMode::DETAILED)
+         {
+            entry->instruction = __atomic_load_n(&entry->entry->instruction, __ATOMIC_ACQUIRE);
+            if (!entry->instruction)
+               entry->instruction = m_decode_cache.setInstruction(entry->entry, decode(inst, *entry->entry->dec_inst));
+         }
+      }
+      else
+         entry->type = PipelineEntry::END;
+
+      m_queue->push();
+   }
+   while (have_inst && !__atomic_load_n(&m_reader_stop, __ATOMIC_ACQUIRE));
+}
+
+void TraceThread::postCall(PipelineCall *call)
+{
+   // Called on the reader thread from inside m_trace.Read()
+   PipelineEntry *entry;
+   for(UInt64 spin = 0; (entry = m_queue->back()) == NULL; ++spin)
+   {
+      if (__atomic_load_n(&m_reader_stop, __ATOMIC_ACQUIRE))
+         return;
+      SPSCQueue<PipelineEntry>::backoff(spin);
+   }
+
+   call->m_done = false;
+   entry->type = PipelineEntry::CALL;
+   entry->call = call;
+   m_queue->push();
+
+   for(UInt64 spin = 0; !__atomic_load_n(&call->m_done, __ATOMIC_ACQUIRE); ++spin)
+   {
+      if (__atomic_load_n(&m_reader_stop, __ATOMIC_ACQUIRE))
+         return;
+      SPSCQueue<PipelineEntry>::backoff(spin);
+   }
+}
+
 void TraceThread::spawn()
 {
    m__thread = _Thread::create(this);
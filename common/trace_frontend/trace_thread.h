@@ -8,6 +8,8 @@
 #include "sift_reader.h"
 #include "operand.h"
 #include "semaphore.h"
+#include "decode_cache.h"
+#include "spsc_queue.h"
 
 #include <decoder.h>
 
@@ -16,6 +18,7 @@
 //}
 
 #include <unordered_map>
+#include <utility>
 
 #define NUM_PAPI_COUNTERS 6
 
@@ -59,11 +62,11 @@ class TraceThread : public Runnable
       bool m_appid_from_coreid;
       uint8_t m_address_randomization_table[256];
       bool m_stop;
-      std::unordered_map<IntPtr, Instruction *> m_icache;
-      //std::unordered_map<IntPtr, const xed_decoded_inst_t *> m_decoder_cache;  // TODO convert to DecoderLib
+      std::unordered_map<IntPtr, Instruction *> m_icache;  // Used when Instructions cannot be shared with other threads
       //static bool xed_initialized;  // TODO convert to DecoderLib
       //xed_state_t m_xed_state_init;  // TODO convert to DecoderLib
-      std::unordered_map<IntPtr, const dl::DecodedInst *> m_decoder_cache;  // TODO convert to DecoderLib
+      DecodeCache::Front m_decode_cache;
+      bool m_share_instructions;
       UInt64 m_bbv_base;
       UInt64 m_bbv_count;
       UInt64 m_bbv_last;
@@ -81,38 +84,100 @@ class TraceThread : public Runnable
       bool m_flushed;
       bool m_virt_cache;
 
+      // Pipelined mode (traceinput/pipeline): a reader thread runs Sift::Reader::Read() and decodes instructions
+      // ahead of this thread, which only does the timing. Callbacks made by the reader are executed by this thread,
+      // after all instructions queued before them, so simulation is unchanged.
+      class PipelineCall
+      {
+         public:
+            virtual ~PipelineCall() {}
+            virtual void call() = 0;
+            bool m_done;
+      };
+      template <typename F> class PipelineCallFunc : public PipelineCall
+      {
+         public:
+            PipelineCallFunc(F &func) : m_func(func), m_result() {}
+            void call() { m_result = m_func(); }
+            F &m_func;
+            decltype(std::declval<F>()()) m_result;
+      };
+      struct PipelineEntry
+      {
+         enum { INSTRUCTION, CALL, END } type;
+         Sift::Instruction inst;
+         Sift::StaticInstruction sinst;     //< Private copy, the reader frees its own when code is modified
+         DecodeCache::Entry *entry;
+         Instruction *instruction;          //< Already decoded, or NULL
+         PipelineCall *call;
+      };
+      class PipelineReader : public Runnable
+      {
+         public:
+            PipelineReader(TraceThread *owner) : m_owner(owner) {}
+            void run() { m_owner->runReader(); }
+         private:
+            TraceThread *m_owner;
+      };
+      // Decode results for the instruction being simulated, when they were obtained ahead of time
+      struct Predecoded
+      {
+         DecodeCache::Entry *entry;
+         Instruction *instruction;
+      };
+
+      bool m_pipeline;
+      SPSCQueue<PipelineEntry> *m_queue;
+      PipelineReader m_reader;
+      _Thread *m_reader_thread;
+      bool m_reader_stop;
+      Sift::StaticInstruction m_sinst[2];   //< Static info of the current and next instruction in pipelined mode
+      UInt32 m_sinst_index;
+
+      bool readInstruction(Sift::Instruction &inst, Predecoded &predecoded);
+      void runReader();
+      void postCall(PipelineCall *call);
+      template <typename F> auto callHandler(F func) -> decltype(func())
+      {
+         if (!m_pipeline)
+            return func();
+         PipelineCallFunc<F> call(func);
+         postCall(&call);
+         return call.m_result;
+      }
+
       void run();
       void signalStarted();
       static Sift::Mode __handleInstructionCountFunc(void* arg, uint32_t icount)
-      { return ((TraceThread*)arg)->handleInstructionCountFunc(icount); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleInstructionCountFunc(icount); }); }
       static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
-      { ((TraceThread*)arg)->handleCacheOnlyFunc(icount, type, eip, address); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleCacheOnlyFunc(icount, type, eip, address); return 0; }); }
       static void __handleOutputFunc(void* arg, uint8_t fd, const uint8_t *data, uint32_t size)
-      { ((TraceThread*)arg)->handleOutputFunc(fd, data, size); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleOutputFunc(fd, data, size); return 0; }); }
       static uint64_t __handleSyscallFunc(void* arg, uint16_t syscall_number, const uint8_t *data, uint32_t size)
-      { return ((TraceThread*)arg)->handleSyscallFunc(syscall_number, data, size); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleSyscallFunc(syscall_number, data, size); }); }
       static int32_t __handleNewThreadFunc(void* arg)
-      { return ((TraceThread*)arg)->handleNewThreadFunc(); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleNewThreadFunc(); }); }
       static int32_t __handleJoinFunc(void* arg, int32_t join_thread_id)
-      { return ((TraceThread*)arg)->handleJoinFunc(join_thread_id); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleJoinFunc(join_thread_id); }); }
       static uint64_t __handleMagicFunc(void* arg, uint64_t a, uint64_t b, uint64_t c)
-      { return ((TraceThread*)arg)->handleMagicFunc(a, b, c); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleMagicFunc(a, b, c); }); }
       static bool __handleEmuFunc(void* arg, Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuReply &res)
-      { return ((TraceThread*)arg)->handleEmuFunc(type, req, res); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleEmuFunc(type, req, res); }); }
       static void __handleRoutineChangeFunc(void* arg, Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
-      { ((TraceThread*)arg)->handleRoutineChangeFunc(event, eip, esp, callEip); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleRoutineChangeFunc(event, eip, esp, callEip); return 0; }); }
       static void __handleRoutineAnnounceFunc(void* arg, uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
-      { ((TraceThread*)arg)->handleRoutineAnnounceFunc(eip, name, imgname, offset, line, column, filename); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleRoutineAnnounceFunc(eip, name, imgname, offset, line, column, filename); return 0; }); }
       static int32_t __handleForkFunc(void* arg)
-      { return ((TraceThread*)arg)->handleForkFunc(); }
+      { TraceThread *tt = (TraceThread*)arg; return tt->callHandler([&]() { return tt->handleForkFunc(); }); }
       static void __handleVCPUIdleFunc(void *arg)
-      { return ((TraceThread*)arg)->handleVCPUIdleFunc(); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleVCPUIdleFunc(); return 0; }); }
       static void __handleVCPUResumeFunc(void *arg)
-      { return ((TraceThread*)arg)->handleVCPUResumeFunc(); }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleVCPUResumeFunc(); return 0; }); }
       static void __handleICacheFlushFunc(void *arg, uint64_t page)
-      { return ((TraceThread*)arg)->handleICacheFlushFunc(page);  }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleICacheFlushFunc(page); return 0; }); }
       static void __handleGMMCmdFunc(void *arg, uint64_t cmd, IntPtr start, uint64_t arg1)
-      { return ((TraceThread*)arg)->handleGMMCmdFunc(cmd, start, arg1);  }
+      { TraceThread *tt = (TraceThread*)arg; tt->callHandler([&]() { tt->handleGMMCmdFunc(cmd, start, arg1); return 0; }); }
 
 
       Sift::Mode handleInstructionCountFunc(uint32_t icount);
@@ -130,9 +195,9 @@ class TraceThread : public Runnable
       void handleVCPUResumeFunc();
       void handleICacheFlushFunc(uint64_t page);
 
-      Instruction* decode(Sift::Instruction &inst);
-      void handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size);
-      void handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl);
+      Instruction* decode(Sift::Instruction &inst, const dl::DecodedInst &dec_inst);
+      void handleInstructionWarmup(Sift::Instruction &inst, const Predecoded &predecoded, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size);
+      void handleInstructionDetailed(Sift::Instruction &inst, const Predecoded &predecoded, Sift::Instruction &next_inst, PerformanceModel *prfmdl);
       //void addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const xed_decoded_inst_t &xed_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_pretetch, PerformanceModel *prfmdl);
       void addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const dl::DecodedInst &decoded_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_pretetch, PerformanceModel *prfmdl);
 
@@ -142,9 +207,7 @@ class TraceThread : public Runnable
       SubsecondTime getCurrentTime() const;
 
       //static dl::Decoder *m_decoder;
-      dl::DecoderFactory *m_factory;  // we need a factory here to be able to create instructions of any kind
       //const xed_decoded_inst_t* staticDecode(Sift::Instruction &inst);
-      const dl::DecodedInst* staticDecode(Sift::Instruction &inst);
 
       long long *m_papi_counters;
 
@@ -153,7 +216,7 @@ class TraceThread : public Runnable
    public:
       bool m_stopped;
 
-      TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup);
+      TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, DecodeCache *decode_cache, bool cleanup);
       ~TraceThread();
 
       void spawn();
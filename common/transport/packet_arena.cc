@@ -0,0 +1,62 @@
+#include "packet_arena.h"
+#include "allocator.h"
+
+#include <cstdlib>
+
+namespace
+{
+
+// Fallback for packets that do not fit in the largest size class
+class HeapAllocator : public Allocator
+{
+   public:
+      void* alloc(size_t bytes)
+      {
+         DataElement *elem = (DataElement*)malloc(sizeof(DataElement) + bytes);
+         elem->allocator = this;
+         return elem->data;
+      }
+      void _dealloc(void *ptr)
+      {
+         ::free(ptr);
+      }
+};
+
+}
+
+Allocator*
+PacketArena::getAllocator(UInt32 size)
+{
+   // Never deleted: receivers may still free packets while the simulator is shutting down
+   static Allocator **s_allocators = createAllocators();
+
+   for(UInt32 c = 0; c < NUM_CLASSES; ++c)
+      if (size <= (MIN_CLASS_SIZE << c))
+         return s_allocators[c];
+   return s_allocators[NUM_CLASSES];
+}
+
+Allocator**
+PacketArena::createAllocators()
+{
+   Allocator **allocators = new Allocator*[NUM_CLASSES + 1];
+   for(UInt32 c = 0; c < NUM_CLASSES; ++c)
+      allocators[c] = new MagazineAllocatorBase(sizeof(void*) + (MIN_CLASS_SIZE << c), 0, "PacketArena");
+   allocators[NUM_CLASSES] = new HeapAllocator();
+   return allocators;
+}
+
+Byte*
+PacketArena::alloc(UInt32 length)
+{
+   UInt32 size = sizeof(Header) + length;
+   Header *header = (Header*)getAllocator(size)->alloc(size);
+   header->next = NULL;
+   return (Byte*)(header + 1);
+}
+
+void
+PacketArena::free(Byte *buffer)
+{
+   Allocator::dealloc(buffer - sizeof(Header));
+}
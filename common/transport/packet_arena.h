@@ -0,0 +1,38 @@
+#ifndef PACKET_ARENA_H
+#define PACKET_ARENA_H
+
+#include "fixed_types.h"
+
+class Allocator;
+
+// Pooled, size-classed buffers for network packets.
+//
+// Packets are built once by the sender (NetPacket::makeBuffer) and handed to the receiving node by pointer,
+// which frees them after processing. Each size class is a MagazineAllocator, so allocation and free take no lock,
+// and buffers the receiver frees go back to the sender's magazine with one compare-and-swap. Every buffer has a
+// hidden link word in front of it that mailboxes use to queue it without allocating. Buffers larger than the
+// largest class use the heap.
+
+class PacketArena
+{
+   public:
+      static Byte* alloc(UInt32 length);
+      static void free(Byte *buffer);
+
+      // Link word of <buffer>, for use by whoever currently owns it
+      static Byte*& next(Byte *buffer) { return ((Header*)(buffer - sizeof(Header)))->next; }
+
+   private:
+      struct Header
+      {
+         Byte *next;
+      };
+
+      static const UInt32 MIN_CLASS_SIZE = 128;
+      static const UInt32 NUM_CLASSES = 6;   // 128 bytes to 4 KB
+
+      static Allocator* getAllocator(UInt32 size);
+      static Allocator** createAllocators();
+};
+
+#endif // PACKET_ARENA_H
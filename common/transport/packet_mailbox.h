@@ -0,0 +1,82 @@
+#ifndef PACKET_MAILBOX_H
+#define PACKET_MAILBOX_H
+
+#include "packet_arena.h"
+#include "lock.h"
+#include "cond.h"
+
+// Lock-free mailbox for PacketArena buffers, with any number of senders and a single receiver thread.
+//
+// Senders push onto a stack with one compare-and-swap, linking buffers through their PacketArena link word.
+// The receiver takes the whole stack at once and reverses it into a private list, so buffers are received in
+// the order they were pushed. The lock and condition variable are only used when the receiver goes to sleep.
+
+class PacketMailbox
+{
+   public:
+      PacketMailbox()
+         : m_inbox(NULL)
+         , m_head(NULL)
+         , m_waiting(false)
+      {}
+
+      // Any thread
+      void push(Byte *buffer)
+      {
+         Byte *head = __atomic_load_n(&m_inbox, __ATOMIC_RELAXED);
+         do
+            PacketArena::next(buffer) = head;
+         while (!__atomic_compare_exchange_n(&m_inbox, &head, buffer, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+         // Pairs with the store to m_waiting in pop(): either the receiver sees our buffer, or we see it waiting
+         if (__atomic_load_n(&m_waiting, __ATOMIC_SEQ_CST))
+         {
+            ScopedLock sl(m_lock);
+            m_cond.signal();
+         }
+      }
+
+      // Receiver only: the oldest buffer, waiting for one if the mailbox is empty
+      Byte* pop()
+      {
+         while (!m_head && !refill())
+         {
+            ScopedLock sl(m_lock);
+            __atomic_store_n(&m_waiting, true, __ATOMIC_SEQ_CST);
+            if (!__atomic_load_n(&m_inbox, __ATOMIC_SEQ_CST))
+               m_cond.wait(m_lock);
+            __atomic_store_n(&m_waiting, false, __ATOMIC_RELAXED);
+         }
+         Byte *buffer = m_head;
+         m_head = PacketArena::next(buffer);
+         return buffer;
+      }
+
+      // Receiver only
+      bool empty()
+      {
+         return !m_head && !refill();
+      }
+
+   private:
+      Byte *m_inbox __attribute__((aligned(64)));   //< Pushed by senders, newest first
+      Byte *m_head __attribute__((aligned(64)));    //< Receiver only, oldest first
+      bool m_waiting;
+      Lock m_lock;
+      ConditionVariable m_cond;
+
+      bool refill()
+      {
+         Byte *buffer = __atomic_exchange_n(&m_inbox, (Byte*)NULL, __ATOMIC_ACQUIRE);
+         while (buffer)
+         {
+            Byte *next = PacketArena::next(buffer);
+            PacketArena::next(buffer) = m_head;
+            m_head = buffer;
+            buffer = next;
+         }
+         return m_head != NULL;
+      }
+};
+
+#endif // PACKET_MAILBOX_H
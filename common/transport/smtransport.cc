@@ -74,68 +74,54 @@ SmTransport::SmNode::SmNode(core_id_t core_id, SmTransport *smt)
 
 SmTransport::SmNode::~SmNode()
 {
-   LOG_ASSERT_WARNING(m_queue.empty(), "Unread messages in queue for core: %d", getCoreId());
+   LOG_ASSERT_WARNING(m_mailbox.empty(), "Unread messages in queue for core: %d", getCoreId());
+   while (!m_mailbox.empty())
+      PacketArena::free(m_mailbox.pop());
    m_smt->clearNodeForId(getCoreId());
 }
 
+SmTransport::SmNode* SmTransport::SmNode::getNode(core_id_t dest_id)
+{
+   SmNode *dest_node = m_smt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+   return dest_node;
+}
+
 void SmTransport::SmNode::globalSend(SInt32 dest_proc, const void *buffer, UInt32 length)
 {
    LOG_ASSERT_ERROR(dest_proc == 0, "Destination other than zero: %d", dest_proc);
-   send((SmNode*)m_smt->getGlobalNode(), buffer, length);
+   Byte *data = PacketArena::alloc(length);
+   memcpy(data, buffer, length);
+   ((SmNode*)m_smt->getGlobalNode())->m_mailbox.push(data);
 }
 
 void SmTransport::SmNode::send(SInt32 dest_id, const void* buffer, UInt32 length)
 {
-   SmNode *dest_node = m_smt->getNodeFromId(dest_id);
-   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
-   send(dest_node, buffer, length);
+   Byte *data = PacketArena::alloc(length);
+   memcpy(data, buffer, length);
+   sendBuffer(dest_id, data, length);
 }
 
-void SmTransport::SmNode::send(SmNode *dest_node, const void *buffer, UInt32 length)
+// All nodes live in this process, so the buffer itself is handed to the destination
+void SmTransport::SmNode::sendBuffer(SInt32 dest_id, Byte *buffer, UInt32 length)
 {
-   Byte *data = new Byte[length];
-   memcpy(data, buffer, length);
+   LOG_PRINT("sending msg -- size: %i, data: %p, dest: %d", length, buffer, dest_id);
 
-   LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, data, dest_node);
-
-   dest_node->m_lock.acquire();
-   dest_node->m_queue.push(data);
-   dest_node->m_lock.release();
-   dest_node->m_cond.broadcast();
+   getNode(dest_id)->m_mailbox.push(buffer);
 }
 
 Byte* SmTransport::SmNode::recv()
 {
    LOG_PRINT("attempting recv -- this: %p", this);
 
-   m_lock.acquire();
-
-   while (true)
-   {
-      if (!m_queue.empty())
-      {
-         Byte *data = m_queue.front();
-         m_queue.pop();
-         m_lock.release();
-
-         LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
-
-         return data;
-      }
-      else
-      {
-         m_cond.wait(m_lock);
-      }
-   }
+   Byte *data = m_mailbox.pop();
+
+   LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
+
+   return data;
 }
 
 bool SmTransport::SmNode::query()
 {
-   bool result = false;
-
-   m_lock.acquire();
-   result = !m_queue.empty();
-   m_lock.release();
-
-   return result;
+   return !m_mailbox.empty();
 }
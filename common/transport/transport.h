@@ -17,6 +17,9 @@ public:
 
       virtual void globalSend(SInt32 dest_proc, const void *buffer, UInt32 length) = 0;
       virtual void send(core_id_t dest, const void *buffer, UInt32 length) = 0;
+      // Send a buffer allocated with PacketArena::alloc() without copying it, the transport takes ownership
+      virtual void sendBuffer(core_id_t dest, Byte *buffer, UInt32 length) = 0;
+      // Buffers returned by recv() are owned by the caller, who should release them with PacketArena::free()
       virtual Byte* recv() = 0;
       virtual bool query() = 0;
 
@@ -14,10 +14,15 @@ PinThread::~PinThread()
 
 void PinThread::run()
 {
-   m_thread_p = PIN_SpawnInternalThread(m_func, m_param, 32*1024*1024, NULL);
+   m_thread_p = PIN_SpawnInternalThread(m_func, m_param, 32*1024*1024, &m_thread_uid);
    assert(m_thread_p != INVALID_THREADID);
 }
 
+void PinThread::join()
+{
+   PIN_WaitForThreadTermination(m_thread_uid, PIN_INFINITE_TIMEOUT, NULL);
+}
+
 _Thread* _Thread::create(ThreadFunc func, void *param)
 {
    return new PinThread(func, param);
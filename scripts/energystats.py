@@ -79,6 +79,7 @@ class EnergyStats:
       current = 'energystats-temp%s' % ('B' if self.name_last and self.name_last[-1] == 'A' else 'A')
       self.in_stats_write = True
       sim.stats.write(current)
+      sim.stats.flush()
       self.in_stats_write = False
       #   If we also have a previous snapshot: update power
       if self.name_last:
@@ -30,6 +30,7 @@ class PowerTrace:
     _t0 = t0 or 'roi-begin'
     _t1 = t1 or 'roi-end'
     if not t1: t1 = self.t_roi_end
+    sim.stats.flush()
     os.system('unset PYTHONHOME; %s -d %s -o %s --partial=%s:%s --no-graph' % (
       os.path.join(os.getenv('SNIPER_ROOT'), 'tools/mcpat.py'),
       sim.config.output_dir,
@@ -0,0 +1,561 @@
+#include "blockstream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+   const size_t MinMatch = 4;
+   const size_t LastLiterals = 5;    // The last bytes of a block are always emitted as literals
+   const size_t MatchSafety = 12;    // No match starts this close to the end of a block
+   const size_t MaxOffset = 65535;
+
+   inline uint32_t read32(const uint8_t *p)
+   {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+   }
+
+   inline uint64_t read64(const uint8_t *p)
+   {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+   }
+
+   inline uint32_t hash32(uint32_t v)
+   {
+      return (v * 2654435761u) >> (32 - Sift::BlockCodec::HashBits);
+   }
+
+   inline uint8_t* writeLength(uint8_t *op, size_t length)
+   {
+      while (length >= 255)
+      {
+         *op++ = 255;
+         length -= 255;
+      }
+      *op++ = length;
+      return op;
+   }
+
+   // Sequence: token (literal length << 4 | match length - MinMatch), [literal length], literals,
+   // offset (16-bit little-endian), [match length]. The last sequence has literals only.
+   uint8_t* emitSequence(uint8_t *op, uint8_t *op_end, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length, bool last)
+   {
+      size_t needed = 1 + literal_length + literal_length / 255 + 1 + (last ? 0 : 2 + match_length / 255 + 1);
+      if (size_t(op_end - op) < needed)
+         return NULL;
+
+      uint8_t *token = op++;
+      *token = std::min(literal_length, size_t(15)) << 4;
+      if (literal_length >= 15)
+         op = writeLength(op, literal_length - 15);
+      memcpy(op, literals, literal_length);
+      op += literal_length;
+
+      if (!last)
+      {
+         *op++ = offset & 0xff;
+         *op++ = offset >> 8;
+         match_length -= MinMatch;
+         *token |= std::min(match_length, size_t(15));
+         if (match_length >= 15)
+            op = writeLength(op, match_length - 15);
+      }
+      return op;
+   }
+
+   inline bool readLength(const uint8_t *&ip, const uint8_t *ip_end, size_t &length)
+   {
+      uint8_t b;
+      do
+      {
+         if (ip >= ip_end)
+            return false;
+         b = *ip++;
+         length += b;
+      }
+      while (b == 255);
+      return true;
+   }
+}
+
+size_t Sift::BlockCodec::compressBound(size_t size)
+{
+   return size + size / 255 + 16;
+}
+
+size_t Sift::BlockCodec::compress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size, uint32_t *hashtable)
+{
+   std::vector<uint32_t> local_table;
+   if (!hashtable)
+   {
+      local_table.resize(HashTableSize);
+      hashtable = local_table.data();
+   }
+
+   const uint8_t *ip = src, *anchor = src, *end = src + size;
+   uint8_t *op = dst, *op_end = dst + dst_size;
+
+   if (size >= MatchSafety)
+   {
+      const uint8_t *match_limit = end - LastLiterals;
+      const uint8_t *ip_limit = end - MatchSafety;
+      memset(hashtable, 0, HashTableSize * sizeof(uint32_t));
+
+      while (ip <= ip_limit)
+      {
+         uint32_t sequence = read32(ip);
+         uint32_t h = hash32(sequence);
+         const uint8_t *ref = src + hashtable[h];
+         hashtable[h] = ip - src;
+
+         if (ref < ip && size_t(ip - ref) <= MaxOffset && read32(ref) == sequence)
+         {
+            while (ip > anchor && ref > src && ip[-1] == ref[-1])
+            {
+               --ip;
+               --ref;
+            }
+
+            const uint8_t *mp = ip + MinMatch, *mr = ref + MinMatch;
+            while (mp + sizeof(uint64_t) <= match_limit)
+            {
+               uint64_t diff = read64(mp) ^ read64(mr);
+               if (diff)
+               {
+                  mp += __builtin_ctzll(diff) >> 3;
+                  goto match_done;
+               }
+               mp += sizeof(uint64_t);
+               mr += sizeof(uint64_t);
+            }
+            while (mp < match_limit && *mp == *mr)
+            {
+               ++mp;
+               ++mr;
+            }
+         match_done:
+
+            op = emitSequence(op, op_end, anchor, ip - anchor, ip - ref, mp - ip, false);
+            if (!op)
+               return 0;
+            ip = anchor = mp;
+            // Prime the table with a position inside the match, helps on long repeated runs
+            hashtable[hash32(read32(ip - 2))] = ip - 2 - src;
+         }
+         else
+         {
+            // Step faster through data that does not compress
+            ip += 1 + ((ip - anchor) >> 6);
+         }
+      }
+   }
+
+   op = emitSequence(op, op_end, anchor, end - anchor, 0, 0, true);
+   if (!op)
+      return 0;
+   return op - dst;
+}
+
+bool Sift::BlockCodec::decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size)
+{
+   const uint8_t *ip = src, *ip_end = src + size;
+   uint8_t *op = dst, *op_end = dst + raw_size;
+
+   while (true)
+   {
+      if (ip >= ip_end)
+         return false;
+      uint8_t token = *ip++;
+
+      size_t literal_length = token >> 4;
+      if (literal_length == 15 && !readLength(ip, ip_end, literal_length))
+         return false;
+      if (size_t(ip_end - ip) < literal_length || size_t(op_end - op) < literal_length)
+         return false;
+      if (literal_length <= 16 && ip_end - ip >= 16 && op_end - op >= 16)
+         // Fixed-size copy of the common short runs, avoids a variable-length memcpy call
+         memcpy(op, ip, 16);
+      else
+         memcpy(op, ip, literal_length);
+      op += literal_length;
+      ip += literal_length;
+
+      if (ip == ip_end)
+         return op == op_end;
+
+      if (ip_end - ip < 2)
+         return false;
+      size_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > size_t(op - dst))
+         return false;
+
+      size_t match_length = token & 0xf;
+      if (match_length == 15 && !readLength(ip, ip_end, match_length))
+         return false;
+      match_length += MinMatch;
+      if (size_t(op_end - op) < match_length)
+         return false;
+
+      const uint8_t *ref = op - offset;
+      if (offset >= 16 && match_length <= 16 && op_end - op >= 16)
+      {
+         memcpy(op, ref, 16);
+      }
+      else if (offset >= match_length)
+      {
+         memcpy(op, ref, match_length);
+      }
+      else
+      {
+         // Overlapping copy (repeated pattern), must go front to back
+         size_t i = 0;
+         if (offset >= sizeof(uint64_t))
+            for( ; i + sizeof(uint64_t) <= match_length; i += sizeof(uint64_t))
+               memcpy(op + i, ref + i, sizeof(uint64_t));
+         for( ; i < match_length; ++i)
+            op[i] = ref[i];
+      }
+      op += match_length;
+   }
+}
+
+bool Sift::BlockCodec::readIndex(const char *filename, std::vector<BlockIndexEntry> &index)
+{
+   std::ifstream file(filename, std::ios::in | std::ios::binary);
+   if (!file.is_open())
+      return false;
+
+   BlockTrailer trailer;
+   file.seekg(-(std::streamoff)sizeof(trailer), std::ios::end);
+   file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   if (file.fail() || trailer.magic != IndexMagic)
+      return false;
+
+   index.resize(trailer.num_blocks);
+   file.seekg(trailer.index_offset, std::ios::beg);
+   file.read(reinterpret_cast<char*>(index.data()), trailer.num_blocks * sizeof(BlockIndexEntry));
+   return !file.fail();
+}
+
+
+oblockstream::oblockstream(vostream *output, uint64_t file_offset, bool write_index)
+   : output(output)
+   , m_comp(Sift::BlockCodec::compressBound(Sift::BlockCodec::BlockSize))
+   , m_hashtable(Sift::BlockCodec::HashTableSize)
+   , m_raw_offset(0)
+   , m_file_offset(file_offset)
+   , m_write_index(write_index)
+{
+   m_raw.reserve(Sift::BlockCodec::BlockSize);
+}
+
+oblockstream::~oblockstream()
+{
+   writeBlock();
+
+   Sift::BlockCodec::BlockHeader end = { 0, 0 };
+   output->write(reinterpret_cast<char*>(&end), sizeof(end));
+   m_file_offset += sizeof(end);
+
+   if (m_write_index)
+   {
+      Sift::BlockCodec::BlockTrailer trailer = { m_file_offset, (uint32_t)m_index.size(), Sift::BlockCodec::IndexMagic };
+      output->write(reinterpret_cast<char*>(m_index.data()), m_index.size() * sizeof(Sift::BlockCodec::BlockIndexEntry));
+      output->write(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   }
+
+   output->flush();
+   delete output;
+}
+
+void oblockstream::write(const char* s, std::streamsize n)
+{
+   while (n > 0)
+   {
+      size_t used = m_raw.size();
+      size_t chunk = std::min(size_t(n), Sift::BlockCodec::BlockSize - used);
+      m_raw.resize(used + chunk);
+      memcpy(m_raw.data() + used, s, chunk);
+      s += chunk;
+      n -= chunk;
+
+      if (m_raw.size() == Sift::BlockCodec::BlockSize)
+         writeBlock();
+   }
+}
+
+void oblockstream::flush()
+{
+   // Partial blocks are fine, the reader may be waiting for these records before it sends a response
+   writeBlock();
+   output->flush();
+}
+
+void oblockstream::writeBlock()
+{
+   if (m_raw.empty())
+      return;
+
+   size_t comp_size = Sift::BlockCodec::compress(m_raw.data(), m_raw.size(), m_comp.data(), m_comp.size(), m_hashtable.data());
+
+   Sift::BlockCodec::BlockHeader hdr;
+   hdr.raw_size = m_raw.size();
+   const uint8_t *payload;
+   if (comp_size == 0 || comp_size >= m_raw.size())
+   {
+      hdr.comp_size = m_raw.size() | Sift::BlockCodec::BlockStored;
+      payload = m_raw.data();
+      comp_size = m_raw.size();
+   }
+   else
+   {
+      hdr.comp_size = comp_size;
+      payload = m_comp.data();
+   }
+
+   Sift::BlockCodec::BlockIndexEntry entry = { m_raw_offset, m_file_offset };
+   m_index.push_back(entry);
+
+   output->write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+   output->write(reinterpret_cast<const char*>(payload), comp_size);
+
+   m_raw_offset += m_raw.size();
+   m_file_offset += sizeof(hdr) + comp_size;
+   m_raw.clear();
+}
+
+
+iblockstream::State::State(vistream *input, uint64_t file_offset, unsigned int num_threads)
+   : input(input)
+   , m_slots(num_threads ? 2 * num_threads + 2 : 1)
+   , m_consume_seq(0)
+   , m_data(NULL)
+   , m_data_end(NULL)
+   , m_fail(false)
+   , m_started(false)
+   , m_file_offset(file_offset)
+   , m_position(file_offset)
+#if !defined(PIN_CRT)
+   , m_num_decoders(num_threads)
+   , m_fetch_seq(0)
+   , m_decode_seq(0)
+   , m_end_seq(0)
+   , m_end_seen(false)
+   , m_stop(false)
+   , m_fetching(false)
+#endif
+{
+   for(auto &slot : m_slots)
+      slot.state = Slot::Empty;
+}
+
+iblockstream::iblockstream(vistream *input, uint64_t file_offset, unsigned int num_threads)
+   : m_state(new State(input, file_offset, num_threads))
+{
+#if !defined(PIN_CRT)
+   // The threads hold on to the state until they exit
+   if (num_threads)
+   {
+      m_fetcher = std::thread(&State::fetcherThread, m_state);
+      for(unsigned int i = 0; i < num_threads; ++i)
+         m_decoders.push_back(std::thread(&State::decoderThread, m_state));
+   }
+#endif
+}
+
+iblockstream::~iblockstream()
+{
+#if !defined(PIN_CRT)
+   if (m_state->m_num_decoders)
+   {
+      {
+         std::unique_lock<std::mutex> lock(m_state->m_lock);
+         m_state->m_stop = true;
+         m_state->m_cond.notify_all();
+         // A fetcher waiting for more input would otherwise keep the destructor waiting for as long as the
+         // writer stays alive. Inputs that cannot be shut down get a moment to deliver, then the fetcher is
+         // left to exit on its own once its read returns.
+         if (!m_state->input->shutdown()
+             && !m_state->m_cond.wait_for(lock, std::chrono::milliseconds(100), [this]{ return !m_state->m_fetching; }))
+            m_fetcher.detach();
+      }
+      if (m_fetcher.joinable())
+         m_fetcher.join();
+      for(auto &decoder : m_decoders)
+         decoder.join();
+   }
+#endif
+}
+
+bool iblockstream::State::fetchBlock(Slot &slot)
+{
+   input->read(reinterpret_cast<char*>(&slot.header), sizeof(slot.header));
+   if (input->fail() || slot.header.raw_size == 0)
+      return false;
+
+   uint32_t comp_size = slot.header.comp_size & ~Sift::BlockCodec::BlockStored;
+   if (slot.header.raw_size > Sift::BlockCodec::BlockSize || comp_size > Sift::BlockCodec::compressBound(Sift::BlockCodec::BlockSize))
+      return false;
+
+   slot.comp.resize(comp_size);
+   input->read(reinterpret_cast<char*>(slot.comp.data()), comp_size);
+   if (input->fail())
+      return false;
+
+   m_file_offset += sizeof(slot.header) + comp_size;
+   slot.end_offset = m_file_offset;
+   return true;
+}
+
+void iblockstream::State::decodeBlock(Slot &slot)
+{
+   if (slot.header.comp_size & Sift::BlockCodec::BlockStored)
+   {
+      slot.ok = slot.comp.size() == slot.header.raw_size;
+      slot.raw.swap(slot.comp);
+   }
+   else
+   {
+      slot.raw.resize(slot.header.raw_size);
+      slot.ok = Sift::BlockCodec::decompress(slot.comp.data(), slot.comp.size(), slot.raw.data(), slot.header.raw_size);
+   }
+}
+
+bool iblockstream::State::nextBlock()
+{
+   Slot *slot;
+
+#if !defined(PIN_CRT)
+   if (m_num_decoders)
+   {
+      std::unique_lock<std::mutex> lock(m_lock);
+      if (m_started)
+      {
+         m_slots[m_consume_seq % m_slots.size()].state = Slot::Empty;
+         ++m_consume_seq;
+         m_cond.notify_all();
+      }
+      m_started = true;
+
+      slot = &m_slots[m_consume_seq % m_slots.size()];
+      m_cond.wait(lock, [&]{ return slot->state == Slot::Ready || (m_end_seen && m_consume_seq >= m_end_seq); });
+      if (slot->state != Slot::Ready)
+         return false;
+   }
+   else
+#endif
+   {
+      slot = &m_slots[0];
+      if (!fetchBlock(*slot))
+         return false;
+      decodeBlock(*slot);
+   }
+
+   if (!slot->ok)
+      return false;
+
+   m_data = slot->raw.data();
+   m_data_end = m_data + slot->header.raw_size;
+   m_position = slot->end_offset;
+   return true;
+}
+
+#if !defined(PIN_CRT)
+void iblockstream::State::fetcherThread()
+{
+   while (true)
+   {
+      uint64_t seq;
+      {
+         std::unique_lock<std::mutex> lock(m_lock);
+         m_cond.wait(lock, [&]{ return m_stop || m_fetch_seq < m_consume_seq + m_slots.size(); });
+         if (m_stop)
+            return;
+         seq = m_fetch_seq;
+         m_fetching = true;
+      }
+
+      // The slot is Empty so nobody else touches it, no need to hold the lock while reading
+      Slot &slot = m_slots[seq % m_slots.size()];
+      bool valid = fetchBlock(slot);
+
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_fetching = false;
+      if (m_stop)
+      {
+         m_cond.notify_all();
+         return;
+      }
+      if (!valid)
+      {
+         m_end_seq = seq;
+         m_end_seen = true;
+         m_cond.notify_all();
+         return;
+      }
+      slot.state = Slot::Fetched;
+      ++m_fetch_seq;
+      m_cond.notify_all();
+   }
+}
+
+void iblockstream::State::decoderThread()
+{
+   while (true)
+   {
+      Slot *slot;
+      {
+         std::unique_lock<std::mutex> lock(m_lock);
+         m_cond.wait(lock, [&]{ return m_stop || m_decode_seq < m_fetch_seq || (m_end_seen && m_decode_seq >= m_end_seq); });
+         if (m_stop || m_decode_seq >= m_fetch_seq)
+            return;
+         slot = &m_slots[m_decode_seq % m_slots.size()];
+         slot->state = Slot::Decoding;
+         ++m_decode_seq;
+      }
+
+      // Blocks are independent, so several decoders can work on consecutive blocks at the same time
+      decodeBlock(*slot);
+
+      std::lock_guard<std::mutex> lock(m_lock);
+      slot->state = Slot::Ready;
+      m_cond.notify_all();
+   }
+}
+#endif
+
+void iblockstream::State::read(char* s, std::streamsize n)
+{
+   while (n > 0)
+   {
+      if (m_data == m_data_end && !nextBlock())
+      {
+         memset(s, 0, n);
+         m_fail = true;
+         return;
+      }
+
+      size_t chunk = std::min(size_t(n), size_t(m_data_end - m_data));
+      memcpy(s, m_data, chunk);
+      m_data += chunk;
+      s += chunk;
+      n -= chunk;
+   }
+}
+
+int iblockstream::State::peek()
+{
+   if (m_data == m_data_end && !nextBlock())
+   {
+      m_fail = true;
+      return EOF;
+   }
+   return *m_data;
+}
@@ -0,0 +1,165 @@
+#ifndef __BLOCKSTREAM_H
+#define __BLOCKSTREAM_H
+
+#include "zfstream.h"
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#if !defined(PIN_CRT)
+# include <chrono>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+// Block-compressed SIFT container
+//
+// After the (uncompressed) SIFT header, the record stream is cut into blocks of at most BlockSize bytes.
+// Each block is compressed independently with a small LZ77-class codec (byte-aligned sequences, 64 KB
+// window, no entropy coding) so it can be decoded at memory speed, and blocks can be decoded in parallel.
+//
+//   BlockHeader { raw_size, comp_size | BlockStored }, payload[comp_size]   (repeated)
+//   BlockHeader { 0, 0 }                                                     (end of blocks)
+//   BlockIndexEntry[num_blocks], BlockTrailer                                (regular files only)
+
+namespace Sift
+{
+   namespace BlockCodec
+   {
+      const uint32_t BlockSize = 1 << 20;
+      const uint32_t BlockStored = 0x80000000;   //< Payload is stored uncompressed
+      const uint32_t IndexMagic = 0x58444e49;    // "INDX"
+      const unsigned int HashBits = 14;
+      const size_t HashTableSize = 1 << HashBits;
+
+      typedef struct
+      {
+         uint32_t raw_size;
+         uint32_t comp_size;
+      } __attribute__ ((__packed__)) BlockHeader;
+
+      typedef struct
+      {
+         uint64_t raw_offset;    //< Offset of the block in the uncompressed record stream
+         uint64_t file_offset;   //< Offset of the BlockHeader in the file
+      } __attribute__ ((__packed__)) BlockIndexEntry;
+
+      typedef struct
+      {
+         uint64_t index_offset;
+         uint32_t num_blocks;
+         uint32_t magic;
+      } __attribute__ ((__packed__)) BlockTrailer;
+
+      size_t compressBound(size_t size);
+      // Returns the compressed size, or 0 if the output did not fit in dst_size bytes.
+      // hashtable (HashTableSize entries) can be passed in to avoid allocating one per call.
+      size_t compress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size, uint32_t *hashtable = NULL);
+      // Returns false on corrupt input or if the output is not exactly raw_size bytes
+      bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+      // Read the block index of a block-compressed trace file, returns false if it has none
+      bool readIndex(const char *filename, std::vector<BlockIndexEntry> &index);
+   };
+};
+
+class oblockstream : public vostream
+{
+   private:
+      vostream *output;
+      std::vector<uint8_t> m_raw;
+      std::vector<uint8_t> m_comp;
+      std::vector<uint32_t> m_hashtable;
+      std::vector<Sift::BlockCodec::BlockIndexEntry> m_index;
+      uint64_t m_raw_offset;
+      uint64_t m_file_offset;
+      bool m_write_index;
+      void writeBlock();
+   public:
+      // file_offset is the number of bytes already written to output (the SIFT header),
+      // write_index should only be set when output is a regular file
+      oblockstream(vostream *output, uint64_t file_offset, bool write_index);
+      virtual ~oblockstream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush();
+      virtual bool fail()
+         { return output->fail(); }
+      virtual bool is_open()
+         { return output->is_open(); }
+};
+
+class iblockstream : public vistream
+{
+   private:
+      struct Slot
+      {
+         enum State { Empty, Fetched, Decoding, Ready };
+         State state;
+         bool ok;
+         Sift::BlockCodec::BlockHeader header;
+         uint64_t end_offset;
+         std::vector<uint8_t> comp;
+         std::vector<uint8_t> raw;
+      };
+
+      // Shared with the helper threads, so that a fetcher blocked on input that cannot be shut down (a named pipe
+      // whose writer is still alive) can be left behind by the destructor. The last thread out deletes the input.
+      struct State
+      {
+         vistream *input;
+         std::vector<Slot> m_slots;
+         uint64_t m_consume_seq;       //< Block currently being consumed
+         const uint8_t *m_data;        //< Current position in the consumed block
+         const uint8_t *m_data_end;
+         bool m_fail;
+         bool m_started;
+         uint64_t m_file_offset;       //< Bytes fetched from input
+         uint64_t m_position;          //< Input offset up to the end of the consumed block
+
+#if !defined(PIN_CRT)
+         // Helper threads: one fetcher reads compressed blocks in order, decoders work on independent blocks
+         unsigned int m_num_decoders;
+         std::mutex m_lock;
+         std::condition_variable m_cond;
+         uint64_t m_fetch_seq;
+         uint64_t m_decode_seq;
+         uint64_t m_end_seq;
+         bool m_end_seen;
+         bool m_stop;
+         bool m_fetching;              //< The fetcher is reading from input
+
+         void fetcherThread();
+         void decoderThread();
+#endif
+
+         State(vistream *input, uint64_t file_offset, unsigned int num_threads);
+         ~State() { delete input; }
+         bool fetchBlock(Slot &slot);
+         static void decodeBlock(Slot &slot);
+         bool nextBlock();
+         void read(char* s, std::streamsize n);
+         int peek();
+      };
+
+      std::shared_ptr<State> m_state;
+#if !defined(PIN_CRT)
+      std::thread m_fetcher;
+      std::vector<std::thread> m_decoders;
+#endif
+
+   public:
+      // file_offset is the number of bytes already read from input (the SIFT header).
+      // With num_threads == 0, blocks are decoded synchronously from read().
+      iblockstream(vistream *input, uint64_t file_offset, unsigned int num_threads = 1);
+      virtual ~iblockstream();
+      virtual void read(char* s, std::streamsize n)
+         { m_state->read(s, n); }
+      virtual int peek()
+         { return m_state->peek(); }
+      virtual bool fail() const { return m_state->m_fail; }
+      uint64_t position() const { return m_state->m_position; }
+};
+
+#endif // __BLOCKSTREAM_H
@@ -0,0 +1,323 @@
+#include "shmstream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+   const uint32_t ShmMagic = 0x4d485353; // "SSHM"
+   const uint64_t ShmAlign = 4096;
+   // Positions are published once this many bytes are outstanding (or on flush/wait), comparable to
+   // the buffering that std::ofstream does on the named pipe
+   const uint64_t PublishBatch = 16384;
+   // How long the creator waits for the reader to attach before it removes the channel's name
+   const uint64_t AttachTimeoutUs = 10000000;
+
+   typedef struct
+   {
+      uint32_t magic;
+      uint32_t pad;
+      uint64_t length;
+      Sift::ShmChannel::Ring rings[Sift::ShmChannel::NumDirections];
+   } ChannelHeader;
+
+   uint64_t alignUp(uint64_t value, uint64_t align)
+   {
+      return (value + align - 1) & ~(align - 1);
+   }
+
+   void shmPath(char *path, size_t length, const char *name)
+   {
+      snprintf(path, length, "/dev/shm%s", name);
+   }
+
+   inline void cpuRelax()
+   {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+   }
+
+   // Back off gradually: spin first, since the other side typically catches up within microseconds,
+   // then yield, then sleep. Returns false when the peer process has gone away.
+   bool backoff(uint64_t iteration, pid_t peer)
+   {
+      if (iteration < 1024)
+      {
+         cpuRelax();
+      }
+      else if (iteration < 16384)
+      {
+         sched_yield();
+      }
+      else
+      {
+         usleep(50);
+         if ((iteration & 1023) == 0 && peer > 0 && kill(peer, 0) == -1 && errno == ESRCH)
+            return false;
+      }
+      return true;
+   }
+}
+
+Sift::ShmChannel* Sift::ShmChannel::create(uint32_t id, uint64_t trace_size, uint64_t response_size)
+{
+   static uint32_t counter = 0;
+
+   assert((trace_size & (trace_size - 1)) == 0);
+   assert((response_size & (response_size - 1)) == 0);
+
+   char name[MaxNameSize], path[128];
+   snprintf(name, sizeof(name), "/sift-%d-%u-%u", getpid(), id, __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED));
+   shmPath(path, sizeof(path), name);
+
+   uint64_t trace_offset = alignUp(sizeof(ChannelHeader), ShmAlign);
+   uint64_t response_offset = trace_offset + alignUp(trace_size, ShmAlign);
+   uint64_t length = response_offset + alignUp(response_size, ShmAlign);
+
+   int fd = ::open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return NULL;
+   if (ftruncate(fd, length) != 0)
+   {
+      ::close(fd);
+      unlink(path);
+      return NULL;
+   }
+   void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   ::close(fd);
+   if (base == MAP_FAILED)
+   {
+      unlink(path);
+      return NULL;
+   }
+
+   ChannelHeader *hdr = (ChannelHeader*)base;
+   memset(hdr, 0, sizeof(ChannelHeader));
+   hdr->length = length;
+   hdr->rings[Trace].size = trace_size;
+   hdr->rings[Trace].offset = trace_offset;
+   hdr->rings[Trace].producer_pid = getpid();
+   hdr->rings[Response].size = response_size;
+   hdr->rings[Response].offset = response_offset;
+   hdr->rings[Response].consumer_pid = getpid();
+   __atomic_store_n(&hdr->magic, ShmMagic, __ATOMIC_RELEASE);
+
+   return new ShmChannel(name, base, length, true);
+}
+
+Sift::ShmChannel* Sift::ShmChannel::open(const char *name)
+{
+   char path[128];
+   shmPath(path, sizeof(path), name);
+
+   int fd = ::open(path, O_RDWR);
+   if (fd < 0)
+      return NULL;
+   struct stat filestatus;
+   if (fstat(fd, &filestatus) != 0 || (size_t)filestatus.st_size < sizeof(ChannelHeader))
+   {
+      ::close(fd);
+      return NULL;
+   }
+   void *base = mmap(NULL, filestatus.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   ::close(fd);
+   // Both sides now hold a mapping, the name is no longer needed
+   unlink(path);
+   if (base == MAP_FAILED)
+      return NULL;
+
+   ChannelHeader *hdr = (ChannelHeader*)base;
+   if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != ShmMagic || hdr->length != (uint64_t)filestatus.st_size)
+   {
+      munmap(base, filestatus.st_size);
+      return NULL;
+   }
+   hdr->rings[Trace].consumer_pid = getpid();
+   hdr->rings[Response].producer_pid = getpid();
+
+   return new ShmChannel(name, base, filestatus.st_size, false);
+}
+
+Sift::ShmChannel::ShmChannel(const char *name, void *base, size_t length, bool creator)
+   : m_base(base)
+   , m_length(length)
+   , m_creator(creator)
+   , m_reader_expected(false)
+{
+   strncpy(m_name, name, sizeof(m_name) - 1);
+   m_name[sizeof(m_name) - 1] = '\0';
+}
+
+Sift::ShmChannel::~ShmChannel()
+{
+   if (m_creator)
+   {
+      // The reader unlinks the name when it attaches. Give a reader that is still on its way (we may have written
+      // the whole trace into the ring already) some time to do so, then remove the name ourselves. Without a reader
+      // to wait for (the name was never sent, or we are aborting), remove it right away.
+      for (uint64_t waited = 0; m_reader_expected && waited < AttachTimeoutUs && __atomic_load_n(&getRing(Trace)->consumer_pid, __ATOMIC_ACQUIRE) == 0; waited += 1000)
+         usleep(1000);
+      char path[128];
+      shmPath(path, sizeof(path), m_name);
+      unlink(path);
+   }
+   munmap(m_base, m_length);
+}
+
+Sift::ShmChannel::Ring* Sift::ShmChannel::getRing(Direction dir) const
+{
+   return &((ChannelHeader*)m_base)->rings[dir];
+}
+
+uint8_t* Sift::ShmChannel::getData(Direction dir) const
+{
+   return (uint8_t*)m_base + getRing(dir)->offset;
+}
+
+
+oshmstream::oshmstream(Sift::ShmChannel *channel, Sift::ShmChannel::Direction dir)
+   : m_ring(channel->getRing(dir))
+   , m_data(channel->getData(dir))
+   , m_mask(m_ring->size - 1)
+   , m_head(__atomic_load_n(&m_ring->head, __ATOMIC_ACQUIRE))
+   , m_tail_cache(__atomic_load_n(&m_ring->tail, __ATOMIC_ACQUIRE))
+   , m_fail(false)
+{
+}
+
+oshmstream::~oshmstream()
+{
+   publish();
+   __atomic_store_n(&m_ring->closed, 1, __ATOMIC_RELEASE);
+}
+
+void oshmstream::publish()
+{
+   __atomic_store_n(&m_ring->head, m_head, __ATOMIC_RELEASE);
+}
+
+void oshmstream::write(const char* s, std::streamsize n)
+{
+   uint64_t iteration = 0;
+   while (n > 0 && !m_fail)
+   {
+      uint64_t space = m_ring->size - (m_head - m_tail_cache);
+      if (space == 0)
+      {
+         m_tail_cache = __atomic_load_n(&m_ring->tail, __ATOMIC_ACQUIRE);
+         space = m_ring->size - (m_head - m_tail_cache);
+         if (space == 0)
+         {
+            // Ring is full: make sure the consumer sees everything we have, then wait for it to drain
+            publish();
+            if (!backoff(iteration++, m_ring->consumer_pid))
+               m_fail = true;
+            continue;
+         }
+      }
+      iteration = 0;
+
+      uint64_t offset = m_head & m_mask;
+      uint64_t chunk = std::min(std::min((uint64_t)n, space), m_ring->size - offset);
+      memcpy(m_data + offset, s, chunk);
+      m_head += chunk;
+      s += chunk;
+      n -= chunk;
+   }
+
+   // Publish in batches to avoid bouncing the head cache line on every record
+   if (m_head - m_ring->head >= PublishBatch)
+      publish();
+}
+
+
+ishmstream::ishmstream(Sift::ShmChannel *channel, Sift::ShmChannel::Direction dir)
+   : m_ring(channel->getRing(dir))
+   , m_data(channel->getData(dir))
+   , m_mask(m_ring->size - 1)
+   , m_tail(__atomic_load_n(&m_ring->tail, __ATOMIC_ACQUIRE))
+   , m_head_cache(__atomic_load_n(&m_ring->head, __ATOMIC_ACQUIRE))
+   , m_fail(false)
+   , m_shutdown(false)
+{
+}
+
+ishmstream::~ishmstream()
+{
+   __atomic_store_n(&m_ring->tail, m_tail, __ATOMIC_RELEASE);
+}
+
+bool ishmstream::waitData()
+{
+   uint64_t iteration = 0;
+   while (m_head_cache == m_tail)
+   {
+      m_head_cache = __atomic_load_n(&m_ring->head, __ATOMIC_ACQUIRE);
+      if (m_head_cache != m_tail)
+         break;
+
+      // Let the producer reuse everything we consumed before we go to sleep
+      __atomic_store_n(&m_ring->tail, m_tail, __ATOMIC_RELEASE);
+
+      if (__atomic_load_n(&m_ring->closed, __ATOMIC_ACQUIRE))
+      {
+         // Re-read head: the producer publishes before closing
+         m_head_cache = __atomic_load_n(&m_ring->head, __ATOMIC_ACQUIRE);
+         if (m_head_cache == m_tail)
+            return false;
+         break;
+      }
+      if (!backoff(iteration++, m_ring->producer_pid) || __atomic_load_n(&m_shutdown, __ATOMIC_ACQUIRE))
+         return false;
+   }
+   return true;
+}
+
+bool ishmstream::shutdown()
+{
+   __atomic_store_n(&m_shutdown, true, __ATOMIC_RELEASE);
+   return true;
+}
+
+void ishmstream::read(char* s, std::streamsize n)
+{
+   while (n > 0)
+   {
+      if (!waitData())
+      {
+         memset(s, 0, n);
+         m_fail = true;
+         return;
+      }
+
+      uint64_t offset = m_tail & m_mask;
+      uint64_t chunk = std::min(std::min((uint64_t)n, m_head_cache - m_tail), m_ring->size - offset);
+      memcpy(s, m_data + offset, chunk);
+      m_tail += chunk;
+      s += chunk;
+      n -= chunk;
+   }
+
+   if (m_tail - m_ring->tail >= PublishBatch)
+      __atomic_store_n(&m_ring->tail, m_tail, __ATOMIC_RELEASE);
+}
+
+int ishmstream::peek()
+{
+   if (!waitData())
+   {
+      m_fail = true;
+      return EOF;
+   }
+   return m_data[m_tail & m_mask];
+}
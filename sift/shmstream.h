@@ -0,0 +1,118 @@
+#ifndef __SHMSTREAM_H
+#define __SHMSTREAM_H
+
+#include "zfstream.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// Shared-memory transport for SIFT traces
+//
+// A ShmChannel is a single memory-mapped region (in /dev/shm) holding two single-producer/single-consumer
+// byte rings: one carrying the trace from the recorder to the simulator, and one carrying responses
+// (syscalls, joins, magic, ...) back. The name of the region is passed in the extended SIFT header,
+// so the named pipe is only used to exchange the header.
+
+namespace Sift
+{
+   class ShmChannel
+   {
+      public:
+         enum Direction
+         {
+            Trace = 0,
+            Response = 1,
+            NumDirections
+         };
+
+         struct Ring
+         {
+            // Producer and consumer positions live on separate cache lines
+            volatile uint64_t head;       //< Bytes written by the producer (published)
+            uint8_t _pad0[56];
+            volatile uint64_t tail;       //< Bytes consumed by the consumer (published)
+            uint8_t _pad1[56];
+            volatile uint32_t closed;     //< Set by the producer when it will not write any more data
+            volatile pid_t producer_pid;  //< Used to detect a peer that died without closing
+            volatile pid_t consumer_pid;
+            uint32_t _pad2;
+            uint64_t size;                //< Capacity of data[], power of two
+            uint64_t offset;              //< Offset of data[] from the start of the mapping
+            uint8_t _pad3[32];
+         };
+
+         static const uint64_t DefaultTraceRingSize = 4 << 20;
+         static const uint64_t DefaultResponseRingSize = 64 << 10;
+         static const uint32_t MaxNameSize = 64;    //< Including the terminating NUL
+
+         // Create a new channel, called by the trace writer
+         static ShmChannel* create(uint32_t id, uint64_t trace_size = DefaultTraceRingSize, uint64_t response_size = DefaultResponseRingSize);
+         // Attach to an existing channel by name, called by the trace reader. Unlinks the name once mapped.
+         static ShmChannel* open(const char *name);
+
+         // The creator also unlinks the name, in case the reader never attached. If the name was passed to a reader,
+         // the destructor first waits a while for it to attach.
+         ~ShmChannel();
+
+         // Called by the creator once the name was sent to the reader, or with false when aborting
+         void setReaderExpected(bool expected) { m_reader_expected = expected; }
+
+         const char* getName() const { return m_name; }
+         Ring* getRing(Direction dir) const;
+         uint8_t* getData(Direction dir) const;
+
+      private:
+         ShmChannel(const char *name, void *base, size_t length, bool creator);
+
+         char m_name[MaxNameSize];
+         void *m_base;
+         size_t m_length;
+         bool m_creator;
+         bool m_reader_expected;
+   };
+};
+
+class oshmstream : public vostream
+{
+   private:
+      Sift::ShmChannel::Ring *m_ring;
+      uint8_t *m_data;
+      uint64_t m_mask;
+      uint64_t m_head;        //< Local write position, published to m_ring->head in batches
+      uint64_t m_tail_cache;  //< Last observed consumer position
+      bool m_fail;
+      void publish();
+   public:
+      oshmstream(Sift::ShmChannel *channel, Sift::ShmChannel::Direction dir);
+      virtual ~oshmstream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush()
+         { publish(); }
+      virtual bool fail()
+         { return m_fail; }
+      virtual bool is_open()
+         { return m_ring != NULL; }
+};
+
+class ishmstream : public vistream
+{
+   private:
+      Sift::ShmChannel::Ring *m_ring;
+      uint8_t *m_data;
+      uint64_t m_mask;
+      uint64_t m_tail;        //< Local read position, published to m_ring->tail in batches
+      uint64_t m_head_cache;  //< Last observed producer position
+      bool m_fail;
+      bool m_shutdown;        //< Set by shutdown() from another thread
+      bool waitData();
+   public:
+      ishmstream(Sift::ShmChannel *channel, Sift::ShmChannel::Direction dir);
+      virtual ~ishmstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual bool shutdown();
+      uint64_t position() const { return m_tail; }
+};
+
+#endif // __SHMSTREAM_H
@@ -11,13 +11,10 @@
 
 #define NUM_PAPI_COUNTERS 6
 
-// When compiling against PinCRT and not using Pinplay, disable zlib as we do not have a PinCRT-compiled version
-#if defined(PIN_CRT) && !defined(PINPLAY_SUPPORTED)
-# define SIFT_USE_ZLIB 0
-#else
-/* TODO: Using zlib is problematic in current version. */
-# define SIFT_USE_ZLIB 0
-#endif
+// Legacy zlib streams (CompressionZlib) are not written anymore: they cannot be flushed mid-stream without
+// deadlocking on response pipes, and there is no PinCRT-compiled zlib. New traces use CompressionBlock,
+// which has its own codec (see blockstream.h) and works in every build.
+#define SIFT_USE_ZLIB 0
 
 namespace Sift
 {
@@ -43,6 +40,8 @@ namespace Sift
       ArchIA32 = 2,
       IcacheVariable = 4,
       PhysicalAddress = 8,
+      SharedMemory = 16,         //< Records follow in a ShmChannel, its name is in the extra header
+      CompressionBlock = 32,     //< Records are stored in independently compressed blocks
    } Option;
 
    typedef union
@@ -2,11 +2,14 @@
 #include "sift_format.h"
 #include "sift_utils.h"
 #include "zfstream.h"
+#include "shmstream.h"
+#include "blockstream.h"
 
 #include <iostream>
 #include <fstream>
 #include <cassert>
 #include <cstring>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -21,6 +24,7 @@
 Sift::Reader::Reader(const char *filename, const char *response_filename, uint32_t id)
    : input(NULL)
    , response(NULL)
+   , m_shm(NULL)
    , handleInstructionCountFunc(NULL)
    , handleInstructionCountArg(NULL)
    , handleCacheOnlyFunc(NULL)
@@ -50,9 +54,12 @@ Sift::Reader::Reader(const char *filename, const char *response_filename, uint32
    , handleGMMCmdFunc(NULL)
    , handleGMMCmdArg(NULL)
    , filesize(0)
+   , inputstream(NULL)
    , last_address(0)
    , icache()
    , m_id(id)
+   , m_decompression_threads(1)
+   , m_compressed(false)
    , m_trace_has_pa(false)
    , m_seen_end(false)
    , m_last_sinst(NULL)
@@ -82,6 +89,8 @@ Sift::Reader::~Reader()
       delete input;
    if (response)
       delete response;
+   if (m_shm)
+      delete m_shm;
    for(std::unordered_map<uint64_t, const uint8_t*>::iterator i = icache.begin() ; i != icache.end() ; ++i)
    {
       delete [] (*i).second;
@@ -119,9 +128,31 @@ bool Sift::Reader::initStream()
       std::cerr << "[SIFT:" << m_id << "] Invalid magic number\n";
       return false;
    }
-   if (hdr.size != 0)
+   // Extra header bytes only carry the name of a shared-memory channel
+   if (hdr.size != 0 && (!(hdr.options & SharedMemory) || hdr.size > ShmChannel::MaxNameSize))
    {
       std::cerr << "[SIFT:" << m_id << "] Invalid header size\n";
+      return false;
+   }
+   std::vector<char> extra(hdr.size + 1, '\0');
+   if (hdr.size != 0)
+   {
+      input->read(extra.data(), hdr.size);
+   }
+
+   if (hdr.options & SharedMemory)
+   {
+      m_shm = ShmChannel::open(extra.data());
+      if (!m_shm)
+      {
+         std::cerr << "[SIFT:" << m_id << "] Cannot open shared-memory channel " << extra.data() << "\n";
+         return false;
+      }
+      // Only the header is sent through the named pipe, everything else comes through the ring
+      delete input;
+      inputstream = NULL;
+      input = new ishmstream(m_shm, ShmChannel::Trace);
+      hdr.options &= ~SharedMemory;
    }
 
 #if SIFT_USE_ZLIB
@@ -137,6 +168,13 @@ bool Sift::Reader::initStream()
    }
 #endif
 
+   if (hdr.options & CompressionBlock)
+   {
+      input = new iblockstream(input, sizeof(hdr) + hdr.size, m_decompression_threads);
+      m_compressed = true;
+      hdr.options &= ~CompressionBlock;
+   }
+
    if (hdr.options & ArchIA32)
    {
       //xed_state_t init = { XED_MACHINE_MODE_LONG_COMPAT_32, XED_ADDRESS_WIDTH_32b };
@@ -172,7 +210,11 @@ bool Sift::Reader::initStream()
 
 bool Sift::Reader::initResponse()
 {
-   if (!response)
+   if (!response && m_shm)
+   {
+      response = new oshmstream(m_shm, ShmChannel::Response);
+   }
+   else if (!response)
    {
       if (strcmp(m_response_filename, "") == 0)
       {
@@ -895,8 +937,13 @@ void Sift::Reader::sendSimpleResponse(RecOtherType type, void *data, uint32_t si
 
 uint64_t Sift::Reader::getPosition()
 {
-   if (inputstream)
+   if (m_compressed)
+      // The helper threads are reading from inputstream, ask the stream how far we got
+      return static_cast<iblockstream*>(input)->position();
+   else if (inputstream)
       return inputstream->tellg();
+   else if (m_shm)
+      return static_cast<ishmstream*>(input)->position();
    else
       return 0;
 }
@@ -46,6 +46,8 @@ namespace Sift
       int isa;
    } Instruction;
 
+   class ShmChannel;
+
    class Reader
    {
       typedef Mode (*HandleInstructionCountFunc)(void* arg, uint32_t icount);
@@ -67,6 +69,7 @@ namespace Sift
       private:
          vistream *input;
          vostream *response;
+         ShmChannel *m_shm;
          HandleInstructionCountFunc handleInstructionCountFunc;
          void *handleInstructionCountArg;
          HandleCacheOnlyFunc handleCacheOnlyFunc;
@@ -114,6 +117,8 @@ namespace Sift
 #endif
 
          uint32_t m_id;
+         unsigned int m_decompression_threads;
+         bool m_compressed;
 
          bool m_trace_has_pa;
          bool m_seen_end;
@@ -148,6 +153,8 @@ namespace Sift
          void setHandleVCPUFunc(HandleVCPUIdleFunc funcIdle, HandleVCPUResumeFunc funcResume, void *arg = NULL) { assert(funcIdle); assert(funcResume); handleVCPUIdleFunc = funcIdle; handleVCPUResumeFunc = funcResume; handleVCPUArg = arg; }
          void setHandleICacheFlushFunc(HandleICacheFlushFunc func, void *arg = NULL) { handleICacheFlushFunc = func; handleICacheFlushArg = arg; }
          void setHandleGMMCmdFunc(HandleGMMCmdFunc func, void *arg = NULL) { handleGMMCmdFunc = func; handleGMMCmdArg = arg; }
+         // Number of helper threads decoding block-compressed traces ahead of Read(), 0 to decode inline
+         void setDecompressionThreads(unsigned int num_threads) { m_decompression_threads = num_threads; }
 
          uint64_t getPosition();
          uint64_t getLength();
@@ -4,6 +4,8 @@
 #include "sift_utils.h"
 #include "sift_assert.h"
 #include "zfstream.h"
+#include "shmstream.h"
+#include "blockstream.h"
 
 #include <cstdlib>
 #include <cstring>
@@ -37,8 +39,9 @@ __sift_assert_fail(__const char *__assertion, __const char *__file,
 }
 
 
-Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, TranslationType send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data)
+Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, TranslationType send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data, bool useSharedMemory)
    : response(NULL)
+   , m_shm(NULL)
    , getCodeFunc(getCodeFunc)
    , getCodeFunc2(getCodeFunc2)
    , getCodeFunc2Data(getCodeFunc2Data)
@@ -65,20 +68,28 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    m_response_filename = strdup(response_filename);
 
    uint64_t options = 0;
-#if SIFT_USE_ZLIB
    if (useCompression)
-      options |= CompressionZlib;
-#else
-   if (useCompression) {
-      std::cerr << "[SIFT:" << m_id << "] Warning: Compression disabled, ignoring request.\n";
-   }
-#endif
+      options |= CompressionBlock;
    if (arch32)
       options |= ArchIA32;
    if (requires_icache_per_insn)
       options |= IcacheVariable;
    if (m_send_va2pa_mapping != NO_TRANS)
       options |= PhysicalAddress;
+   if (useSharedMemory)
+   {
+      m_shm = ShmChannel::create(m_id);
+      if (m_shm)
+      {
+         options |= SharedMemory;
+         // Records are not copied through the kernel anymore, compressing them would only cost time
+         options &= ~CompressionBlock;
+      }
+      else
+      {
+         std::cerr << "[SIFT:" << m_id << "] Warning: Unable to create shared-memory channel, falling back to " << filename << "\n";
+      }
+   }
 
    output = new vofstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
 
@@ -86,6 +97,11 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    {
       delete output;
       output = nullptr;
+      if (m_shm)
+      {
+         delete m_shm;
+         m_shm = NULL;
+      }
       return;
    }
 
@@ -93,12 +109,29 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    std::cerr << "[DEBUG:" << m_id << "] Write Header" << std::endl;
    #endif
 
-   Sift::Header hdr = { Sift::MagicNumber, 0 /* header size */, options, {}};
+   // The shared-memory channel name is passed as extra header, NUL-terminated
+   uint32_t extra_size = m_shm ? strlen(m_shm->getName()) + 1 : 0;
+   Sift::Header hdr = { Sift::MagicNumber, extra_size, options, {}};
    output->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (extra_size)
+      output->write(m_shm->getName(), extra_size);
    output->flush();
 
-   if (options & CompressionZlib)
-      output = new ozstream(output);
+   if (m_shm)
+   {
+      if (!output->fail())
+         m_shm->setReaderExpected(true);
+      // The named pipe has served its purpose, all further records go through the ring
+      delete output;
+      output = new oshmstream(m_shm, ShmChannel::Trace);
+   }
+   else if (options & CompressionBlock)
+   {
+      // Only write the block index when it can be read back, i.e. not into a named pipe
+      struct stat filestatus;
+      bool is_file = stat(filename, &filestatus) == 0 && S_ISREG(filestatus.st_mode);
+      output = new oblockstream(output, sizeof(hdr) + extra_size, is_file);
+   }
 }
 
 // Modified from http://stackoverflow.com/questions/2203159/is-there-a-c-equivalent-to-getcwd
@@ -110,7 +143,11 @@ String get_working_path()
 
 void Sift::Writer::initResponse()
 {
-   if (!response)
+   if (!response && m_shm)
+   {
+     response = new ishmstream(m_shm, ShmChannel::Response);
+   }
+   else if (!response)
    {
      sift_assert(strcmp(m_response_filename, "") != 0);
      response = new vifstream(m_response_filename, std::ios::in);
@@ -156,6 +193,12 @@ void Sift::Writer::End()
       delete output;
       output = NULL;
    }
+
+   if (m_shm)
+   {
+      delete m_shm;
+      m_shm = NULL;
+   }
 }
 
 void Sift::Writer::Abort()
@@ -172,6 +215,13 @@ void Sift::Writer::Abort()
       delete response;
       response = NULL;
    }
+
+   if (m_shm)
+   {
+      m_shm->setReaderExpected(false);
+      delete m_shm;
+      m_shm = NULL;
+   }
 }
 
 Sift::Writer::~Writer()
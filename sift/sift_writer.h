@@ -14,6 +14,8 @@ class vostream;
 
 namespace Sift
 {
+   class ShmChannel;
+
    class Writer
    {
       public:
@@ -30,6 +32,7 @@ namespace Sift
       private:
          vostream *output;
          vistream *response;
+         ShmChannel *m_shm;
          GetCodeFunc getCodeFunc;
          GetCodeFunc2 getCodeFunc2;
          void *getCodeFunc2Data;
@@ -55,10 +58,10 @@ namespace Sift
          uint64_t va2pa_lookup(uint64_t va);
 
       public:
-         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, TranslationType send_va2pa_mapping = NO_TRANS, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL);
-         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL)
+         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, TranslationType send_va2pa_mapping = NO_TRANS, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL, bool useSharedMemory = false);
+         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL, bool useSharedMemory = false)
             : Writer(filename, getCodeFunc, useCompression, response_filename, id, arch32, requires_icache_per_insn,
-                     send_va2pa_mapping ? PAGEMAP : EXPLICIT, getCodeFunc2, GetCodeFunc2Data) {}
+                     send_va2pa_mapping ? PAGEMAP : EXPLICIT, getCodeFunc2, GetCodeFunc2Data, useSharedMemory) {}
 
          ~Writer();
          void End();
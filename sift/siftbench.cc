@@ -0,0 +1,253 @@
+// Measure SIFT transport throughput: a forked writer streams synthetic instruction records to a reader,
+// over a named pipe or over a shared-memory channel, optionally with a Sync round-trip every so often.
+//
+// With -z, measure block compression on existing (uncompressed) traces instead: compression ratio,
+// compression speed and decode speed with 1..N threads. -o writes the compressed trace.
+
+#define __STDC_FORMAT_MACROS
+
+#include "sift_writer.h"
+#include "sift_reader.h"
+#include "blockstream.h"
+
+#include <inttypes.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+static void getCode(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+   memset(dst, 0x90, size); // nop
+}
+
+static double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void runWriter(const char *filename, const char *response_filename, bool shm, uint64_t records, uint64_t sync_interval)
+{
+   Sift::Writer writer(filename, getCode, false, response_filename, 0, false, false, Sift::Writer::NO_TRANS, NULL, NULL, shm);
+   uint64_t addresses[1];
+   for(uint64_t i = 0; i < records; ++i)
+   {
+      // A 64-instruction loop with one memory operand per instruction and a back-edge branch
+      uint64_t eip = 0x400000 + (i & 63) * 4;
+      addresses[0] = 0x10000000 + (i & 0xffff) * 8;
+      bool is_branch = (i & 63) == 63;
+      writer.Instruction(eip, 4, 1, addresses, is_branch, is_branch, false, true);
+      if (sync_interval && (i % sync_interval) == sync_interval - 1)
+         writer.Sync();
+   }
+   writer.End();
+}
+
+static bool runBenchmark(bool shm, uint64_t records, uint64_t sync_interval)
+{
+   char filename[256], response_filename[256];
+   snprintf(filename, sizeof(filename), "/tmp/siftbench.%d.sift", getpid());
+   snprintf(response_filename, sizeof(response_filename), "/tmp/siftbench_response.%d.sift", getpid());
+   unlink(filename);
+   unlink(response_filename);
+   if (mkfifo(filename, 0600) != 0 || mkfifo(response_filename, 0600) != 0)
+   {
+      perror("mkfifo");
+      return false;
+   }
+
+   pid_t pid = fork();
+   if (pid == 0)
+   {
+      runWriter(filename, sync_interval ? response_filename : "", shm, records, sync_interval);
+      _exit(0);
+   }
+
+   double t_start = now();
+
+   Sift::Reader reader(filename, response_filename);
+   Sift::Instruction inst;
+   uint64_t count = 0, checksum = 0;
+   while(reader.Read(inst))
+   {
+      ++count;
+      checksum += inst.addresses[0];
+   }
+
+   double t_elapsed = now() - t_start;
+
+   int status;
+   waitpid(pid, &status, 0);
+   unlink(filename);
+   unlink(response_filename);
+
+   printf("%-6s %12" PRIu64 " records  %8.3f s  %8.2f Mrecords/s  (checksum %016" PRIx64 ")\n",
+      shm ? "shm" : "pipe", count, t_elapsed, count / t_elapsed / 1e6, checksum);
+
+   return count == records;
+}
+
+static bool benchmarkCompression(const char *filename, const char *output_filename, unsigned int max_threads)
+{
+   std::ifstream file(filename, std::ios::in | std::ios::binary);
+   std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+   const Sift::Header *hdr = reinterpret_cast<const Sift::Header*>(data.data());
+   if (data.size() < sizeof(Sift::Header) || hdr->magic != Sift::MagicNumber)
+   {
+      fprintf(stderr, "%s: not a SIFT trace\n", filename);
+      return false;
+   }
+   if (hdr->options & (Sift::CompressionZlib | Sift::CompressionBlock | Sift::SharedMemory))
+   {
+      fprintf(stderr, "%s: expected an uncompressed trace file\n", filename);
+      return false;
+   }
+
+   size_t header_size = sizeof(Sift::Header) + hdr->size;
+   const uint8_t *records = data.data() + header_size;
+   size_t size = data.size() - header_size;
+
+   // Compress
+   struct Block { size_t offset, raw_size; std::vector<uint8_t> comp; };
+   std::vector<Block> blocks;
+   std::vector<uint32_t> hashtable(Sift::BlockCodec::HashTableSize);
+   size_t comp_total = 0;
+
+   double t_start = now();
+   for(size_t offset = 0; offset < size; offset += Sift::BlockCodec::BlockSize)
+   {
+      Block block;
+      block.offset = offset;
+      block.raw_size = std::min(size - offset, size_t(Sift::BlockCodec::BlockSize));
+      block.comp.resize(Sift::BlockCodec::compressBound(block.raw_size));
+      size_t comp_size = Sift::BlockCodec::compress(records + offset, block.raw_size, block.comp.data(), block.comp.size(), hashtable.data());
+      block.comp.resize(comp_size);
+      comp_total += comp_size + sizeof(Sift::BlockCodec::BlockHeader);
+      blocks.push_back(block);
+   }
+   double t_compress = now() - t_start;
+
+   printf("%s: %zu bytes -> %zu bytes, ratio %.2fx, compress %.1f MB/s\n",
+      filename, size, comp_total, double(size) / comp_total, size / t_compress / 1e6);
+
+   // Decompress, blocks are independent so threads simply take every n-th block
+   std::vector<uint8_t> raw(size);
+   for(unsigned int num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+   {
+      memset(raw.data(), 0, size);
+      bool ok = true;
+      t_start = now();
+      std::vector<std::thread> threads;
+      for(unsigned int t = 0; t < num_threads; ++t)
+         threads.push_back(std::thread([&, t]() {
+            for(size_t i = t; i < blocks.size(); i += num_threads)
+               if (!Sift::BlockCodec::decompress(blocks[i].comp.data(), blocks[i].comp.size(), raw.data() + blocks[i].offset, blocks[i].raw_size))
+                  ok = false;
+         }));
+      for(auto &thread : threads)
+         thread.join();
+      double t_decompress = now() - t_start;
+      ok = ok && memcmp(raw.data(), records, size) == 0;
+
+      printf("   decode %2u thread%s  %8.2f GB/s  %s\n", num_threads, num_threads > 1 ? "s" : " ", size / t_decompress / 1e9, ok ? "ok" : "MISMATCH");
+      if (!ok)
+         return false;
+   }
+
+   if (output_filename)
+   {
+      // Write through the same path as Sift::Writer, then read it back through Sift::Reader's stream
+      Sift::Header out_hdr = *hdr;
+      out_hdr.options |= Sift::CompressionBlock;
+      vostream *output = new vofstream(output_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+      output->write(reinterpret_cast<const char*>(&out_hdr), sizeof(out_hdr));
+      output->write(reinterpret_cast<const char*>(data.data() + sizeof(Sift::Header)), hdr->size);
+      output = new oblockstream(output, header_size, true);
+      output->write(reinterpret_cast<const char*>(records), size);
+      delete output;
+
+      vifstream *input = new vifstream(output_filename, std::ios::in | std::ios::binary);
+      std::vector<char> skip(header_size);
+      input->read(skip.data(), header_size);
+      iblockstream stream(input, header_size, max_threads);
+      t_start = now();
+      std::vector<char> buffer(size);
+      stream.read(buffer.data(), size);
+      double t_read = now() - t_start;
+      bool ok = !stream.fail() && memcmp(buffer.data(), records, size) == 0;
+
+      std::vector<Sift::BlockCodec::BlockIndexEntry> index;
+      ok = ok && Sift::BlockCodec::readIndex(output_filename, index) && index.size() == blocks.size();
+
+      printf("   wrote %s, stream read with %u helper thread%s %8.2f GB/s  %s\n", output_filename, max_threads, max_threads > 1 ? "s" : "", size / t_read / 1e9, ok ? "ok" : "MISMATCH");
+      if (!ok)
+         return false;
+   }
+
+   return true;
+}
+
+int main(int argc, char* argv[])
+{
+   uint64_t records = 100000000;
+   uint64_t sync_interval = 0;
+   bool do_pipe = true, do_shm = true;
+   std::vector<const char*> compress_files;
+   const char *output_filename = NULL;
+   unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+   int opt;
+   while ((opt = getopt(argc, argv, "n:s:t:z:o:j:")) != -1)
+   {
+      switch(opt)
+      {
+         case 'n':
+            records = strtoull(optarg, NULL, 0);
+            break;
+         case 's':
+            sync_interval = strtoull(optarg, NULL, 0);
+            break;
+         case 't':
+            do_pipe = strcmp(optarg, "pipe") == 0;
+            do_shm = strcmp(optarg, "shm") == 0;
+            break;
+         case 'z':
+            compress_files.push_back(optarg);
+            break;
+         case 'o':
+            output_filename = optarg;
+            break;
+         case 'j':
+            max_threads = atoi(optarg);
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-n <records>] [-s <sync interval>] [-t pipe|shm]\n", argv[0]);
+            fprintf(stderr, "       %s -z <trace.sift> [-z <trace.sift> ...] [-o <compressed.sift>] [-j <max threads>]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   bool ok = true;
+   if (!compress_files.empty())
+   {
+      for(auto filename : compress_files)
+         ok &= benchmarkCompression(filename, compress_files.size() == 1 ? output_filename : NULL, max_threads);
+      return ok ? 0 : 1;
+   }
+
+   if (do_pipe)
+      ok &= runBenchmark(false, records, sync_interval);
+   if (do_shm)
+      ok &= runBenchmark(true, records, sync_interval);
+
+   return ok ? 0 : 1;
+}
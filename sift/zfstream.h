@@ -73,6 +73,9 @@ class vistream
       virtual void read(char* s, std::streamsize n) = 0;
       virtual int peek() = 0;
       virtual bool fail() const = 0;
+      // Called from another thread to make a read that waits for more data fail. Returns false if the input
+      // cannot do that, in which case such a read keeps waiting for as long as the writer stays alive.
+      virtual bool shutdown() { return false; }
 };
 
 class vifstream : public vistream
@@ -112,6 +115,7 @@ class izstream : public vistream
       virtual int peek();
       virtual bool eof() const { return m_eof; }
       virtual bool fail() const { return m_fail; }
+      virtual bool shutdown() { return input->shutdown(); }
 };
 
 #endif // __ZFSTREAM_H
@@ -0,0 +1,119 @@
+// Lookup and replacement throughput of CacheSet for each replacement policy, on 8, 16 and 20-way sets.
+// Uses only the public CacheSet interface, so it can be built against different tag store layouts
+// (see the Makefile), and checks that find() agrees with the blocks in each set.
+
+#include "cache_set.h"
+#include "cache_block_info.h"
+#include "config_file.hpp"
+#include "simulator.h"
+
+#include <cstdio>
+#include <random>
+#include <sys/time.h>
+#include <vector>
+
+static double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static bool check(std::vector<CacheSet*> &sets)
+{
+   for (size_t s = 0; s < sets.size(); ++s)
+   {
+      for (UInt32 way = 0; way < sets[s]->getAssociativity(); ++way)
+      {
+         CacheBlockInfo *block = sets[s]->peekBlock(way);
+         if (!block->isValid())
+            continue;
+         UInt32 index = ~0;
+         if (sets[s]->find(block->getTag(), &index) != block || index != way)
+         {
+            printf("set %zu way %u: find(%#lx) returned way %u\n", s, way, (unsigned long)block->getTag(), index);
+            return false;
+         }
+      }
+      if (sets[s]->find(IntPtr(1) << 60) != NULL)
+      {
+         printf("set %zu: found a tag that was never inserted\n", s);
+         return false;
+      }
+   }
+   return true;
+}
+
+static bool benchmark(const char *policy, UInt32 associativity, UInt64 num_accesses)
+{
+   const UInt32 num_sets = 2048;
+   const UInt64 capacity = num_sets * associativity;
+
+   CacheSetInfo *set_info = CacheSet::createCacheSetInfo("bench", "perf_model/l3_cache", 0, policy, associativity);
+   std::vector<CacheSet*> sets;
+   for (UInt32 s = 0; s < num_sets; ++s)
+      sets.push_back(CacheSet::createCacheSet("perf_model/l3_cache", 0, policy, CacheBase::SHARED_CACHE, associativity, 64, set_info));
+
+   // 80% of the accesses go to a hot region of half the cache, the rest to a region four times its size
+   std::mt19937_64 rng(associativity);
+   std::vector<IntPtr> lines(1 << 20);
+   for (size_t i = 0; i < lines.size(); ++i)
+      lines[i] = (rng() % 5 < 4) ? rng() % (capacity / 2) : capacity + rng() % (4 * capacity);
+
+   UInt64 hits = 0;
+   CacheBlockInfo fill, evicted;
+   double start = now();
+   for (UInt64 i = 0; i < num_accesses; ++i)
+   {
+      IntPtr line = lines[i & (lines.size() - 1)];
+      CacheSet *set = sets[line % num_sets];
+      IntPtr tag = line / num_sets;
+      UInt32 way;
+      if (set->find(tag, &way))
+      {
+         set->read_line(way, 0, NULL, 0, true);
+         ++hits;
+      }
+      else
+      {
+         bool eviction;
+         fill.setTag(tag);
+         fill.setCState(CacheState::SHARED);
+         set->insert(&fill, NULL, &eviction, &evicted, NULL, NULL);
+      }
+   }
+   double elapsed = now() - start;
+
+   printf("%-12s %2u-way: %6.1f Maccesses/s (hit rate %.1f%%)\n", policy, associativity,
+          num_accesses / elapsed / 1e6, 100. * hits / num_accesses);
+
+   bool ok = check(sets);
+   for (size_t s = 0; s < sets.size(); ++s)
+      delete sets[s];
+   delete set_info;
+   return ok;
+}
+
+int main(int argc, char **argv)
+{
+   const char *policies[] = { "lru", "nru", "mru", "nmru", "plru", "srrip", "random", "round_robin" };
+   const UInt32 associativities[] = { 8, 16, 20 };
+   UInt64 num_accesses = argc > 1 ? atol(argv[1]) : 20000000;
+
+   // The only configuration values the replacement policies read
+   config::ConfigFile cfg;
+   cfg.loadConfigFromString("[perf_model/l3_cache/srrip]\nbits = 3\n[perf_model/l3_cache/qbs]\nattempts = 1\n");
+   Simulator::setConfig(&cfg, Config::STANDALONE);
+
+   bool ok = true;
+   for (UInt32 associativity : associativities)
+      for (const char *policy : policies)
+      {
+         // PLRU is only implemented for 4 and 8 ways
+         if (String(policy) == "plru" && associativity > 8)
+            continue;
+         ok &= benchmark(policy, associativity, num_accesses);
+      }
+
+   return ok ? 0 : 1;
+}
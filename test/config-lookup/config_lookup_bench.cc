@@ -0,0 +1,167 @@
+// Time spent in configuration lookups while creating the memory managers of 64, 256 and 1024 cores. For each core
+// this issues the lookups of the ParametricDramDirectoryMSI::MemoryManager constructor, including the loop over
+// all cores that the master core of each last-level cache does. The legacy variant splits the path and walks the
+// section tree for every lookup, as Config::getKey did; the flat variant uses the flat key table, and handles for
+// the loop over all cores. Both must read the same values.
+
+#include "config_file.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/time.h>
+
+namespace
+{
+
+const char *CACHES[] = { "l1_icache", "l1_dcache", "l2_cache", "l3_cache" };
+const UInt32 NUM_CACHES = 4;
+
+const char *SCALAR_INTS[] = {
+   "perf_model/cache/levels", "perf_model/l1_icache/cache_block_size", "perf_model/stlb/size", "perf_model/itlb/size",
+   "perf_model/dtlb/size", "perf_model/tlb/penalty", "perf_model/core/logical_cpus",
+   "perf_model/dram_directory/total_entries", "perf_model/dram_directory/associativity",
+   "perf_model/dram_directory/max_hw_sharers", "perf_model/dram_directory/home_lookup_param",
+   "perf_model/dram_directory/directory_cache_access_time", "perf_model/llc/evict_buffers",
+};
+const char *SCALAR_STRINGS[] = { "perf_model/dram_directory/directory_type", "perf_model/dram_directory/locations" };
+const char *SCALAR_BOOLS[] = { "perf_model/tlb/penalty_parallel", "perf_model/dram/direct_access" };
+const char *CACHE_INTS[] = { "cache_size", "associativity", "data_access_time", "tags_access_time", "writeback_time", "shared_cores" };
+const char *CACHE_STRINGS[] = { "dvfs_domain", "address_hash", "replacement_policy", "perf_model_type", "prefetcher" };
+const char *CACHE_BOOLS[] = { "perfect", "writethrough" };
+
+#define COUNT(a) (sizeof(a) / sizeof(a[0]))
+
+class BenchConfig : public config::ConfigFile
+{
+   public:
+      // Config::getKey before the flat key table
+      const config::Key & legacyGetKey(const String & path, UInt64 index)
+      {
+         std::vector<String> path_elements;
+         boost::split(path_elements, path, boost::is_any_of("/"));
+         String key_name = path_elements[path_elements.size() - 1];
+         config::Section & section = getSection_unsafe(path.substr(0, path.rfind("/")));
+         if (!section.hasKey(key_name, index))
+            config::KeyNotFoundError(path, index);
+         return section.getKey(key_name, index);
+      }
+};
+
+struct Legacy
+{
+   BenchConfig *cfg;
+   SInt64 getInt(const String & path, UInt64 index = UINT64_MAX) { return cfg->legacyGetKey(path, index).getInt(); }
+   String getString(const String & path, UInt64 index = UINT64_MAX) { return cfg->legacyGetKey(path, index).getString(); }
+   bool getBool(const String & path, UInt64 index = UINT64_MAX) { return cfg->legacyGetKey(path, index).getBool(); }
+
+   UInt64 allCores(UInt32 num_cores, UInt64 checksum)
+   {
+      for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      {
+         checksum = checksum * 31 + getInt("perf_model/l1_dcache/cache_size", core_id);
+         checksum = checksum * 31 + getString("perf_model/l1_dcache/address_hash", core_id).size();
+      }
+      return checksum;
+   }
+};
+
+struct Flat
+{
+   BenchConfig *cfg;
+   SInt64 getInt(const String & path, UInt64 index = UINT64_MAX) { return cfg->getIntArray(path, index); }
+   String getString(const String & path, UInt64 index = UINT64_MAX) { return cfg->getStringArray(path, index); }
+   bool getBool(const String & path, UInt64 index = UINT64_MAX) { return cfg->getBoolArray(path, index); }
+
+   UInt64 allCores(UInt32 num_cores, UInt64 checksum)
+   {
+      config::Handle<SInt64> cache_size = cfg->getHandle<SInt64>("perf_model/l1_dcache/cache_size");
+      config::Handle<String> address_hash = cfg->getHandle<String>("perf_model/l1_dcache/address_hash");
+      for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      {
+         checksum = checksum * 31 + cache_size.get(core_id);
+         checksum = checksum * 31 + address_hash.get(core_id).size();
+      }
+      return checksum;
+   }
+};
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class L> UInt64 createMemoryManagers(L lookup, UInt32 num_cores, double &seconds)
+{
+   UInt64 checksum = 0;
+   double start = now();
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+   {
+      for(UInt32 i = 0; i < COUNT(SCALAR_INTS); ++i)
+         checksum = checksum * 31 + lookup.getInt(SCALAR_INTS[i]);
+      for(UInt32 i = 0; i < COUNT(SCALAR_STRINGS); ++i)
+         checksum = checksum * 31 + lookup.getString(SCALAR_STRINGS[i]).size();
+      for(UInt32 i = 0; i < COUNT(SCALAR_BOOLS); ++i)
+         checksum = checksum * 31 + lookup.getBool(SCALAR_BOOLS[i]);
+
+      for(UInt32 c = 0; c < NUM_CACHES; ++c)
+      {
+         String prefix = String("perf_model/") + CACHES[c] + "/";
+         checksum = checksum * 31 + lookup.getInt(prefix + "cache_block_size");
+         for(UInt32 i = 0; i < COUNT(CACHE_INTS); ++i)
+            checksum = checksum * 31 + lookup.getInt(prefix + CACHE_INTS[i], core_id);
+         for(UInt32 i = 0; i < COUNT(CACHE_STRINGS); ++i)
+            checksum = checksum * 31 + lookup.getString(prefix + CACHE_STRINGS[i], core_id).size();
+         for(UInt32 i = 0; i < COUNT(CACHE_BOOLS); ++i)
+            checksum = checksum * 31 + lookup.getBool(prefix + CACHE_BOOLS[i], core_id);
+         if (c + 1 < NUM_CACHES)
+            checksum = checksum * 31 + lookup.getInt(prefix + "next_level_read_bandwidth", core_id);
+      }
+      checksum = checksum * 31 + lookup.getBool("perf_model/l1_icache/coherent", core_id);
+      checksum = checksum * 31 + lookup.getInt("perf_model/l1_dcache/outstanding_misses", core_id);
+      checksum = checksum * 31 + lookup.getBool("perf_model/nuca/enabled", core_id);
+      checksum = checksum * 31 + lookup.getBool("perf_model/dram/cache/enabled", core_id);
+
+      // Master core of the last-level cache checks the L1-D of all cores
+      if (core_id % lookup.getInt("perf_model/l3_cache/shared_cores", core_id) == 0)
+         checksum = lookup.allCores(num_cores, checksum);
+   }
+   seconds = now() - start;
+   return checksum;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+   String source;
+   for(int i = 1; i < argc; ++i)
+   {
+      std::ifstream file(argv[i]);
+      std::stringstream contents;
+      contents << file.rdbuf();
+      source += String(contents.str().c_str()) + "\n";
+   }
+
+   BenchConfig cfg;
+   double start = now();
+   cfg.loadConfigFromString(source);
+   printf("load: %.2f ms\n", (now() - start) * 1e3);
+
+   bool ok = true;
+   printf("%-8s %14s %14s\n", "cores", "legacy ms", "flat ms");
+   for(UInt32 num_cores = 64; num_cores <= 1024; num_cores *= 4)
+   {
+      double seconds_legacy, seconds_flat;
+      UInt64 checksum_legacy = createMemoryManagers(Legacy{&cfg}, num_cores, seconds_legacy);
+      UInt64 checksum_flat = createMemoryManagers(Flat{&cfg}, num_cores, seconds_flat);
+      ok &= checksum_legacy == checksum_flat;
+      printf("%-8u %14.2f %14.2f\n", num_cores, seconds_legacy * 1e3, seconds_flat * 1e3);
+   }
+   if (!ok)
+      printf("ERROR: the lookups returned different values\n");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Invalidation fan-outs per second for a 128-core directory whose entries have random sets of sharers. Each step
+// picks an entry and sends an invalidation to each of its sharers, as processExReqFromL2Cache does for a line in
+// SHARED state.
+// The legacy variant allocates every entry separately, keeps sharers in a std::bitset and builds a
+// std::vector of sharers for every fan-out, as getSharersList did. The new variant stores the entries in one
+// array (as Directory does now) and iterates over the sharers with getFirstSharer / getNextSharer.
+
+#include "directory_entry_limited_no_broadcast.h"
+
+#include <bitset>
+#include <cstdio>
+#include <sys/time.h>
+#include <vector>
+
+namespace
+{
+
+const UInt32 NUM_CORES = 128;
+const UInt32 NUM_ENTRIES = 1 << 16;
+const UInt64 NUM_STEPS = 1 << 22;
+
+typedef DirectoryEntryLimitedNoBroadcast<DirectorySharersBitset<NUM_CORES> > Entry;
+
+class LegacyEntry
+{
+   public:
+      LegacyEntry() : m_sharers() {}
+      virtual ~LegacyEntry() {}
+
+      virtual void addSharer(core_id_t sharer_id) { m_sharers[sharer_id] = true; }
+      virtual UInt32 getNumSharers() { return m_sharers.count(); }
+      virtual std::pair<bool, std::vector<core_id_t> > getSharersList()
+      {
+         std::pair<bool, std::vector<core_id_t> > sharers_list;
+         sharers_list.first = false;
+         sharers_list.second.resize(getNumSharers());
+
+         SInt32 i = 0;
+         for(UInt32 j = 0; j < m_sharers.size(); ++j)
+            if (m_sharers[j])
+               sharers_list.second[i++] = j;
+         return sharers_list;
+      }
+
+   private:
+      std::bitset<NUM_CORES> m_sharers;
+};
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+UInt64 next(UInt64 &state)
+{
+   state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+   return state;
+}
+
+// Sharers of an entry: up to max_sharers random cores
+template <class F> void forSharers(UInt64 &state, UInt32 max_sharers, F f)
+{
+   UInt32 num = next(state) % (max_sharers + 1);
+   for(UInt32 n = 0; n < num; ++n)
+      f(next(state) % NUM_CORES);
+}
+
+UInt64 runLegacy(UInt32 max_sharers, double &rate)
+{
+   UInt64 state = 0x2545f4914f6cdd1dULL, checksum = 0;
+   std::vector<LegacyEntry*> entries(NUM_ENTRIES);
+   for(UInt32 e = 0; e < NUM_ENTRIES; ++e)
+   {
+      LegacyEntry *entry = entries[e] = new LegacyEntry();
+      forSharers(state, max_sharers, [entry](core_id_t sharer_id) { entry->addSharer(sharer_id); });
+   }
+
+   double start = now();
+   for(UInt64 step = 0; step < NUM_STEPS; ++step)
+   {
+      LegacyEntry *entry = entries[next(state) % NUM_ENTRIES];
+      std::pair<bool, std::vector<core_id_t> > sharers_list_pair = entry->getSharersList();
+      for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
+         checksum = checksum * 31 + sharers_list_pair.second[i];   // sendMsg(INV_REQ)
+   }
+   rate = NUM_STEPS / (now() - start);
+
+   for(UInt32 e = 0; e < NUM_ENTRIES; ++e)
+      delete entries[e];
+   return checksum;
+}
+
+UInt64 runIterator(UInt32 max_sharers, double &rate)
+{
+   UInt64 state = 0x2545f4914f6cdd1dULL, checksum = 0;
+   std::vector<Entry> entries(NUM_ENTRIES, Entry(NUM_CORES, NUM_CORES));
+   for(UInt32 e = 0; e < NUM_ENTRIES; ++e)
+   {
+      Entry *entry = &entries[e];
+      forSharers(state, max_sharers, [entry](core_id_t sharer_id) { if (!entry->hasSharer(sharer_id)) entry->addSharer(sharer_id, NUM_CORES); });
+   }
+
+   double start = now();
+   for(UInt64 step = 0; step < NUM_STEPS; ++step)
+   {
+      Entry *entry = &entries[next(state) % NUM_ENTRIES];
+      for (core_id_t sharer_id = entry->getFirstSharer(); sharer_id != INVALID_CORE_ID; sharer_id = entry->getNextSharer(sharer_id))
+         checksum = checksum * 31 + sharer_id;   // sendMsg(INV_REQ)
+   }
+   rate = NUM_STEPS / (now() - start);
+   return checksum;
+}
+
+}
+
+int main()
+{
+   bool ok = true;
+   printf("%-12s %16s %16s\n", "max-sharers", "legacy Mfan/s", "iterator Mfan/s");
+   for(UInt32 max_sharers = 2; max_sharers <= NUM_CORES; max_sharers *= 4)
+   {
+      double rate_legacy, rate_iterator;
+      UInt64 checksum_legacy = runLegacy(max_sharers, rate_legacy);
+      UInt64 checksum_iterator = runIterator(max_sharers, rate_iterator);
+      ok &= checksum_legacy == checksum_iterator;
+      printf("%-12u %16.2f %16.2f\n", max_sharers, rate_legacy / 1e6, rate_iterator / 1e6);
+   }
+   if (!ok)
+      printf("ERROR: invalidations were sent to different sharers\n");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// Accesses per second through a private L1-D and L2 and a shared L3 (Gainestown geometries), with the
+// precompiled fast_parametric levels, with the run-time geometry fallback and with the tag-only sets that
+// fast_nehalem uses. All three must see the same misses. Then several cores with private L1s behind a coherent
+// shared L2 read and write a few lines, checking the MESI invariants after every access.
+
+#include "fast_cache.h"
+
+#include <cstdio>
+#include <sys/time.h>
+#include <vector>
+
+using namespace FastParametric;
+
+namespace
+{
+
+const UInt64 NUM_STEPS = 1 << 24;
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+UInt64 next(UInt64 &state)
+{
+   state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+   return state;
+}
+
+// Mostly a 24 KB working set, sometimes anywhere in 64 MB
+IntPtr nextTag(UInt64 &state)
+{
+   UInt64 r = next(state);
+   return (r >> 8) % (r % 10 ? 24 * 1024 / 64 : 64 * 1024 * 1024 / 64);
+}
+
+// fast_nehalem's CacheSet
+template <UInt32 assoc>
+class LegacySet
+{
+   private:
+      IntPtr m_tags[assoc];
+      UInt64 m_lru[assoc];
+      UInt64 m_lru_max;
+   public:
+      LegacySet() : m_tags(), m_lru(), m_lru_max(0) {}
+      bool find(IntPtr tag)
+      {
+         for(unsigned int idx = 0; idx < assoc; ++idx)
+         {
+            if (m_tags[idx] == tag)
+            {
+               m_lru[idx] = ++m_lru_max;
+               return true;
+            }
+         }
+         UInt64 lru_min = UINT64_MAX; unsigned int idx_min = 0;
+         for(unsigned int idx = 0; idx < assoc; ++idx)
+         {
+            if (m_lru[idx] < lru_min)
+            {
+               lru_min = m_lru[idx];
+               idx_min = idx;
+            }
+         }
+         m_tags[idx_min] = tag;
+         m_lru[idx_min] = ++m_lru_max;
+         return false;
+      }
+};
+
+UInt64 runLegacy(double &rate)
+{
+   std::vector<LegacySet<8> > l1(64), l2(512);
+   std::vector<LegacySet<16> > l3(8192);
+   UInt64 state = 0x2545f4914f6cdd1dULL, misses = 0;
+
+   double start = now();
+   for(UInt64 step = 0; step < NUM_STEPS; ++step)
+   {
+      IntPtr tag = nextTag(state) + 1;    // Tag zero is an empty way
+      if (!l1[tag & 63].find(tag) && !l2[tag & 511].find(tag) && !l3[tag & 8191].find(tag))
+         ++misses;
+   }
+   rate = NUM_STEPS / (now() - start);
+   return misses;
+}
+
+// The private and shared lookups of FastParametric::MemoryManager::coreInitiateMemoryAccessFast
+UInt64 runHierarchy(PrivateCacheBase* l1, PrivateCacheBase* l2, SharedCacheBase* l3, double &rate)
+{
+   PrivateCacheBase* levels[] = { l1, l2 };
+   UInt64 state = 0x2545f4914f6cdd1dULL, misses = 0;
+
+   double start = now();
+   for(UInt64 step = 0; step < NUM_STEPS; ++step)
+   {
+      IntPtr tag = nextTag(state) + 1;
+      Core::mem_op_t mem_op_type = step % 4 ? Core::READ : Core::WRITE;
+      UInt32 level = 0;
+      state_t line_state = INVALID;
+      for(; level < 2 && line_state == INVALID; ++level)
+         line_state = levels[level]->access(mem_op_type, tag);
+      if (line_state == INVALID)
+      {
+         if (!l3->access(0, mem_op_type, tag, line_state))
+            ++misses;
+      }
+      else
+      {
+         --level;
+         if (mem_op_type == Core::WRITE && line_state != MODIFIED)
+         {
+            levels[level]->setState(tag, line_state, MODIFIED);
+            line_state = MODIFIED;
+         }
+      }
+      for(UInt32 above = 0; above < level; ++above)
+         levels[above]->insert(tag, line_state);
+   }
+   rate = NUM_STEPS / (now() - start);
+   return misses;
+}
+
+class Peer : public SharedCacheBase::Peer
+{
+   public:
+      PrivateCacheBase* l1;
+      void invalidate(IntPtr tag) { l1->invalidate(tag); }
+      void downgrade(IntPtr tag) { l1->downgrade(tag); }
+      void fill(IntPtr tag, state_t state)
+      {
+         state_t current = l1->peek(tag);
+         if (current == INVALID)
+            l1->insert(tag, state);
+         else
+            l1->setState(tag, current, state);
+      }
+};
+
+bool checkCoherence()
+{
+   const UInt32 NUM_CORES = 4, NUM_LINES = 64;
+   SharedCache<2, 8> l2(2, 8, "L2", 0, NUM_CORES, true);     // Smaller than the lines used, to test back-invalidation
+   std::vector<Peer> peers(NUM_CORES);
+   for(UInt32 core = 0; core < NUM_CORES; ++core)
+   {
+      // Tiny L1s, so that lines are also evicted silently
+      peers[core].l1 = new PrivateCache<2, 4>(2, 4, "L1-D", core);
+      l2.setPeer(core, &peers[core]);
+   }
+
+   UInt64 state = 0x2545f4914f6cdd1dULL;
+   for(UInt64 step = 0; step < 1 << 20; ++step)
+   {
+      UInt32 core = next(state) % NUM_CORES;
+      IntPtr tag = next(state) % NUM_LINES;
+      Core::mem_op_t mem_op_type = next(state) % 3 ? Core::READ : Core::WRITE;
+      PrivateCacheBase* l1 = peers[core].l1;
+
+      state_t line_state = l1->access(mem_op_type, tag);
+      if (line_state == INVALID)
+         l2.access(core, mem_op_type, tag, line_state);
+      else if (mem_op_type == Core::WRITE && line_state != MODIFIED)
+      {
+         if (line_state == SHARED || !l1->setState(tag, line_state, MODIFIED))
+            l2.upgrade(core, tag);
+      }
+
+      // At most one exclusive copy, and then no other copies. Reads without a fill do not change any state.
+      UInt32 valid = 0, exclusive = 0;
+      for(UInt32 c = 0; c < NUM_CORES; ++c)
+      {
+         state_t s = peers[c].l1->access(Core::READ, tag);
+         valid += s != INVALID;
+         exclusive += s == EXCLUSIVE || s == MODIFIED;
+      }
+      if (exclusive > 1 || (exclusive == 1 && valid > 1) || (mem_op_type == Core::WRITE && exclusive != 1))
+      {
+         printf("step %lu: core %u %s line %lu, %u copies of which %u exclusive\n", (unsigned long)step, core,
+                mem_op_type == Core::WRITE ? "wrote" : "read", (unsigned long)tag, valid, exclusive);
+         return false;
+      }
+   }
+
+   for(UInt32 core = 0; core < NUM_CORES; ++core)
+      delete peers[core].l1;
+   return true;
+}
+
+}
+
+int main()
+{
+   double rate_legacy, rate_precompiled, rate_generic;
+   UInt64 misses_legacy = runLegacy(rate_legacy);
+
+   PrivateCache<8, 64> l1(8, 64, "L1-D", 0);
+   PrivateCache<8, 512> l2(8, 512, "L2", 0);
+   SharedCache<16, 8192> l3(16, 8192, "L3", 0, 1, false);
+   UInt64 misses_precompiled = runHierarchy(&l1, &l2, &l3, rate_precompiled);
+
+   PrivateCache<0, 0> l1_generic(8, 64, "L1-D", 0);
+   PrivateCache<0, 0> l2_generic(8, 512, "L2", 0);
+   SharedCache<0, 0> l3_generic(16, 8192, "L3", 0, 1, false);
+   UInt64 misses_generic = runHierarchy(&l1_generic, &l2_generic, &l3_generic, rate_generic);
+
+   printf("%-14s %12s %12s\n", "", "Macc/s", "misses");
+   printf("%-14s %12.2f %12lu\n", "fast_nehalem", rate_legacy / 1e6, (unsigned long)misses_legacy);
+   printf("%-14s %12.2f %12lu\n", "precompiled", rate_precompiled / 1e6, (unsigned long)misses_precompiled);
+   printf("%-14s %12.2f %12lu\n", "generic", rate_generic / 1e6, (unsigned long)misses_generic);
+
+   bool ok = misses_legacy == misses_precompiled && misses_precompiled == misses_generic;
+   if (!ok)
+      printf("ERROR: the hierarchies missed on different accesses\n");
+   if (!checkCoherence())
+   {
+      printf("ERROR: coherence invariants violated\n");
+      ok = false;
+   }
+   return ok ? 0 : 1;
+}
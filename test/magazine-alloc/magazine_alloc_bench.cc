@@ -0,0 +1,131 @@
+// Allocations per second of TypedAllocator vs. MagazineAllocator, with one allocator per thread (as for each core's
+// performance model). Every fourth batch of objects is handed to the next thread, which frees them (a remote free).
+
+#include "allocator.h"
+#include "spsc_queue.h"
+
+#include <cstdio>
+#include <pthread.h>
+#include <sys/time.h>
+#include <vector>
+
+namespace
+{
+
+struct Object
+{
+   UInt64 payload[16];
+   static Allocator *allocator;
+};
+
+const UInt64 NUM_ALLOCS = 1 << 22;
+const UInt32 BATCH = 64;
+const UInt32 REMOTE_EVERY = 4;
+
+struct Worker
+{
+   Allocator *allocator;
+   SPSCQueue<void*> *to_next;
+   SPSCQueue<void*> *from_prev;
+   pthread_barrier_t *barrier;
+   UInt64 remote;
+};
+
+void drain(SPSCQueue<void*> *queue, UInt64 &remote)
+{
+   while (void **ptr = queue->front())
+   {
+      Allocator::dealloc(*ptr);
+      queue->pop();
+      ++remote;
+   }
+}
+
+void* work(void *arg)
+{
+   Worker *worker = (Worker*)arg;
+   void *batch[BATCH];
+
+   pthread_barrier_wait(worker->barrier);
+   for(UInt64 n = 0, i = 0; n < NUM_ALLOCS; n += BATCH, ++i)
+   {
+      for(UInt32 j = 0; j < BATCH; ++j)
+      {
+         batch[j] = worker->allocator->alloc(sizeof(Object));
+         ((Object*)batch[j])->payload[0] = n + j;
+      }
+      for(UInt32 j = 0; j < BATCH; ++j)
+      {
+         void **slot;
+         if (worker->to_next && i % REMOTE_EVERY == 0 && (slot = worker->to_next->back()))
+         {
+            *slot = batch[j];
+            worker->to_next->push();
+         }
+         else
+            Allocator::dealloc(batch[j]);
+      }
+      if (worker->from_prev)
+         drain(worker->from_prev, worker->remote);
+   }
+   pthread_barrier_wait(worker->barrier);
+   if (worker->from_prev)
+      drain(worker->from_prev, worker->remote);
+   return NULL;
+}
+
+template <class A> void run(const char *name, UInt32 num_threads)
+{
+   std::vector<Worker> workers(num_threads);
+   std::vector<SPSCQueue<void*>*> queues(num_threads);
+   std::vector<pthread_t> threads(num_threads);
+   pthread_barrier_t barrier;
+   pthread_barrier_init(&barrier, NULL, num_threads + 1);
+
+   for(UInt32 t = 0; t < num_threads; ++t)
+      queues[t] = num_threads > 1 ? new SPSCQueue<void*>(64 * BATCH) : NULL;
+   for(UInt32 t = 0; t < num_threads; ++t)
+   {
+      workers[t].allocator = new A();
+      workers[t].to_next = queues[t];
+      workers[t].from_prev = queues[(t + num_threads - 1) % num_threads];
+      workers[t].barrier = &barrier;
+      workers[t].remote = 0;
+      pthread_create(&threads[t], NULL, work, &workers[t]);
+   }
+
+   struct timeval start, stop;
+   pthread_barrier_wait(&barrier);
+   gettimeofday(&start, NULL);
+   pthread_barrier_wait(&barrier);
+   gettimeofday(&stop, NULL);
+
+   UInt64 remote = 0;
+   for(UInt32 t = 0; t < num_threads; ++t)
+   {
+      pthread_join(threads[t], NULL);
+      remote += workers[t].remote;
+   }
+   for(UInt32 t = 0; t < num_threads; ++t)
+   {
+      delete workers[t].allocator;
+      delete queues[t];
+   }
+   pthread_barrier_destroy(&barrier);
+
+   double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_usec - start.tv_usec) / 1e6;
+   printf("%-18s threads=%-3u %8.1f Malloc/s  (%.1f Malloc/s per thread, %4.1f%% remote frees)\n", name, num_threads,
+      num_threads * NUM_ALLOCS / seconds / 1e6, NUM_ALLOCS / seconds / 1e6, 100. * remote / (num_threads * NUM_ALLOCS));
+}
+
+}
+
+int main(int argc, char **argv)
+{
+   for(UInt32 num_threads = 1; num_threads <= 64; num_threads *= 2)
+   {
+      run<TypedAllocator<Object> >("TypedAllocator", num_threads);
+      run<MagazineAllocator<Object> >("MagazineAllocator", num_threads);
+   }
+   return 0;
+}
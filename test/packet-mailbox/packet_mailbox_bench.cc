@@ -0,0 +1,187 @@
+// Messages per second from N sender threads to N receiver threads, each sender spreading its messages over all
+// receivers. Like cores waiting for their misses, senders have at most WINDOW messages in flight. The copying variant does what SmTransport did before: build the packet in a new buffer, copy it into
+// another one for the destination's mutex-protected queue, and copy the payload out again on receive.
+// The mailbox variant builds the packet once in a PacketArena buffer and hands it over by pointer.
+// Receivers check that packets from each sender arrive in order.
+
+#include "packet_arena.h"
+#include "packet_mailbox.h"
+#include "lock.h"
+#include "cond.h"
+
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <queue>
+#include <sys/time.h>
+#include <vector>
+
+namespace
+{
+
+const UInt64 NUM_MESSAGES = 1 << 18;   // Per sender
+const UInt32 HEADER_SIZE = 48;         // sizeof(NetPacket)
+const UInt32 PAYLOAD_SIZE = 176;       // A ShmemMsg with a 64-byte cache line
+const UInt64 WINDOW = 64;
+
+struct Message
+{
+   UInt32 sender;
+   UInt64 seq;
+};
+
+class CopyingQueue
+{
+   public:
+      void send(const Byte *packet, UInt32 length)
+      {
+         Byte *data = new Byte[length];
+         memcpy(data, packet, length);
+         m_lock.acquire();
+         m_queue.push(data);
+         m_lock.release();
+         m_cond.broadcast();
+      }
+      Byte* recv()
+      {
+         m_lock.acquire();
+         while (m_queue.empty())
+            m_cond.wait(m_lock);
+         Byte *data = m_queue.front();
+         m_queue.pop();
+         m_lock.release();
+         return data;
+      }
+   private:
+      std::queue<Byte*> m_queue;
+      Lock m_lock;
+      ConditionVariable m_cond;
+};
+
+struct Copying
+{
+   std::vector<CopyingQueue> queues;
+   Copying(UInt32 n) : queues(n) {}
+
+   void send(UInt32 dest, const Message &message)
+   {
+      Byte *buffer = new Byte[HEADER_SIZE + PAYLOAD_SIZE];   // NetPacket::makeBuffer
+      memset(buffer, 0, HEADER_SIZE);
+      memcpy(buffer + HEADER_SIZE, &message, sizeof(message));
+      queues[dest].send(buffer, HEADER_SIZE + PAYLOAD_SIZE);
+      delete [] buffer;
+   }
+   Message recv(UInt32 self)
+   {
+      Byte *buffer = queues[self].recv();
+      Byte *payload = new Byte[PAYLOAD_SIZE];                // NetPacket(Byte*)
+      memcpy(payload, buffer + HEADER_SIZE, PAYLOAD_SIZE);
+      delete [] buffer;
+      Message message = *(Message*)payload;
+      delete [] payload;
+      return message;
+   }
+};
+
+struct Mailbox
+{
+   std::vector<PacketMailbox> mailboxes;
+   Mailbox(UInt32 n) : mailboxes(n) {}
+
+   void send(UInt32 dest, const Message &message)
+   {
+      Byte *buffer = PacketArena::alloc(HEADER_SIZE + PAYLOAD_SIZE);
+      memset(buffer, 0, HEADER_SIZE);
+      memcpy(buffer + HEADER_SIZE, &message, sizeof(message));
+      mailboxes[dest].push(buffer);
+   }
+   Message recv(UInt32 self)
+   {
+      Byte *buffer = mailboxes[self].pop();
+      Message message = *(Message*)(buffer + HEADER_SIZE);
+      PacketArena::free(buffer);
+      return message;
+   }
+};
+
+template <class T> struct Thread
+{
+   T *transport;
+   UInt32 index, num;
+   UInt64 *received;   // Per sender
+   bool ok;
+};
+
+template <class T> void* sender(void *arg)
+{
+   Thread<T> *thread = (Thread<T>*)arg;
+   for(UInt64 seq = 0; seq < NUM_MESSAGES; ++seq)
+   {
+      while (seq - __atomic_load_n(&thread->received[thread->index], __ATOMIC_ACQUIRE) >= WINDOW)
+         sched_yield();
+      thread->transport->send((thread->index + seq) % thread->num, Message{ thread->index, seq });
+   }
+   return NULL;
+}
+
+template <class T> void* receiver(void *arg)
+{
+   Thread<T> *thread = (Thread<T>*)arg;
+   std::vector<SInt64> last(thread->num, -1);
+   for(UInt64 n = 0; n < NUM_MESSAGES; ++n)
+   {
+      Message message = thread->transport->recv(thread->index);
+      if (SInt64(message.seq) <= last[message.sender])
+         thread->ok = false;
+      last[message.sender] = message.seq;
+      __atomic_fetch_add(&thread->received[message.sender], 1, __ATOMIC_RELEASE);
+   }
+   return NULL;
+}
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class T> double run(UInt32 num, bool &ok)
+{
+   T transport(num);
+   std::vector<Thread<T> > threads(2 * num);
+   std::vector<pthread_t> tids(2 * num);
+   std::vector<UInt64> received(num, 0);
+
+   double start = now();
+   for(UInt32 i = 0; i < 2 * num; ++i)
+   {
+      threads[i] = Thread<T>{ &transport, i % num, num, &received[0], true };
+      pthread_create(&tids[i], NULL, i < num ? receiver<T> : sender<T>, &threads[i]);
+   }
+   for(UInt32 i = 0; i < 2 * num; ++i)
+   {
+      pthread_join(tids[i], NULL);
+      ok &= threads[i].ok;
+   }
+   return num * NUM_MESSAGES / (now() - start);
+}
+
+}
+
+int main()
+{
+   bool ok = true;
+   printf("%-8s %18s %18s\n", "senders", "copying Mmsg/s", "mailbox Mmsg/s");
+   for(UInt32 num = 1; num <= 32; num *= 2)
+   {
+      double copying = run<Copying>(num, ok);
+      double mailbox = run<Mailbox>(num, ok);
+      printf("%-8u %18.2f %18.2f\n", num, copying / 1e6, mailbox / 1e6);
+      fflush(stdout);
+   }
+   if (!ok)
+      printf("ERROR: packets were received out of order\n");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Operations per second on a directory's request queues. Each step either starts a request for a random line
+// (enqueue, and front when it is the only one waiting, as in handleMsgFromL2Cache) or completes the oldest
+// request of a line that has one outstanding (dequeue, then front of the next waiter, as in
+// processNextReqFromL2Cache). Lines come from a small hot set, so some of them collect several waiters.
+// The legacy variant is the std::map of heap-allocated std::queues that the flat table replaced.
+
+#include "req_queue_list_template.h"
+
+#include <cstdio>
+#include <map>
+#include <queue>
+#include <sys/time.h>
+#include <vector>
+
+namespace
+{
+
+const UInt64 NUM_STEPS = 1 << 23;
+const UInt32 NUM_LINES = 1 << 20;
+const UInt32 NUM_HOT_LINES = 64;
+const UInt32 HOT_EVERY = 8;
+
+struct Request
+{
+   UInt64 id;
+};
+
+class LegacyReqQueueList
+{
+   private:
+      std::map<IntPtr, std::queue<Request*>* > m_req_queue_list;
+
+   public:
+      void enqueue(IntPtr address, Request* req)
+      {
+         if (m_req_queue_list.count(address) == 0)
+            m_req_queue_list[address] = new std::queue<Request*>();
+         m_req_queue_list[address]->push(req);
+      }
+      Request* dequeue(IntPtr address)
+      {
+         Request* req = m_req_queue_list[address]->front();
+         m_req_queue_list[address]->pop();
+         if (m_req_queue_list[address]->empty())
+         {
+            delete m_req_queue_list[address];
+            m_req_queue_list.erase(address);
+         }
+         return req;
+      }
+      Request* front(IntPtr address) { return m_req_queue_list[address]->front(); }
+      UInt32 size(IntPtr address) { return m_req_queue_list.count(address) ? m_req_queue_list[address]->size() : 0; }
+      bool empty(IntPtr address) { return m_req_queue_list.count(address) == 0; }
+};
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Returns a checksum of the order in which requests were served
+template <class Q> UInt64 run(Q &queues, UInt32 outstanding, double &rate)
+{
+   std::vector<Request> requests(outstanding);
+   std::vector<IntPtr> in_flight;       // Address of each outstanding request, in no particular order
+   UInt64 state = 0x2545f4914f6cdd1dULL, checksum = 0, id = 0;
+
+   double start = now();
+   for(UInt64 step = 0; step < NUM_STEPS; ++step)
+   {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      if (in_flight.size() < outstanding && (in_flight.empty() || state & 1))
+      {
+         IntPtr address = ((state >> 8) % (step % HOT_EVERY ? NUM_LINES : NUM_HOT_LINES)) << 6;
+         Request *req = &requests[id % outstanding];
+         req->id = id++;
+         queues.enqueue(address, req);
+         if (queues.size(address) == 1)
+            checksum = checksum * 31 + queues.front(address)->id;
+         in_flight.push_back(address);
+      }
+      else
+      {
+         UInt32 index = (state >> 8) % in_flight.size();
+         IntPtr address = in_flight[index];
+         in_flight[index] = in_flight.back();
+         in_flight.pop_back();
+         checksum = checksum * 31 + queues.dequeue(address)->id;
+         if (!queues.empty(address))
+            checksum = checksum * 31 + queues.front(address)->id;
+      }
+   }
+   rate = NUM_STEPS / (now() - start);
+   return checksum;
+}
+
+}
+
+int main()
+{
+   bool ok = true;
+   printf("%-12s %16s %16s %12s %12s %10s\n", "outstanding", "legacy Mops/s", "flat Mops/s", "probes/look", "probes-max", "overflows");
+   for(UInt32 outstanding = 16; outstanding <= 4096; outstanding *= 4)
+   {
+      double rate_legacy, rate_flat;
+      LegacyReqQueueList legacy;
+      UInt64 checksum_legacy = run(legacy, outstanding, rate_legacy);
+
+      ReqQueueListStats stats = ReqQueueListStats();
+      ReqQueueListTemplate<Request> flat(&stats);
+      UInt64 checksum_flat = run(flat, outstanding, rate_flat);
+
+      ok &= checksum_legacy == checksum_flat;
+      printf("%-12u %16.2f %16.2f %12.2f %12lu %10lu\n", outstanding, rate_legacy / 1e6, rate_flat / 1e6,
+         double(stats.probes) / stats.lookups, (unsigned long)stats.probes_max, (unsigned long)stats.overflows);
+   }
+   if (!ok)
+      printf("ERROR: requests were served in a different order\n");
+   return ok ? 0 : 1;
+}
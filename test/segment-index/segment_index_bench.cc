@@ -0,0 +1,169 @@
+// Compare SegmentIndex against the linear scan over all segments it replaces in
+// GlobalMemoryManager::policyLookup, for 10 to 100k segments, and check that
+// concurrent readers stay consistent while segments are being added.
+
+#include "segment_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+using namespace SingleLevelMemory;
+
+static double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static PolicyBase* policyFor(size_t i)
+{
+   // Fake, never dereferenced
+   return (PolicyBase*)(0x1000 + 16 * i);
+}
+
+static PolicyBase* linearLookup(const std::vector<Segment> &table, IntPtr address)
+{
+   for (const auto& seg : table)
+      if (seg.contains(address) && seg.m_policy)
+         return seg.m_policy;
+   return NULL;
+}
+
+static bool benchmark(size_t num_segments, size_t num_lookups)
+{
+   std::mt19937_64 rng(num_segments);
+
+   // Segments of 4 KB .. 64 KB with gaps in between, registered in random order
+   std::vector<Segment> segments;
+   IntPtr address = 0x10000000;
+   for (size_t i = 0; i < num_segments; ++i)
+   {
+      IntPtr length = 4096 * (1 + rng() % 16);
+      segments.push_back(Segment{0, address, address + length, policyFor(i)});
+      address += length + 4096 * (rng() % 4);
+   }
+   std::vector<Segment> order = segments;
+   std::shuffle(order.begin(), order.end(), rng);
+
+   SegmentIndex index(1);
+   double t_start = now();
+   for (const auto& seg : order)
+      if (!index.insert(seg.m_start, seg.m_end))
+         return false;
+   double t_insert = now() - t_start;
+   for (const auto& seg : order)
+   {
+      PolicyBase *old_policy;
+      if (!index.setPolicy(seg.m_start, seg.m_policy, &old_policy) || old_policy != NULL)
+         return false;
+   }
+   // Overlapping segments must be refused
+   if (index.insert(segments[num_segments / 2].m_start + 1, segments[num_segments / 2].m_start + 2))
+      return false;
+
+   // Random addresses (including ones in gaps), and a stream with locality: 64 consecutive lines per segment
+   std::vector<IntPtr> random_addresses(num_lookups), local_addresses(num_lookups);
+   size_t local_segment = 0;
+   for (size_t i = 0; i < num_lookups; ++i)
+   {
+      random_addresses[i] = segments[0].m_start + rng() % (address - segments[0].m_start);
+      if (i % 64 == 0)
+         local_segment = rng() % num_segments;
+      const Segment &seg = segments[local_segment];
+      local_addresses[i] = seg.m_start + (i % 64) * 64 % (seg.m_end - seg.m_start);
+   }
+
+   printf("%7zu segments  insert %8.1f ns/segment", num_segments, t_insert / num_segments * 1e9);
+
+   const std::vector<IntPtr>* streams[] = { &random_addresses, &local_addresses };
+   const char* names[] = { "random", "local" };
+   for (int s = 0; s < 2; ++s)
+   {
+      const std::vector<IntPtr> &addresses = *streams[s];
+
+      uintptr_t check_index = 0, check_linear = 0;
+      t_start = now();
+      for (auto a : addresses)
+         check_index += (uintptr_t)index.lookup(a, 0);
+      double t_index = now() - t_start;
+
+      // The linear scan is far too slow for the full stream at large sizes
+      size_t num_linear = std::min(num_lookups, size_t(2e8 / num_segments));
+      t_start = now();
+      for (size_t i = 0; i < num_linear; ++i)
+         check_linear += (uintptr_t)linearLookup(segments, addresses[i]);
+      double t_linear = now() - t_start;
+
+      uintptr_t check_prefix = 0;
+      for (size_t i = 0; i < num_linear; ++i)
+         check_prefix += (uintptr_t)index.lookup(addresses[i], 0);
+      if (check_prefix != check_linear)
+      {
+         printf("\n  %s: MISMATCH\n", names[s]);
+         return false;
+      }
+
+      printf("  | %s: index %6.1f ns, linear %10.1f ns", names[s], t_index / num_lookups * 1e9, t_linear / num_linear * 1e9);
+   }
+   printf("\n");
+   return true;
+}
+
+static bool concurrent(size_t num_segments, unsigned int num_readers)
+{
+   SegmentIndex index(num_readers);
+   std::atomic<size_t> inserted(0);
+   std::atomic<bool> ok(true);
+
+   std::vector<std::thread> readers;
+   for (unsigned int r = 0; r < num_readers; ++r)
+      readers.push_back(std::thread([&, r]() {
+         std::mt19937_64 rng(r);
+         while (inserted.load() < num_segments)
+         {
+            // Every segment that was published before we start looking must be found, with its policy
+            size_t n = inserted.load();
+            if (n == 0)
+               continue;
+            size_t i = rng() % n;
+            PolicyBase *policy = index.lookup(0x10000000 + i * 8192 + rng() % 4096, r);
+            if (policy != policyFor(i))
+               ok = false;
+         }
+      }));
+
+   // Insert in an order that splits chunks all over the index
+   for (size_t i = 0; i < num_segments; ++i)
+   {
+      PolicyBase *old_policy;
+      index.insert(0x10000000 + i * 8192, 0x10000000 + i * 8192 + 4096);
+      index.setPolicy(0x10000000 + i * 8192, policyFor(i), &old_policy);
+      inserted.store(i + 1);
+   }
+
+   for (auto &thread : readers)
+      thread.join();
+
+   printf("concurrent: %u readers, %zu segments  %s\n", num_readers, num_segments, ok ? "ok" : "MISMATCH");
+   return ok && index.size() == num_segments;
+}
+
+int main(int argc, char* argv[])
+{
+   size_t num_lookups = argc > 1 ? atol(argv[1]) : 10000000;
+   bool ok = true;
+
+   for (size_t num_segments = 10; num_segments <= 100000; num_segments *= 10)
+      ok &= benchmark(num_segments, num_lookups);
+
+   ok &= concurrent(20000, std::max(2u, std::thread::hardware_concurrency()));
+
+   return ok ? 0 : 1;
+}
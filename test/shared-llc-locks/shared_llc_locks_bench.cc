@@ -0,0 +1,148 @@
+// Accesses per second to a shared last-level cache's MSHR and set locks, with one host thread per core.
+// Each access takes the set lock for its line in shared mode and checks the MSHR for an overlapping miss,
+// one in MISS_EVERY accesses is a miss that upgrades to the exclusive stack lock and inserts an MSHR entry.
+// The legacy variant is the single-lock std::unordered_map that MshrTable replaced.
+
+#include "mshr_table.h"
+#include "setlock.h"
+#include "lock.h"
+
+#include <cstdio>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+const UInt64 NUM_ACCESSES = 1 << 21;
+const UInt32 NUM_LINES = 1 << 16;
+const UInt32 NUM_SETS = 64;          // Set locks are made for the L1-D sets (see MemoryManager)
+const UInt32 MISS_EVERY = 16;
+const UInt32 MSHR_BANKS = 4, MSHR_ENTRIES = 8;      // A banked setting, perf_model/cache/mshr_banks defaults to 1
+
+class LegacyMshr
+{
+   public:
+      bool isOverlapping(IntPtr address, SubsecondTime t_now)
+      {
+         ScopedLock sl(m_lock);
+         return m_mshr.count(address) && m_mshr[address].t_issue < t_now && m_mshr[address].t_complete > t_now;
+      }
+      void insert(IntPtr address, SubsecondTime t_issue, SubsecondTime t_complete)
+      {
+         ScopedLock sl(m_lock);
+         m_mshr[address].t_issue = t_issue;
+         m_mshr[address].t_complete = t_complete;
+         while (m_mshr.size() > 8)
+         {
+            IntPtr address_min = 0;
+            SubsecondTime time_min = SubsecondTime::MaxTime();
+            for(Mshr::iterator it = m_mshr.begin(); it != m_mshr.end(); ++it)
+               if (it->second.t_complete < time_min)
+               {
+                  address_min = it->first;
+                  time_min = it->second.t_complete;
+               }
+            m_mshr.erase(address_min);
+         }
+      }
+   private:
+      struct MshrEntry { SubsecondTime t_issue, t_complete; };
+      typedef std::unordered_map<IntPtr, MshrEntry> Mshr;
+      Mshr m_mshr;
+      Lock m_lock;
+};
+
+template <class M> struct Worker
+{
+   UInt32 core_id;
+   M *mshr;
+   std::vector<SetLock> *setlocks;
+   pthread_barrier_t *barrier;
+   UInt64 overlapping;
+};
+
+template <class M> void* work(void *arg)
+{
+   Worker<M> *worker = (Worker<M>*)arg;
+   UInt64 state = 0x2545f4914f6cdd1dULL * (worker->core_id + 1);
+   SubsecondTime t_now = SubsecondTime::Zero();
+
+   pthread_barrier_wait(worker->barrier);
+   for(UInt64 i = 0; i < NUM_ACCESSES; ++i)
+   {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      IntPtr address = (state % NUM_LINES) << 6;
+      SetLock &setlock = (*worker->setlocks)[(address >> 6) % NUM_SETS];
+
+      setlock.acquire_shared(worker->core_id);
+      if (worker->mshr->isOverlapping(address, t_now))
+         ++worker->overlapping;
+      if (i % MISS_EVERY == 0)
+      {
+         setlock.upgrade(worker->core_id);
+         worker->mshr->insert(address, t_now, t_now + SubsecondTime::NS(50));
+         setlock.downgrade(worker->core_id);
+      }
+      setlock.release_shared(worker->core_id);
+      t_now += SubsecondTime::NS(1);
+   }
+   return NULL;
+}
+
+double now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class M> double run(M *mshr, UInt32 num_threads, LockWaitStats *setlock_wait, UInt64 &overlapping)
+{
+   std::vector<SetLock> setlocks(NUM_SETS, SetLock(0, num_threads, setlock_wait));
+   std::vector<Worker<M> > workers(num_threads);
+   std::vector<pthread_t> threads(num_threads);
+   pthread_barrier_t barrier;
+   pthread_barrier_init(&barrier, NULL, num_threads + 1);
+
+   for(UInt32 t = 0; t < num_threads; ++t)
+   {
+      workers[t] = Worker<M>{ t, mshr, &setlocks, &barrier, 0 };
+      pthread_create(&threads[t], NULL, work<M>, &workers[t]);
+   }
+   pthread_barrier_wait(&barrier);
+   double start = now();
+   overlapping = 0;
+   for(UInt32 t = 0; t < num_threads; ++t)
+   {
+      pthread_join(threads[t], NULL);
+      overlapping += workers[t].overlapping;
+   }
+   double elapsed = now() - start;
+   pthread_barrier_destroy(&barrier);
+   return num_threads * NUM_ACCESSES / elapsed;
+}
+
+}
+
+int main()
+{
+   printf("%-8s %16s %16s %14s %16s %16s\n", "threads", "legacy Macc/s", "banked Macc/s", "overlapping", "setlock wait ms", "mshr wait ms");
+   for(UInt32 num_threads = 1; num_threads <= 64; num_threads *= 2)
+   {
+      UInt64 overlapping_legacy, overlapping_banked;
+      LockWaitStats setlock_wait = LockWaitStats(), mshr_wait = LockWaitStats(), unused = LockWaitStats();
+
+      LegacyMshr legacy;
+      double rate_legacy = run(&legacy, num_threads, &unused, overlapping_legacy);
+
+      MshrTable banked(MSHR_BANKS, MSHR_ENTRIES, &mshr_wait);
+      double rate_banked = run(&banked, num_threads, &setlock_wait, overlapping_banked);
+
+      printf("%-8u %16.2f %16.2f %14lu %16.2f %16.2f\n", num_threads, rate_legacy / 1e6, rate_banked / 1e6,
+         (unsigned long)overlapping_banked, setlock_wait.wait_time / 1e6, mshr_wait.wait_time / 1e6);
+   }
+   return 0;
+}
@@ -0,0 +1,164 @@
+// Just enough of the simulator for the standalone microbenchmarks in test/, which compile a few simulator sources
+// without a Sniper build. Provides a Simulator whose only manager is a StatsManager that drops all metrics, and
+// whose configuration is whatever the benchmark passes to Simulator::setConfig() (none by default); a pthread
+// mutex for Lock; a wall clock for Timer; and no logging. Link together with common/misc/cond.cc.
+
+#include "simulator.h"
+#include "config.h"
+#include "lock.h"
+#include "log.h"
+#include "stats.h"
+#include "timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <time.h>
+
+Simulator *Simulator::m_singleton = NULL;
+config::Config *Simulator::m_config_file = NULL;
+bool Simulator::m_config_file_allowed = true;
+Config::SimulationMode Simulator::m_mode = Config::STANDALONE;
+dl::Decoder *Simulator::m_decoder = NULL;
+
+void Simulator::allocate()
+{
+   m_singleton = new Simulator();
+}
+
+void Simulator::release()
+{
+   delete m_singleton;
+   m_singleton = NULL;
+}
+
+void Simulator::setConfig(config::Config *cfg, Config::SimulationMode mode)
+{
+   m_config_file = cfg;
+   m_mode = mode;
+}
+
+Simulator::Simulator()
+   : m_config(m_mode)
+   , m_log(m_config)
+   , m_tags_manager(NULL)
+   , m_syscall_server(NULL)
+   , m_sync_server(NULL)
+   , m_magic_server(NULL)
+   , m_clock_skew_minimization_server(NULL)
+   , m_stats_manager(new StatsManager())
+   , m_transport(NULL)
+   , m_core_manager(NULL)
+   , m_thread_manager(NULL)
+   , m_thread_stats_manager(NULL)
+   , m_sim_thread_manager(NULL)
+   , m_clock_skew_minimization_manager(NULL)
+   , m_fastforward_performance_manager(NULL)
+   , m_trace_manager(NULL)
+   , m_dvfs_manager(NULL)
+   , m_hooks_manager(NULL)
+   , m_sampling_manager(NULL)
+   , m_faultinjection_manager(NULL)
+   , m_rtn_tracer(NULL)
+   , m_memory_tracker(NULL)
+   , m_checkpoint_manager(NULL)
+   , m_stats_sampler(NULL)
+   , m_running(false)
+   , m_inst_mode_output(false)
+   , m_sim_mode(USER)
+   , m_factory(NULL)
+{
+}
+
+Simulator::~Simulator()
+{
+   delete m_stats_manager;
+}
+
+namespace
+{
+   struct SimulatorInstance
+   {
+      SimulatorInstance() { Simulator::allocate(); }
+      ~SimulatorInstance() { Simulator::release(); }
+   } s_simulator_instance;
+}
+
+// Nothing is read from the simulator's own configuration (Sim()->getConfig())
+Config::Config(SimulationMode mode)
+{
+}
+
+Config::~Config()
+{
+}
+
+Log::Log(Config &config)
+   : _coreFiles(NULL)
+   , _simFiles(NULL)
+   , _coreLocks(NULL)
+   , _simLocks(NULL)
+   , _systemFile(NULL)
+   , _coreCount(0)
+   , _startTime(0)
+   , _loggingEnabled(false)
+   , _anyLoggingEnabled(false)
+{
+}
+
+Log::~Log()
+{
+}
+
+Log* Log::getSingleton()
+{
+   fprintf(stderr, "Unexpected log message\n");
+   abort();
+}
+
+String Log::getModule(const char *filename) { abort(); }
+void Log::log(ErrorState err, const char *source_file, SInt32 source_line, const char *format, ...) { abort(); }
+
+StatsManager::StatsManager()
+   : m_db(NULL)
+   , m_thread(NULL)
+{
+}
+
+StatsManager::~StatsManager()
+{
+}
+
+void StatsManager::run()
+{
+}
+
+void StatsManager::registerMetric(StatsMetricBase *metric)
+{
+   delete metric;
+}
+
+template <> UInt64 makeStatsValue<UInt64>(UInt64 t) { return t; }
+
+class LockStub : public LockImplementation
+{
+   public:
+      LockStub() { pthread_mutex_init(&m_mutex, NULL); }
+      ~LockStub() { pthread_mutex_destroy(&m_mutex); }
+      void acquire() { pthread_mutex_lock(&m_mutex); }
+      void release() { pthread_mutex_unlock(&m_mutex); }
+   private:
+      pthread_mutex_t m_mutex;
+};
+
+LockImplementation* LockCreator_Default::create()
+{
+   return new LockStub();
+}
+
+UInt64 Timer::now()
+{
+   timespec t;
+   clock_gettime(CLOCK_REALTIME, &t);
+   return (UInt64(t.tv_sec) * 1000000000) + t.tv_nsec;
+}
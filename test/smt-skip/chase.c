@@ -0,0 +1,26 @@
+// Memory-bound kernel: a dependent pointer chase through a randomly permuted array much larger than the LLC
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+   long size = argc > 1 ? atol(argv[1]) : 8 << 20, steps = argc > 2 ? atol(argv[2]) : 2000000;
+   long *next = malloc(size * sizeof(long)), i, p;
+
+   for(i = 0; i < size; ++i)
+      next[i] = i;
+   // Sattolo's algorithm: a single cycle through all elements
+   for(i = size - 1; i > 0; --i)
+   {
+      long j = random() % i, t = next[i];
+      next[i] = next[j];
+      next[j] = t;
+   }
+
+   for(i = 0, p = 0; i < steps; ++i)
+      p = next[p];
+
+   printf("%ld\n", p);
+   return 0;
+}
@@ -116,6 +116,18 @@ def generate_simout(jobid = None, resultsdir = None, partial = None, output = sy
       ('    miss rate', '%s.missrate'%c, lambda v: '%.2f%%' % v),
       ('    mpki', '%s.mpki'%c, lambda v: '%.2f' % v),
     ])
+    if sum(results.get('%s.prefetches'%c, [])):
+      # Accuracy: prefetched lines that were used, coverage: misses that were avoided by a prefetch,
+      # late: useful prefetches that had not yet completed when the demand access arrived
+      results['%s.prefetch-accuracy'%c] = map(lambda (a,b): 100*a/float(b or 1), zip(results['%s.hits-prefetch'%c], results['%s.prefetches'%c]))
+      results['%s.prefetch-coverage'%c] = map(lambda (a,b): 100*a/float((a+b) or 1), zip(results['%s.hits-prefetch'%c], results['%s.misses'%c]))
+      results['%s.prefetch-late'%c] = map(lambda (a,b): 100*a/float(b or 1), zip(results.get('%s.hits-prefetch-late'%c, [0]*ncores), results['%s.hits-prefetch'%c]))
+      template.extend([
+        ('    num prefetches', '%s.prefetches'%c, str),
+        ('    prefetch accuracy', '%s.prefetch-accuracy'%c, lambda v: '%.2f%%' % v),
+        ('    prefetch coverage', '%s.prefetch-coverage'%c, lambda v: '%.2f%%' % v),
+        ('    late prefetches', '%s.prefetch-late'%c, lambda v: '%.2f%%' % v),
+      ])
 
   allcaches = [ 'nuca-cache', 'dram-cache' ]
   existcaches = [ c for c in allcaches if '%s.reads'%c in results ]
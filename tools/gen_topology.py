@@ -101,7 +101,7 @@ def gen_topology(resultsdir = '.', jobid = None, outputobj = sys.stdout, format
     ymax = None
 
 
-    is_mesh = (sniper_config.get_config(config, 'network/memory_model_1') == 'emesh_hop_by_hop')
+    is_mesh = (sniper_config.get_config(config, 'network/memory_model_1') in ('emesh_hop_by_hop', 'emesh_parallel'))
     if is_mesh:
       ncores = int(config['general/total_cores'])
       dimensions = int(sniper_config.get_config(config, 'network/emesh_hop_by_hop/dimensions'))
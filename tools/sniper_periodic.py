@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+
+# Reader for sim.stats.periodic, written by the native periodic statistics sampler (stats/sampler/enabled = true).
+# See common/system/stats_sampler.cc for the file layout.
+
+import sys, os, getopt, struct, sniper_lib, sniper_config
+
+
+def read_periodic(filename):
+  data = bytearray(open(filename, 'rb').read())
+  magic, version, num_columns, interval = struct.unpack_from('<8sIIQ', bytes(data[:24]), 0)
+  if magic != b'SNIPSMPL' or version != 1:
+    raise ValueError('%s is not a version 1 periodic statistics file' % filename)
+  offset = 24
+  columns = []
+  for i in range(num_columns):
+    index, length = struct.unpack_from('<II', bytes(data[offset:offset+8]), 0)
+    offset += 8
+    columns.append((str(data[offset:offset+length]), index))
+    offset += length
+
+  def varint():
+    value, shift = 0, 0
+    while True:
+      byte = data[offset + varint.pos]
+      varint.pos += 1
+      value |= (byte & 0x7f) << shift
+      if byte < 0x80:
+        return value
+      shift += 7
+  varint.pos = 0
+
+  times = []
+  deltas = [ [] for i in range(num_columns) ]
+  time = 0
+  length = len(data) - offset
+  while varint.pos < length:
+    time += varint()
+    times.append(time)
+    for i in range(num_columns):
+      value = varint()
+      deltas[i].append((value >> 1) ^ -(value & 1))
+  return { 'interval': interval, 'columns': columns, 'times': times, 'deltas': deltas }
+
+
+def usage():
+  print 'Usage:', sys.argv[0], '[-h (help)] [-d <resultsdir (default: .)>] [-m <object.metric>[,...] (default: all)] [--abs (absolute values instead of deltas)] [--ipc (per-core IPC)]'
+
+
+if __name__ == '__main__':
+  resultsdir = '.'
+  metrics = None
+  absolute = False
+  do_ipc = False
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'hd:m:', [ 'abs', 'ipc' ])
+  except getopt.GetoptError, e:
+    print e
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-d':
+      resultsdir = a
+    if o == '-m':
+      metrics = a.split(',')
+    if o == '--abs':
+      absolute = True
+    if o == '--ipc':
+      do_ipc = True
+
+  if args:
+    usage()
+    sys.exit(-1)
+
+  trace = read_periodic(os.path.join(resultsdir, 'sim.stats.periodic'))
+  times, columns, deltas = trace['times'], trace['columns'], trace['deltas']
+
+  if do_ipc:
+    cores = [ (index, i) for i, (name, index) in enumerate(columns) if name == 'performance_model.instruction_count' ]
+    if not cores:
+      sys.stderr.write('IPC requires performance_model.instruction_count in stats/sampler/metrics\n')
+      sys.exit(-1)
+    config = sniper_lib.get_config(resultsdir = resultsdir)
+    freqs = dict([ (core, float(sniper_config.get_config(config, 'perf_model/core/frequency', core))) for core, i in cores ])
+    print ','.join([ 'time_ns' ] + [ 'ipc[%d]' % core for core, i in cores ])
+    # The first record covers everything before the first sample
+    for r in range(1, len(times)):
+      dt = (times[r] - times[r-1]) / 1e6
+      print ','.join([ '%d' % (times[r] / 1e6) ] + [ '%.3f' % (deltas[i][r] / (dt * freqs[core]) if dt else 0) for core, i in cores ])
+  else:
+    selected = [ i for i, (name, index) in enumerate(columns) if not metrics or name in metrics ]
+    print ','.join([ 'time_ns' ] + [ '%s[%d]' % columns[i] for i in selected ])
+    values = [ 0 ] * len(columns)
+    for r in range(len(times)):
+      for i in selected:
+        values[i] = values[i] + deltas[i][r] if absolute else deltas[i][r]
+      print ','.join([ '%d' % (times[r] / 1e6) ] + [ '%d' % values[i] for i in selected ])
@@ -0,0 +1,63 @@
+import struct, array, sniper_stats, sniper_stats_sqlite
+
+# Values written with stats/format = binary: sim.stats.bin holds the values, sim.stats.sqlite3 everything else.
+# See common/misc/stats.cc for the file layout.
+
+class SniperStatsBin(sniper_stats_sqlite.SniperStatsSqlite):
+  def __init__(self, filename = 'sim.stats.sqlite3', filename_bin = 'sim.stats.bin'):
+    sniper_stats_sqlite.SniperStatsSqlite.__init__(self, filename)
+    self.records, self.slots = self.read_records(filename_bin)
+
+  def read_records(self, filename):
+    data = open(filename, 'rb').read()
+    magic, version = struct.unpack_from('<8sI', data, 0)
+    if magic != b'SNIPSTAT' or version != 1:
+      raise ValueError('%s is not a version 1 statistics file' % filename)
+    offset = 12
+    records = {} # prefixid -> (record number, slots, values)
+    slots = []   # slot -> (nameid, core)
+    while offset < len(data):
+      prefixid, num_new_slots = struct.unpack_from('<QI', data, offset)
+      offset += 12
+      for i in range(num_new_slots):
+        nameid, core = struct.unpack_from('<Qi', data, offset)
+        slots.append((nameid, core))
+        offset += 12
+      num_values, = struct.unpack_from('<I', data, offset)
+      offset += 4
+      s = array.array('I', data[offset:offset+4*num_values])
+      offset += 4*num_values
+      v = array.array('L' if array.array('L').itemsize == 8 else 'Q', data[offset:offset+8*num_values])
+      offset += 8*num_values
+      records[prefixid] = (len(records), s, v)
+    return records, slots
+
+  def read_snapshot(self, prefix, metrics = None):
+    c = self.db.cursor()
+    c.execute('select prefixid from `prefixes` where prefixname = ?', (prefix,))
+    prefixids = list(c)
+    if not prefixids or prefixids[0][0] not in self.records:
+      raise ValueError('Invalid prefix %s' % prefix)
+    # Replay all changes up to and including this snapshot
+    last = self.records[prefixids[0][0]][0]
+    current = {}
+    for number, s, v in sorted(self.records.values(), key = lambda record: record[0]):
+      if number > last:
+        break
+      for slot, value in zip(s, v):
+        current[slot] = value
+    if metrics:
+      nameids = set([ nameid for nameid, (objectname, metricname) in self.names.items() if '%s.%s' % (objectname, metricname) in metrics ])
+    values = {}
+    for slot, value in current.items():
+      nameid, core = self.slots[slot]
+      if value == 0 or (metrics and nameid not in nameids):
+        continue
+      if nameid not in values: values[nameid] = {}
+      values[nameid][core] = value
+    return values
+
+if __name__ == '__main__':
+  stats = SniperStatsBin()
+  print(stats.get_snapshots())
+  print(stats.read_snapshot('roi-end'))